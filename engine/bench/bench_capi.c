@@ -0,0 +1,105 @@
+/* MatFree - C API benchmark: per-call overhead of mf_call and mf_eval
+ * Copyright (c) 2026 MatFree Contributors - MIT License
+ *
+ * Usage:
+ *   matfree_bench_capi [calls] [n]     (default calls = 1e5, n = 16)
+ *
+ * Calls a small kernel repeatedly on an n-element vector, through
+ * mf_call (no parsing), through mf_eval (lexed and parsed every time),
+ * and with a borrowed argument buffer.
+ */
+
+#include "capi/matfree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void check(mf_status status, mf_engine* engine) {
+    if (status != MF_OK) {
+        fprintf(stderr, "error: %s\n", mf_last_error(engine));
+        exit(1);
+    }
+}
+
+static void report(const char* name, double seconds, long calls) {
+    printf("  %-22s %9.3f us/call  (%.0f calls/s)\n", name, seconds / (double)calls * 1e6,
+           (double)calls / seconds);
+}
+
+int main(int argc, char* argv[]) {
+    long calls = argc > 1 ? (long)atof(argv[1]) : 100000;
+    size_t n = argc > 2 ? (size_t)atof(argv[2]) : 16;
+    double* data = malloc(n * sizeof(double));
+    double checksum = 0;
+    long i;
+    size_t k;
+    for (k = 0; k < n; k++) data[k] = (double)k;
+
+    printf("MatFree C API v%d: %ld calls on %zu elements\n", mf_api_version(), calls, n);
+    mf_engine* engine = mf_engine_create();
+    if (!engine) return 1;
+
+    /* mf_call with an owned (copied) argument */
+    {
+        mf_value* x = mf_value_matrix(1, n, MF_DOUBLE, data);
+        double t0 = now();
+        for (i = 0; i < calls; i++) {
+            mf_value* result;
+            check(mf_call(engine, "sum", (const mf_value* const*)&x, 1, &result, 1), engine);
+            checksum += *mf_value_data(result);
+            mf_value_free(result);
+        }
+        report("mf_call(sum)", now() - t0, calls);
+        mf_value_free(x);
+    }
+
+    /* mf_call with a fresh borrowed argument each time */
+    {
+        double t0 = now();
+        for (i = 0; i < calls; i++) {
+            mf_value* x = mf_value_borrow(1, n, data, NULL, NULL);
+            mf_value* result;
+            check(mf_call(engine, "sum", (const mf_value* const*)&x, 1, &result, 1), engine);
+            checksum += *mf_value_data(result);
+            mf_value_free(result);
+            mf_value_free(x);
+        }
+        report("mf_call(sum), borrowed", now() - t0, calls);
+    }
+
+    /* Two results */
+    {
+        mf_value* x = mf_value_matrix(1, n, MF_DOUBLE, data);
+        double t0 = now();
+        for (i = 0; i < calls; i++) {
+            mf_value* results[2];
+            check(mf_call(engine, "sort", (const mf_value* const*)&x, 1, results, 2), engine);
+            checksum += *mf_value_data(results[1]);
+            mf_value_free(results[0]);
+            mf_value_free(results[1]);
+        }
+        report("mf_call(sort), 2 outputs", now() - t0, calls);
+        mf_value_free(x);
+    }
+
+    /* The same work through source code */
+    {
+        mf_value* x = mf_value_matrix(1, n, MF_DOUBLE, data);
+        check(mf_set(engine, "x", x), engine);
+        mf_value_free(x);
+        double t0 = now();
+        for (i = 0; i < calls; i++) check(mf_eval(engine, "s = sum(x);"), engine);
+        report("mf_eval(\"s = sum(x);\")", now() - t0, calls);
+    }
+
+    printf("  (checksum %g)\n", checksum);
+    mf_engine_destroy(engine);
+    free(data);
+    return 0;
+}
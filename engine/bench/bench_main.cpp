@@ -0,0 +1,498 @@
+// MatFree - Benchmark suite with JSON results and regression comparison
+// Copyright (c) 2026 MatFree Contributors - MIT License
+//
+// Usage:
+//   matfree_bench [options]
+//     --list                 List the benchmarks and exit
+//     --filter <text>        Run only benchmarks whose name contains text
+//     --reps <n>             Timed repetitions per benchmark (default 10)
+//     --warmup <n>           Untimed runs before timing (default 2)
+//     --min-time <s>         Minimum time of one repetition (default 0.05);
+//                            fast operations are repeated to fill it
+//     --json <file>          Write results as JSON ("-" for stdout)
+//     --compare <file>       Compare with results saved by --json; exits
+//                            with 1 if any benchmark regressed
+//     --threshold <f>        Relative slowdown that counts as a regression
+//                            (default 0.10)
+//     --examples <dir>       Directory of the example scripts
+//
+// Each benchmark is timed over `reps` repetitions; a repetition runs the
+// operation enough times to take at least `min-time`, and reports the time
+// per operation. Results give the median (what --compare uses), mean,
+// standard deviation and range, plus heap allocations per operation.
+
+#include "core/interpreter.h"
+#include "core/builtins.h"
+#include "core/lexer.h"
+#include "core/parser.h"
+#include "core/parallel.h"
+#include "core/sorting.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace matfree;
+
+// ============================================================================
+// Allocation counting
+// ============================================================================
+
+// The replacements below pair malloc with free, which GCC cannot see
+// through once they are inlined into the standard allocators
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<uint64_t> allocationCount{0};
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+struct Benchmark {
+    std::string name;
+    std::string group;
+    std::function<void()> run; // one operation
+    double bytes = 0;          // processed per operation, for throughput
+};
+
+struct Result {
+    std::string name;
+    std::string group;
+    size_t iterations = 0; // operations per repetition
+    std::vector<double> samples; // seconds per operation, one per repetition
+    double median = 0, mean = 0, stddev = 0, min = 0, max = 0;
+    double allocations = 0; // per operation
+    double bytes = 0;
+};
+
+// An interpreter running one parsed snippet. Setup code runs once; the
+// snippet itself is parsed once and executed for every operation.
+class ScriptRunner {
+public:
+    ScriptRunner(const std::string& setup, const std::string& code) {
+        registerAllBuiltins(interp_);
+        interp_.setOutput(sink_);
+        if (!setup.empty()) interp_.executeString(setup, "<setup>");
+        Lexer lexer(code, "<bench>");
+        Parser parser(lexer.tokenize());
+        program_ = std::make_shared<Program>(parser.parse());
+    }
+
+    void operator()() {
+        sink_.str(std::string());
+        interp_.execute(*program_);
+    }
+
+private:
+    std::ostringstream sink_; // script output, discarded
+    Interpreter interp_;
+    std::shared_ptr<Program> program_;
+};
+
+static Benchmark script(const std::string& group, const std::string& name, const std::string& setup,
+                        const std::string& code) {
+    auto runner = std::make_shared<ScriptRunner>(setup, code);
+    return {group + "/" + name, group, [runner] { (*runner)(); }, 0};
+}
+
+static std::string readFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static std::vector<Benchmark> makeBenchmarks(const std::string& examplesDir) {
+    std::vector<Benchmark> b;
+    const std::string rand512 = "rng(1); A = rand(512); B = rand(512);";
+    const std::string vec = "rng(1); x = rand(1, 1000000); y = rand(1, 1000000);";
+
+    // Matrix kernels
+    b.push_back(script("matrix", "gemm_256", "rng(1); A = rand(256); B = rand(256);", "C = A * B;"));
+    b.push_back(script("matrix", "gemm_512", rand512, "C = A * B;"));
+    b.push_back(script("matrix", "inv_300", "rng(1); A = rand(300) + 300 * eye(300);", "Ai = inv(A);"));
+    b.push_back(script("matrix", "transpose_1000", "rng(1); A = rand(1000);", "T = A';"));
+
+    // Elementwise operations
+    b.push_back(script("elementwise", "add_mul_1e6", vec, "z = x .* y + 1;"));
+    b.push_back(script("elementwise", "exp_1e6", vec, "z = exp(x);"));
+    b.push_back(script("elementwise", "compare_1e6", vec, "z = x > y;"));
+
+    // Reductions
+    b.push_back(script("reduction", "sum_1e6", vec, "s = sum(x);"));
+    b.push_back(script("reduction", "max_1e6", vec, "m = max(x);"));
+    b.push_back(script("reduction", "cumsum_1e6", vec, "c = cumsum(x);"));
+    b.push_back(script("reduction", "sum_cols_512", rand512, "s = sum(A);"));
+
+    // Sorting (the radix kernel directly, then through the language)
+    {
+        auto input = std::make_shared<std::vector<double>>(1000000);
+        std::mt19937_64 gen(42);
+        std::normal_distribution<double> dist(0.0, 1e3);
+        for (auto& v : *input) v = dist(gen);
+        auto work = std::make_shared<std::vector<double>>();
+        b.push_back({"sort/kernel_1e6", "sort",
+                     [input, work] {
+                         *work = *input;
+                         sortValues(work->data(), work->size(), SortOrder::ASCEND);
+                     },
+                     8e6});
+    }
+    b.push_back(script("sort", "sort_1e6", vec, "z = sort(x);"));
+    b.push_back(script("sort", "unique_1e6", "rng(1); x = floor(rand(1, 1000000) * 1000);", "u = unique(x);"));
+
+    // Indexing
+    b.push_back(script("indexing", "gather_1e6", vec + " idx = randperm(1000000);", "z = x(idx);"));
+    b.push_back(script("indexing", "find_mask_1e6", vec, "z = x(find(x > 0.5));"));
+    b.push_back(script("indexing", "scalar_assign_loop_1e4", "x = zeros(1, 10000);",
+                       "for i = 1:10000\n    x(i) = i;\nend"));
+    b.push_back(script("indexing", "colon_slice_512", rand512, "c = A(:, 100); r = A(200, :);"));
+
+    // Interpreter dispatch and calls
+    b.push_back(script("interpreter", "for_loop_1e5", "", "s = 0;\nfor i = 1:100000\n    s = s + i;\nend"));
+    b.push_back(script("interpreter", "while_if_1e5", "",
+                       "i = 0; s = 0;\nwhile i < 100000\n    i = i + 1;\n    if mod(i, 2) == 0\n        s = s + i;\n"
+                       "    end\nend"));
+    b.push_back(script("calls", "user_function_1e4", "function y = inc(x)\ny = x + 1;\nend",
+                       "s = 0;\nfor i = 1:10000\n    s = inc(s);\nend"));
+    b.push_back(script("calls", "builtin_1e4", "", "s = 0;\nfor i = 1:10000\n    s = s + abs(i);\nend"));
+    b.push_back(script("calls", "anonymous_1e4", "f = @(x) x + 1;", "s = 0;\nfor i = 1:10000\n    s = f(s);\nend"));
+    b.push_back(script("calls", "arrayfun_1e4", "f = @(x) x * 2; v = 1:10000;", "w = arrayfun(f, v);"));
+
+    // Allocation: building values element by element
+    b.push_back(script("allocation", "grow_vector_1e4", "", "v = [];\nfor i = 1:10000\n    v(end + 1) = i;\nend"));
+    b.push_back(script("allocation", "cell_of_strings_1e3", "",
+                       "c = cell(1, 1000);\nfor i = 1:1000\n    c{i} = sprintf('item%d', i);\nend"));
+
+    // Parsing throughput: the examples (or a generated program) many times over
+    {
+        std::string source;
+        std::error_code ec;
+        for (auto& entry : std::filesystem::directory_iterator(examplesDir, ec))
+            if (entry.path().extension() == ".m") source += readFile(entry.path()) + "\n";
+        if (source.empty())
+            for (int i = 0; i < 50; i++)
+                source += "function y = f" + std::to_string(i) + "(x)\n    y = x .^ 2 + sin(x) * [1 2; 3 4];\nend\n";
+        std::string text;
+        while (text.size() < (1u << 20)) text += source;
+        auto code = std::make_shared<std::string>(std::move(text));
+        b.push_back({"parse/lex_parse_1MB", "parse",
+                     [code] {
+                         Lexer lexer(*code, "<bench>");
+                         Parser parser(lexer.tokenize());
+                         Program program = parser.parse();
+                         if (program.statements.empty() && program.functions.empty()) std::abort();
+                     },
+                     static_cast<double>(code->size())});
+    }
+
+    // The example scripts, end to end
+    std::vector<std::filesystem::path> examples;
+    std::error_code ec;
+    for (auto& entry : std::filesystem::directory_iterator(examplesDir, ec))
+        if (entry.path().extension() == ".m") examples.push_back(entry.path());
+    std::sort(examples.begin(), examples.end());
+    for (auto& path : examples) {
+        std::string source = readFile(path);
+        b.push_back(script("examples", path.stem().string(), "", source));
+    }
+    return b;
+}
+
+// ============================================================================
+// Timing
+// ============================================================================
+
+static double secondsOf(const std::function<void()>& fn, size_t iterations) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+static Result measure(const Benchmark& bench, int warmup, int reps, double minTime) {
+    Result r;
+    r.name = bench.name;
+    r.group = bench.group;
+    r.bytes = bench.bytes;
+
+    // Warm up (caches, lazily built state), and size a repetition
+    double single = secondsOf(bench.run, 1);
+    for (int i = 1; i < warmup; i++) single = std::min(single, secondsOf(bench.run, 1));
+    r.iterations = static_cast<size_t>(std::max(1.0, std::ceil(minTime / std::max(single, 1e-9))));
+
+    uint64_t allocs0 = allocationCount.load();
+    for (int i = 0; i < reps; i++) r.samples.push_back(secondsOf(bench.run, r.iterations) / r.iterations);
+    uint64_t allocs = allocationCount.load() - allocs0;
+    r.allocations = static_cast<double>(allocs) / (static_cast<double>(r.iterations) * reps);
+
+    std::vector<double> sorted = r.samples;
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    r.median = n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    r.min = sorted.front();
+    r.max = sorted.back();
+    for (double s : sorted) r.mean += s / n;
+    double ss = 0;
+    for (double s : sorted) ss += (s - r.mean) * (s - r.mean);
+    r.stddev = n > 1 ? std::sqrt(ss / (n - 1)) : 0.0;
+    return r;
+}
+
+// ============================================================================
+// JSON
+// ============================================================================
+
+static std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static std::string toJson(const std::vector<Result>& results, int warmup, int reps, double minTime) {
+    std::ostringstream os;
+    os.precision(6);
+    os << "{\n  \"format\": \"matfree-bench\",\n  \"version\": 1,\n";
+    os << "  \"threads\": " << parallelThreadCount() << ",\n";
+    os << "  \"warmup\": " << warmup << ",\n  \"repetitions\": " << reps << ",\n  \"min_time_s\": " << minTime
+       << ",\n";
+    os << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        os << (i ? ",\n" : "\n") << "    {\"name\": " << jsonString(r.name) << ", \"group\": " << jsonString(r.group)
+           << ", \"iterations\": " << r.iterations << ", \"median_ns\": " << r.median * 1e9
+           << ", \"mean_ns\": " << r.mean * 1e9 << ", \"stddev_ns\": " << r.stddev * 1e9
+           << ", \"min_ns\": " << r.min * 1e9 << ", \"max_ns\": " << r.max * 1e9
+           << ", \"allocations\": " << r.allocations;
+        if (r.bytes > 0) os << ", \"mb_per_s\": " << r.bytes / r.median / 1e6;
+        os << "}";
+    }
+    os << "\n  ]\n}\n";
+    return os.str();
+}
+
+// Just enough of a JSON reader for files written by toJson: the objects in
+// "results", as name -> number fields
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& text) : s_(text) {}
+
+    std::map<std::string, std::map<std::string, double>> results() {
+        std::map<std::string, std::map<std::string, double>> out;
+        size_t p = s_.find("\"results\"");
+        if (p == std::string::npos) throw std::runtime_error("no \"results\" array");
+        pos_ = s_.find('[', p);
+        if (pos_ == std::string::npos) throw std::runtime_error("no \"results\" array");
+        pos_++;
+        while (skipSpace() && s_[pos_] != ']') {
+            if (s_[pos_] == ',') {
+                pos_++;
+                continue;
+            }
+            expect('{');
+            std::string name;
+            std::map<std::string, double> fields;
+            while (skipSpace() && s_[pos_] != '}') {
+                if (s_[pos_] == ',') {
+                    pos_++;
+                    continue;
+                }
+                std::string key = string();
+                skipSpace();
+                expect(':');
+                skipSpace();
+                if (s_[pos_] == '"') {
+                    std::string value = string();
+                    if (key == "name") name = value;
+                } else {
+                    char* end = nullptr;
+                    fields[key] = std::strtod(s_.c_str() + pos_, &end);
+                    pos_ = static_cast<size_t>(end - s_.c_str());
+                }
+            }
+            expect('}');
+            out[name] = fields;
+        }
+        return out;
+    }
+
+private:
+    bool skipSpace() {
+        while (pos_ < s_.size() && std::isspace(static_cast<unsigned char>(s_[pos_]))) pos_++;
+        if (pos_ >= s_.size()) throw std::runtime_error("unexpected end of JSON");
+        return true;
+    }
+    void expect(char c) {
+        skipSpace();
+        if (s_[pos_] != c) throw std::runtime_error(std::string("expected '") + c + "' in JSON");
+        pos_++;
+    }
+    std::string string() {
+        expect('"');
+        std::string out;
+        while (pos_ < s_.size() && s_[pos_] != '"') {
+            if (s_[pos_] == '\\' && pos_ + 1 < s_.size()) pos_++;
+            out += s_[pos_++];
+        }
+        pos_++;
+        return out;
+    }
+
+    const std::string& s_;
+    size_t pos_ = 0;
+};
+
+// Slower by more than `threshold` and by more than the noise of both runs
+static int compare(const std::vector<Result>& results, const std::string& baselinePath, double threshold,
+                   FILE* table) {
+    auto baseline = JsonReader(readFile(baselinePath)).results();
+    int regressions = 0;
+    std::fprintf(table, "\n%-36s %12s %12s %9s\n", "Benchmark", "Baseline", "Current", "Change");
+    for (auto& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || !it->second.count("median_ns")) {
+            std::fprintf(table, "%-36s %12s %12.4g %9s  new\n", r.name.c_str(), "-", r.median * 1e9, "");
+            continue;
+        }
+        double base = it->second["median_ns"];
+        double baseSd = it->second.count("stddev_ns") ? it->second["stddev_ns"] : 0.0;
+        double cur = r.median * 1e9;
+        double change = base > 0 ? cur / base - 1 : 0;
+        double noise = 2 * std::max(baseSd, r.stddev * 1e9);
+        const char* status = "";
+        if (change > threshold && cur - base > noise) {
+            status = "  REGRESSION";
+            regressions++;
+        } else if (change < -threshold && base - cur > noise) {
+            status = "  improved";
+        }
+        std::fprintf(table, "%-36s %12.4g %12.4g %+8.1f%%%s\n", r.name.c_str(), base, cur, 100 * change, status);
+    }
+    std::fprintf(table, "\n%d regression%s (threshold %.0f%%, times in ns per operation)\n", regressions,
+                regressions == 1 ? "" : "s", 100 * threshold);
+    return regressions;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(int argc, char* argv[]) {
+    std::string filter, jsonPath, baselinePath;
+    std::string examplesDir = MATFREE_EXAMPLES_DIR;
+    int reps = 10, warmup = 2;
+    double minTime = 0.05, threshold = 0.10;
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--list") list = true;
+        else if (arg == "--filter" && hasValue) filter = argv[++i];
+        else if (arg == "--reps" && hasValue) reps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--warmup" && hasValue) warmup = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--min-time" && hasValue) minTime = std::atof(argv[++i]);
+        else if (arg == "--json" && hasValue) jsonPath = argv[++i];
+        else if (arg == "--compare" && hasValue) baselinePath = argv[++i];
+        else if (arg == "--threshold" && hasValue) threshold = std::atof(argv[++i]);
+        else if (arg == "--examples" && hasValue) examplesDir = argv[++i];
+        else {
+            std::cerr << "Unknown option: " << arg << " (see the comment at the top of bench_main.cpp)" << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<Benchmark> benchmarks;
+    try {
+        benchmarks = makeBenchmarks(examplesDir);
+    } catch (std::exception& e) {
+        std::cerr << "Benchmark setup failed: " << e.what() << std::endl;
+        return 2;
+    }
+    if (list) {
+        for (auto& b : benchmarks) std::cout << b.name << std::endl;
+        return 0;
+    }
+
+    // The table goes to stderr when the JSON goes to stdout
+    FILE* table = jsonPath == "-" ? stderr : stdout;
+    std::fprintf(table, "MatFree benchmarks: %d repetitions of >= %g s, %zu threads\n\n", reps, minTime,
+                 parallelThreadCount());
+    std::fprintf(table, "%-36s %12s %8s %10s %10s\n", "Benchmark", "Median", "CV", "Allocs/op", "MB/s");
+    std::vector<Result> results;
+    for (auto& b : benchmarks) {
+        if (!filter.empty() && b.name.find(filter) == std::string::npos) continue;
+        Result r;
+        try {
+            r = measure(b, warmup, reps, minTime);
+        } catch (std::exception& e) {
+            std::cerr << b.name << " failed: " << e.what() << std::endl;
+            return 2;
+        }
+        char median[32], rate[32] = "";
+        if (r.median >= 1e-3) std::snprintf(median, sizeof(median), "%.3f ms", r.median * 1e3);
+        else std::snprintf(median, sizeof(median), "%.3f us", r.median * 1e6);
+        if (r.bytes > 0) std::snprintf(rate, sizeof(rate), "%.1f", r.bytes / r.median / 1e6);
+        std::fprintf(table, "%-36s %12s %7.1f%% %10.1f %10s\n", r.name.c_str(), median,
+                     r.mean > 0 ? 100 * r.stddev / r.mean : 0.0, r.allocations, rate);
+        std::fflush(table);
+        results.push_back(std::move(r));
+    }
+
+    if (!jsonPath.empty()) {
+        std::string json = toJson(results, warmup, reps, minTime);
+        if (jsonPath == "-") {
+            std::cout << json;
+        } else {
+            std::ofstream out(jsonPath, std::ios::binary);
+            if (!out) {
+                std::cerr << "Cannot write " << jsonPath << std::endl;
+                return 2;
+            }
+            out << json;
+        }
+    }
+
+    if (!baselinePath.empty()) {
+        try {
+            return compare(results, baselinePath, threshold, table) > 0 ? 1 : 0;
+        } catch (std::exception& e) {
+            std::cerr << "Cannot read baseline " << baselinePath << ": " << e.what() << std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
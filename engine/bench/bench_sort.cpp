@@ -0,0 +1,66 @@
+// MatFree - Sort benchmark: radix sortValues vs std::sort
+// Copyright (c) 2026 MatFree Contributors - MIT License
+//
+// Usage:
+//   matfree_bench_sort [n] [reps]     (default n = 1e8, reps = 3)
+
+#include "core/sorting.h"
+#include "core/parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace matfree;
+
+template <typename F>
+static double bestOf(int reps, const std::vector<double>& input, F&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; r++) {
+        std::vector<double> data = input;
+        auto t0 = std::chrono::steady_clock::now();
+        fn(data);
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+        if (!std::is_sorted(data.begin(), data.end()))
+            std::cerr << "warning: output not sorted" << std::endl;
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? static_cast<size_t>(std::atof(argv[1])) : 100000000;
+    int reps = (argc > 2) ? std::atoi(argv[2]) : 3;
+
+    std::cout << "Sorting " << n << " doubles, best of " << reps
+              << " (" << parallelThreadCount() << " threads)" << std::endl;
+
+    std::mt19937_64 gen(42);
+    std::normal_distribution<double> dist(0.0, 1e3);
+    std::vector<double> input(n);
+    for (auto& v : input) v = dist(gen);
+
+    double tStd = bestOf(reps, input, [](std::vector<double>& d) {
+        std::sort(d.begin(), d.end());
+    });
+    double tRadix = bestOf(reps, input, [](std::vector<double>& d) {
+        sortValues(d.data(), d.size(), SortOrder::ASCEND);
+    });
+    double tRadixIdx = bestOf(reps, input, [](std::vector<double>& d) {
+        std::vector<uint64_t> perm(d.size());
+        std::iota(perm.begin(), perm.end(), uint64_t(0));
+        sortValues(d.data(), d.size(), SortOrder::ASCEND, perm.data());
+    });
+
+    auto report = [n](const char* name, double t) {
+        std::cout << "  " << name << t << " s  (" << (n / t / 1e6) << " M/s)" << std::endl;
+    };
+    report("std::sort           ", tStd);
+    report("radix               ", tRadix);
+    report("radix + indices     ", tRadixIdx);
+    std::cout << "  speedup (radix vs std::sort): " << (tStd / tRadix) << "x" << std::endl;
+    return 0;
+}
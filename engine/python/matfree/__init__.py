@@ -13,6 +13,9 @@ Usage:
     # Get variable values
     x = matfree.get("x")
 
+    # Call a function directly (no parsing; several results as a tuple)
+    m, i = matfree.call("max", x, nargout=2)
+
     # Interactive session
     matfree.repl()
 """
@@ -23,7 +26,7 @@ __license__ = "MIT"
 
 # Try to import the C++ bindings
 try:
-    from .pymatfree import Engine, eval as _eval, get as _get
+    from .pymatfree import Engine, eval as _eval, get as _get, call as _call
     _HAS_NATIVE = True
 except ImportError:
     _HAS_NATIVE = False
@@ -58,6 +61,18 @@ def eval(code: str) -> str:
         )
 
 
+def call(name: str, *args, nargout: int = 1) -> tuple:
+    """Call a MatFree function with the given arguments and return a tuple
+    of its first nargout results. Raises RuntimeError if the function gives
+    fewer. Requires the native bindings."""
+    if not _HAS_NATIVE:
+        raise RuntimeError(
+            "matfree.call needs the native bindings. Build them with: "
+            "cmake -DMATFREE_BUILD_PYTHON=ON .."
+        )
+    return _call(name, *args, nargout=nargout)
+
+
 def run_file(filename: str) -> str:
     """Execute a .m file."""
     try:
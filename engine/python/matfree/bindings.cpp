@@ -9,86 +9,207 @@
 
 #include "core/interpreter.h"
 #include "core/builtins.h"
+#include "core/numeric_types.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
 
 namespace py = pybind11;
 using namespace matfree;
 
+// NumPy dtype of a MatFree numeric class, by kind and item size
+static NumericClass numericClassOf(const py::dtype& dt) {
+    char kind = dt.kind();
+    size_t size = static_cast<size_t>(dt.itemsize());
+    if (kind == 'f' && size == 8) return NumericClass::DOUBLE;
+    if (kind == 'f' && size == 4) return NumericClass::SINGLE;
+    if (kind == 'b' && size == 1) return NumericClass::UINT8;
+    if (kind == 'i' || kind == 'u') {
+        bool u = kind == 'u';
+        switch (size) {
+            case 1: return u ? NumericClass::UINT8 : NumericClass::INT8;
+            case 2: return u ? NumericClass::UINT16 : NumericClass::INT16;
+            case 4: return u ? NumericClass::UINT32 : NumericClass::INT32;
+            case 8: return u ? NumericClass::UINT64 : NumericClass::INT64;
+        }
+    }
+    throw py::type_error("MatFree cannot hold arrays of dtype " + py::str(dt).cast<std::string>());
+}
+
+// Matrix over a NumPy array. A C-ordered, aligned float64 array is shared
+// without copying: the matrix keeps the array alive and, like any external
+// matrix, is copied the first time MatFree modifies it. Fortran-ordered or
+// strided arrays are first made C-ordered by NumPy, other dtypes are
+// converted into a new matrix. 1-D arrays become row vectors.
+static Matrix matrixFromArray(const py::array& value) {
+    if (value.ndim() > 2) throw py::value_error("MatFree arrays have at most 2 dimensions");
+    size_t rows = value.ndim() == 2 ? static_cast<size_t>(value.shape(0)) : 1;
+    size_t cols = value.ndim() == 0 ? 1 : static_cast<size_t>(value.shape(value.ndim() - 1));
+    NumericClass cls = numericClassOf(value.dtype());
+
+    py::array arr = py::array::ensure(value, py::array::c_style); // copies only when needed
+    if (!arr) throw py::error_already_set();
+    bool aligned = reinterpret_cast<std::uintptr_t>(arr.data()) % alignof(double) == 0;
+    if (cls == NumericClass::DOUBLE && aligned) {
+        // Released (with the GIL held) when the last matrix sharing it goes
+        std::shared_ptr<void> owner(new py::object(arr), [](void* p) {
+            py::gil_scoped_acquire gil;
+            delete static_cast<py::object*>(p);
+        });
+        return Matrix::external(rows, cols, static_cast<double*>(const_cast<void*>(arr.data())),
+                                std::move(owner), false);
+    }
+
+    Matrix m(rows, cols);
+    py::gil_scoped_release release;
+    convertToDouble(arr.data(), cls, m.numel(), m.begin());
+    return m;
+}
+
+// Value for a Python object (number, bool, str or array)
+static ValuePtr toValue(const py::handle& value) {
+    if (py::isinstance<py::bool_>(value)) return Value::makeBool(value.cast<bool>());
+    if (py::isinstance<py::float_>(value) || py::isinstance<py::int_>(value))
+        return Value::makeScalar(value.cast<double>());
+    if (py::isinstance<py::str>(value)) return Value::makeString(value.cast<std::string>());
+    if (py::isinstance<py::array>(value)) return Value::makeMatrix(matrixFromArray(value.cast<py::array>()));
+    throw py::type_error("MatFree cannot hold a value of type " +
+                         py::str(value.get_type()).cast<std::string>());
+}
+
+// Python object for a value: float for scalars, str for strings, a
+// read-only NumPy view for matrices
+static py::object toPython(const ValuePtr& val) {
+    if (!val || val->isEmpty()) return py::none();
+
+    if (val->isScalar()) {
+        return py::float_(val->scalarDouble());
+    }
+
+    if (val->isMatrix() || val->isLogical()) {
+        // A read-only view of the MatFree buffer; the capsule keeps the
+        // value alive. MatFree never modifies a stored value in place
+        // (assignment makes a new one), so the view stays valid.
+        const Matrix& m = val->matrix();
+        py::capsule keep(new ValuePtr(val), [](void* p) { delete static_cast<ValuePtr*>(p); });
+        auto rows = static_cast<py::ssize_t>(m.rows()), cols = static_cast<py::ssize_t>(m.cols());
+        py::ssize_t item = sizeof(double);
+        py::array_t<double> arr({rows, cols}, {cols * item, item}, m.begin(), keep);
+        arr.attr("setflags")(py::arg("write") = false);
+        return std::move(arr);
+    }
+
+    if (val->isString()) {
+        return py::str(val->string());
+    }
+
+    return py::str(val->toString());
+}
+
+// One MatFree session. Execution runs without the GIL, so engines on
+// different Python threads run concurrently; calls into the same engine
+// are serialized.
 class PyEngine {
 public:
     PyEngine() {
         registerAllBuiltins(interp_);
+        interp_.setOutput(output_);
     }
 
     std::string eval(const std::string& code) {
-        std::ostringstream oss;
-        interp_.setOutput(oss);
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
+        output_.str("");
         interp_.executeString(code);
-        return oss.str();
+        return output_.str();
     }
 
-    py::object get(const std::string& name) {
-        auto val = interp_.globalEnv()->get(name);
-        if (!val || val->isEmpty()) return py::none();
-
-        if (val->isScalar()) {
-            return py::float_(val->scalarDouble());
+    /// Call a function (built-in, user function or a function handle
+    /// variable) on converted arguments and return its first `nargout`
+    /// results; raises RuntimeError if it gives fewer. Nothing is lexed or parsed, so calling small functions
+    /// many times costs little more than the functions themselves.
+    py::tuple call(const std::string& name, const py::args& args, int nargout) {
+        ValueList in;
+        in.reserve(args.size());
+        for (auto& a : args) in.push_back(toValue(a));
+
+        ValueList out;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(mutex_);
+            output_.str("");
+            auto var = interp_.globalEnv()->get(name);
+            int want = std::max(nargout, 1);
+            out = var && var->isFuncHandle() ? interp_.callFuncHandleMulti(var->funcHandle(), in, want)
+                                             : interp_.callFunctionMulti(name, in, want);
         }
 
-        if (val->isMatrix()) {
-            auto& m = val->matrix();
-            py::array_t<double> arr({m.rows(), m.cols()});
-            auto buf = arr.mutable_unchecked<2>();
-            for (size_t i = 0; i < m.rows(); i++)
-                for (size_t j = 0; j < m.cols(); j++)
-                    buf(i, j) = m(i, j);
-            return std::move(arr);
-        }
+        // Fewer results than asked for is an error, as in [a, b] = f(...)
+        size_t n = static_cast<size_t>(std::max(nargout, 0));
+        if (out.size() < n || std::any_of(out.begin(), out.begin() + n, [](const ValuePtr& v) { return !v; }))
+            throw RuntimeError(name + ": too many output arguments (asked for " + std::to_string(n) + ")");
+        py::tuple result(n);
+        for (size_t i = 0; i < n; i++) result[i] = toPython(out[i]);
+        return result;
+    }
 
-        if (val->isString()) {
-            return py::str(val->string());
+    // The engine lock is only ever taken without the GIL: a thread running
+    // the engine may need the GIL (to release a shared NumPy array)
+    py::object get(const std::string& name) {
+        ValuePtr val;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(mutex_);
+            val = interp_.globalEnv()->get(name);
         }
-
-        return py::str(val->toString());
+        return toPython(val);
     }
 
     void set(const std::string& name, py::object value) {
-        if (py::isinstance<py::float_>(value) || py::isinstance<py::int_>(value)) {
-            interp_.globalEnv()->set(name, Value::makeScalar(value.cast<double>()));
-        } else if (py::isinstance<py::str>(value)) {
-            interp_.globalEnv()->set(name, Value::makeString(value.cast<std::string>()));
-        } else if (py::isinstance<py::array>(value)) {
-            py::array_t<double> arr = value.cast<py::array_t<double>>();
-            auto buf = arr.unchecked<2>();
-            Matrix m(buf.shape(0), buf.shape(1));
-            for (ssize_t i = 0; i < buf.shape(0); i++)
-                for (ssize_t j = 0; j < buf.shape(1); j++)
-                    m(i, j) = buf(i, j);
-            interp_.globalEnv()->set(name, Value::makeMatrix(std::move(m)));
-        }
+        ValuePtr val = toValue(value);
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
+        interp_.globalEnv()->set(name, std::move(val));
     }
 
     void runFile(const std::string& filename) {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
         interp_.executeFile(filename);
     }
 
 private:
     Interpreter interp_;
+    std::ostringstream output_;
+    std::mutex mutex_;
 };
 
+static PyEngine& defaultEngine() {
+    thread_local PyEngine engine;
+    return engine;
+}
+
 PYBIND11_MODULE(pymatfree, m) {
     m.doc() = "MatFree - Open-Source Computing Environment";
 
     py::class_<PyEngine>(m, "Engine")
         .def(py::init<>())
         .def("eval", &PyEngine::eval, "Execute MatFree code")
-        .def("get", &PyEngine::get, "Get variable value")
-        .def("set", &PyEngine::set, "Set variable value")
+        .def("get", &PyEngine::get, "Get variable value (matrices as read-only views, no copy)")
+        .def("set", &PyEngine::set, "Set variable value (float64 C-ordered arrays are shared, not copied)")
+        .def("call", &PyEngine::call, "Call a MatFree function and return its results as a tuple",
+             py::arg("name"), py::arg("nargout") = 1)
         .def("run_file", &PyEngine::runFile, "Execute a .m file");
 
-    // Module-level convenience functions using a global engine
-    static PyEngine globalEngine;
-    m.def("eval", [](const std::string& code) { return globalEngine.eval(code); });
-    m.def("get", [](const std::string& name) { return globalEngine.get(name); });
+    // Module-level convenience functions use a default engine per thread,
+    // so Python threads never share a session
+    m.def("eval", [](const std::string& code) { return defaultEngine().eval(code); });
+    m.def("get", [](const std::string& name) { return defaultEngine().get(name); });
+    m.def("call", [](const std::string& name, const py::args& args, int nargout) {
+        return defaultEngine().call(name, args, nargout);
+    }, py::arg("name"), py::arg("nargout") = 1);
 }
 
 #endif // MATFREE_BUILD_PYTHON
@@ -0,0 +1,118 @@
+#pragma once
+// MatFree - C embedding API (libmatfree_capi)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+//
+// A stable C ABI over the interpreter, for embedding MatFree without its
+// internal C++ types. Engines are independent sessions; one engine may be
+// used by one thread at a time, different engines concurrently.
+//
+// Functions that can fail return MF_OK or MF_ERROR; the message of the last
+// failure on an engine is available from mf_last_error. Values are opaque
+// reference-counted handles owned by the caller, released with
+// mf_value_free. Matrices are rows x cols, stored row-major.
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#  ifdef MATFREE_CAPI_EXPORTS
+#    define MF_API __declspec(dllexport)
+#  else
+#    define MF_API __declspec(dllimport)
+#  endif
+#else
+#  define MF_API __attribute__((visibility("default")))
+#endif
+
+/// Version of this header. Additions keep the version; changes to
+/// existing declarations increase it (and the library's SOVERSION).
+#define MATFREE_CAPI_VERSION 1
+
+typedef struct mf_engine mf_engine;
+typedef struct mf_value mf_value;
+
+typedef enum mf_status { MF_OK = 0, MF_ERROR = 1 } mf_status;
+
+/// Element types of arrays passed in and out. MatFree computes in double;
+/// other types are converted (integers rounded and saturated on the way out).
+typedef enum mf_class {
+    MF_DOUBLE, MF_SINGLE, MF_INT8, MF_UINT8, MF_INT16, MF_UINT16,
+    MF_INT32, MF_UINT32, MF_INT64, MF_UINT64
+} mf_class;
+
+typedef enum mf_kind {
+    MF_KIND_EMPTY, MF_KIND_MATRIX, MF_KIND_LOGICAL, MF_KIND_STRING, MF_KIND_OTHER
+} mf_kind;
+
+/// MATFREE_CAPI_VERSION of the library actually loaded.
+MF_API int mf_api_version(void);
+
+// ---------------------------------------------------------------------------
+// Engines
+// ---------------------------------------------------------------------------
+
+/// NULL if the engine cannot be created.
+MF_API mf_engine* mf_engine_create(void);
+MF_API void mf_engine_destroy(mf_engine* engine);
+
+/// Run source code in the engine's workspace.
+MF_API mf_status mf_eval(mf_engine* engine, const char* code);
+
+/// Call a function (built-in, user function or a function handle variable)
+/// with `nargs` arguments. Up to `nargout` results are stored in `results`
+/// as new values; slots the function does not fill are set to NULL.
+MF_API mf_status mf_call(mf_engine* engine, const char* name, const mf_value* const* args, size_t nargs,
+                         mf_value** results, size_t nargout);
+
+/// A workspace variable as a new value, or NULL (with an error) if there is
+/// no such variable.
+MF_API mf_value* mf_get(mf_engine* engine, const char* name);
+MF_API mf_status mf_set(mf_engine* engine, const char* name, const mf_value* value);
+
+/// Text printed by the last mf_eval or mf_call (NUL-terminated; valid until
+/// the next call on the engine).
+MF_API const char* mf_output(const mf_engine* engine);
+
+/// Message of the last failed call on the engine ("" if none).
+MF_API const char* mf_last_error(const mf_engine* engine);
+
+// ---------------------------------------------------------------------------
+// Values
+// ---------------------------------------------------------------------------
+
+MF_API mf_value* mf_value_scalar(double x);
+MF_API mf_value* mf_value_string(const char* text);
+
+/// A rows x cols matrix copied (and converted) from `data`, row-major.
+MF_API mf_value* mf_value_matrix(size_t rows, size_t cols, mf_class cls, const void* data);
+
+/// A rows x cols matrix over caller memory, without copying. MatFree reads
+/// the memory in place and copies it before modifying it. `release(context)`
+/// is called once no value refers to the memory any more; until then it
+/// must stay valid and unchanged. `release` may be NULL.
+MF_API mf_value* mf_value_borrow(size_t rows, size_t cols, const double* data,
+                                 void (*release)(void* context), void* context);
+
+MF_API void mf_value_free(mf_value* value);
+
+MF_API mf_kind mf_value_kind(const mf_value* value);
+MF_API void mf_value_size(const mf_value* value, size_t* rows, size_t* cols);
+
+/// The elements of a matrix or logical value, row-major, without copying;
+/// valid while `value` lives. NULL for other kinds.
+MF_API const double* mf_value_data(const mf_value* value);
+
+/// Copy the rows*cols elements of a matrix or logical value to `out`,
+/// converted to `cls`. MF_ERROR for other kinds.
+MF_API mf_status mf_value_copy(const mf_value* value, mf_class cls, void* out);
+
+/// The text of a string value (NUL-terminated, valid while `value` lives),
+/// or NULL.
+MF_API const char* mf_value_text(const mf_value* value);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,229 @@
+// MatFree - C embedding API (libmatfree_capi)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "matfree.h"
+#include "core/builtins.h"
+#include "core/interpreter.h"
+#include "core/numeric_types.h"
+#include <algorithm>
+#include <sstream>
+
+using namespace matfree;
+
+struct mf_engine {
+    Interpreter interp;
+    std::ostringstream output;
+    std::string outputText;
+    std::string error;
+};
+
+struct mf_value {
+    ValuePtr value;
+};
+
+namespace {
+
+NumericClass numericClassOf(mf_class cls) {
+    switch (cls) {
+        case MF_DOUBLE: return NumericClass::DOUBLE;
+        case MF_SINGLE: return NumericClass::SINGLE;
+        case MF_INT8: return NumericClass::INT8;
+        case MF_UINT8: return NumericClass::UINT8;
+        case MF_INT16: return NumericClass::INT16;
+        case MF_UINT16: return NumericClass::UINT16;
+        case MF_INT32: return NumericClass::INT32;
+        case MF_UINT32: return NumericClass::UINT32;
+        case MF_INT64: return NumericClass::INT64;
+        case MF_UINT64: return NumericClass::UINT64;
+    }
+    throw RuntimeError("unknown element class");
+}
+
+mf_value* wrap(ValuePtr v) {
+    return v ? new mf_value{std::move(v)} : nullptr;
+}
+
+// Run `fn` for an engine, turning exceptions into MF_ERROR and the
+// engine's last error; nothing may propagate across the C boundary.
+template <typename F>
+mf_status guarded(mf_engine* engine, F&& fn) {
+    if (!engine) return MF_ERROR;
+    engine->error.clear();
+    try {
+        fn();
+        return MF_OK;
+    } catch (const std::exception& e) {
+        engine->error = e.what();
+    } catch (...) {
+        engine->error = "unknown error";
+    }
+    return MF_ERROR;
+}
+
+// Capture what a call prints, for mf_output
+struct OutputScope {
+    mf_engine* engine;
+    explicit OutputScope(mf_engine* e) : engine(e) { engine->output.str(""); }
+    ~OutputScope() { engine->outputText = engine->output.str(); }
+};
+
+} // namespace
+
+int mf_api_version(void) {
+    return MATFREE_CAPI_VERSION;
+}
+
+mf_engine* mf_engine_create(void) {
+    try {
+        auto* engine = new mf_engine();
+        registerAllBuiltins(engine->interp);
+        engine->interp.setOutput(engine->output);
+        return engine;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void mf_engine_destroy(mf_engine* engine) {
+    delete engine;
+}
+
+mf_status mf_eval(mf_engine* engine, const char* code) {
+    return guarded(engine, [&] {
+        OutputScope capture(engine);
+        engine->interp.executeString(code ? code : "");
+    });
+}
+
+mf_status mf_call(mf_engine* engine, const char* name, const mf_value* const* args, size_t nargs,
+                  mf_value** results, size_t nargout) {
+    for (size_t i = 0; i < nargout; i++) results[i] = nullptr;
+    return guarded(engine, [&] {
+        if (!name) throw RuntimeError("mf_call: no function name");
+        ValueList in(nargs);
+        for (size_t i = 0; i < nargs; i++) {
+            if (!args[i]) throw RuntimeError("mf_call: argument " + std::to_string(i + 1) + " is NULL");
+            in[i] = args[i]->value;
+        }
+        OutputScope capture(engine);
+        Interpreter& interp = engine->interp;
+        auto var = interp.globalEnv()->get(name);
+        int want = static_cast<int>(std::max<size_t>(nargout, 1));
+        ValueList out = var && var->isFuncHandle() ? interp.callFuncHandleMulti(var->funcHandle(), in, want)
+                                                   : interp.callFunctionMulti(name, in, want);
+        for (size_t i = 0; i < std::min(nargout, out.size()); i++) results[i] = wrap(out[i]);
+    });
+}
+
+mf_value* mf_get(mf_engine* engine, const char* name) {
+    ValuePtr v;
+    guarded(engine, [&] {
+        v = engine->interp.globalEnv()->get(name ? name : "");
+        if (!v) throw RuntimeError(std::string("Undefined variable '") + (name ? name : "") + "'");
+    });
+    return wrap(std::move(v));
+}
+
+mf_status mf_set(mf_engine* engine, const char* name, const mf_value* value) {
+    return guarded(engine, [&] {
+        if (!name || !value) throw RuntimeError("mf_set: NULL name or value");
+        engine->interp.globalEnv()->set(name, value->value);
+    });
+}
+
+const char* mf_output(const mf_engine* engine) {
+    return engine ? engine->outputText.c_str() : "";
+}
+
+const char* mf_last_error(const mf_engine* engine) {
+    return engine ? engine->error.c_str() : "";
+}
+
+mf_value* mf_value_scalar(double x) {
+    return wrap(Value::makeScalar(x));
+}
+
+mf_value* mf_value_string(const char* text) {
+    return wrap(Value::makeString(text ? text : ""));
+}
+
+mf_value* mf_value_matrix(size_t rows, size_t cols, mf_class cls, const void* data) {
+    try {
+        Matrix m(rows, cols);
+        if (m.numel() > 0) convertToDouble(data, numericClassOf(cls), m.numel(), m.begin());
+        return wrap(Value::makeMatrix(std::move(m)));
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+mf_value* mf_value_borrow(size_t rows, size_t cols, const double* data, void (*release)(void*),
+                          void* context) {
+    try {
+        struct Borrowed {
+            void (*release)(void*);
+            void* context;
+            ~Borrowed() {
+                if (release) release(context);
+            }
+        };
+        std::shared_ptr<void> owner(new Borrowed{release, context});
+        // Not shared on copy: MatFree's first write goes to its own copy
+        return wrap(Value::makeMatrix(
+            Matrix::external(rows, cols, const_cast<double*>(data), std::move(owner), false)));
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void mf_value_free(mf_value* value) {
+    delete value;
+}
+
+mf_kind mf_value_kind(const mf_value* value) {
+    if (!value) return MF_KIND_EMPTY;
+    const Value& v = *value->value;
+    if (v.isEmpty()) return MF_KIND_EMPTY;
+    if (v.isMatrix()) return MF_KIND_MATRIX;
+    if (v.isLogical()) return MF_KIND_LOGICAL;
+    if (v.isString()) return MF_KIND_STRING;
+    return MF_KIND_OTHER;
+}
+
+void mf_value_size(const mf_value* value, size_t* rows, size_t* cols) {
+    size_t r = 0, c = 0;
+    mf_kind kind = mf_value_kind(value);
+    if (kind == MF_KIND_MATRIX || kind == MF_KIND_LOGICAL) {
+        r = value->value->matrix().rows();
+        c = value->value->matrix().cols();
+    } else if (kind == MF_KIND_STRING) {
+        r = 1;
+        c = value->value->string().size();
+    } else if (kind == MF_KIND_OTHER) {
+        r = c = 1;
+    }
+    if (rows) *rows = r;
+    if (cols) *cols = c;
+}
+
+const double* mf_value_data(const mf_value* value) {
+    mf_kind kind = mf_value_kind(value);
+    if (kind != MF_KIND_MATRIX && kind != MF_KIND_LOGICAL) return nullptr;
+    return value->value->matrix().begin();
+}
+
+mf_status mf_value_copy(const mf_value* value, mf_class cls, void* out) {
+    mf_kind kind = mf_value_kind(value);
+    if (kind != MF_KIND_MATRIX && kind != MF_KIND_LOGICAL) return MF_ERROR;
+    try {
+        const Matrix& m = value->value->matrix();
+        if (m.numel() > 0) convertFromDouble(m.begin(), numericClassOf(cls), m.numel(), out);
+        return MF_OK;
+    } catch (...) {
+        return MF_ERROR;
+    }
+}
+
+const char* mf_value_text(const mf_value* value) {
+    return mf_value_kind(value) == MF_KIND_STRING ? value->value->string().c_str() : nullptr;
+}
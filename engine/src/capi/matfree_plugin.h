@@ -0,0 +1,96 @@
+#pragma once
+// MatFree - Native extension (plugin) ABI
+// Copyright (c) 2026 MatFree Contributors - MIT License
+//
+// A plugin is a shared library named <function>.mfx on the search path
+// (addpath). It is loaded the first time <function> is called, and
+// reloaded after `clear mex` if the file has changed since. The library
+// exports mf_plugin_init, which defines its functions through the host.
+// It must define <function>; any other functions it defines become
+// callable once it is loaded.
+//
+// Plugins depend only on this header. Arguments are read-only views of
+// MatFree's storage (no copies). Outputs are allocated by the host and
+// filled in place. Matrices are rows x cols and stored row-major.
+//
+//     #include "capi/matfree_plugin.h"
+//
+//     static int scale(const mf_host* host, mf_call* call, int nargout,
+//                      int nargin, const mf_arg* args, void* data) {
+//         if (nargin != 2) return host->error(call, "scale: expected 2 inputs");
+//         double* out = host->output_matrix(call, 0, args[0].rows, args[0].cols);
+//         for (size_t i = 0; i < args[0].rows * args[0].cols; i++)
+//             out[i] = args[0].data[i] * args[1].data[0];
+//         return 0;
+//     }
+//
+//     MF_PLUGIN_EXPORT int mf_plugin_init(const mf_host* host, mf_registry* registry) {
+//         host->define(registry, "scale", scale, NULL);
+//         return MATFREE_PLUGIN_ABI;
+//     }
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#  define MF_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#  define MF_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+/// ABI version. Plugins return the version they were built against from
+/// mf_plugin_init; the host refuses versions it does not support.
+#define MATFREE_PLUGIN_ABI 1
+
+typedef enum mf_arg_kind {
+    MF_ARG_EMPTY, MF_ARG_MATRIX, MF_ARG_LOGICAL, MF_ARG_STRING, MF_ARG_OTHER
+} mf_arg_kind;
+
+/// One input argument, valid for the duration of the call.
+typedef struct mf_arg {
+    mf_arg_kind kind;
+    size_t rows, cols;  // a string is 1 x length
+    const double* data; // matrices and logicals: rows*cols elements, otherwise NULL
+    const char* text;   // strings: NUL-terminated, otherwise NULL
+} mf_arg;
+
+typedef struct mf_call mf_call;         // one call in progress
+typedef struct mf_registry mf_registry; // definitions made by mf_plugin_init
+
+struct mf_host;
+
+/// A plugin function. Returns 0 on success; on failure, the value of
+/// host->error (or any nonzero value).
+typedef int (*mf_plugin_function)(const struct mf_host* host, mf_call* call, int nargout, int nargin,
+                                  const mf_arg* args, void* data);
+
+/// Services the host provides to plugins.
+typedef struct mf_host {
+    int abi; // MATFREE_PLUGIN_ABI of the host
+
+    /// Output `index` (0-based) as a rows x cols matrix of zeros; returns
+    /// its storage to fill in place. Outputs may be set up to
+    /// max(nargout, 1); NULL beyond that.
+    double* (*output_matrix)(mf_call* call, int index, size_t rows, size_t cols);
+    void (*output_scalar)(mf_call* call, int index, double value);
+    void (*output_string)(mf_call* call, int index, const char* text);
+
+    /// Fail the call with `message` once the function returns. Returns a
+    /// nonzero value for the function to return.
+    int (*error)(mf_call* call, const char* message);
+
+    /// Define a function; only during mf_plugin_init. `data` is passed to
+    /// every call.
+    void (*define)(mf_registry* registry, const char* name, mf_plugin_function fn, void* data);
+} mf_host;
+
+/// Entry point every plugin exports. Returns MATFREE_PLUGIN_ABI, or a
+/// negative value if the plugin cannot be used.
+typedef int (*mf_plugin_init_function)(const mf_host* host, mf_registry* registry);
+
+#ifdef __cplusplus
+}
+#endif
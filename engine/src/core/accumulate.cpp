@@ -0,0 +1,116 @@
+// MatFree - Grouped aggregation kernels
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "accumulate.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace matfree {
+
+namespace {
+
+// Partial accumulators are only replicated when the output is at most this
+// many cells; beyond that the merge would cost more than the scatter.
+constexpr size_t kMaxPartialCells = size_t(1) << 18;
+
+// Fixed upper bound on partial accumulators (independent of thread count).
+constexpr size_t kMaxPartials = 16;
+
+constexpr size_t kMinAccumGrain = size_t(1) << 16;
+
+struct Partial {
+    std::vector<double> acc;
+    std::vector<double> count;
+};
+
+double identityOf(AccumOp op) {
+    switch (op) {
+    case AccumOp::PROD: return 1.0;
+    case AccumOp::MAX:
+    case AccumOp::MIN: return std::numeric_limits<double>::quiet_NaN(); // fmax/fmin identity
+    default: return 0.0;
+    }
+}
+
+template <typename Combine>
+void scatter(Partial& p, const size_t* target, const double* vals, double scalarVal,
+             size_t begin, size_t end, Combine combine) {
+    double* acc = p.acc.data();
+    double* cnt = p.count.data();
+    if (vals) {
+        for (size_t i = begin; i < end; i++) {
+            size_t t = target[i];
+            acc[t] = combine(acc[t], vals[i]);
+            cnt[t] += 1.0;
+        }
+    } else {
+        for (size_t i = begin; i < end; i++) {
+            size_t t = target[i];
+            acc[t] = combine(acc[t], scalarVal);
+            cnt[t] += 1.0;
+        }
+    }
+}
+
+template <typename F>
+void withCombine(AccumOp op, F&& f) {
+    switch (op) {
+    case AccumOp::PROD: f([](double a, double b) { return a * b; }); break;
+    case AccumOp::MAX:  f([](double a, double b) { return std::fmax(a, b); }); break;
+    case AccumOp::MIN:  f([](double a, double b) { return std::fmin(a, b); }); break;
+    default:            f([](double a, double b) { return a + b; }); break;
+    }
+}
+
+} // namespace
+
+std::vector<double> accumulate(const size_t* target, size_t n, const double* vals,
+                               double scalarVal, size_t outSize, AccumOp op, double fill) {
+    size_t grain = std::max(kMinAccumGrain, (n + kMaxPartials - 1) / kMaxPartials);
+    if (outSize > kMaxPartialCells) grain = std::max<size_t>(n, 1);
+    size_t nchunks = std::max<size_t>(parallelChunkCount(n, grain), 1);
+
+    std::vector<Partial> partial(nchunks);
+    withCombine(op, [&](auto combine) {
+        parallelForChunks(n, grain, [&](size_t chunk, size_t begin, size_t end) {
+            Partial& p = partial[chunk];
+            p.acc.assign(outSize, identityOf(op));
+            p.count.assign(outSize, 0.0);
+            scatter(p, target, vals, scalarVal, begin, end, combine);
+        });
+        Partial& total = partial[0];
+        if (total.acc.empty()) {
+            total.acc.assign(outSize, identityOf(op));
+            total.count.assign(outSize, 0.0);
+        }
+        for (size_t c = 1; c < nchunks; c++) {
+            for (size_t k = 0; k < outSize; k++) {
+                total.acc[k] = combine(total.acc[k], partial[c].acc[k]);
+                total.count[k] += partial[c].count[k];
+            }
+        }
+    });
+
+    std::vector<double> out = std::move(partial[0].acc);
+    const std::vector<double>& count = partial[0].count;
+    for (size_t k = 0; k < outSize; k++) {
+        if (count[k] == 0.0) out[k] = fill;
+        else if (op == AccumOp::MEAN) out[k] /= count[k];
+        else if (op == AccumOp::COUNT) out[k] = count[k];
+    }
+    return out;
+}
+
+void groupByTarget(const size_t* target, size_t n, size_t outSize,
+                   std::vector<size_t>& start, std::vector<size_t>& order) {
+    start.assign(outSize + 1, 0);
+    for (size_t i = 0; i < n; i++) start[target[i] + 1]++;
+    for (size_t k = 0; k < outSize; k++) start[k + 1] += start[k];
+    order.resize(n);
+    std::vector<size_t> next(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < n; i++) order[next[target[i]]++] = i;
+}
+
+} // namespace matfree
@@ -0,0 +1,27 @@
+#pragma once
+// MatFree - Grouped aggregation kernels (accumarray)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include <cstddef>
+#include <vector>
+
+namespace matfree {
+
+/// Reductions with a dedicated scatter kernel.
+enum class AccumOp { SUM, PROD, MAX, MIN, MEAN, COUNT };
+
+/// Single-pass scatter reduction: every entry i adds vals[i] (or
+/// `scalarVal` when vals is null) to output cell target[i] with `op`.
+/// Cells that receive no entry are set to `fill`. Large inputs with a
+/// moderate output size are split into a fixed number of chunks, each with
+/// private partial accumulators merged in chunk order, so results do not
+/// depend on the thread count. MAX and MIN ignore NaN.
+std::vector<double> accumulate(const size_t* target, size_t n, const double* vals,
+                               double scalarVal, size_t outSize, AccumOp op, double fill);
+
+/// Stable counting sort of entry positions by target cell: the entries of
+/// cell k are order[start[k]] .. order[start[k + 1] - 1], in input order.
+void groupByTarget(const size_t* target, size_t n, size_t outSize,
+                   std::vector<size_t>& start, std::vector<size_t>& order);
+
+} // namespace matfree
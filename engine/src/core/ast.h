@@ -204,6 +204,14 @@ struct ForStmt {
     StmtList body;
 };
 
+/// Parallel loop: parfor i = expr ... end, or parfor (i = expr, M) ... end
+struct ParforStmt {
+    std::string variable;
+    ExprPtr range;
+    ExprPtr maxWorkers; // nullptr if not provided
+    StmtList body;
+};
+
 /// While loop: while cond ... end
 struct WhileStmt {
     ExprPtr condition;
@@ -270,6 +278,7 @@ using StmtVariant = std::variant<
     MultiAssignStmt,
     IfStmt,
     ForStmt,
+    ParforStmt,
     WhileStmt,
     SwitchStmt,
     TryCatchStmt,
@@ -2,15 +2,31 @@
 // Copyright (c) 2026 MatFree Contributors - MIT License
 
 #include "builtins.h"
+#include "sorting.h"
+#include "statistics.h"
+#include "histogram.h"
+#include "scan.h"
+#include "sets.h"
+#include "accumulate.h"
+#include "parallel.h"
+#include "workspace_file.h"
+#include "memmap.h"
+#include "delimited_text.h"
+#include "format.h"
+#include "file_io.h"
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <numeric>
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <filesystem>
 #include <chrono>
 #include <random>
 #include <functional>
+#include <limits>
+#include <unordered_map>
 
 namespace matfree {
 
@@ -29,6 +45,55 @@ static void requireMinArgs(const std::string& name, const ValueList& args, size_
     }
 }
 
+// Helper: the size arguments of rand-style constructors, starting at
+// args[first]: none (1x1), n (n x n), [r c], or r, c. Trailing class names
+// such as 'double' are accepted and ignored.
+static std::pair<size_t, size_t> randomSize(const std::string& name, const ValueList& args, size_t first) {
+    std::vector<double> dims;
+    for (size_t i = first; i < args.size(); i++) {
+        if (args[i]->isString()) {
+            if (args[i]->string() != "double") throw RuntimeError(name + ": unsupported option '" + args[i]->string() + "'");
+            continue;
+        }
+        const Matrix& m = args[i]->matrix();
+        if (i == first && args.size() - first == 1 && m.numel() > 1) {
+            dims.assign(m.begin(), m.end());
+        } else {
+            dims.push_back(args[i]->scalarDouble());
+        }
+    }
+    if (dims.empty()) return {1, 1};
+    if (dims.size() == 1) dims.push_back(dims[0]);
+    for (size_t i = 2; i < dims.size(); i++)
+        if (dims[i] != 1) throw RuntimeError(name + ": only 2-D sizes are supported");
+    auto count = [](double d) { return d > 0 ? static_cast<size_t>(d) : size_t(0); };
+    return {count(dims[0]), count(dims[1])};
+}
+
+// Helper: a scalar non-negative integer count argument
+static size_t nonNegativeCount(const std::string& name, const ValuePtr& arg) {
+    double d = arg->scalarDouble();
+    if (!(d >= 0) || d != std::floor(d)) throw RuntimeError(name + ": expected a non-negative integer");
+    return static_cast<size_t>(d);
+}
+
+// Tall arrays are structs naming their datastore and the reduction that
+// gather() will stream over it ("gather" for the array itself).
+static bool isTall(const ValuePtr& v) {
+    return v->isStruct() && v->structVal().fields.count("TallOp");
+}
+
+static ValuePtr tallReduction(const std::string& name, const ValuePtr& tall, const std::string& op,
+                              ValuePtr bins = nullptr) {
+    const MFStruct& t = tall->structVal();
+    if (t.fields.at("TallOp")->string() != "gather")
+        throw RuntimeError(name + ": reductions of reduced tall arrays are not supported");
+    MFStruct r = t;
+    r.fields["TallOp"] = Value::makeString(op);
+    if (bins) r.fields["Bins"] = bins;
+    return Value::makeStruct(std::move(r));
+}
+
 // ============================================================================
 // Math built-ins
 // ============================================================================
@@ -106,74 +171,64 @@ void registerMathBuiltins(Interpreter& interp) {
         return Value::makeScalar(std::remainder(a, b));
     });
 
-    // max, min
-    interp.registerBuiltin("max", [](const ValueList& args) -> ValuePtr {
-        if (args.size() == 1) {
-            auto& m = args[0]->matrix();
-            if (m.isVector() || m.isScalar()) {
-                return Value::makeScalar(m.maxVal());
-            }
-            // Along dimension 1 (columnwise)
-            Matrix result(1, m.cols());
-            for (size_t j = 0; j < m.cols(); j++) {
-                double mx = m(0, j);
-                for (size_t i = 1; i < m.rows(); i++) mx = std::max(mx, m(i, j));
-                result(0, j) = mx;
-            }
-            return Value::makeMatrix(std::move(result));
-        }
-        if (args.size() == 2) {
-            // Element-wise max of two arrays
-            if (args[0]->isScalar() && args[1]->isScalar()) {
-                return Value::makeScalar(std::max(args[0]->scalarDouble(), args[1]->scalarDouble()));
-            }
-            auto& a = args[0]->matrix();
-            auto& b = args[1]->matrix();
-            size_t r = std::max(a.rows(), b.rows());
-            size_t c = std::max(a.cols(), b.cols());
-            Matrix result(r, c);
-            for (size_t i = 0; i < r; i++)
-                for (size_t j = 0; j < c; j++)
-                    result(i, j) = std::max(a.getWithBroadcast(i, j), b.getWithBroadcast(i, j));
-            return Value::makeMatrix(std::move(result));
-        }
-        throw RuntimeError("max: too many arguments");
-    });
-
-    interp.registerBuiltin("min", [](const ValueList& args) -> ValuePtr {
-        if (args.size() == 1) {
-            auto& m = args[0]->matrix();
-            if (m.isVector() || m.isScalar()) {
-                return Value::makeScalar(m.minVal());
-            }
-            Matrix result(1, m.cols());
-            for (size_t j = 0; j < m.cols(); j++) {
-                double mn = m(0, j);
-                for (size_t i = 1; i < m.rows(); i++) mn = std::min(mn, m(i, j));
-                result(0, j) = mn;
+    // max, min: [m, i] = max(x) also gives the index of the (first) extreme
+    // of a vector, or the row of each column's; max(a, b) is elementwise
+    auto makeExtremum = [](const std::string& name, bool isMax) {
+        return [name, isMax](const ValueList& args, int nargout) -> ValueList {
+            if (args.size() == 1 && isTall(args[0])) return {tallReduction(name, args[0], name)};
+            if (args.size() == 1) {
+                auto& m = args[0]->matrix();
+                if (m.isVector() || m.isScalar()) {
+                    double best = isMax ? m.maxVal() : m.minVal();
+                    if (nargout < 2) return {Value::makeScalar(best)};
+                    auto at = isMax ? std::max_element(m.begin(), m.end()) : std::min_element(m.begin(), m.end());
+                    return {Value::makeScalar(best), Value::makeScalar(static_cast<double>(at - m.begin() + 1))};
+                }
+                // Along dimension 1 (columnwise)
+                Matrix result(1, m.cols());
+                Matrix index(1, m.cols());
+                for (size_t j = 0; j < m.cols(); j++) {
+                    double best = m(0, j);
+                    size_t at = 0;
+                    for (size_t i = 1; i < m.rows(); i++) {
+                        if (isMax ? best < m(i, j) : m(i, j) < best) {
+                            best = m(i, j);
+                            at = i;
+                        }
+                    }
+                    result(0, j) = best;
+                    index(0, j) = static_cast<double>(at + 1);
+                }
+                if (nargout < 2) return {Value::makeMatrix(std::move(result))};
+                return {Value::makeMatrix(std::move(result)), Value::makeMatrix(std::move(index))};
             }
-            return Value::makeMatrix(std::move(result));
-        }
-        if (args.size() == 2) {
-            if (args[0]->isScalar() && args[1]->isScalar()) {
-                return Value::makeScalar(std::min(args[0]->scalarDouble(), args[1]->scalarDouble()));
+            if (args.size() == 2) {
+                if (nargout > 1) throw RuntimeError(name + ": two outputs need a single input");
+                auto pick = [isMax](double x, double y) { return isMax ? std::max(x, y) : std::min(x, y); };
+                // Element-wise extreme of two arrays
+                if (args[0]->isScalar() && args[1]->isScalar()) {
+                    return {Value::makeScalar(pick(args[0]->scalarDouble(), args[1]->scalarDouble()))};
+                }
+                auto& a = args[0]->matrix();
+                auto& b = args[1]->matrix();
+                size_t r = std::max(a.rows(), b.rows());
+                size_t c = std::max(a.cols(), b.cols());
+                Matrix result(r, c);
+                for (size_t i = 0; i < r; i++)
+                    for (size_t j = 0; j < c; j++)
+                        result(i, j) = pick(a.getWithBroadcast(i, j), b.getWithBroadcast(i, j));
+                return {Value::makeMatrix(std::move(result))};
             }
-            auto& a = args[0]->matrix();
-            auto& b = args[1]->matrix();
-            size_t r = std::max(a.rows(), b.rows());
-            size_t c = std::max(a.cols(), b.cols());
-            Matrix result(r, c);
-            for (size_t i = 0; i < r; i++)
-                for (size_t j = 0; j < c; j++)
-                    result(i, j) = std::min(a.getWithBroadcast(i, j), b.getWithBroadcast(i, j));
-            return Value::makeMatrix(std::move(result));
-        }
-        throw RuntimeError("min: too many arguments");
-    });
+            throw RuntimeError(name + ": too many arguments");
+        };
+    };
+    interp.registerMultiBuiltin("max", makeExtremum("max", true));
+    interp.registerMultiBuiltin("min", makeExtremum("min", false));
 
-    // sum, prod, cumsum, cumprod
+    // sum, prod
     interp.registerBuiltin("sum", [](const ValueList& args) -> ValuePtr {
         requireMinArgs("sum", args, 1);
+        if (isTall(args[0])) return tallReduction("sum", args[0], "sum");
         auto& m = args[0]->matrix();
         if (args.size() == 1) {
             if (m.isVector() || m.isScalar()) return Value::makeScalar(m.sum());
@@ -197,34 +252,130 @@ void registerMathBuiltins(Interpreter& interp) {
         return Value::makeMatrix(std::move(result));
     });
 
-    interp.registerBuiltin("cumsum", [](const ValueList& args) -> ValuePtr {
-        requireArgs("cumsum", args, 1);
-        auto& m = args[0]->matrix();
-        Matrix result(m.rows(), m.cols());
-        if (m.isVector()) {
-            double s = 0;
-            for (size_t i = 0; i < m.numel(); i++) {
-                s += m(i);
-                result(i) = s;
-            }
-        } else {
-            // Along dim 1 (column-wise)
-            for (size_t j = 0; j < m.cols(); j++) {
-                double s = 0;
-                for (size_t i = 0; i < m.rows(); i++) {
-                    s += m(i, j);
-                    result(i, j) = s;
+    // cumsum, cumprod, cummax, cummin: f(x, [dim], ['forward' | 'reverse'],
+    // ['includenan' | 'omitnan'])
+    auto makeScan = [](const std::string& name, ScanOp op) {
+        return [name, op](const ValueList& args) -> ValuePtr {
+            requireMinArgs(name, args, 1);
+            const Matrix& m = args[0]->matrix();
+            int dim = 0;
+            bool reverse = false;
+            NanFlag nanFlag = defaultScanNanFlag(op);
+            for (size_t i = 1; i < args.size(); i++) {
+                if (args[i]->isString()) {
+                    std::string opt = args[i]->string();
+                    std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+                    if (opt == "forward") reverse = false;
+                    else if (opt == "reverse") reverse = true;
+                    else if (opt == "omitnan") nanFlag = NanFlag::OMIT;
+                    else if (opt == "includenan") nanFlag = NanFlag::INCLUDE;
+                    else throw RuntimeError(name + ": unknown option '" + args[i]->string() + "'");
+                } else {
+                    dim = static_cast<int>(args[i]->scalarDouble());
+                    if (dim < 1) throw RuntimeError(name + ": dimension must be a positive integer");
                 }
             }
-        }
-        return Value::makeMatrix(std::move(result));
-    });
+            if (dim == 0) dim = defaultSortDim(m);
+            return Value::makeMatrix(scanAlongDim(m, dim, op, nanFlag, reverse));
+        };
+    };
+    interp.registerBuiltin("cumsum",  makeScan("cumsum",  ScanOp::SUM));
+    interp.registerBuiltin("cumprod", makeScan("cumprod", ScanOp::PROD));
+    interp.registerBuiltin("cummax",  makeScan("cummax",  ScanOp::MAX));
+    interp.registerBuiltin("cummin",  makeScan("cummin",  ScanOp::MIN));
+
+    // diff(x, [n], [dim]): n-th order differences
+    interp.registerBuiltin("diff", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("diff", args, 1);
+        const Matrix& m = args[0]->matrix();
+        double order = (args.size() >= 2 && !(args[1]->isMatrix() && args[1]->matrix().numel() == 0))
+                           ? args[1]->scalarDouble() : 1.0;
+        if (order < 0 || order != std::floor(order))
+            throw RuntimeError("diff: order must be a non-negative integer");
+        int dim = (args.size() >= 3) ? static_cast<int>(args[2]->scalarDouble()) : defaultSortDim(m);
+        return Value::makeMatrix(diffAlongDim(m, static_cast<size_t>(order), dim));
+    });
+    // Side-effect-free built-ins may be called from any thread; the
+    // elementwise ones map each element independently (see cellfun/arrayfun)
+    for (const char* name : {"sin", "cos", "tan", "asin", "acos", "atan", "sinh", "cosh", "tanh",
+                             "exp", "log", "log2", "log10", "sqrt", "abs", "floor", "ceil",
+                             "round", "fix", "sign", "real", "imag", "conj"})
+        interp.setBuiltinTraits(name, ELEMENTWISE_BUILTIN);
+    for (const char* name : {"atan2", "mod", "rem", "max", "min", "sum", "prod"})
+        interp.setBuiltinTraits(name, PURE_BUILTIN);
 }
 
 // ============================================================================
 // Matrix construction and manipulation built-ins
 // ============================================================================
 
+// Set builtins: convert an argument to kernel keys. Char data is treated as
+// one string when the other operand is a cell array, otherwise as codes.
+static SetKeys toSetKeys(const std::string& name, const ValuePtr& v, bool asString) {
+    SetKeys keys;
+    if (v->isCellArray()) {
+        keys.isString = true;
+        for (auto& e : v->cellArray().data) {
+            if (!e || !e->isString())
+                throw RuntimeError(name + ": cell array inputs must contain only strings");
+            keys.strings.push_back(e->string());
+        }
+    } else if (v->isString() && asString) {
+        keys.isString = true;
+        keys.strings.push_back(v->string());
+    } else if (v->isString()) {
+        for (unsigned char ch : v->string()) keys.numbers.push_back(static_cast<double>(ch));
+    } else if (v->isNumeric() || v->isEmpty()) {
+        if (v->isNumeric()) keys.numbers.assign(v->matrix().begin(), v->matrix().end());
+    } else {
+        throw RuntimeError(name + ": inputs must be numeric, char or cell arrays of strings");
+    }
+    return keys;
+}
+
+// 'sorted' (default) or 'stable' among the trailing arguments
+static bool parseSetOrder(const std::string& name, const ValueList& args, size_t first) {
+    bool sorted = true;
+    for (size_t i = first; i < args.size(); i++) {
+        std::string opt = args[i]->isString() ? args[i]->string() : "";
+        std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+        if (opt == "sorted") sorted = true;
+        else if (opt == "stable") sorted = false;
+        else throw RuntimeError(name + ": unknown option");
+    }
+    return sorted;
+}
+
+// Set results keep row orientation only when the inputs are rows
+static bool isRowInput(const ValuePtr& v) {
+    if (v->isString()) return true;
+    if (v->isCellArray()) return v->cellArray().rows <= 1;
+    if (v->isNumeric()) return v->matrix().rows() <= 1 || v->matrix().numel() == 0;
+    return true;
+}
+
+static ValuePtr setResultValue(const SetKeys& keys, bool asChar, bool row) {
+    size_t n = keys.size();
+    size_t r = row ? 1 : n, c = row ? n : 1;
+    if (keys.isString) {
+        CellArray cell(r, c);
+        for (size_t i = 0; i < n; i++) cell.data[i] = Value::makeString(keys.strings[i]);
+        return Value::makeCellArray(std::move(cell));
+    }
+    if (asChar) {
+        std::string str;
+        for (double d : keys.numbers) str += static_cast<char>(d);
+        return Value::makeString(str);
+    }
+    return Value::makeMatrix(Matrix(r, c, keys.numbers));
+}
+
+static ValuePtr indexColumn(const std::vector<size_t>& positions) {
+    Matrix idx(positions.size(), 1);
+    for (size_t i = 0; i < positions.size(); i++) idx(i) = static_cast<double>(positions[i] + 1);
+    return Value::makeMatrix(std::move(idx));
+}
+
 void registerMatrixBuiltins(Interpreter& interp) {
     // zeros
     interp.registerBuiltin("zeros", [](const ValueList& args) -> ValuePtr {
@@ -262,28 +413,145 @@ void registerMatrixBuiltins(Interpreter& interp) {
         return Value::makeMatrix(Matrix::eye(r, c));
     });
 
-    // rand
+    // rand, randn: uniform (0, 1) and standard normal draws from the
+    // session's counter-based stream (see random.h)
     interp.registerBuiltin("rand", [](const ValueList& args) -> ValuePtr {
-        if (args.empty()) return Value::makeScalar(Matrix::rand(1, 1)(0, 0));
-        if (args.size() == 1) {
-            size_t n = static_cast<size_t>(args[0]->scalarDouble());
-            return Value::makeMatrix(Matrix::rand(n, n));
-        }
-        size_t r = static_cast<size_t>(args[0]->scalarDouble());
-        size_t c = static_cast<size_t>(args[1]->scalarDouble());
-        return Value::makeMatrix(Matrix::rand(r, c));
+        auto [r, c] = randomSize("rand", args, 0);
+        return Value::makeMatrix(Matrix::rand(r, c, Interpreter::current().session().rng));
     });
 
-    // randn
     interp.registerBuiltin("randn", [](const ValueList& args) -> ValuePtr {
-        if (args.empty()) return Value::makeScalar(Matrix::randn(1, 1)(0, 0));
-        if (args.size() == 1) {
-            size_t n = static_cast<size_t>(args[0]->scalarDouble());
-            return Value::makeMatrix(Matrix::randn(n, n));
+        auto [r, c] = randomSize("randn", args, 0);
+        return Value::makeMatrix(Matrix::randn(r, c, Interpreter::current().session().rng));
+    });
+
+    // randi(imax, ...) or randi([imin imax], ...): uniform integers
+    interp.registerBuiltin("randi", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("randi", args, 1);
+        const Matrix& limits = args[0]->matrix();
+        double lo = 1, hi;
+        if (limits.numel() == 1) {
+            hi = limits(0);
+        } else if (limits.numel() == 2) {
+            lo = limits(0);
+            hi = limits(1);
+        } else {
+            throw RuntimeError("randi: the first argument must be imax or [imin imax]");
         }
-        size_t r = static_cast<size_t>(args[0]->scalarDouble());
-        size_t c = static_cast<size_t>(args[1]->scalarDouble());
-        return Value::makeMatrix(Matrix::randn(r, c));
+        if (lo != std::floor(lo) || hi != std::floor(hi))
+            throw RuntimeError("randi: the limits must be integers");
+        auto [r, c] = randomSize("randi", args, 1);
+        Matrix result(r, c);
+        Interpreter::current().session().rng.fillIntegers(result.begin(), result.numel(), lo, hi);
+        return Value::makeMatrix(std::move(result));
+    });
+
+    // randperm(n) or randperm(n, k): a random permutation of 1..n (first k)
+    interp.registerBuiltin("randperm", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("randperm", args, 1);
+        size_t n = nonNegativeCount("randperm", args[0]);
+        size_t k = args.size() > 1 ? nonNegativeCount("randperm", args[1]) : n;
+        auto values = Interpreter::current().session().rng.permutation(n, k);
+        return Value::makeMatrix(Matrix(1, k, std::move(values)));
+    });
+
+    // randsample(n, k), randsample(population, k), randsample(..., replace)
+    // and randsample(..., true, w) for weighted sampling with replacement
+    interp.registerBuiltin("randsample", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("randsample", args, 2);
+        Matrix population;
+        bool row = false;
+        if (args[0]->isScalar()) {
+            size_t n = nonNegativeCount("randsample", args[0]);
+            population = Matrix(n, 1);
+            for (size_t i = 0; i < n; i++) population(i) = static_cast<double>(i + 1);
+        } else {
+            population = args[0]->toMatrix();
+            row = population.rows() == 1;
+        }
+        size_t n = population.numel();
+        size_t k = nonNegativeCount("randsample", args[1]);
+        bool replace = args.size() > 2 && args[2]->toBool();
+        RandomStream& rng = Interpreter::current().session().rng;
+
+        std::vector<double> picks(k);
+        if (args.size() > 3) {
+            if (!replace) throw RuntimeError("randsample: weighted sampling requires replacement");
+            const Matrix& w = args[3]->matrix();
+            if (w.numel() != n) throw RuntimeError("randsample: the weights must match the population");
+            std::vector<double> cumulative(n);
+            double total = 0;
+            for (size_t i = 0; i < n; i++) {
+                if (!(w(i) >= 0)) throw RuntimeError("randsample: the weights must be non-negative");
+                cumulative[i] = total += w(i);
+            }
+            if (!(total > 0)) throw RuntimeError("randsample: the weights must not all be zero");
+            rng.fillUniform(picks.data(), k);
+            for (auto& p : picks) {
+                size_t i = std::upper_bound(cumulative.begin(), cumulative.end(), p * total) - cumulative.begin();
+                p = population(std::min(i, n - 1));
+            }
+        } else if (replace) {
+            if (k > 0 && n == 0) throw RuntimeError("randsample: the population is empty");
+            rng.fillIntegers(picks.data(), k, 0, static_cast<double>(n) - 1);
+            for (auto& p : picks) p = population(static_cast<size_t>(p));
+        } else {
+            if (k > n) throw RuntimeError("randsample: k must not exceed the population size without replacement");
+            picks = rng.permutation(n, k);
+            for (auto& p : picks) p = population(static_cast<size_t>(p) - 1);
+        }
+        return Value::makeMatrix(row ? Matrix(1, k, std::move(picks)) : Matrix(k, 1, std::move(picks)));
+    });
+
+    // rng(seed), rng('default'), rng('shuffle'), rng(s) and s = rng. Every
+    // generator name selects the Philox stream; sequences are reproducible
+    // within MatFree but differ from MATLAB's.
+    interp.registerBuiltin("rng", [](const ValueList& args) -> ValuePtr {
+        SessionState& session = Interpreter::current().session();
+        RandomStream& rng = session.rng;
+        if (args.empty()) {
+            MFStruct s;
+            s.fields["Type"] = Value::makeString("philox");
+            s.fields["Seed"] = Value::makeScalar(static_cast<double>(rng.seed()));
+            Matrix state(1, 4);
+            state(0) = static_cast<double>(rng.stream() >> 32);
+            state(1) = static_cast<double>(rng.stream() & 0xFFFFFFFFu);
+            state(2) = static_cast<double>(rng.position());
+            state(3) = static_cast<double>(session.substreamsUsed);
+            s.fields["State"] = Value::makeMatrix(std::move(state));
+            return Value::makeStruct(std::move(s));
+        }
+        if (args[0]->isStruct()) {
+            auto& fields = args[0]->structVal().fields;
+            auto seed = fields.find("Seed");
+            auto state = fields.find("State");
+            if (seed == fields.end() || state == fields.end() || state->second->matrix().numel() != 4)
+                throw RuntimeError("rng: expected a settings structure returned by rng");
+            const Matrix& st = state->second->matrix();
+            uint64_t stream = (static_cast<uint64_t>(st(0)) << 32) | static_cast<uint64_t>(st(1));
+            rng = RandomStream(static_cast<uint64_t>(seed->second->scalarDouble()), stream,
+                               static_cast<uint64_t>(st(2)));
+            session.substreamsUsed = static_cast<uint64_t>(st(3));
+            return Value::makeEmpty();
+        }
+        uint64_t seed;
+        if (args[0]->isString()) {
+            std::string mode = args[0]->string();
+            if (mode == "default") seed = 0;
+            // Kept below 2^53 like numeric seeds, so Seed round-trips as a double
+            else if (mode == "shuffle") seed = ((static_cast<uint64_t>(std::random_device{}()) << 32) ^
+                                                static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())) &
+                                               ((uint64_t(1) << 53) - 1);
+            else throw RuntimeError("rng: unknown option '" + mode + "'");
+        } else {
+            double d = args[0]->scalarDouble();
+            if (!(d >= 0) || d != std::floor(d) || d >= 0x1.0p53)
+                throw RuntimeError("rng: the seed must be a non-negative integer");
+            seed = static_cast<uint64_t>(d);
+        }
+        rng.reset(seed);
+        session.substreamsUsed = 0;
+        return Value::makeEmpty();
     });
 
     // linspace
@@ -307,30 +575,28 @@ void registerMatrixBuiltins(Interpreter& interp) {
         return Value::makeMatrix(std::move(result));
     });
 
-    // size
-    interp.registerBuiltin("size", [](const ValueList& args) -> ValuePtr {
+    // size; [r, c, ...] = size(x) gives one dimension per output
+    interp.registerMultiBuiltin("size", [](const ValueList& args, int nargout) -> ValueList {
         requireMinArgs("size", args, 1);
+        double rows = 1, cols = 1;
         if (args[0]->isNumeric()) {
-            auto& m = args[0]->matrix();
-            if (args.size() == 1) {
-                Matrix result(1, 2);
-                result(0, 0) = static_cast<double>(m.rows());
-                result(0, 1) = static_cast<double>(m.cols());
-                return Value::makeMatrix(std::move(result));
-            }
-            int dim = static_cast<int>(args[1]->scalarDouble());
-            if (dim == 1) return Value::makeScalar(static_cast<double>(m.rows()));
-            if (dim == 2) return Value::makeScalar(static_cast<double>(m.cols()));
-            return Value::makeScalar(1.0);
-        }
-        if (args[0]->isString()) {
-            return Value::makeMatrix(Matrix(1, 2, {1.0, static_cast<double>(args[0]->string().size())}));
+            rows = static_cast<double>(args[0]->matrix().rows());
+            cols = static_cast<double>(args[0]->matrix().cols());
+        } else if (args[0]->isString()) {
+            cols = static_cast<double>(args[0]->string().size());
+        } else if (args[0]->isCellArray()) {
+            rows = static_cast<double>(args[0]->cellArray().rows);
+            cols = static_cast<double>(args[0]->cellArray().cols);
         }
-        if (args[0]->isCellArray()) {
-            auto& c = args[0]->cellArray();
-            return Value::makeMatrix(Matrix(1, 2, {static_cast<double>(c.rows), static_cast<double>(c.cols)}));
+        if (args.size() > 1) {
+            if (nargout > 1) throw RuntimeError("size: too many output arguments with a dimension");
+            int dim = static_cast<int>(args[1]->scalarDouble());
+            return {Value::makeScalar(dim == 1 ? rows : dim == 2 ? cols : 1.0)};
         }
-        return Value::makeMatrix(Matrix(1, 2, {1.0, 1.0}));
+        if (nargout < 2) return {Value::makeMatrix(Matrix(1, 2, {rows, cols}))};
+        ValueList dims{Value::makeScalar(rows), Value::makeScalar(cols)};
+        while (dims.size() < static_cast<size_t>(nargout)) dims.push_back(Value::makeScalar(1.0));
+        return dims;
     });
 
     // length
@@ -444,17 +710,168 @@ void registerMatrixBuiltins(Interpreter& interp) {
         return Value::makeMatrix(Matrix::vertcat(mats));
     });
 
-    // sort
-    interp.registerBuiltin("sort", [](const ValueList& args) -> ValuePtr {
+    // sort: [s, idx] = sort(x, dim, 'ascend'|'descend')
+    interp.registerMultiBuiltin("sort", [](const ValueList& args, int nargout) -> ValueList {
         requireMinArgs("sort", args, 1);
-        auto m = args[0]->matrix(); // copy
-        auto& d = m.data();
-        std::sort(d.begin(), d.end());
-        return Value::makeMatrix(std::move(m));
+        int dim = 0;
+        SortOrder order = SortOrder::ASCEND;
+        for (size_t i = 1; i < args.size(); i++) {
+            if (args[i]->isString()) {
+                std::string mode = args[i]->string();
+                std::transform(mode.begin(), mode.end(), mode.begin(), ::tolower);
+                if (mode == "ascend") order = SortOrder::ASCEND;
+                else if (mode == "descend") order = SortOrder::DESCEND;
+                else throw RuntimeError("sort: unknown option '" + args[i]->string() + "'");
+            } else {
+                dim = static_cast<int>(args[i]->scalarDouble());
+                if (dim < 1) throw RuntimeError("sort: dimension must be a positive integer");
+            }
+        }
+        bool wantIdx = nargout >= 2;
+
+        if (args[0]->isCellArray()) {
+            // Cell array of strings: lexicographic, stable
+            auto& cell = args[0]->cellArray();
+            std::vector<size_t> perm(cell.data.size());
+            std::iota(perm.begin(), perm.end(), 0);
+            std::vector<std::string> keys;
+            for (auto& v : cell.data) {
+                if (!v || !v->isString()) throw RuntimeError("sort: cell array must contain only strings");
+                keys.push_back(v->string());
+            }
+            std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) {
+                return order == SortOrder::ASCEND ? keys[a] < keys[b] : keys[b] < keys[a];
+            });
+            CellArray sorted(cell.rows, cell.cols);
+            Matrix idx(cell.rows, cell.cols);
+            for (size_t i = 0; i < perm.size(); i++) {
+                sorted.data[i] = cell.data[perm[i]];
+                idx(i) = static_cast<double>(perm[i] + 1);
+            }
+            return {Value::makeCellArray(std::move(sorted)), Value::makeMatrix(std::move(idx))};
+        }
+
+        const Matrix m = args[0]->toMatrix();
+        if (dim == 0) dim = defaultSortDim(m);
+        auto res = sortAlongDim(m, dim, order, wantIdx);
+        ValuePtr sorted;
+        if (args[0]->isString()) {
+            std::string str;
+            for (size_t i = 0; i < res.values.numel(); i++) str += static_cast<char>(res.values(i));
+            sorted = Value::makeString(str);
+        } else {
+            sorted = Value::makeMatrix(std::move(res.values));
+        }
+        if (!wantIdx) return {sorted};
+        return {sorted, Value::makeMatrix(std::move(res.indices))};
     });
 
-    // find
-    interp.registerBuiltin("find", [](const ValueList& args) -> ValuePtr {
+    // sortrows: [B, idx] = sortrows(A, column), negative columns sort descending
+    interp.registerMultiBuiltin("sortrows", [](const ValueList& args, int nargout) -> ValueList {
+        requireMinArgs("sortrows", args, 1);
+        auto& m = args[0]->matrix();
+        std::vector<int> columns;
+        bool descend = false;
+        for (size_t i = 1; i < args.size(); i++) {
+            if (args[i]->isString()) {
+                std::string mode = args[i]->string();
+                std::transform(mode.begin(), mode.end(), mode.begin(), ::tolower);
+                if (mode == "descend") descend = true;
+                else if (mode != "ascend")
+                    throw RuntimeError("sortrows: unknown option '" + args[i]->string() + "'");
+            } else {
+                auto& cm = args[i]->matrix();
+                for (size_t k = 0; k < cm.numel(); k++) columns.push_back(static_cast<int>(cm(k)));
+            }
+        }
+        if (descend) {
+            if (columns.empty())
+                for (size_t j = 0; j < m.cols(); j++) columns.push_back(static_cast<int>(j + 1));
+            for (auto& c : columns) c = -c;
+        }
+        auto res = sortRows(m, columns, nargout >= 2);
+        if (nargout < 2) return {Value::makeMatrix(std::move(res.values))};
+        return {Value::makeMatrix(std::move(res.values)), Value::makeMatrix(std::move(res.indices))};
+    });
+
+    // [C, ia, ic] = unique(A, ['sorted' | 'stable'])
+    interp.registerMultiBuiltin("unique", [](const ValueList& args, int nargout) -> ValueList {
+        requireMinArgs("unique", args, 1);
+        bool sorted = parseSetOrder("unique", args, 1);
+        SetKeys keys = toSetKeys("unique", args[0], false);
+        auto res = uniqueKeys(keys, sorted, nargout >= 3);
+        ValueList out = {setResultValue(keys.subset(res.first), args[0]->isString(),
+                                        isRowInput(args[0]))};
+        if (nargout >= 2) out.push_back(indexColumn(res.first));
+        if (nargout >= 3) out.push_back(indexColumn(res.group));
+        return out;
+    });
+
+    // [tf, loc] = ismember(A, B)
+    interp.registerMultiBuiltin("ismember", [](const ValueList& args, int nargout) -> ValueList {
+        requireArgs("ismember", args, 2);
+        bool asString = args[0]->isCellArray() || args[1]->isCellArray();
+        SetKeys query = toSetKeys("ismember", args[0], asString);
+        auto loc = memberIndex(query, toSetKeys("ismember", args[1], asString));
+        size_t rows = 1, cols = loc.size();
+        if (args[0]->isCellArray()) {
+            rows = args[0]->cellArray().rows;
+            cols = args[0]->cellArray().cols;
+        } else if (!args[0]->isString()) {
+            rows = args[0]->matrix().rows();
+            cols = args[0]->matrix().cols();
+        }
+        if (asString && args[0]->isString()) rows = cols = 1;
+        Matrix tf(rows, cols), where(rows, cols);
+        for (size_t i = 0; i < loc.size(); i++) {
+            tf(i) = (loc[i] != kNotFound) ? 1.0 : 0.0;
+            where(i) = (loc[i] != kNotFound) ? static_cast<double>(loc[i] + 1) : 0.0;
+        }
+        // tf is logical whatever its shape
+        ValuePtr tfv = Value::makeBool(false);
+        tfv->matrix() = std::move(tf);
+        if (nargout < 2) return {tfv};
+        return {tfv, Value::makeMatrix(std::move(where))};
+    });
+
+    // [C, ia, ib] = intersect/union(A, B), [C, ia] = setdiff(A, B);
+    // each takes an optional 'sorted' (default) or 'stable'
+    using SetOpFn = std::vector<SetElement> (*)(const SetKeys&, const SetKeys&, bool);
+    auto makeSetOp = [](const std::string& name, SetOpFn op) {
+        return [name, op](const ValueList& args, int nargout) -> ValueList {
+            requireMinArgs(name, args, 2);
+            bool sorted = parseSetOrder(name, args, 2);
+            bool asString = args[0]->isCellArray() || args[1]->isCellArray();
+            SetKeys a = toSetKeys(name, args[0], asString);
+            SetKeys b = toSetKeys(name, args[1], asString);
+            auto elems = op(a, b, sorted);
+
+            SetKeys c;
+            c.isString = a.isString;
+            std::vector<size_t> ia, ib;
+            for (auto& e : elems) {
+                const SetKeys& src = (e.a != kNotFound) ? a : b;
+                size_t pos = (e.a != kNotFound) ? e.a : e.b;
+                if (c.isString) c.strings.push_back(src.strings[pos]);
+                else c.numbers.push_back(src.numbers[pos]);
+                if (e.a != kNotFound) ia.push_back(e.a);
+                if (e.b != kNotFound) ib.push_back(e.b);
+            }
+            bool charOut = args[0]->isString() && args[1]->isString();
+            bool row = isRowInput(args[0]) && isRowInput(args[1]);
+            ValueList out = {setResultValue(c, charOut, row)};
+            if (nargout >= 2) out.push_back(indexColumn(ia));
+            if (nargout >= 3) out.push_back(indexColumn(ib));
+            return out;
+        };
+    };
+    interp.registerMultiBuiltin("intersect", makeSetOp("intersect", intersectKeys));
+    interp.registerMultiBuiltin("union", makeSetOp("union", unionKeys));
+    interp.registerMultiBuiltin("setdiff", makeSetOp("setdiff", setdiffKeys));
+
+    // find: linear indices of the nonzeros, or [r, c, v] = find(x) with
+    // their rows, columns and values
+    interp.registerMultiBuiltin("find", [](const ValueList& args, int nargout) -> ValueList {
         requireMinArgs("find", args, 1);
         auto& m = args[0]->matrix();
         std::vector<double> indices;
@@ -462,7 +879,17 @@ void registerMatrixBuiltins(Interpreter& interp) {
             if (m(i) != 0.0) indices.push_back(static_cast<double>(i + 1));
         }
         size_t n = indices.size();
-        return Value::makeMatrix(Matrix(1, n, std::move(indices)));
+        if (nargout < 2) return {Value::makeMatrix(Matrix(1, n, std::move(indices)))};
+        Matrix rows(1, n), cols(1, n), values(1, n);
+        for (size_t k = 0; k < n; k++) {
+            size_t i = static_cast<size_t>(indices[k]) - 1;
+            rows(k) = static_cast<double>(i / m.cols() + 1);
+            cols(k) = static_cast<double>(i % m.cols() + 1);
+            values(k) = m(i);
+        }
+        ValueList out{Value::makeMatrix(std::move(rows)), Value::makeMatrix(std::move(cols))};
+        if (nargout > 2) out.push_back(Value::makeMatrix(std::move(values)));
+        return out;
     });
 
     // any, all
@@ -548,6 +975,9 @@ void registerMatrixBuiltins(Interpreter& interp) {
         result(2) = a(0) * b(1) - a(1) * b(0);
         return Value::makeMatrix(std::move(result));
     });
+    for (const char* name : {"size", "length", "numel", "sort", "any", "all", "isempty",
+                             "norm", "dot", "cross", "cumsum", "cumprod", "cummax", "cummin", "diff"})
+        interp.setBuiltinTraits(name, PURE_BUILTIN);
 }
 
 // ============================================================================
@@ -794,53 +1224,12 @@ void registerStringBuiltins(Interpreter& interp) {
         return Value::makeString(s.substr(start, end - start + 1));
     });
 
-    // sprintf
+    // sprintf(fmt, args...): the format is cycled over all elements
     interp.registerBuiltin("sprintf", [](const ValueList& args) -> ValuePtr {
         requireMinArgs("sprintf", args, 1);
-        std::string fmt = args[0]->string();
         std::string result;
-        size_t argIdx = 1;
-
-        for (size_t i = 0; i < fmt.size(); i++) {
-            if (fmt[i] == '%' && i + 1 < fmt.size()) {
-                i++;
-                std::string spec = "%";
-                // Parse format specifier
-                while (i < fmt.size() && !std::isalpha(fmt[i])) {
-                    spec += fmt[i++];
-                }
-                if (i < fmt.size()) {
-                    char type = fmt[i];
-                    spec += type;
-
-                    if (argIdx < args.size()) {
-                        char buf[256];
-                        if (type == 'd' || type == 'i') {
-                            snprintf(buf, sizeof(buf), spec.c_str(),
-                                    static_cast<int>(args[argIdx]->scalarDouble()));
-                        } else if (type == 'f' || type == 'e' || type == 'g') {
-                            snprintf(buf, sizeof(buf), spec.c_str(), args[argIdx]->scalarDouble());
-                        } else if (type == 's') {
-                            result += args[argIdx]->string();
-                            argIdx++;
-                            continue;
-                        } else {
-                            snprintf(buf, sizeof(buf), spec.c_str(), args[argIdx]->scalarDouble());
-                        }
-                        result += buf;
-                        argIdx++;
-                    }
-                }
-            } else if (fmt[i] == '\\' && i + 1 < fmt.size()) {
-                i++;
-                if (fmt[i] == 'n') result += '\n';
-                else if (fmt[i] == 't') result += '\t';
-                else result += fmt[i];
-            } else {
-                result += fmt[i];
-            }
-        }
-        return Value::makeString(result);
+        PrintfFormat(args[0]->string()).format(args, 1, result);
+        return Value::makeString(std::move(result));
     });
 
     // char, double
@@ -865,97 +1254,397 @@ void registerStringBuiltins(Interpreter& interp) {
         }
         throw RuntimeError("double: cannot convert");
     });
+    for (const char* name : {"num2str", "upper", "lower", "strtrim"})
+        interp.setBuiltinTraits(name, PURE_BUILTIN);
 }
 
 // ============================================================================
 // I/O built-ins
 // ============================================================================
 
+// Workspace file name: MATLAB's default .mat extension is added when the
+// name has none (the contents are MatFree's own format, not MAT-file).
+static std::string workspacePath(const std::string& name) {
+    return std::filesystem::path(name).has_extension() ? name : name + ".mat";
+}
+
+// MAT-file version flags (-v6, -v7, -v7.3, -mat) are accepted and ignored.
+static bool isVersionFlag(const std::string& a) {
+    return a == "-mat" || (a.size() > 2 && a.compare(0, 2, "-v") == 0);
+}
+
+// Name/value options of the delimited text readers, from args[first] on.
+static DelimitedOptions delimitedOptions(const std::string& fname, const ValueList& args, size_t first) {
+    DelimitedOptions opts;
+    if ((args.size() - first) % 2 != 0) throw RuntimeError(fname + ": options must be name/value pairs");
+    for (size_t i = first; i < args.size(); i += 2) {
+        std::string opt = args[i]->string();
+        std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+        const ValuePtr& v = args[i + 1];
+        if (opt == "delimiter") {
+            std::string d = v->string();
+            if (d == "\\t" || d == "tab") opts.delimiter = '\t';
+            else if (d == "space" || d == "whitespace") opts.delimiter = ' ';
+            else if (d == "comma") opts.delimiter = ',';
+            else if (d == "semi" || d == "semicolon") opts.delimiter = ';';
+            else if (d == "bar") opts.delimiter = '|';
+            else if (d.size() == 1) opts.delimiter = d[0];
+            else throw RuntimeError(fname + ": unsupported Delimiter '" + d + "'");
+        } else if (opt == "numheaderlines") {
+            opts.headerLines = static_cast<long>(nonNegativeCount(fname, v));
+        } else if (opt == "columns") {
+            for (double c : v->matrix()) {
+                if (!(c >= 1) || c != std::floor(c)) throw RuntimeError(fname + ": Columns must be positive integers");
+                opts.columns.push_back(static_cast<size_t>(c) - 1);
+            }
+        } else if (opt == "emptyvalue") {
+            opts.emptyValue = v->scalarDouble();
+        } else if (opt == "treatasmissing") {
+            if (v->isString()) opts.missing.push_back(v->string());
+            else for (auto& m : v->cellArray().data) opts.missing.push_back(m->string());
+        } else {
+            throw RuntimeError(fname + ": unknown option '" + args[i]->string() + "'");
+        }
+    }
+    return opts;
+}
+
+// A header name as a struct field name: invalid characters become '_',
+// a leading non-letter gets an 'x', and repeats get a _2, _3, ... suffix.
+static std::string variableName(const std::string& header, size_t index, std::unordered_map<std::string, int>& seen) {
+    std::string name;
+    for (char c : header) name += std::isalnum(static_cast<unsigned char>(c)) || c == '_' ? c : '_';
+    if (name.empty() || name.find_first_not_of('_') == std::string::npos) name = "Var" + std::to_string(index + 1);
+    else if (!std::isalpha(static_cast<unsigned char>(name[0]))) name = "x" + name;
+    int n = ++seen[name];
+    return n == 1 ? name : name + "_" + std::to_string(n);
+}
+
+// An open file of the session's file table.
+static std::shared_ptr<FileHandle> fileOf(const std::string& name, const ValuePtr& fid) {
+    auto& files = Interpreter::current().session().files;
+    if (!fid->isScalar()) throw RuntimeError(name + ": invalid file identifier");
+    auto it = files.find(static_cast<int>(fid->scalarDouble()));
+    if (it == files.end()) throw RuntimeError(name + ": invalid file identifier");
+    return it->second;
+}
+
+// Machine format of fopen/fread/fwrite: true for big-endian.
+static bool isBigEndianFormat(const std::string& name, const std::string& fmt) {
+    if (fmt == "n" || fmt == "native") return hostIsBigEndian();
+    if (fmt == "l" || fmt == "ieee-le" || fmt == "a" || fmt == "ieee-le.l64") return false;
+    if (fmt == "b" || fmt == "ieee-be" || fmt == "s" || fmt == "ieee-be.l64") return true;
+    throw RuntimeError(name + ": unknown machine format '" + fmt + "'");
+}
+
+// fread precision: 'uint16' and 'uint16=>double' read as double, and so
+// does '*uint16' (MatFree arrays are double); 'uint8=>char' and '*char'
+// read text.
+struct ReadPrecision {
+    NumericClass source = NumericClass::UINT8;
+    bool text = false;
+};
+
+static ReadPrecision readPrecision(const std::string& spec) {
+    ReadPrecision p;
+    std::string s = spec, output;
+    if (!s.empty() && s[0] == '*') {
+        s = s.substr(1);
+        output = s;
+    }
+    size_t arrow = s.find("=>");
+    if (arrow != std::string::npos) {
+        output = s.substr(arrow + 2);
+        s = s.substr(0, arrow);
+    }
+    p.source = parseNumericClass(s);
+    p.text = output == "char";
+    if (!output.empty() && !p.text) parseNumericClass(output);
+    return p;
+}
+
 void registerIOBuiltins(Interpreter& interp) {
     // disp
-    interp.registerBuiltin("disp", [&interp](const ValueList& args) -> ValuePtr {
+    interp.registerBuiltin("disp", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
         requireArgs("disp", args, 1);
         if (args[0]->isString()) {
-            interp.output() << args[0]->string() << std::endl;
+            interp.output() << args[0]->string() << '\n';
         } else if (args[0]->isNumeric()) {
             args[0]->matrix().display(interp.output());
         } else {
-            interp.output() << args[0]->toString() << std::endl;
+            interp.output() << args[0]->toString() << '\n';
         }
         return Value::makeEmpty();
     });
 
-    // fprintf
-    interp.registerBuiltin("fprintf", [&interp](const ValueList& args) -> ValuePtr {
+    // fprintf([fid,] fmt, args...): fid 1 is the output, 2 standard error,
+    // others files from fopen.
+    // The whole text is formatted first and written at once.
+    interp.registerBuiltin("fprintf", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
         requireMinArgs("fprintf", args, 1);
-        // Simple fprintf to stdout (ignoring file id for now)
-        std::string fmt;
-        size_t startArg = 0;
-
-        if (args[0]->isScalar() && args.size() > 1) {
-            // First arg might be file ID (1=stdout, 2=stderr)
-            startArg = 1;
-            fmt = args[1]->string();
-            startArg = 2;
-        } else if (args[0]->isString()) {
-            fmt = args[0]->string();
-            startArg = 1;
+        size_t fmtArg = args[0]->isString() ? 0 : 1;
+        std::ostream* os = &interp.output();
+        std::shared_ptr<FileHandle> file;
+        if (fmtArg == 1) {
+            if (args.size() < 2) throw RuntimeError("fprintf: missing format");
+            double fid = args[0]->scalarDouble();
+            if (fid == 2) os = &std::cerr;
+            else if (fid != 1) file = fileOf("fprintf", args[0]);
         }
+        std::string result;
+        PrintfFormat(args[fmtArg]->string()).format(args, fmtArg + 1, result);
+        if (file) file->writeText(result);
+        else os->write(result.data(), static_cast<std::streamsize>(result.size()));
+        return Value::makeEmpty();
+    });
 
-        // Build the formatted string using sprintf logic
-        ValueList sprintfArgs;
-        sprintfArgs.push_back(Value::makeString(fmt));
-        for (size_t i = startArg; i < args.size(); i++) {
-            sprintfArgs.push_back(args[i]);
+    // [fid, msg] = fopen(file, permission = 'r', machinefmt = 'native')
+    // fid is -1 (and msg the reason) when the file cannot be opened
+    interp.registerMultiBuiltin("fopen", [](const ValueList& args, int) -> ValueList {
+        Interpreter& interp = Interpreter::current();
+        requireMinArgs("fopen", args, 1);
+        std::string permission = args.size() > 1 ? args[1]->string() : "r";
+        bool bigEndian = args.size() > 2 ? isBigEndianFormat("fopen", args[2]->string()) : hostIsBigEndian();
+        std::string message;
+        auto file = FileHandle::open(args[0]->string(), permission, bigEndian, message);
+        if (!file) return {Value::makeScalar(-1), Value::makeString(message)};
+        SessionState& session = interp.session();
+        int fid = session.nextFile++;
+        session.files[fid] = file;
+        return {Value::makeScalar(fid), Value::makeString("")};
+    });
+
+    // fclose(fid) or fclose('all'): 0 on success, -1 if data could not be written
+    interp.registerBuiltin("fclose", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
+        requireArgs("fclose", args, 1);
+        auto& files = interp.session().files;
+        bool ok = true;
+        if (args[0]->isString()) {
+            if (args[0]->string() != "all") throw RuntimeError("fclose: expected a file identifier or 'all'");
+            for (auto& [fid, file] : files) ok = file->close() && ok;
+            files.clear();
+        } else {
+            auto file = fileOf("fclose", args[0]);
+            ok = file->close();
+            files.erase(static_cast<int>(args[0]->scalarDouble()));
         }
-
-        // Quick inline format
-        std::string result;
-        size_t argIdx = 1;
-        for (size_t i = 0; i < fmt.size(); i++) {
-            if (fmt[i] == '%' && i + 1 < fmt.size()) {
-                i++;
-                std::string spec = "%";
-                while (i < fmt.size() && !std::isalpha(fmt[i])) {
-                    spec += fmt[i++];
-                }
-                if (i < fmt.size()) {
-                    char type = fmt[i];
-                    spec += type;
-                    if (startArg + argIdx - 1 < args.size()) {
-                        auto& arg = args[startArg + argIdx - 1];
-                        char buf[256];
-                        if (type == 's') {
-                            result += arg->string();
-                        } else if (type == 'd' || type == 'i') {
-                            snprintf(buf, sizeof(buf), spec.c_str(),
-                                    static_cast<int>(arg->scalarDouble()));
-                            result += buf;
-                        } else {
-                            snprintf(buf, sizeof(buf), spec.c_str(), arg->scalarDouble());
-                            result += buf;
-                        }
-                        argIdx++;
-                    }
-                }
-            } else if (fmt[i] == '\\' && i + 1 < fmt.size()) {
-                i++;
-                if (fmt[i] == 'n') result += '\n';
-                else if (fmt[i] == 't') result += '\t';
-                else result += fmt[i];
+        return Value::makeScalar(ok ? 0 : -1);
+    });
+
+    // [A, count] = fread(fid, size = Inf, precision = 'uint8', skip = 0, machinefmt)
+    // size is n, Inf, [m n] or [m Inf]; A is filled in linear index order
+    // (as reshape fills it) and padded with zeros. Elements are read in
+    // large blocks and converted in memory.
+    interp.registerMultiBuiltin("fread", [](const ValueList& args, int) -> ValueList {
+        requireMinArgs("fread", args, 1);
+        auto file = fileOf("fread", args[0]);
+        ReadPrecision precision = readPrecision(args.size() > 2 ? args[2]->string() : "uint8");
+        if (args.size() > 3 && args[3]->scalarDouble() != 0) throw RuntimeError("fread: skip is not supported");
+        bool bigEndian = args.size() > 4 ? isBigEndianFormat("fread", args[4]->string()) : file->bigEndian();
+        size_t elem = numericClassSize(precision.source);
+
+        size_t rows = 0, cols = 1, requested = SIZE_MAX;
+        bool shaped = false;
+        if (args.size() > 1) {
+            const Matrix& sz = args[1]->matrix();
+            auto dim = [](double d) { return std::isinf(d) ? SIZE_MAX : static_cast<size_t>(std::max(d, 0.0)); };
+            if (sz.numel() == 1) {
+                requested = dim(sz(0));
+            } else if (sz.numel() == 2) {
+                if (std::isinf(sz(0))) throw RuntimeError("fread: only the last size may be Inf");
+                shaped = true;
+                rows = dim(sz(0));
+                cols = dim(sz(1));
+                if (cols != SIZE_MAX) requested = rows * cols;
             } else {
-                result += fmt[i];
+                throw RuntimeError("fread: size must be n, Inf, [m n] or [m Inf]");
             }
         }
-        interp.output() << result;
+
+        // One element more than the file holds, so reading to the end sets feof
+        size_t available = static_cast<size_t>(file->remaining() / elem);
+        std::vector<double> data(std::min(requested, available + 1));
+        size_t count = file->readNumeric(precision.source, data.size(), bigEndian, data.data());
+        data.resize(count);
+        if (precision.text) {
+            std::string text(count, '\0');
+            for (size_t i = 0; i < count; i++) text[i] = static_cast<char>(data[i]);
+            return {Value::makeString(std::move(text)), Value::makeScalar(static_cast<double>(count))};
+        }
+        Matrix result;
+        if (!shaped) {
+            result = Matrix(count, 1, std::move(data));
+        } else {
+            if (cols == SIZE_MAX) cols = rows == 0 ? 0 : (count + rows - 1) / rows;
+            data.resize(rows * cols, 0.0);
+            result = Matrix(rows, cols, std::move(data));
+        }
+        return {Value::makeMatrix(std::move(result)), Value::makeScalar(static_cast<double>(count))};
+    });
+
+    // count = fwrite(fid, A, precision = 'uint8', skip = 0, machinefmt):
+    // the elements of A in linear index order, converted (rounded and
+    // saturated for integer classes) in large blocks
+    interp.registerBuiltin("fwrite", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
+        requireMinArgs("fwrite", args, 2);
+        std::vector<double> text;
+        const double* data;
+        size_t n;
+        if (args[1]->isString()) {
+            for (unsigned char c : args[1]->string()) text.push_back(c);
+            data = text.data();
+            n = text.size();
+        } else {
+            const Matrix& m = args[1]->matrix();
+            data = m.begin();
+            n = m.numel();
+        }
+        NumericClass cls = readPrecision(args.size() > 2 ? args[2]->string() : "uint8").source;
+        if (args.size() > 3 && args[3]->scalarDouble() != 0) throw RuntimeError("fwrite: skip is not supported");
+        double fid = args[0]->scalarDouble();
+        if (fid == 1 || fid == 2) {
+            std::vector<char> bytes(n * numericClassSize(cls));
+            convertFromDouble(data, cls, n, bytes.data());
+            std::ostream& os = fid == 1 ? interp.output() : std::cerr;
+            os.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            return Value::makeScalar(static_cast<double>(n));
+        }
+        auto file = fileOf("fwrite", args[0]);
+        bool bigEndian = args.size() > 4 ? isBigEndianFormat("fwrite", args[4]->string()) : file->bigEndian();
+        return Value::makeScalar(static_cast<double>(file->writeNumeric(data, n, cls, bigEndian)));
+    });
+
+    // status = fseek(fid, offset, origin): origin 'bof' (-1), 'cof' (0) or
+    // 'eof' (1); 0 on success, -1 otherwise
+    interp.registerBuiltin("fseek", [](const ValueList& args) -> ValuePtr {
+        requireArgs("fseek", args, 3);
+        auto file = fileOf("fseek", args[0]);
+        int origin;
+        if (args[2]->isString()) {
+            std::string o = args[2]->string();
+            if (o == "bof") origin = SEEK_SET;
+            else if (o == "cof") origin = SEEK_CUR;
+            else if (o == "eof") origin = SEEK_END;
+            else throw RuntimeError("fseek: origin must be 'bof', 'cof' or 'eof'");
+        } else {
+            double o = args[2]->scalarDouble();
+            origin = o < 0 ? SEEK_SET : o == 0 ? SEEK_CUR : SEEK_END;
+        }
+        return Value::makeScalar(file->seek(static_cast<int64_t>(args[1]->scalarDouble()), origin) ? 0 : -1);
+    });
+
+    interp.registerBuiltin("ftell", [](const ValueList& args) -> ValuePtr {
+        requireArgs("ftell", args, 1);
+        return Value::makeScalar(static_cast<double>(fileOf("ftell", args[0])->tell()));
+    });
+
+    interp.registerBuiltin("frewind", [](const ValueList& args) -> ValuePtr {
+        requireArgs("frewind", args, 1);
+        fileOf("frewind", args[0])->seek(0, SEEK_SET);
+        return Value::makeEmpty();
+    });
+
+    interp.registerBuiltin("feof", [](const ValueList& args) -> ValuePtr {
+        requireArgs("feof", args, 1);
+        return Value::makeBool(fileOf("feof", args[0])->eof());
+    });
+
+    // fgetl(fid) / fgets(fid): the next line without / with its line
+    // break, or -1 at the end of the file
+    for (bool keepNewline : {false, true}) {
+        std::string name = keepNewline ? "fgets" : "fgetl";
+        interp.registerBuiltin(name, [name, keepNewline](const ValueList& args) -> ValuePtr {
+            requireArgs(name, args, 1);
+            std::string line;
+            if (!fileOf(name, args[0])->readLine(line, keepNewline)) return Value::makeScalar(-1);
+            return Value::makeString(std::move(line));
+        });
+    }
+
+    // loadlibrary(lib, header), loadlibrary(lib, header, 'alias', name):
+    // load a C library and the functions declared in `header`, a header
+    // file or prototype text. The library is known by its file name
+    // without extension, or by `name`.
+    interp.registerBuiltin("loadlibrary", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("loadlibrary", args, 2);
+        std::filesystem::path path = args[0]->string();
+        if (!std::filesystem::exists(path)) {
+#if defined(_WIN32)
+            const char* suffix = ".dll";
+#elif defined(__APPLE__)
+            const char* suffix = ".dylib";
+#else
+            const char* suffix = ".so";
+#endif
+            std::filesystem::path lib = path;
+            lib.replace_filename("lib" + path.filename().string() + suffix);
+            if (std::filesystem::exists(path.string() + suffix)) path += suffix;
+            else if (std::filesystem::exists(lib)) path = lib;
+        }
+        std::string prototypes = args[1]->string();
+        if (std::filesystem::is_regular_file(prototypes)) {
+            std::ifstream in(prototypes);
+            std::stringstream ss;
+            ss << in.rdbuf();
+            prototypes = ss.str();
+        }
+        std::string name = path.stem().string();
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            if (args[i]->string() == "alias") name = args[i + 1]->string();
+            else throw RuntimeError("loadlibrary: unknown option '" + args[i]->string() + "'");
+        }
+        auto& libraries = Interpreter::current().session().libraries;
+        if (libraries.count(name)) throw RuntimeError("loadlibrary: library '" + name + "' is already loaded");
+        libraries[name] = ForeignLibrary::load(path.string(), prototypes);
         return Value::makeEmpty();
     });
 
+    // [r, p1, p2, ...] = calllib(lib, fn, args...): the result (unless
+    // void), then the values left in each non-const pointer argument
+    interp.registerMultiBuiltin("calllib", [](const ValueList& args, int) -> ValueList {
+        requireMinArgs("calllib", args, 2);
+        auto& libraries = Interpreter::current().session().libraries;
+        auto it = libraries.find(args[0]->string());
+        if (it == libraries.end()) throw RuntimeError("calllib: library '" + args[0]->string() + "' is not loaded");
+        return it->second->call(args[1]->string(), ValueList(args.begin() + 2, args.end()));
+    });
+
+    interp.registerBuiltin("unloadlibrary", [](const ValueList& args) -> ValuePtr {
+        requireArgs("unloadlibrary", args, 1);
+        if (!Interpreter::current().session().libraries.erase(args[0]->string()))
+            throw RuntimeError("unloadlibrary: library '" + args[0]->string() + "' is not loaded");
+        return Value::makeEmpty();
+    });
+
+    interp.registerBuiltin("libisloaded", [](const ValueList& args) -> ValuePtr {
+        requireArgs("libisloaded", args, 1);
+        return Value::makeBool(Interpreter::current().session().libraries.count(args[0]->string()) > 0);
+    });
+
+    // libfunctions(lib): the callable functions as a column cell array
+    interp.registerBuiltin("libfunctions", [](const ValueList& args) -> ValuePtr {
+        requireArgs("libfunctions", args, 1);
+        auto& libraries = Interpreter::current().session().libraries;
+        auto it = libraries.find(args[0]->string());
+        if (it == libraries.end())
+            throw RuntimeError("libfunctions: library '" + args[0]->string() + "' is not loaded");
+        auto names = it->second->functionNames();
+        CellArray cell(names.size(), 1);
+        for (size_t i = 0; i < names.size(); i++) cell.data[i] = Value::makeString(names[i]);
+        return Value::makeCellArray(std::move(cell));
+    });
+
     // input
-    interp.registerBuiltin("input", [&interp](const ValueList& args) -> ValuePtr {
+    interp.registerBuiltin("input", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
         if (!args.empty() && args[0]->isString()) {
             interp.output() << args[0]->string();
         }
+        interp.flushOutput();
         std::string line;
         std::getline(std::cin, line);
 
@@ -981,30 +1670,122 @@ void registerIOBuiltins(Interpreter& interp) {
     });
 
     // warning
-    interp.registerBuiltin("warning", [&interp](const ValueList& args) -> ValuePtr {
+    interp.registerBuiltin("warning", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
         if (!args.empty() && args[0]->isString()) {
-            interp.output() << "Warning: " << args[0]->string() << std::endl;
+            interp.output() << "Warning: " << args[0]->string() << '\n';
         }
         return Value::makeEmpty();
     });
 
-    // tic, toc
-    static std::chrono::time_point<std::chrono::high_resolution_clock> ticTime;
-
-    interp.registerBuiltin("tic", [](const ValueList&) -> ValuePtr {
-        ticTime = std::chrono::high_resolution_clock::now();
+    // tic, toc (the timer is per session)
+    // tic starts the session's timer; t = tic also returns the start time
+    // (in ns) for toc(t), leaving the session's timer alone
+    interp.registerMultiBuiltin("tic", [](const ValueList&, int nargout) -> ValueList {
+        auto now = std::chrono::steady_clock::now();
+        if (nargout > 0) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch());
+            return {Value::makeScalar(static_cast<double>(ns.count()))};
+        }
+        Interpreter::current().session().ticTime = now;
+        return {Value::makeEmpty()};
+    });
+
+    // toc, toc(t): seconds since tic; printed unless assigned
+    interp.registerMultiBuiltin("toc", [](const ValueList& args, int nargout) -> ValueList {
+        Interpreter& interp = Interpreter::current();
+        auto now = std::chrono::steady_clock::now();
+        auto start = interp.session().ticTime;
+        if (!args.empty()) {
+            auto ns = std::chrono::nanoseconds(static_cast<int64_t>(args[0]->scalarDouble()));
+            start = std::chrono::steady_clock::time_point(
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(ns));
+        }
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        if (nargout > 0) return {Value::makeScalar(elapsed)};
+        interp.output() << "Elapsed time is " << elapsed << " seconds.\n";
+        return {Value::makeEmpty()};
+    });
+
+    // profile('on') clears and starts profiling, 'resume' continues
+    // without clearing, 'off' stops, 'clear' drops the data. 'viewer'
+    // stops and prints the report; 'report' prints it. p = profile('info')
+    // gives p.FunctionTable, a cell column of structs with FunctionName,
+    // NumCalls, TotalTime, SelfTime and ExecutedLines ([line calls time]
+    // rows). profile('json') returns the report as JSON text;
+    // profile('json', file) writes it to file.
+    // profile('sample', hz) samples the call stack instead (1000 Hz by
+    // default), which leaves tight loops undisturbed; 'off' stops it too.
+    // profile('flamegraph', file) writes the samples as collapsed stacks,
+    // profile('trace', file) as Chrome trace events; without a file they
+    // return the text.
+    interp.registerBuiltin("profile", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
+        requireMinArgs("profile", args, 1);
+        const std::string& action = args[0]->string();
+        if (action == "on") {
+            interp.profiler().clear();
+            interp.setProfiling(true);
+        } else if (action == "resume") {
+            interp.setProfiling(true);
+        } else if (action == "off") {
+            interp.setProfiling(false);
+            interp.stopSampling();
+        } else if (action == "clear") {
+            interp.profiler().clear();
+        } else if (action == "status") {
+            return Value::makeString(interp.profiling() || interp.sampling() ? "on" : "off");
+        } else if (action == "sample") {
+            interp.startSampling(args.size() > 1 ? args[1]->scalarDouble() : 1000.0);
+        } else if (action == "flamegraph" || action == "trace") {
+            Sampler& sampler = interp.sampler();
+            std::string text = action == "trace" ? sampler.chromeTrace() : sampler.foldedStacks();
+            if (args.size() < 2) return Value::makeString(text);
+            std::ofstream out(args[1]->string(), std::ios::binary);
+            if (!out) throw RuntimeError("profile: cannot write '" + args[1]->string() + "'");
+            out << text;
+        } else if (action == "viewer" || action == "report") {
+            if (action == "viewer") interp.setProfiling(false);
+            interp.output() << interp.profiler().textReport();
+        } else if (action == "json") {
+            std::string json = interp.profiler().jsonReport();
+            if (args.size() < 2) return Value::makeString(json);
+            std::ofstream out(args[1]->string(), std::ios::binary);
+            if (!out) throw RuntimeError("profile: cannot write '" + args[1]->string() + "'");
+            out << json;
+        } else if (action == "info") {
+            auto functions = interp.profiler().functions();
+            CellArray table(functions.size(), 1);
+            for (size_t i = 0; i < functions.size(); i++) {
+                const FunctionStats& f = *functions[i];
+                Matrix lines(f.lines.size(), 3);
+                size_t r = 0;
+                for (auto& [line, ls] : f.lines) {
+                    lines(r, 0) = line;
+                    lines(r, 1) = static_cast<double>(ls.calls);
+                    lines(r, 2) = ls.time;
+                    r++;
+                }
+                MFStruct entry;
+                entry.fields["FunctionName"] = Value::makeString(f.name);
+                entry.fields["NumCalls"] = Value::makeScalar(static_cast<double>(f.calls));
+                entry.fields["TotalTime"] = Value::makeScalar(f.totalTime);
+                entry.fields["SelfTime"] = Value::makeScalar(f.selfTime());
+                entry.fields["ExecutedLines"] = Value::makeMatrix(std::move(lines));
+                table.data[i] = Value::makeStruct(std::move(entry));
+            }
+            MFStruct info;
+            info.fields["FunctionTable"] = Value::makeCellArray(std::move(table));
+            return Value::makeStruct(std::move(info));
+        } else {
+            throw RuntimeError("profile: unknown action '" + action + "'");
+        }
         return Value::makeEmpty();
     });
 
-    interp.registerBuiltin("toc", [&interp](const ValueList&) -> ValuePtr {
-        auto now = std::chrono::high_resolution_clock::now();
-        double elapsed = std::chrono::duration<double>(now - ticTime).count();
-        interp.output() << "Elapsed time is " << elapsed << " seconds." << std::endl;
-        return Value::makeScalar(elapsed);
-    });
-
     // exist (simplified)
-    interp.registerBuiltin("exist", [&interp](const ValueList& args) -> ValuePtr {
+    interp.registerBuiltin("exist", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
         requireArgs("exist", args, 1);
         std::string name = args[0]->string();
         if (interp.currentEnv()->has(name)) return Value::makeScalar(1.0);
@@ -1016,6 +1797,368 @@ void registerIOBuiltins(Interpreter& interp) {
         if (fm.good()) return Value::makeScalar(2.0);
         return Value::makeScalar(0.0);
     });
+
+    // save(file), save(file, 'x', 'y', ...), save(file, ..., '-append')
+    interp.registerBuiltin("save", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
+        requireMinArgs("save", args, 1);
+        std::string path = workspacePath(args[0]->string());
+        bool append = false;
+        std::vector<std::string> names;
+        for (size_t i = 1; i < args.size(); i++) {
+            std::string a = args[i]->string();
+            if (a == "-append") append = true;
+            else if (!isVersionFlag(a)) names.push_back(a);
+        }
+        auto env = interp.currentEnv();
+        if (names.empty()) {
+            names = env->variableNames();
+            std::sort(names.begin(), names.end());
+        }
+        std::vector<std::pair<std::string, ValuePtr>> vars;
+        for (auto& name : names) {
+            auto v = env->get(name);
+            if (!v) throw RuntimeError("save: variable '" + name + "' not found");
+            vars.emplace_back(name, v);
+        }
+        saveWorkspace(path, vars, append);
+        return Value::makeEmpty();
+    });
+
+    // load(file) and load(file, 'x', ...) bind variables in the workspace,
+    // each read from the mapped file on first use; S = load(...) returns
+    // them as the fields of a struct
+    interp.registerMultiBuiltin("load", [](const ValueList& args, int nargout) -> ValueList {
+        Interpreter& interp = Interpreter::current();
+        requireMinArgs("load", args, 1);
+        auto reader = std::make_shared<WorkspaceReader>(workspacePath(args[0]->string()));
+        std::vector<const WorkspaceEntry*> selected;
+        for (size_t i = 1; i < args.size(); i++) {
+            std::string a = args[i]->string();
+            if (isVersionFlag(a)) continue;
+            auto* e = reader->find(a);
+            if (!e) throw RuntimeError("load: variable '" + a + "' not found in file");
+            selected.push_back(e);
+        }
+        if (selected.empty())
+            for (auto& e : reader->entries()) selected.push_back(&e);
+
+        Interpreter* owner = &interp;
+        auto makeHandle = [owner](const std::string& name) { return owner->makeFunctionHandle(name); };
+        if (nargout > 0) {
+            MFStruct s;
+            for (auto* e : selected) s.fields[e->name] = reader->read(*e, makeHandle);
+            return {Value::makeStruct(std::move(s))};
+        }
+        for (auto* e : selected) {
+            WorkspaceEntry entry = *e;
+            LazyVariable lazy;
+            lazy.load = [reader, entry, makeHandle] { return reader->read(entry, makeHandle); };
+            lazy.size = std::to_string(entry.rows) + "x" + std::to_string(entry.cols);
+            lazy.className = workspaceClassName(entry.type);
+            interp.currentEnv()->setLazy(entry.name, std::move(lazy));
+        }
+        return {Value::makeEmpty()};
+    });
+
+    // m = memmapfile(file, 'Format', fmt, 'Offset', bytes, 'Repeat', n,
+    //                'Writable', tf, 'Access', 'normal'|'sequential'|'random'|'willneed')
+    // fmt is a class name or {class, [rows cols]} / {class, [rows cols], name}.
+    // m.Data views the file: with writable 'double' data, m.Data(i) = v
+    // stores into the file (copies such as d = m.Data never do); other
+    // classes are read into memory as double.
+    interp.registerBuiltin("memmapfile", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("memmapfile", args, 1);
+        if (args.size() % 2 == 0) throw RuntimeError("memmapfile: options must be name/value pairs");
+        MemmapSpec spec;
+        spec.path = args[0]->string();
+        std::string fieldName;
+        ValuePtr format = Value::makeString("uint8");
+        for (size_t i = 1; i < args.size(); i += 2) {
+            std::string opt = args[i]->string();
+            std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+            const ValuePtr& v = args[i + 1];
+            if (opt == "format") {
+                format = v;
+                if (v->isString()) {
+                    spec.format = parseNumericClass(v->string());
+                } else if (v->isCellArray() && (v->cellArray().data.size() == 2 || v->cellArray().data.size() == 3)) {
+                    const CellArray& c = v->cellArray();
+                    spec.format = parseNumericClass(c.data[0]->string());
+                    const Matrix& dims = c.data[1]->matrix();
+                    if (dims.numel() != 2) throw RuntimeError("memmapfile: Format size must be [rows cols]");
+                    spec.hasShape = true;
+                    spec.rows = nonNegativeCount("memmapfile", Value::makeScalar(dims(0)));
+                    spec.cols = nonNegativeCount("memmapfile", Value::makeScalar(dims(1)));
+                    if (c.data.size() == 3) fieldName = c.data[2]->string();
+                } else {
+                    throw RuntimeError("memmapfile: Format must be a class name or {class, [rows cols], name}");
+                }
+            } else if (opt == "offset") {
+                spec.offset = nonNegativeCount("memmapfile", v);
+            } else if (opt == "repeat") {
+                double r = v->scalarDouble();
+                spec.repeat = std::isinf(r) ? SIZE_MAX : nonNegativeCount("memmapfile", v);
+            } else if (opt == "writable") {
+                spec.writable = v->scalarDouble() != 0;
+            } else if (opt == "access") {
+                std::string a = v->string();
+                if (a == "normal") spec.access = MapAccess::NORMAL;
+                else if (a == "sequential") spec.access = MapAccess::SEQUENTIAL;
+                else if (a == "random") spec.access = MapAccess::RANDOM;
+                else if (a == "willneed") spec.access = MapAccess::WILL_NEED;
+                else throw RuntimeError("memmapfile: unknown Access '" + a + "'");
+            } else {
+                throw RuntimeError("memmapfile: unknown option '" + args[i]->string() + "'");
+            }
+        }
+        ValuePtr data = Value::makeMatrix(memmapMatrix(spec));
+        if (!fieldName.empty()) {
+            MFStruct record;
+            record.fields[fieldName] = data;
+            data = Value::makeStruct(std::move(record));
+        }
+        MFStruct m;
+        m.fields["Filename"] = Value::makeString(spec.path);
+        m.fields["Format"] = format;
+        m.fields["Offset"] = Value::makeScalar(static_cast<double>(spec.offset));
+        m.fields["Repeat"] = Value::makeScalar(spec.repeat == SIZE_MAX ? INFINITY : static_cast<double>(spec.repeat));
+        m.fields["Writable"] = Value::makeBool(spec.writable);
+        m.fields["Data"] = data;
+        return Value::makeStruct(std::move(m));
+    });
+
+    // M = readmatrix(file, 'Delimiter', d, 'NumHeaderLines', n, 'Columns', idx,
+    //                'EmptyValue', v, 'TreatAsMissing', {'NA', ...})
+    // Text fields read as NaN; the delimiter and a header line are detected
+    // unless given
+    interp.registerBuiltin("readmatrix", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("readmatrix", args, 1);
+        DelimitedOptions opts = delimitedOptions("readmatrix", args, 1);
+        return Value::makeMatrix(std::move(readDelimited(args[0]->string(), opts, false).numbers));
+    });
+
+    // csvread(file) and csvread(file, R, C): comma separated numbers from
+    // zero-based row R and column C on
+    interp.registerBuiltin("csvread", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("csvread", args, 1);
+        if (args.size() != 1 && args.size() != 3) throw RuntimeError("csvread: expected csvread(file) or csvread(file, R, C)");
+        DelimitedOptions opts;
+        opts.delimiter = ',';
+        opts.emptyValue = 0;
+        opts.headerLines = args.size() == 3 ? static_cast<long>(nonNegativeCount("csvread", args[1])) : 0;
+        if (args.size() == 3) opts.firstColumn = nonNegativeCount("csvread", args[2]);
+        return Value::makeMatrix(std::move(readDelimited(args[0]->string(), opts, false).numbers));
+    });
+
+    // C = readcell(file, ...): every field, numbers as doubles and text as
+    // strings. No header line is skipped unless NumHeaderLines is given.
+    interp.registerBuiltin("readcell", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("readcell", args, 1);
+        DelimitedOptions opts = delimitedOptions("readcell", args, 1);
+        if (opts.headerLines < 0) opts.headerLines = 0;
+        DelimitedData d = readDelimited(args[0]->string(), opts, true);
+        size_t rows = d.numbers.rows(), cols = d.numbers.cols();
+        CellArray c(rows, cols);
+        for (size_t j = 0; j < cols; j++) {
+            for (size_t i = 0; i < rows; i++) {
+                double v = d.numbers(i, j);
+                bool number = !d.isText[j] || parseDelimitedNumber(d.text[j][i], v) || d.text[j][i].empty();
+                c.at(i, j) = number ? Value::makeScalar(d.numbers(i, j)) : Value::makeString(d.text[j][i]);
+            }
+        }
+        return Value::makeCellArray(std::move(c));
+    });
+
+    // T = readtable(file, ...): a struct with one field per column, named
+    // from the header line (Var1, Var2, ... without one). Numeric columns
+    // are column vectors, text columns cell columns of strings.
+    interp.registerBuiltin("readtable", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("readtable", args, 1);
+        DelimitedOptions opts = delimitedOptions("readtable", args, 1);
+        DelimitedData d = readDelimited(args[0]->string(), opts, true);
+        size_t rows = d.numbers.rows(), cols = d.numbers.cols();
+        MFStruct t;
+        std::unordered_map<std::string, int> seen;
+        for (size_t j = 0; j < cols; j++) {
+            ValuePtr column;
+            if (d.isText[j]) {
+                CellArray c(rows, 1);
+                for (size_t i = 0; i < rows; i++) c.data[i] = Value::makeString(d.text[j][i]);
+                column = Value::makeCellArray(std::move(c));
+            } else {
+                Matrix m(rows, 1);
+                for (size_t i = 0; i < rows; i++) m(i) = d.numbers(i, j);
+                column = Value::makeMatrix(std::move(m));
+            }
+            t.fields[variableName(d.names[j], j, seen)] = column;
+        }
+        return Value::makeStruct(std::move(t));
+    });
+
+    // ds = datastore(location, 'Type', 'tabulartext' | 'binary', 'ReadSize', n,
+    //                'Format', class, ...readmatrix options)
+    // location is a file, a directory (all files in it) or a cell of them
+    interp.registerBuiltin("datastore", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
+        requireMinArgs("datastore", args, 1);
+        if (args.size() % 2 == 0) throw RuntimeError("datastore: options must be name/value pairs");
+        std::vector<std::string> files;
+        auto addLocation = [&files](const std::string& loc) {
+            namespace fs = std::filesystem;
+            if (!fs::is_directory(loc)) {
+                if (!fs::exists(loc)) throw RuntimeError("datastore: '" + loc + "' does not exist");
+                files.push_back(loc);
+                return;
+            }
+            std::vector<std::string> inDir;
+            for (auto& e : fs::directory_iterator(loc))
+                if (e.is_regular_file()) inDir.push_back(e.path().string());
+            std::sort(inDir.begin(), inDir.end());
+            files.insert(files.end(), inDir.begin(), inDir.end());
+        };
+        if (args[0]->isCellArray()) {
+            for (auto& loc : args[0]->cellArray().data) addLocation(loc->string());
+        } else {
+            addLocation(args[0]->string());
+        }
+
+        DatastoreOptions opts;
+        bool readSizeGiven = false;
+        ValueList textArgs = {args[0]};
+        for (size_t i = 1; i < args.size(); i += 2) {
+            std::string opt = args[i]->string();
+            std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+            if (opt == "type") {
+                std::string type = args[i + 1]->string();
+                if (type == "binary") opts.kind = DatastoreKind::BINARY;
+                else if (type == "tabulartext") opts.kind = DatastoreKind::TEXT;
+                else throw RuntimeError("datastore: unknown Type '" + type + "'");
+            } else if (opt == "readsize") {
+                opts.readSize = nonNegativeCount("datastore", args[i + 1]);
+                readSizeGiven = true;
+            } else if (opt == "format") {
+                opts.format = parseNumericClass(args[i + 1]->string());
+            } else {
+                textArgs.push_back(args[i]);
+                textArgs.push_back(args[i + 1]);
+            }
+        }
+        if (opts.kind == DatastoreKind::BINARY && !readSizeGiven) opts.readSize = size_t(1) << 20;
+        if (opts.kind == DatastoreKind::BINARY && textArgs.size() > 1)
+            throw RuntimeError("datastore: option '" + textArgs[1]->string() + "' does not apply to binary files");
+        opts.text = delimitedOptions("datastore", textArgs, 1);
+
+        auto ds = std::make_shared<Datastore>(files, opts);
+        SessionState& session = interp.session();
+        // Unique across sessions, so a parfor worker's datastore is never
+        // taken for one of the client's
+        static std::atomic<uint64_t> nextHandle{1};
+        uint64_t handle = nextHandle++;
+        session.datastores[handle] = ds;
+
+        MFStruct v;
+        CellArray fileCells(files.size(), 1);
+        for (size_t k = 0; k < files.size(); k++) fileCells.data[k] = Value::makeString(files[k]);
+        v.fields["Files"] = Value::makeCellArray(std::move(fileCells));
+        v.fields["Type"] = Value::makeString(opts.kind == DatastoreKind::BINARY ? "binary" : "tabulartext");
+        v.fields["ReadSize"] = Value::makeScalar(static_cast<double>(opts.readSize));
+        if (opts.kind == DatastoreKind::TEXT) {
+            auto names = ds->columnNames();
+            CellArray nameCells(1, names.size());
+            for (size_t k = 0; k < names.size(); k++) nameCells.data[k] = Value::makeString(names[k]);
+            v.fields["VariableNames"] = Value::makeCellArray(std::move(nameCells));
+        }
+        v.fields["Handle"] = Value::makeScalar(static_cast<double>(handle));
+        return Value::makeStruct(std::move(v));
+    });
+
+    // The session's datastore behind a datastore (or tall) struct
+    auto datastoreOf = [](const std::string& name, const ValuePtr& v) {
+        const ValuePtr* ds = &v;
+        if (isTall(v)) ds = &v->structVal().fields.at("Datastore");
+        if (!(*ds)->isStruct() || !(*ds)->structVal().fields.count("Handle"))
+            throw RuntimeError(name + ": expected a datastore");
+        auto& table = Interpreter::current().session().datastores;
+        auto it = table.find(static_cast<uint64_t>((*ds)->structVal().fields.at("Handle")->scalarDouble()));
+        if (it == table.end())
+            throw RuntimeError(name + ": the datastore has been closed (clear all) or belongs to another session");
+        return it->second;
+    };
+
+    interp.registerBuiltin("hasdata", [datastoreOf](const ValueList& args) -> ValuePtr {
+        requireArgs("hasdata", args, 1);
+        return Value::makeBool(datastoreOf("hasdata", args[0])->hasData());
+    });
+
+    // The next block: up to ReadSize rows of a text file, or a column of up
+    // to ReadSize elements of a binary one. The block after it is read in
+    // the background meanwhile.
+    interp.registerBuiltin("read", [datastoreOf](const ValueList& args) -> ValuePtr {
+        requireArgs("read", args, 1);
+        return Value::makeMatrix(datastoreOf("read", args[0])->read());
+    });
+
+    interp.registerBuiltin("reset", [datastoreOf](const ValueList& args) -> ValuePtr {
+        requireArgs("reset", args, 1);
+        datastoreOf("reset", args[0])->reset();
+        return Value::makeEmpty();
+    });
+
+    // t = tall(ds): the datastore's data as one array. sum, mean, min, max
+    // (per column) and histcounts of it are deferred until gather.
+    interp.registerBuiltin("tall", [datastoreOf](const ValueList& args) -> ValuePtr {
+        requireArgs("tall", args, 1);
+        datastoreOf("tall", args[0]);
+        MFStruct t;
+        t.fields["Datastore"] = args[0];
+        t.fields["TallOp"] = Value::makeString("gather");
+        return Value::makeStruct(std::move(t));
+    });
+
+    // [a, b, ...] = gather(x, y, ...): evaluate deferred tall results, all
+    // of those over the same datastore in one pass. Other values pass
+    // through unchanged.
+    interp.registerMultiBuiltin("gather", [datastoreOf](const ValueList& args, int nargout) -> ValueList {
+        requireMinArgs("gather", args, 1);
+        ValueList out(args.begin(), args.end());
+        std::vector<bool> done(args.size(), false);
+        for (size_t i = 0; i < args.size(); i++) {
+            if (done[i] || !isTall(args[i])) continue;
+            auto ds = datastoreOf("gather", args[i]);
+            std::vector<size_t> group;
+            std::vector<TallReduction> reductions;
+            for (size_t j = i; j < args.size(); j++) {
+                if (done[j] || !isTall(args[j]) || datastoreOf("gather", args[j]) != ds) continue;
+                const auto& f = args[j]->structVal().fields;
+                std::string op = f.at("TallOp")->string();
+                TallReduction r;
+                if (op == "gather") r.op = TallReduction::GATHER;
+                else if (op == "sum") r.op = TallReduction::SUM;
+                else if (op == "mean") r.op = TallReduction::MEAN;
+                else if (op == "min") r.op = TallReduction::MIN;
+                else if (op == "max") r.op = TallReduction::MAX;
+                else if (op == "histcounts") {
+                    r.op = TallReduction::HISTCOUNTS;
+                    const Matrix& bins = f.at("Bins")->matrix();
+                    if (bins.isScalar()) r.nbins = nonNegativeCount("histcounts", f.at("Bins"));
+                    else r.edges.assign(bins.begin(), bins.end());
+                } else {
+                    throw RuntimeError("gather: unknown tall operation '" + op + "'");
+                }
+                group.push_back(j);
+                reductions.push_back(std::move(r));
+                done[j] = true;
+            }
+            auto results = evaluateTall(*ds, reductions);
+            for (size_t k = 0; k < group.size(); k++) {
+                Matrix& m = results[k];
+                out[group[k]] = m.isScalar() ? Value::makeScalar(m(0)) : Value::makeMatrix(std::move(m));
+            }
+        }
+        out.resize(std::max<size_t>(1, std::min<size_t>(out.size(), static_cast<size_t>(std::max(nargout, 1)))));
+        return out;
+    });
 }
 
 // ============================================================================
@@ -1139,16 +2282,76 @@ void registerTypeBuiltins(Interpreter& interp) {
         for (auto& v : cell.data) v = Value::makeEmpty();
         return Value::makeCellArray(std::move(cell));
     });
+    for (const char* name : {"isnumeric", "ischar", "islogical", "isstruct", "iscell"})
+        interp.setBuiltinTraits(name, PURE_BUILTIN);
+    for (const char* name : {"isnan", "isinf", "isfinite"})
+        interp.setBuiltinTraits(name, ELEMENTWISE_BUILTIN);
 }
 
 // ============================================================================
 // Statistics built-ins
 // ============================================================================
 
+// Trailing options shared by the order-statistics builtins
+struct StatsOptions {
+    int dim = 0;      // 0 = first non-singleton dimension; 3 and up leave each element alone
+    bool all = false; // reduce over every element
+    NanFlag nan = NanFlag::INCLUDE;
+};
+
+static StatsOptions parseStatsOptions(const std::string& name, const ValueList& args,
+                                      size_t first, NanFlag defaultNan) {
+    StatsOptions opts;
+    opts.nan = defaultNan;
+    for (size_t i = first; i < args.size(); i++) {
+        if (args[i]->isString()) {
+            std::string opt = args[i]->string();
+            std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+            if (opt == "all") opts.all = true;
+            else if (opt == "omitnan") opts.nan = NanFlag::OMIT;
+            else if (opt == "includenan") opts.nan = NanFlag::INCLUDE;
+            else throw RuntimeError(name + ": unknown option '" + args[i]->string() + "'");
+        } else {
+            double d = args[i]->scalarDouble();
+            if (!(d >= 1) || d != std::floor(d))
+                throw RuntimeError(name + ": dimension must be a positive integer");
+            opts.dim = d > 3 ? 3 : static_cast<int>(d);
+        }
+    }
+    return opts;
+}
+
+// Apply a per-line statistic honouring dim/'all'; an empty input yields NaN(s).
+// Along dim >= 3 every element is a line of its own, so the result has the
+// input's shape (one output per line only).
+static Matrix reduceStats(const Matrix& m, StatsOptions& opts, size_t outPerLine,
+                          const std::function<void(double*, size_t, double*)>& fn) {
+    if (!opts.all && opts.dim >= 3) {
+        if (outPerLine != 1) throw RuntimeError("several results per element along dimension 3 need N-D arrays");
+        Matrix result(m.rows(), m.cols());
+        for (size_t i = 0; i < m.numel(); i++) {
+            double x = m(i);
+            fn(&x, 1, &result(i));
+        }
+        return result;
+    }
+    if (m.numel() == 0) {
+        opts.dim = 2;
+        return Matrix(1, outPerLine, std::nan(""));
+    }
+    if (opts.all) {
+        opts.dim = 2;
+        return reduceLines(Matrix(1, m.numel(), std::vector<double>(m.begin(), m.end())), 2, outPerLine, fn);
+    }
+    if (opts.dim == 0) opts.dim = defaultSortDim(m);
+    return reduceLines(m, opts.dim, outPerLine, fn);
+}
+
 void registerStatsBuiltins(Interpreter& interp) {
     // mean
     interp.registerBuiltin("mean", [](const ValueList& args) -> ValuePtr {
         requireMinArgs("mean", args, 1);
+        if (isTall(args[0])) return tallReduction("mean", args[0], "mean");
         auto& m = args[0]->matrix();
         if (m.isVector() || m.isScalar()) return Value::makeScalar(m.mean());
         if (args.size() >= 2) {
@@ -1158,127 +2361,576 @@ void registerStatsBuiltins(Interpreter& interp) {
         return Value::makeMatrix(m.meanAlongDim(1));
     });
 
-    // std
-    interp.registerBuiltin("std", [](const ValueList& args) -> ValuePtr {
-        requireMinArgs("std", args, 1);
-        auto& m = args[0]->matrix();
-        double mu = m.mean();
-        double s = 0;
-        for (size_t i = 0; i < m.numel(); i++) {
-            double d = m(i) - mu;
-            s += d * d;
+    // var(x, [w], [dim | 'all'], ['omitnan' | 'includenan']) and std(...):
+    // one pass per column/row. w = 0 (default) normalizes by N-1, w = 1 by N.
+    auto makeVariance = [](const std::string& name, bool root) {
+        return [name, root](const ValueList& args) -> ValuePtr {
+            requireMinArgs(name, args, 1);
+            int w = 0;
+            size_t first = 1; // options start after the weight, if given
+            if (args.size() >= 2 && !args[1]->isString()) {
+                first = 2;
+                if (!args[1]->isEmpty() && !(args[1]->isMatrix() && args[1]->matrix().numel() == 0)) {
+                    w = static_cast<int>(args[1]->scalarDouble());
+                    if (w != 0 && w != 1) throw RuntimeError(name + ": weight must be 0 or 1");
+                }
+            }
+            auto opts = parseStatsOptions(name, args, first, NanFlag::INCLUDE);
+            auto finish = [&](const MomentAccumulator& acc) {
+                double v = acc.variance(w);
+                return root ? std::sqrt(v) : v;
+            };
+            Matrix m = args[0]->toMatrix();
+            // Explicit dim across a singleton (or dim >= 3): each element is its own sample
+            bool singleton = !opts.all && (opts.dim >= 3 || (m.numel() > 0 && m.isVector() &&
+                                           ((opts.dim == 1 && m.rows() == 1) || (opts.dim == 2 && m.cols() == 1))));
+            if (singleton) {
+                Matrix zeros(m.rows(), m.cols(), 0.0);
+                for (size_t i = 0; i < m.numel(); i++)
+                    if (std::isnan(m(i))) zeros(i) = std::nan("");
+                return Value::makeMatrix(std::move(zeros));
+            }
+            if (opts.all || m.isVector() || m.numel() == 0) {
+                return Value::makeScalar(finish(accumulateMoments(m.begin(), m.numel(), opts.nan)));
+            }
+            int dim = opts.dim ? opts.dim : defaultSortDim(m);
+            auto moments = momentsAlongDim(m, dim, opts.nan);
+            Matrix result = (dim == 1) ? Matrix(1, moments.size()) : Matrix(moments.size(), 1);
+            for (size_t i = 0; i < moments.size(); i++) result(i) = finish(moments[i]);
+            return Value::makeMatrix(std::move(result));
+        };
+    };
+    interp.registerBuiltin("var", makeVariance("var", false));
+    interp.registerBuiltin("std", makeVariance("std", true));
+
+    // median(x, [dim | 'all'], ['omitnan' | 'includenan'])
+    interp.registerBuiltin("median", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("median", args, 1);
+        auto opts = parseStatsOptions("median", args, 1, NanFlag::INCLUDE);
+        return Value::makeMatrix(reduceStats(args[0]->toMatrix(), opts, 1,
+            [nan = opts.nan](double* line, size_t len, double* out) {
+                *out = medianInPlace(line, len, nan);
+            }));
+    });
+
+    // quantile(x, p, [dim]) and prctile(x, p, [dim]); NaNs are ignored
+    auto makeQuantile = [](const std::string& name, double scale) {
+        return [name, scale](const ValueList& args) -> ValuePtr {
+            requireMinArgs(name, args, 2);
+            const Matrix& pm = args[1]->matrix();
+            std::vector<double> probs(pm.numel());
+            for (size_t i = 0; i < probs.size(); i++) probs[i] = pm(i) / scale;
+            auto opts = parseStatsOptions(name, args, 2, NanFlag::OMIT);
+            return Value::makeMatrix(reduceStats(args[0]->toMatrix(), opts, probs.size(),
+                [&probs, nan = opts.nan](double* line, size_t len, double* out) {
+                    quantilesInPlace(line, len, probs, out, nan);
+                }));
+        };
+    };
+    interp.registerBuiltin("quantile", makeQuantile("quantile", 1.0));
+    interp.registerBuiltin("prctile", makeQuantile("prctile", 100.0));
+
+    // [M, F] = mode(x, [dim]): most frequent value (smallest on ties) and its count
+    interp.registerMultiBuiltin("mode", [](const ValueList& args, int nargout) -> ValueList {
+        requireMinArgs("mode", args, 1);
+        auto opts = parseStatsOptions("mode", args, 1, NanFlag::OMIT);
+        if (!opts.all && opts.dim >= 3) {
+            // Each element is the mode of itself
+            Matrix m = args[0]->toMatrix();
+            Matrix modes(m.rows(), m.cols()), freqs(m.rows(), m.cols());
+            for (size_t i = 0; i < m.numel(); i++) std::tie(modes(i), freqs(i)) = modeOf(&m(i), 1);
+            if (nargout < 2) return {Value::makeMatrix(std::move(modes))};
+            return {Value::makeMatrix(std::move(modes)), Value::makeMatrix(std::move(freqs))};
+        }
+        Matrix both = reduceStats(args[0]->toMatrix(), opts, 2,
+            [](double* line, size_t len, double* out) {
+                auto [value, count] = modeOf(line, len);
+                out[0] = value;
+                out[1] = count;
+            });
+        // Value and count are stacked along the reduced dimension: split them.
+        bool alongRows = (opts.dim == 1);
+        Matrix modes = alongRows ? both.getRow(0) : both.getCol(0);
+        if (nargout < 2) return {Value::makeMatrix(std::move(modes))};
+        Matrix freqs = alongRows ? both.getRow(1) : both.getCol(1);
+        return {Value::makeMatrix(std::move(modes)), Value::makeMatrix(std::move(freqs))};
+    });
+
+    // cov(X, [w]) or cov(x, y, [w]): columns are variables, rows observations
+    auto covInput = [](const std::string& name, const ValueList& args, int& w) {
+        requireMinArgs(name, args, 1);
+        auto asColumn = [](const Matrix& v) {
+            return v.isVector() ? Matrix(v.numel(), 1, std::vector<double>(v.begin(), v.end())) : v;
+        };
+        Matrix x = asColumn(args[0]->matrix());
+        size_t next = 1;
+        if (args.size() >= 2 && !args[1]->isScalar()) {
+            Matrix y = asColumn(args[1]->matrix());
+            if (y.numel() != x.numel())
+                throw RuntimeError(name + ": X and Y must have the same number of elements");
+            Matrix xy(x.numel(), 2);
+            for (size_t i = 0; i < x.numel(); i++) {
+                xy(i, 0) = x(i);
+                xy(i, 1) = y(i);
+            }
+            x = std::move(xy);
+            next = 2;
         }
-        // Default: normalize by N-1 (sample std)
-        double n = static_cast<double>(m.numel());
-        return Value::makeScalar(std::sqrt(s / (n > 1 ? n - 1 : 1)));
+        w = (args.size() > next) ? static_cast<int>(args[next]->scalarDouble()) : 0;
+        if (w != 0 && w != 1) throw RuntimeError(name + ": weight must be 0 or 1");
+        return x;
+    };
+
+    interp.registerBuiltin("cov", [covInput](const ValueList& args) -> ValuePtr {
+        int w;
+        Matrix x = covInput("cov", args, w);
+        return Value::makeMatrix(covariance(x, w));
     });
 
-    // var
-    interp.registerBuiltin("var", [](const ValueList& args) -> ValuePtr {
-        requireMinArgs("var", args, 1);
-        auto& m = args[0]->matrix();
-        double mu = m.mean();
-        double s = 0;
-        for (size_t i = 0; i < m.numel(); i++) {
-            double d = m(i) - mu;
-            s += d * d;
+    // corrcoef: covariance scaled by the standard deviations
+    interp.registerBuiltin("corrcoef", [covInput](const ValueList& args) -> ValuePtr {
+        int w;
+        Matrix c = covariance(covInput("corrcoef", args, w), 0);
+        size_t p = c.rows();
+        std::vector<double> sd(p);
+        for (size_t i = 0; i < p; i++) sd[i] = std::sqrt(c(i, i));
+        for (size_t i = 0; i < p; i++) {
+            for (size_t j = 0; j < p; j++) {
+                double s = sd[i] * sd[j];
+                c(i, j) = (i == j) ? 1.0 : (s > 0 ? c(i, j) / s : 0.0);
+            }
         }
-        double n = static_cast<double>(m.numel());
-        return Value::makeScalar(s / (n > 1 ? n - 1 : 1));
+        return Value::makeMatrix(std::move(c));
+    });
+
+    // moments(x) summarizes x; moments(s, x) folds chunk x into summary s;
+    // moments(s1, s2) merges two summaries. Summaries are structs with
+    // count, mean, m2, min, max, var and std, so data can be reduced chunk
+    // by chunk without holding it all in memory.
+    interp.registerBuiltin("moments", [](const ValueList& args) -> ValuePtr {
+        requireMinArgs("moments", args, 1);
+        auto fromStruct = [](const MFStruct& s) {
+            MomentAccumulator acc;
+            auto field = [&](const char* f) {
+                auto it = s.fields.find(f);
+                if (it == s.fields.end()) throw RuntimeError(std::string("moments: summary is missing field '") + f + "'");
+                return it->second->scalarDouble();
+            };
+            acc.count = field("count");
+            acc.mean = field("mean");
+            acc.m2 = field("m2");
+            acc.min = field("min");
+            acc.max = field("max");
+            return acc;
+        };
+        MomentAccumulator acc;
+        for (auto& arg : args) {
+            if (arg->isStruct()) {
+                acc.merge(fromStruct(arg->structVal()));
+            } else {
+                const Matrix& m = arg->matrix();
+                acc.merge(accumulateMoments(m.begin(), m.numel()));
+            }
+        }
+        MFStruct s;
+        s.fields["count"] = Value::makeScalar(acc.count);
+        s.fields["mean"] = Value::makeScalar(acc.count > 0 ? acc.mean : std::nan(""));
+        s.fields["m2"] = Value::makeScalar(acc.m2);
+        s.fields["min"] = Value::makeScalar(acc.min);
+        s.fields["max"] = Value::makeScalar(acc.max);
+        s.fields["var"] = Value::makeScalar(acc.variance(0));
+        s.fields["std"] = Value::makeScalar(std::sqrt(acc.variance(0)));
+        return Value::makeStruct(std::move(s));
     });
 
-    // median
-    interp.registerBuiltin("median", [](const ValueList& args) -> ValuePtr {
-        requireArgs("median", args, 1);
-        auto m = args[0]->matrix(); // copy
-        auto& d = m.data();
-        std::sort(d.begin(), d.end());
-        size_t n = d.size();
-        if (n % 2 == 0) return Value::makeScalar((d[n/2 - 1] + d[n/2]) / 2.0);
-        return Value::makeScalar(d[n/2]);
-    });
-
-    // cov (simplified: sample covariance matrix)
-    interp.registerBuiltin("cov", [](const ValueList& args) -> ValuePtr {
-        requireArgs("cov", args, 1);
-        auto& m = args[0]->matrix();
-        size_t n = m.rows(), p = m.cols();
+    // Histograms. A scalar second argument is a bin count; a vector gives edges.
+    auto binsFor = [](const Matrix& x, const ValuePtr& spec) {
+        if (!spec) return BinEdges::automatic(x.begin(), x.numel());
+        const Matrix& sm = spec->matrix();
+        if (sm.isScalar()) {
+            double nb = sm(0);
+            if (!(nb >= 1) || nb != std::floor(nb))
+                throw RuntimeError("Number of bins must be a positive integer");
+            return BinEdges::automatic(x.begin(), x.numel(), static_cast<size_t>(nb));
+        }
+        return BinEdges::fromEdges(std::vector<double>(sm.begin(), sm.end()));
+    };
+    auto edgesRow = [](const BinEdges& b) {
+        return Matrix(1, b.edges().size(), b.edges());
+    };
 
-        // Compute means
-        Matrix means = m.meanAlongDim(1);
+    // [N, edges, bin] = histcounts(x, [nbins | edges], ['Normalization', type])
+    interp.registerMultiBuiltin("histcounts", [binsFor, edgesRow](const ValueList& args, int nargout) -> ValueList {
+        requireMinArgs("histcounts", args, 1);
+        if (isTall(args[0])) {
+            if (args.size() > 2) throw RuntimeError("histcounts: options are not supported for tall arrays");
+            return {tallReduction("histcounts", args[0], "histcounts", args.size() > 1 ? args[1] : Value::makeScalar(0))};
+        }
+        const Matrix& x = args[0]->matrix();
+        size_t next = 1;
+        ValuePtr spec;
+        if (args.size() > 1 && !args[1]->isString()) spec = args[next++];
+        std::string norm = "count";
+        for (; next < args.size(); next += 2) {
+            std::string opt = args[next]->string();
+            std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+            if (opt != "normalization" || next + 1 >= args.size())
+                throw RuntimeError("histcounts: unknown option '" + args[next]->string() + "'");
+            norm = args[next + 1]->string();
+            std::transform(norm.begin(), norm.end(), norm.begin(), ::tolower);
+        }
 
-        // Compute covariance
-        Matrix result(p, p, 0.0);
-        for (size_t i = 0; i < p; i++) {
-            for (size_t j = i; j < p; j++) {
-                double s = 0;
-                for (size_t k = 0; k < n; k++) {
-                    s += (m(k, i) - means(0, i)) * (m(k, j) - means(0, j));
-                }
-                result(i, j) = result(j, i) = s / (n > 1 ? n - 1 : 1);
+        BinEdges bins = binsFor(x, spec);
+        Matrix binIdx;
+        if (nargout >= 3) binIdx = Matrix(x.rows(), x.cols());
+        auto counts = histCounts(x.begin(), x.numel(), bins,
+                                 nargout >= 3 ? binIdx.begin() : nullptr);
+
+        size_t nb = bins.bins();
+        const auto& e = bins.edges();
+        double total = static_cast<double>(x.numel());
+        Matrix n(1, nb);
+        double running = 0.0;
+        for (size_t k = 0; k < nb; k++) {
+            double c = static_cast<double>(counts[k]);
+            double w = e[k + 1] - e[k];
+            running += c;
+            if (norm == "count") n(k) = c;
+            else if (norm == "probability") n(k) = c / total;
+            else if (norm == "countdensity") n(k) = c / w;
+            else if (norm == "pdf") n(k) = c / (total * w);
+            else if (norm == "cumcount") n(k) = running;
+            else if (norm == "cdf") n(k) = running / total;
+            else throw RuntimeError("histcounts: unknown normalization '" + norm + "'");
+        }
+        ValueList out = {Value::makeMatrix(std::move(n))};
+        if (nargout >= 2) out.push_back(Value::makeMatrix(edgesRow(bins)));
+        if (nargout >= 3) out.push_back(Value::makeMatrix(std::move(binIdx)));
+        return out;
+    });
+
+    // [N, xedges, yedges] = histcounts2(x, y, [nbins | [nx ny]]) or
+    // histcounts2(x, y, xedges, yedges)
+    interp.registerMultiBuiltin("histcounts2", [binsFor, edgesRow](const ValueList& args, int nargout) -> ValueList {
+        requireMinArgs("histcounts2", args, 2);
+        const Matrix& x = args[0]->matrix();
+        const Matrix& y = args[1]->matrix();
+        if (x.numel() != y.numel())
+            throw RuntimeError("histcounts2: X and Y must have the same number of elements");
+        BinEdges bx, by;
+        if (args.size() >= 4) {
+            bx = binsFor(x, args[2]);
+            by = binsFor(y, args[3]);
+        } else if (args.size() == 3) {
+            const Matrix& nb = args[2]->matrix();
+            if (nb.numel() > 2)
+                throw RuntimeError("histcounts2: bin counts must be a scalar or [nx ny]");
+            bx = binsFor(x, Value::makeScalar(nb(0)));
+            by = binsFor(y, Value::makeScalar(nb(nb.numel() - 1)));
+        } else {
+            bx = binsFor(x, nullptr);
+            by = binsFor(y, nullptr);
+        }
+        ValueList out = {Value::makeMatrix(
+            histCounts2(x.begin(), y.begin(), x.numel(), bx, by))};
+        if (nargout >= 2) out.push_back(Value::makeMatrix(edgesRow(bx)));
+        if (nargout >= 3) out.push_back(Value::makeMatrix(edgesRow(by)));
+        return out;
+    });
+
+    // [counts, centers] = hist(x, [nbins | centers]); every value lands in a bin
+    interp.registerMultiBuiltin("hist", [](const ValueList& args, int nargout) -> ValueList {
+        requireMinArgs("hist", args, 1);
+        const Matrix& x = args[0]->matrix();
+        std::vector<double> centers;
+        BinEdges bins;
+        if (args.size() >= 2 && !args[1]->isScalar()) {
+            // Bin centers given: edges are the midpoints, open-ended outside
+            centers.assign(args[1]->matrix().begin(), args[1]->matrix().end());
+            std::sort(centers.begin(), centers.end());
+            std::vector<double> e(centers.size() + 1);
+            e.front() = -std::numeric_limits<double>::infinity();
+            e.back() = std::numeric_limits<double>::infinity();
+            for (size_t k = 1; k < centers.size(); k++) e[k] = (centers[k - 1] + centers[k]) / 2.0;
+            bins = BinEdges::fromEdges(std::move(e));
+        } else {
+            size_t nb = (args.size() >= 2) ? static_cast<size_t>(args[1]->scalarDouble()) : 10;
+            bins = BinEdges::automatic(x.begin(), x.numel(), nb);
+            const auto& e = bins.edges();
+            for (size_t k = 0; k + 1 < e.size(); k++) centers.push_back((e[k] + e[k + 1]) / 2.0);
+        }
+        auto counts = histCounts(x.begin(), x.numel(), bins);
+        Matrix n(1, counts.size());
+        for (size_t k = 0; k < counts.size(); k++) n(k) = static_cast<double>(counts[k]);
+        ValueList out = {Value::makeMatrix(std::move(n))};
+        if (nargout >= 2) out.push_back(Value::makeMatrix(Matrix(1, centers.size(), centers)));
+        return out;
+    });
+
+    // accumarray(subs, vals, [sz], [fun], [fillval], [issparse])
+    // subs is an n-by-1 or n-by-2 matrix of positive integer subscripts.
+    // @sum, @prod, @max, @min, @mean and @numel/@length run as scatter
+    // kernels; any other function handle is called once per non-empty cell
+    // with that cell's values as a column vector. MatFree has no sparse
+    // storage, so issparse is accepted but the result is always full.
+    interp.registerBuiltin("accumarray", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
+        requireMinArgs("accumarray", args, 2);
+        Matrix subs = args[0]->matrix();
+        const Matrix& vals = args[1]->matrix();
+        if (subs.rows() == 1 && subs.cols() != 2 && vals.numel() == subs.numel())
+            subs = subs.transpose(); // a row of 1-D subscripts
+        size_t n = subs.rows(), dims = subs.cols();
+        if (dims != 1 && dims != 2)
+            throw RuntimeError("accumarray: subscripts must have one or two columns");
+        if (!vals.isScalar() && vals.numel() != n)
+            throw RuntimeError("accumarray: values must be a scalar or have one entry per subscript");
+
+        size_t outRows = 0, outCols = 1;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t d = 0; d < dims; d++) {
+                double v = subs(i, d);
+                if (!(v >= 1) || v != std::floor(v))
+                    throw RuntimeError("accumarray: subscripts must be positive integers");
+            }
+            outRows = std::max(outRows, static_cast<size_t>(subs(i, 0)));
+            if (dims == 2) outCols = std::max(outCols, static_cast<size_t>(subs(i, 1)));
+        }
+        if (args.size() >= 3 && args[2]->isNumeric() && args[2]->matrix().numel() > 0) {
+            const Matrix& sz = args[2]->matrix();
+            if (sz.numel() != 2) throw RuntimeError("accumarray: size must be [rows cols]");
+            if (sz(0) < outRows || sz(1) < outCols || (dims == 1 && sz(1) != 1))
+                throw RuntimeError("accumarray: size is smaller than the largest subscript");
+            outRows = static_cast<size_t>(sz(0));
+            outCols = static_cast<size_t>(sz(1));
+        }
+        double fill = (args.size() >= 5) ? args[4]->scalarDouble() : 0.0;
+
+        std::vector<size_t> target(n);
+        for (size_t i = 0; i < n; i++) {
+            size_t r = static_cast<size_t>(subs(i, 0)) - 1;
+            size_t c = (dims == 2) ? static_cast<size_t>(subs(i, 1)) - 1 : 0;
+            target[i] = r * outCols + c;
+        }
+        const double* valPtr = vals.isScalar() ? nullptr : vals.begin();
+        double scalarVal = vals.isScalar() ? vals(0) : 0.0;
+
+        // Built-in reductions by handle name, unless shadowed by a user function
+        static const std::unordered_map<std::string, AccumOp> fastOps = {
+            {"sum", AccumOp::SUM}, {"prod", AccumOp::PROD}, {"max", AccumOp::MAX},
+            {"min", AccumOp::MIN}, {"mean", AccumOp::MEAN}, {"numel", AccumOp::COUNT},
+            {"length", AccumOp::COUNT},
+        };
+        AccumOp op = AccumOp::SUM;
+        const FunctionHandle* custom = nullptr;
+        if (args.size() >= 4 && !(args[3]->isNumeric() && args[3]->matrix().numel() == 0)) {
+            if (!args[3]->isFuncHandle()) throw RuntimeError("accumarray: fun must be a function handle");
+            const auto& fh = args[3]->funcHandle();
+            auto it = fastOps.find(fh.name);
+            if (it != fastOps.end() && std::holds_alternative<BuiltinFunc>(fh.impl)) op = it->second;
+            else custom = &fh;
+        }
+
+        Matrix result(outRows, outCols);
+        if (!custom) {
+            auto out = accumulate(target.data(), n, valPtr, scalarVal, outRows * outCols, op, fill);
+            std::copy(out.begin(), out.end(), result.begin());
+            return Value::makeMatrix(std::move(result));
+        }
+
+        std::vector<size_t> start, order;
+        groupByTarget(target.data(), n, outRows * outCols, start, order);
+        for (size_t k = 0; k < outRows * outCols; k++) {
+            size_t count = start[k + 1] - start[k];
+            if (count == 0) {
+                result(k) = fill;
+                continue;
+            }
+            Matrix group(count, 1);
+            for (size_t j = 0; j < count; j++) {
+                size_t i = order[start[k] + j];
+                group(j) = valPtr ? valPtr[i] : scalarVal;
             }
+            auto res = interp.callFuncHandle(*custom, {Value::makeMatrix(std::move(group))});
+            result(k) = res->scalarDouble();
         }
         return Value::makeMatrix(std::move(result));
     });
 
-    // corrcoef
-    interp.registerBuiltin("corrcoef", [](const ValueList& args) -> ValuePtr {
-        requireArgs("corrcoef", args, 1);
-        auto& m = args[0]->matrix();
-        size_t n = m.rows(), p = m.cols();
+    // [n, bin] = histc(x, edges): n(k) counts edges(k) <= x < edges(k+1),
+    // and n(end) counts x == edges(end)
+    interp.registerMultiBuiltin("histc", [](const ValueList& args, int nargout) -> ValueList {
+        requireArgs("histc", args, 2);
+        const Matrix& x = args[0]->matrix();
+        const Matrix& em = args[1]->matrix();
+        std::vector<double> e(em.begin(), em.end());
+        if (e.empty()) throw RuntimeError("histc: edges must not be empty");
+        // The final edge acts as a zero-width closed bin of its own.
+        e.push_back(e.back());
+        BinEdges bins = BinEdges::fromEdges(std::move(e));
+        Matrix binIdx;
+        if (nargout >= 2) binIdx = Matrix(x.rows(), x.cols());
+        auto counts = histCounts(x.begin(), x.numel(), bins,
+                                 nargout >= 2 ? binIdx.begin() : nullptr);
+        Matrix n(em.rows(), em.cols());
+        for (size_t k = 0; k < counts.size(); k++) n(k) = static_cast<double>(counts[k]);
+        if (nargout < 2) return {Value::makeMatrix(std::move(n))};
+        return {Value::makeMatrix(std::move(n)), Value::makeMatrix(std::move(binIdx))};
+    });
+    for (const char* name : {"mean", "median", "var", "std", "mode", "quantile", "prctile"})
+        interp.setBuiltinTraits(name, PURE_BUILTIN);
+}
 
-        Matrix means = m.meanAlongDim(1);
+// ============================================================================
+// cellfun / arrayfun
+// ============================================================================
 
-        // Compute covariance and standard deviations
-        Matrix cov(p, p, 0.0);
-        std::vector<double> stds(p);
+// Element i of a cellfun/arrayfun input
+static ValuePtr elementOf(const ValuePtr& v, size_t i) {
+    if (v->isCellArray()) {
+        const auto& e = v->cellArray().data[i];
+        return e ? e : Value::makeEmpty();
+    }
+    if (v->isString()) return Value::makeString(std::string(1, v->string()[i]));
+    if (v->isLogical()) return Value::makeBool(v->matrix()(i) != 0.0);
+    if (v->isStruct()) return v;
+    return Value::makeScalar(v->matrix()(i));
+}
 
-        for (size_t i = 0; i < p; i++) {
-            double s = 0;
-            for (size_t k = 0; k < n; k++) {
-                double d = m(k, i) - means(0, i);
-                s += d * d;
-            }
-            stds[i] = std::sqrt(s / (n > 1 ? n - 1 : 1));
+static std::pair<size_t, size_t> dimsOf(const ValuePtr& v) {
+    if (v->isCellArray()) return {v->cellArray().rows, v->cellArray().cols};
+    if (v->isString()) return {1, v->string().size()};
+    if (v->isStruct()) return {1, 1};
+    return {v->matrix().rows(), v->matrix().cols()};
+}
+
+// Shared implementation of cellfun (overCells) and arrayfun. Calls take one
+// of three paths: an elementwise anonymous function is evaluated once over
+// whole arrays; a pure built-in runs in parallel across elements; anything
+// else is called per element through a HandleCaller (one reused scope).
+static ValueList applyFunction(Interpreter& interp, const std::string& name,
+                               const ValueList& args, int nargout, bool overCells) {
+    requireMinArgs(name, args, 2);
+    ValuePtr fnValue = args[0];
+    if (overCells && fnValue->isString()) {
+        // Legacy cellfun('isempty', C) form
+        std::string fname = fnValue->string();
+        if (fname == "prodofsize") fname = "numel";
+        fnValue = interp.makeFunctionHandle(fname);
+    }
+    if (!fnValue->isFuncHandle()) throw RuntimeError(name + ": first argument must be a function handle");
+    const FunctionHandle& fh = fnValue->funcHandle();
+
+    // Inputs run up to the first recognised option name
+    ValueList inputs;
+    bool uniform = true;
+    ValuePtr errorHandler;
+    size_t i = 1;
+    for (; i < args.size(); i++) {
+        if (i > 1 && args[i]->isString()) {
+            std::string opt = args[i]->string();
+            std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+            if (opt == "uniformoutput" || opt == "errorhandler") break;
         }
+        inputs.push_back(args[i]);
+    }
+    for (; i < args.size(); i += 2) {
+        std::string opt = args[i]->isString() ? args[i]->string() : "";
+        std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+        if (i + 1 >= args.size()) throw RuntimeError(name + ": option '" + opt + "' requires a value");
+        if (opt == "uniformoutput") uniform = args[i + 1]->toBool();
+        else if (opt == "errorhandler") {
+            if (!args[i + 1]->isFuncHandle()) throw RuntimeError(name + ": ErrorHandler must be a function handle");
+            errorHandler = args[i + 1];
+        } else throw RuntimeError(name + ": unknown option");
+    }
 
-        for (size_t i = 0; i < p; i++) {
-            for (size_t j = i; j < p; j++) {
-                double s = 0;
-                for (size_t k = 0; k < n; k++) {
-                    s += (m(k, i) - means(0, i)) * (m(k, j) - means(0, j));
-                }
-                double c = s / (n > 1 ? n - 1 : 1);
-                double r = (stds[i] * stds[j] > 0) ? c / (stds[i] * stds[j]) : 0;
-                cov(i, j) = cov(j, i) = r;
+    auto dims = dimsOf(inputs[0]);
+    for (auto& in : inputs) {
+        if (overCells && !in->isCellArray())
+            throw RuntimeError("cellfun: inputs must be cell arrays");
+        if (dimsOf(in) != dims) throw RuntimeError(name + ": all inputs must have the same size");
+    }
+    size_t n = dims.first * dims.second;
+    size_t nout = static_cast<size_t>(std::max(nargout, 1));
+
+    // Elementwise anonymous function: one call over the whole arrays
+    bool allNumeric = std::all_of(inputs.begin(), inputs.end(),
+                                  [](const ValuePtr& v) { return v->isNumeric(); });
+    if (!overCells && uniform && nout == 1 && !errorHandler && allNumeric && n > 1 &&
+        interp.isElementwiseHandle(fh)) {
+        try {
+            ValuePtr r = HandleCaller(interp, fh, 1)(inputs).front();
+            if (r && r->isNumeric()) {
+                const Matrix& rm = r->matrix();
+                if (rm.rows() == dims.first && rm.cols() == dims.second) return {r};
+                if (rm.isScalar()) return {Value::makeMatrix(Matrix(dims.first, dims.second, rm(0)))};
             }
+        } catch (const RuntimeError&) {
+            // Fall through to per-element calls, which report errors per element
         }
-        return Value::makeMatrix(std::move(cov));
-    });
+    }
 
-    // hist (placeholder - returns bin counts)
-    interp.registerBuiltin("hist", [](const ValueList& args) -> ValuePtr {
-        requireMinArgs("hist", args, 1);
-        auto& m = args[0]->matrix();
-        size_t nbins = (args.size() >= 2) ? static_cast<size_t>(args[1]->scalarDouble()) : 10;
-        double mn = m.minVal(), mx = m.maxVal();
-        double binWidth = (mx - mn) / nbins;
+    std::vector<ValueList> results(n);
+    HandleCaller call(interp, fh, static_cast<int>(nout));
+    auto runOne = [&](size_t k, ValueList& fargs) {
+        for (size_t j = 0; j < inputs.size(); j++) fargs[j] = elementOf(inputs[j], k);
+        ValueList out;
+        try {
+            out = call(fargs);
+        } catch (const RuntimeError& e) {
+            if (!errorHandler) throw;
+            MFStruct err;
+            err.fields["message"] = Value::makeString(e.what());
+            err.fields["identifier"] = Value::makeString("MatFree:runtime");
+            err.fields["index"] = Value::makeScalar(static_cast<double>(k + 1));
+            ValueList hargs = {Value::makeStruct(std::move(err))};
+            hargs.insert(hargs.end(), fargs.begin(), fargs.end());
+            out = interp.callFuncHandleMulti(errorHandler->funcHandle(), hargs, static_cast<int>(nout));
+        }
+        if (out.size() < nout || !out[nout - 1])
+            throw RuntimeError(name + ": too many output arguments");
+        results[k] = std::move(out);
+    };
 
-        Matrix counts(1, nbins, 0.0);
-        for (size_t i = 0; i < m.numel(); i++) {
-            size_t bin = static_cast<size_t>((m(i) - mn) / binWidth);
-            if (bin >= nbins) bin = nbins - 1;
-            counts(0, bin) += 1.0;
+    if (interp.isPureHandle(fh) && !errorHandler) {
+        // Pure built-ins touch no interpreter state, so elements can run on any thread
+        parallelFor(n, 256, [&](size_t begin, size_t end) {
+            ValueList fargs(inputs.size());
+            for (size_t k = begin; k < end; k++) runOne(k, fargs);
+        });
+    } else {
+        ValueList fargs(inputs.size());
+        for (size_t k = 0; k < n; k++) runOne(k, fargs);
+    }
+
+    ValueList outputs;
+    for (size_t o = 0; o < nout; o++) {
+        if (uniform) {
+            Matrix m(dims.first, dims.second);
+            for (size_t k = 0; k < n; k++) {
+                const ValuePtr& v = results[k][o];
+                if (!(v->isNumeric() && v->matrix().isScalar()))
+                    throw RuntimeError(name + ": Non-scalar in Uniform output, at index " +
+                                       std::to_string(k + 1) + ", output " + std::to_string(o + 1) +
+                                       ". Set 'UniformOutput' to false.");
+                m(k) = v->matrix()(0);
+            }
+            outputs.push_back(Value::makeMatrix(std::move(m)));
+        } else {
+            CellArray cell(dims.first, dims.second);
+            for (size_t k = 0; k < n; k++) cell.data[k] = results[k][o];
+            outputs.push_back(Value::makeCellArray(std::move(cell)));
         }
-        return Value::makeMatrix(std::move(counts));
-    });
+    }
+    return outputs;
 }
 
 // ============================================================================
 // Register all built-ins
 // ============================================================================
 
-void registerAllBuiltins(Interpreter& interp) {
+static void registerDefaultBuiltins(Interpreter& interp) {
     registerMathBuiltins(interp);
     registerMatrixBuiltins(interp);
     registerLinAlgBuiltins(interp);
@@ -1290,27 +2942,39 @@ void registerAllBuiltins(Interpreter& interp) {
     // A few more utility functions
 
     // whos
-    interp.registerBuiltin("whos", [&interp](const ValueList&) -> ValuePtr {
+    interp.registerBuiltin("whos", [](const ValueList&) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
         interp.currentEnv()->displayVariables(interp.output());
         return Value::makeEmpty();
     });
 
     // who
-    interp.registerBuiltin("who", [&interp](const ValueList&) -> ValuePtr {
+    interp.registerBuiltin("who", [](const ValueList&) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
         auto names = interp.currentEnv()->variableNames();
-        interp.output() << "Your variables are:" << std::endl << std::endl;
+        interp.output() << "Your variables are:\n\n";
         for (auto& n : names) interp.output() << n << "  ";
-        interp.output() << std::endl << std::endl;
+        interp.output() << "\n\n";
         return Value::makeEmpty();
     });
 
-    // clear
-    interp.registerBuiltin("clear", [&interp](const ValueList& args) -> ValuePtr {
+    // clear, clear(names...); 'mex' and 'functions' unbind native plugins
+    // (reloaded on next call if rebuilt), 'all' clears both and closes the
+    // session's datastores
+    interp.registerBuiltin("clear", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
         if (args.empty()) {
             interp.currentEnv()->clear();
         } else {
             for (auto& a : args) {
-                if (a->isString()) interp.currentEnv()->clear(a->string());
+                if (!a->isString()) continue;
+                const std::string& what = a->string();
+                if (what == "mex" || what == "functions" || what == "all") interp.clearPlugins();
+                if (what == "all") {
+                    interp.currentEnv()->clear();
+                    interp.session().datastores.clear();
+                }
+                else if (what != "mex" && what != "functions") interp.currentEnv()->clear(what);
             }
         }
         return Value::makeEmpty();
@@ -1369,7 +3033,8 @@ void registerAllBuiltins(Interpreter& interp) {
     });
 
     // feval (call function by name)
-    interp.registerBuiltin("feval", [&interp](const ValueList& args) -> ValuePtr {
+    interp.registerBuiltin("feval", [](const ValueList& args) -> ValuePtr {
+        Interpreter& interp = Interpreter::current();
         requireMinArgs("feval", args, 1);
         std::string name = args[0]->string();
         ValueList fargs(args.begin() + 1, args.end());
@@ -1378,46 +3043,27 @@ void registerAllBuiltins(Interpreter& interp) {
             Value::makeEmpty();
     });
 
-    // cellfun (simplified)
-    interp.registerBuiltin("cellfun", [&interp](const ValueList& args) -> ValuePtr {
-        requireArgs("cellfun", args, 2);
-        if (!args[0]->isFuncHandle()) throw RuntimeError("cellfun: first arg must be function handle");
-        if (!args[1]->isCellArray()) throw RuntimeError("cellfun: second arg must be cell array");
-
-        auto& fh = args[0]->funcHandle();
-        auto& cell = args[1]->cellArray();
-        Matrix result(cell.rows, cell.cols);
-
-        for (size_t i = 0; i < cell.data.size(); i++) {
-            ValueList fargs = {cell.data[i]};
-            auto res = std::visit([&](auto& impl) -> ValuePtr {
-                if constexpr (std::is_same_v<std::decay_t<decltype(impl)>, BuiltinFunc>) {
-                    return impl(fargs);
-                } else {
-                    return interp.callFuncHandle(fh, fargs);
-                }
-            }, fh.impl);
-            result(i) = res->scalarDouble();
-        }
-        return Value::makeMatrix(std::move(result));
+    // [A, B, ...] = cellfun(f, C1, C2, ..., 'UniformOutput', tf, 'ErrorHandler', h)
+    interp.registerMultiBuiltin("cellfun", [](const ValueList& args, int nargout) -> ValueList {
+        Interpreter& interp = Interpreter::current();
+        return applyFunction(interp, "cellfun", args, nargout, true);
     });
 
-    // arrayfun (simplified)
-    interp.registerBuiltin("arrayfun", [&interp](const ValueList& args) -> ValuePtr {
-        requireMinArgs("arrayfun", args, 2);
-        if (!args[0]->isFuncHandle()) throw RuntimeError("arrayfun: first arg must be function handle");
-
-        auto& fh = args[0]->funcHandle();
-        auto& m = args[1]->matrix();
-        Matrix result(m.rows(), m.cols());
-
-        for (size_t i = 0; i < m.numel(); i++) {
-            ValueList fargs = {Value::makeScalar(m(i))};
-            auto res = interp.callFuncHandle(fh, fargs);
-            result(i) = res->scalarDouble();
-        }
-        return Value::makeMatrix(std::move(result));
+    // [A, B, ...] = arrayfun(f, X1, X2, ..., 'UniformOutput', tf, 'ErrorHandler', h)
+    interp.registerMultiBuiltin("arrayfun", [](const ValueList& args, int nargout) -> ValueList {
+        Interpreter& interp = Interpreter::current();
+        return applyFunction(interp, "arrayfun", args, nargout, false);
     });
 }
 
+void registerAllBuiltins(Interpreter& interp) {
+    // Built once per process; every interpreter shares the same table.
+    static const std::shared_ptr<const BuiltinTable> table = [] {
+        Interpreter builder;
+        registerDefaultBuiltins(builder);
+        return builder.builtinTable();
+    }();
+    interp.useBuiltins(table);
+}
+
 } // namespace matfree
@@ -0,0 +1,232 @@
+// MatFree - Chunked datastores and streaming (tall) reductions
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "datastore.h"
+#include "histogram.h"
+#include "statistics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace matfree {
+
+namespace {
+
+// End of the line starting at p (past its '\n'), and whether it is blank.
+const char* lineEnd(const char* p, const char* end, bool& blank) {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    const char* e = nl ? nl : end;
+    blank = true;
+    for (const char* c = p; c < e && blank; c++) blank = *c == ' ' || *c == '\t' || *c == '\r';
+    return nl ? nl + 1 : end;
+}
+
+} // namespace
+
+Datastore::Datastore(std::vector<std::string> files, DatastoreOptions options)
+    : files_(std::move(files)), options_(std::move(options)), layouts_(files_.size()) {
+    if (files_.empty()) throw RuntimeError("datastore: no files to read");
+    if (options_.readSize == 0) throw RuntimeError("datastore: ReadSize must be positive");
+    cursor_ = skipExhausted(Cursor());
+}
+
+Datastore::~Datastore() {
+    if (prefetch_.valid()) prefetch_.wait();
+}
+
+Matrix Datastore::read() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cursor_.file >= files_.size()) throw RuntimeError("read: no more data in the datastore");
+    Block block = prefetch_.valid() ? prefetch_.get() : readBlock(cursor_);
+    cursor_ = block.next;
+    if (cursor_.file < files_.size()) prefetch_ = std::async(std::launch::async, [this, at = cursor_] { return readBlock(at); });
+    return std::move(block.data);
+}
+
+void Datastore::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (prefetch_.valid()) {
+        try {
+            prefetch_.get();
+        } catch (...) {
+            // The block is discarded anyway; reading it again will report it
+        }
+    }
+    cursor_ = skipExhausted(Cursor());
+}
+
+std::vector<std::string> Datastore::columnNames() {
+    if (options_.kind != DatastoreKind::TEXT) return {};
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (prefetch_.valid()) prefetch_.wait();
+    return layout(0).names;
+}
+
+const MappedFile& Datastore::mapFile(size_t index) {
+    if (mappedIndex_ != index) {
+        mapped_ = MappedFile::open(files_[index]);
+        mapped_->advise(MapAccess::SEQUENTIAL);
+        mappedIndex_ = index;
+    }
+    return *mapped_;
+}
+
+const DelimitedLayout& Datastore::layout(size_t index) {
+    if (!layouts_[index]) {
+        const MappedFile& f = mapFile(index);
+        layouts_[index] = std::make_unique<DelimitedLayout>(
+            delimitedLayout(f.data(), f.data() + f.size(), options_.text));
+    }
+    return *layouts_[index];
+}
+
+Datastore::Cursor Datastore::skipExhausted(Cursor at) {
+    for (; at.file < files_.size(); at.file++, at.offset = 0) {
+        const MappedFile& f = mapFile(at.file);
+        if (options_.kind == DatastoreKind::BINARY) {
+            if (f.size() - std::min(at.offset, f.size()) >= numericClassSize(options_.format)) return at;
+            continue;
+        }
+        if (at.offset == 0) at.offset = layout(at.file).dataOffset;
+        const char* end = f.data() + f.size();
+        for (const char* p = f.data() + at.offset; p < end;) {
+            bool blank;
+            const char* next = lineEnd(p, end, blank);
+            if (!blank) return at;
+            p = next;
+            at.offset = static_cast<size_t>(p - f.data());
+        }
+    }
+    return at;
+}
+
+Datastore::Block Datastore::readBlock(Cursor at) {
+    const MappedFile& f = mapFile(at.file);
+    const char* begin = f.data() + at.offset;
+    Block block;
+    if (options_.kind == DatastoreKind::BINARY) {
+        size_t elem = numericClassSize(options_.format);
+        size_t n = std::min(options_.readSize, (f.size() - at.offset) / elem);
+        block.data = Matrix(n, 1);
+        convertToDouble(begin, options_.format, n, block.data.begin());
+        block.next = skipExhausted({at.file, at.offset + n * elem});
+        return block;
+    }
+    const char* end = f.data() + f.size();
+    const char* p = begin;
+    for (size_t rows = 0; p < end && rows < options_.readSize;) {
+        bool blank;
+        p = lineEnd(p, end, blank);
+        rows += !blank;
+    }
+    block.data = parseDelimited(begin, p, layout(at.file), options_.text, false).numbers;
+    block.next = skipExhausted({at.file, static_cast<size_t>(p - f.data())});
+    return block;
+}
+
+std::vector<Matrix> evaluateTall(const Datastore& source, const std::vector<TallReduction>& reductions) {
+    // Histograms without edges need the range (and spread) of the data first
+    bool needMoments = std::any_of(reductions.begin(), reductions.end(), [](const TallReduction& r) {
+        return r.op == TallReduction::HISTCOUNTS && r.edges.empty();
+    });
+    MomentAccumulator finite;
+    if (needMoments) {
+        Datastore ds(source.files(), source.options());
+        while (ds.hasData()) {
+            Matrix block = ds.read();
+            for (double x : block)
+                if (std::isfinite(x)) finite.add(x);
+        }
+    }
+
+    struct State {
+        std::vector<double> acc;        // per column (SUM/MEAN/MIN/MAX)
+        double rows = 0;
+        BinEdges bins;
+        std::vector<uint64_t> counts;
+        std::vector<Matrix> blocks;     // GATHER
+    };
+    std::vector<State> states(reductions.size());
+    for (size_t k = 0; k < reductions.size(); k++) {
+        const TallReduction& r = reductions[k];
+        if (r.op != TallReduction::HISTCOUNTS) continue;
+        states[k].bins = r.edges.empty() ? BinEdges::automatic(finite, r.nbins) : BinEdges::fromEdges(r.edges);
+        states[k].counts.assign(states[k].bins.bins(), 0);
+    }
+
+    Datastore ds(source.files(), source.options());
+    size_t cols = SIZE_MAX;
+    while (ds.hasData()) {
+        Matrix block = ds.read();
+        if (block.numel() == 0) continue;
+        if (cols == SIZE_MAX) cols = block.cols();
+        if (block.cols() != cols) throw RuntimeError("gather: blocks of the datastore have different numbers of columns");
+        for (size_t k = 0; k < reductions.size(); k++) {
+            State& st = states[k];
+            switch (reductions[k].op) {
+                case TallReduction::GATHER:
+                    st.blocks.push_back(block);
+                    break;
+                case TallReduction::SUM:
+                case TallReduction::MEAN:
+                    st.acc.resize(cols, 0.0);
+                    for (size_t i = 0; i < block.rows(); i++)
+                        for (size_t j = 0; j < cols; j++) st.acc[j] += block(i, j);
+                    break;
+                case TallReduction::MIN:
+                case TallReduction::MAX: {
+                    bool isMin = reductions[k].op == TallReduction::MIN;
+                    st.acc.resize(cols, std::numeric_limits<double>::quiet_NaN());
+                    for (size_t i = 0; i < block.rows(); i++) {
+                        for (size_t j = 0; j < cols; j++) {
+                            double x = block(i, j);
+                            double& a = st.acc[j];
+                            if (std::isnan(a) || (isMin ? x < a : x > a)) a = std::isnan(x) ? a : x;
+                        }
+                    }
+                    break;
+                }
+                case TallReduction::HISTCOUNTS: {
+                    auto counts = histCounts(block.begin(), block.numel(), st.bins);
+                    for (size_t b = 0; b < counts.size(); b++) st.counts[b] += counts[b];
+                    break;
+                }
+            }
+            st.rows += static_cast<double>(block.rows());
+        }
+    }
+
+    std::vector<Matrix> results;
+    for (size_t k = 0; k < reductions.size(); k++) {
+        State& st = states[k];
+        switch (reductions[k].op) {
+            case TallReduction::GATHER: {
+                size_t rows = 0;
+                for (auto& b : st.blocks) rows += b.rows();
+                Matrix all(rows, cols == SIZE_MAX ? 0 : cols);
+                double* out = all.begin();
+                for (auto& b : st.blocks) out = std::copy(b.begin(), b.end(), out);
+                results.push_back(std::move(all));
+                break;
+            }
+            case TallReduction::MEAN:
+                for (double& a : st.acc) a /= st.rows;
+                [[fallthrough]];
+            case TallReduction::SUM:
+            case TallReduction::MIN:
+            case TallReduction::MAX:
+                results.push_back(Matrix(1, st.acc.size(), st.acc));
+                break;
+            case TallReduction::HISTCOUNTS: {
+                Matrix n(1, st.counts.size());
+                for (size_t b = 0; b < st.counts.size(); b++) n(b) = static_cast<double>(st.counts[b]);
+                results.push_back(std::move(n));
+                break;
+            }
+        }
+    }
+    return results;
+}
+
+} // namespace matfree
@@ -0,0 +1,101 @@
+#pragma once
+// MatFree - Chunked datastores and streaming (tall) reductions
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "value.h"
+#include "mapped_file.h"
+#include "numeric_types.h"
+#include "delimited_text.h"
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace matfree {
+
+enum class DatastoreKind { TEXT, BINARY };
+
+struct DatastoreOptions {
+    DatastoreKind kind = DatastoreKind::TEXT;
+    size_t readSize = 20000;                 // rows (text) or elements (binary) per read
+    NumericClass format = NumericClass::DOUBLE; // element class of binary files
+    DelimitedOptions text;                   // parsing of text files
+};
+
+/// A sequence of files read one block at a time. Text files yield blocks
+/// of up to readSize rows (as readmatrix would parse them), binary files
+/// column vectors of up to readSize elements; a block never spans two
+/// files. While the caller works on one block, the next is read and
+/// parsed on a background thread. Calls may come from several threads
+/// (parfor iterations sharing one datastore); they take turns, and share
+/// the read position.
+class Datastore {
+public:
+    /// Throws RuntimeError when there are no files.
+    Datastore(std::vector<std::string> files, DatastoreOptions options);
+    ~Datastore();
+    Datastore(const Datastore&) = delete;
+    Datastore& operator=(const Datastore&) = delete;
+
+    bool hasData() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cursor_.file < files_.size();
+    }
+
+    /// The next block. Throws RuntimeError when there is no data left.
+    Matrix read();
+
+    /// Start again from the first file.
+    void reset();
+
+    const std::vector<std::string>& files() const { return files_; }
+    const DatastoreOptions& options() const { return options_; }
+
+    /// Header names of the columns of the first text file ("" when unnamed).
+    std::vector<std::string> columnNames();
+
+private:
+    // The next unread byte of a file; file == files_.size() at the end
+    struct Cursor {
+        size_t file = 0;
+        size_t offset = 0;
+    };
+    struct Block {
+        Matrix data;
+        Cursor next;
+    };
+
+    Block readBlock(Cursor at);
+    Cursor skipExhausted(Cursor at);
+    const MappedFile& mapFile(size_t index);
+    const DelimitedLayout& layout(size_t index);
+
+    std::vector<std::string> files_;
+    DatastoreOptions options_;
+    mutable std::mutex mutex_; // held by read, reset, hasData and columnNames
+    Cursor cursor_;
+    std::future<Block> prefetch_; // the block at cursor_, when valid
+
+    // Used by one thread at a time: the caller, or the prefetch it waits for
+    std::shared_ptr<MappedFile> mapped_;
+    size_t mappedIndex_ = SIZE_MAX;
+    std::vector<std::unique_ptr<DelimitedLayout>> layouts_;
+};
+
+/// A reduction evaluated over every block of a datastore.
+struct TallReduction {
+    enum Op { GATHER, SUM, MEAN, MIN, MAX, HISTCOUNTS } op;
+    std::vector<double> edges; // HISTCOUNTS: bin edges, or empty to use nbins
+    size_t nbins = 0;          // HISTCOUNTS without edges (0: Scott's rule)
+};
+
+/// Evaluate all `reductions` in a single pass over a fresh reading of the
+/// datastore's files. SUM/MEAN/MIN/MAX reduce each column (NaN propagates
+/// through SUM and MEAN and is skipped by MIN and MAX) and give a row,
+/// HISTCOUNTS counts all elements, GATHER concatenates the blocks. A
+/// histogram without edges needs the data range first, which costs one
+/// more pass.
+std::vector<Matrix> evaluateTall(const Datastore& source, const std::vector<TallReduction>& reductions);
+
+} // namespace matfree
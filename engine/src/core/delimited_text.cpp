@@ -0,0 +1,300 @@
+// MatFree - Delimited text (CSV, TSV, ...) reader
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "delimited_text.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace matfree {
+
+namespace {
+
+// Bytes per parsing chunk; chunks end on line boundaries.
+constexpr size_t kChunkBytes = size_t(1) << 20;
+
+bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// A line [begin, end) without its line break.
+struct Line {
+    const char* begin;
+    const char* end;
+};
+
+// Next line starting at p (p < end); advances p past its line break.
+Line nextLine(const char*& p, const char* end) {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    Line line{p, nl ? nl : end};
+    p = nl ? nl + 1 : end;
+    if (line.end > line.begin && line.end[-1] == '\r') line.end--;
+    return line;
+}
+
+bool isBlankLine(const Line& line) {
+    for (const char* c = line.begin; c < line.end; c++)
+        if (!isBlank(*c)) return false;
+    return true;
+}
+
+// Call fn(column, field, quoted) for each field of a line. Fields are
+// trimmed; quoted fields are passed without their quotes (with "" still
+// doubled). A ' ' delimiter splits on runs of blanks.
+template <class Fn>
+void forEachField(const Line& line, char delim, Fn&& fn) {
+    const char* p = line.begin;
+    const char* end = line.end;
+    size_t col = 0;
+    if (delim == ' ') {
+        while (p < end && isBlank(*p)) p++;
+        if (p == end) return;
+    }
+    while (true) {
+        while (p < end && isBlank(*p) && *p != delim) p++;
+        const char* fb = p;
+        const char* fe;
+        bool quoted = p < end && *p == '"';
+        if (quoted) {
+            fb = ++p;
+            while (p < end && !(*p == '"' && (p + 1 == end || p[1] != '"'))) p += *p == '"' ? 2 : 1;
+            fe = std::min(p, end);
+            while (p < end && *p != delim) p++;
+        } else {
+            while (p < end && *p != delim) p++;
+            fe = p;
+            while (fe > fb && isBlank(fe[-1])) fe--;
+        }
+        fn(col++, std::string_view(fb, static_cast<size_t>(fe - fb)), quoted);
+        if (p >= end) return;
+        p++; // the delimiter
+        if (delim == ' ') {
+            while (p < end && isBlank(*p)) p++;
+            if (p == end) return;
+        }
+    }
+}
+
+std::string fieldText(std::string_view field, bool quoted) {
+    std::string s(field);
+    if (quoted) {
+        size_t out = 0;
+        for (size_t i = 0; i < s.size(); i++) {
+            s[out++] = s[i];
+            if (s[i] == '"' && i + 1 < s.size() && s[i + 1] == '"') i++;
+        }
+        s.resize(out);
+    }
+    return s;
+}
+
+char detectDelimiter(const Line& line) {
+    const char candidates[] = {',', '\t', ';', '|'};
+    size_t counts[4] = {0, 0, 0, 0};
+    bool inQuotes = false;
+    for (const char* c = line.begin; c < line.end; c++) {
+        if (*c == '"') inQuotes = !inQuotes;
+        if (inQuotes) continue;
+        for (int k = 0; k < 4; k++)
+            if (*c == candidates[k]) counts[k]++;
+    }
+    int best = static_cast<int>(std::max_element(counts, counts + 4) - counts);
+    return counts[best] > 0 ? candidates[best] : ' ';
+}
+
+size_t numericFieldCount(const Line& line, char delim) {
+    size_t n = 0;
+    double v;
+    forEachField(line, delim, [&](size_t, std::string_view f, bool) { n += parseDelimitedNumber(f, v); });
+    return n;
+}
+
+size_t fieldCount(const Line& line, char delim) {
+    size_t n = 0;
+    forEachField(line, delim, [&](size_t, std::string_view, bool) { n++; });
+    return n;
+}
+
+} // namespace
+
+bool parseDelimitedNumber(std::string_view field, double& out) {
+    const char* b = field.data();
+    const char* e = b + field.size();
+    if (b != e && *b == '+') {
+        b++;
+        if (b != e && *b == '-') return false;
+    }
+    if (b == e) return false;
+    auto r = std::from_chars(b, e, out);
+    if (r.ptr != e) return false;
+    if (r.ec == std::errc::result_out_of_range) {
+        // from_chars leaves `out` alone; match strtod (+-HUGE_VAL or 0)
+        out = std::strtod(std::string(field).c_str(), nullptr);
+        return true;
+    }
+    return r.ec == std::errc();
+}
+
+DelimitedLayout delimitedLayout(const char* begin, const char* end, const DelimitedOptions& opts) {
+    // Header and layout from the first lines
+    const char* p = begin;
+    std::vector<Line> firstLines; // header candidates; blank lines count only when headerLines is given
+    size_t wanted = opts.headerLines >= 0 ? static_cast<size_t>(opts.headerLines) + 1 : 2;
+    while (p < end && firstLines.size() < wanted) {
+        Line line = nextLine(p, end);
+        if (opts.headerLines >= 0 || !isBlankLine(line)) firstLines.push_back(line);
+    }
+    char delim = opts.delimiter;
+    if (delim == '\0') {
+        auto first = std::find_if(firstLines.begin(), firstLines.end(), [](const Line& l) { return !isBlankLine(l); });
+        delim = first != firstLines.end() ? detectDelimiter(*first) : ',';
+    }
+    size_t headerLines;
+    if (opts.headerLines >= 0) {
+        headerLines = std::min(static_cast<size_t>(opts.headerLines), firstLines.size());
+    } else {
+        headerLines = firstLines.size() == 2 && numericFieldCount(firstLines[0], delim) == 0 &&
+                      numericFieldCount(firstLines[1], delim) > 0 ? 1 : 0;
+    }
+
+    // Data starts after the header's physical lines
+    const char* data = begin;
+    for (size_t h = 0; h < headerLines;) {
+        if (data >= end) break;
+        Line line = nextLine(data, end);
+        if (opts.headerLines >= 0 || !isBlankLine(line)) h++;
+    }
+    size_t fileCols = 0;
+    if (headerLines > 0) fileCols = fieldCount(firstLines[headerLines - 1], delim);
+    for (const char* q = data; q < end;) {
+        Line line = nextLine(q, end);
+        if (isBlankLine(line)) continue;
+        fileCols = std::max(fileCols, fieldCount(line, delim));
+        break;
+    }
+
+    // Selected columns
+    std::vector<size_t> selected = opts.columns;
+    if (selected.empty())
+        for (size_t c = opts.firstColumn; c < fileCols; c++) selected.push_back(c);
+
+    DelimitedLayout layout;
+    layout.delimiter = delim;
+    layout.dataOffset = static_cast<size_t>(data - begin);
+    layout.names.assign(selected.size(), std::string());
+    if (headerLines > 0) {
+        forEachField(firstLines[headerLines - 1], delim, [&](size_t c, std::string_view f, bool quoted) {
+            auto it = std::find(selected.begin(), selected.end(), c);
+            if (it != selected.end()) layout.names[it - selected.begin()] = fieldText(f, quoted);
+        });
+    }
+    layout.columns = std::move(selected);
+    return layout;
+}
+
+DelimitedData parseDelimited(const char* data, const char* end, const DelimitedLayout& layout,
+                             const DelimitedOptions& opts, bool wantText) {
+    char delim = layout.delimiter;
+    size_t nCols = layout.columns.size();
+    size_t mapSize = 0;
+    for (size_t c : layout.columns) mapSize = std::max(mapSize, c + 1);
+    std::vector<long> outCol(mapSize, -1);
+    for (size_t k = 0; k < nCols; k++) outCol[layout.columns[k]] = static_cast<long>(k);
+
+    DelimitedData result;
+    result.names = layout.names;
+
+    // Chunks of the region, each owning the lines that start in it
+    size_t dataSize = static_cast<size_t>(end - data);
+    size_t nChunks = std::max<size_t>(1, parallelChunkCount(dataSize, kChunkBytes));
+    std::vector<const char*> chunkStart(nChunks + 1);
+    chunkStart[0] = data;
+    chunkStart[nChunks] = end;
+    for (size_t k = 1; k < nChunks; k++) {
+        const char* b = data + dataSize / nChunks * k;
+        const char* nl = static_cast<const char*>(std::memchr(b - 1, '\n', static_cast<size_t>(end - b + 1)));
+        chunkStart[k] = nl ? nl + 1 : end;
+    }
+    for (size_t k = 1; k < nChunks; k++) chunkStart[k] = std::max(chunkStart[k], chunkStart[k - 1]);
+
+    auto forEachLine = [&](size_t k, auto&& fn) {
+        for (const char* q = chunkStart[k]; q < chunkStart[k + 1];) {
+            Line line = nextLine(q, end);
+            if (!isBlankLine(line)) fn(line);
+        }
+    };
+
+    // Pass 1: rows per chunk
+    std::vector<size_t> rowStart(nChunks + 1, 0);
+    parallelFor(nChunks, 1, [&](size_t b, size_t e) {
+        for (size_t k = b; k < e; k++) {
+            size_t n = 0;
+            forEachLine(k, [&](const Line&) { n++; });
+            rowStart[k + 1] = n;
+        }
+    });
+    for (size_t k = 0; k < nChunks; k++) rowStart[k + 1] += rowStart[k];
+    size_t nRows = rowStart[nChunks];
+
+    // Pass 2: numbers, noting which columns hold text
+    result.numbers = Matrix(nRows, nCols);
+    double* out = result.numbers.begin();
+    std::vector<char> chunkText(nChunks * nCols, 0);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    auto isMissing = [&](std::string_view f) {
+        return std::find(opts.missing.begin(), opts.missing.end(), f) != opts.missing.end();
+    };
+    parallelFor(nChunks, 1, [&](size_t b, size_t e) {
+        for (size_t k = b; k < e; k++) {
+            double* row = out + rowStart[k] * nCols;
+            char* text = chunkText.data() + k * nCols;
+            forEachLine(k, [&](const Line& line) {
+                std::fill(row, row + nCols, opts.emptyValue);
+                forEachField(line, delim, [&](size_t c, std::string_view f, bool) {
+                    if (c >= mapSize || outCol[c] < 0 || f.empty()) return;
+                    double& v = row[outCol[c]];
+                    if (parseDelimitedNumber(f, v)) return;
+                    if (isMissing(f)) return;
+                    v = nan;
+                    text[outCol[c]] = 1;
+                });
+                row += nCols;
+            });
+        }
+    });
+    result.isText.assign(nCols, false);
+    for (size_t k = 0; k < nChunks; k++)
+        for (size_t c = 0; c < nCols; c++)
+            if (chunkText[k * nCols + c]) result.isText[c] = true;
+
+    // Pass 3: strings of the text columns
+    result.text.resize(nCols);
+    bool anyText = std::find(result.isText.begin(), result.isText.end(), true) != result.isText.end();
+    if (!wantText || !anyText) return result;
+    for (size_t c = 0; c < nCols; c++)
+        if (result.isText[c]) result.text[c].resize(nRows);
+    parallelFor(nChunks, 1, [&](size_t b, size_t e) {
+        for (size_t k = b; k < e; k++) {
+            size_t r = rowStart[k];
+            forEachLine(k, [&](const Line& line) {
+                forEachField(line, delim, [&](size_t c, std::string_view f, bool quoted) {
+                    if (c < mapSize && outCol[c] >= 0 && result.isText[outCol[c]])
+                        result.text[outCol[c]][r] = fieldText(f, quoted);
+                });
+                r++;
+            });
+        }
+    });
+    return result;
+}
+
+DelimitedData readDelimited(const std::string& path, const DelimitedOptions& opts, bool wantText) {
+    auto file = MappedFile::open(path);
+    file->advise(MapAccess::SEQUENTIAL);
+    const char* begin = file->data();
+    const char* end = begin + file->size();
+    DelimitedLayout layout = delimitedLayout(begin, end, opts);
+    return parseDelimited(begin + layout.dataOffset, end, layout, opts, wantText);
+}
+
+} // namespace matfree
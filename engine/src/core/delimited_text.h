@@ -0,0 +1,64 @@
+#pragma once
+// MatFree - Delimited text (CSV, TSV, ...) reader
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "value.h"
+#include <cmath>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace matfree {
+
+struct DelimitedOptions {
+    char delimiter = '\0';                       // '\0': detect; ' ': runs of blanks
+    long headerLines = -1;                       // -1: detect (0 or 1)
+    std::vector<size_t> columns;                 // 0-based file columns; empty: all
+    size_t firstColumn = 0;                      // with no `columns`, skip this many
+    double emptyValue = std::numeric_limits<double>::quiet_NaN();
+    std::vector<std::string> missing;            // text read as missing, e.g. "NA"
+};
+
+/// The selected columns of a file. A column is text when any of its fields
+/// is neither empty, a number nor a `missing` token.
+struct DelimitedData {
+    std::vector<std::string> names;              // from the last header line; "" without one
+    Matrix numbers;                              // rows x columns; text fields are NaN,
+                                                 // empty and missing ones emptyValue
+    std::vector<bool> isText;
+    std::vector<std::vector<std::string>> text;  // rows strings per text column (if wanted)
+};
+
+/// Where the data of a delimited text file starts and which columns of it
+/// are read.
+struct DelimitedLayout {
+    char delimiter = ',';
+    size_t dataOffset = 0;           // bytes of header before the first data line
+    std::vector<size_t> columns;     // selected file columns, 0-based
+    std::vector<std::string> names;  // their header names ("" without a header)
+};
+
+/// Detect the delimiter, header and columns of the text [begin, end) from
+/// its first lines, as readDelimited does.
+DelimitedLayout delimitedLayout(const char* begin, const char* end, const DelimitedOptions& opts);
+
+/// Parse the whole lines [begin, end) of a file with the given layout,
+/// e.g. one block of a file being read in pieces.
+DelimitedData parseDelimited(const char* begin, const char* end, const DelimitedLayout& layout,
+                             const DelimitedOptions& opts, bool wantText);
+
+/// Read a delimited text file. The file is mapped and split into chunks on
+/// line boundaries; rows are counted and then parsed (std::from_chars)
+/// chunk by chunk in parallel, straight into the result matrix. Text is
+/// only extracted, in a second parallel pass, when `wantText` is set and
+/// some column has any. Blank lines are skipped. Quoted fields ("a, b",
+/// with "" for a quote) may contain delimiters but not line breaks.
+/// Throws RuntimeError if the file cannot be read.
+DelimitedData readDelimited(const std::string& path, const DelimitedOptions& opts, bool wantText);
+
+/// Parse a whole field as a number (optional sign, decimal or exponent
+/// notation, Inf, NaN).
+bool parseDelimitedNumber(std::string_view field, double& out);
+
+} // namespace matfree
@@ -9,9 +9,18 @@
 #include <memory>
 #include <vector>
 #include <iostream>
+#include <functional>
 
 namespace matfree {
 
+/// A variable whose value is produced on first access. load binds variables
+/// this way, so only the variables a script actually uses are read.
+struct LazyVariable {
+    std::function<ValuePtr()> load;
+    std::string size;      // e.g. "1000x3", shown by whos before loading
+    std::string className; // e.g. "double"
+};
+
 /// Represents a variable scope (workspace).
 class Environment : public std::enable_shared_from_this<Environment> {
 public:
@@ -32,6 +41,13 @@ public:
         auto it = variables_.find(name);
         if (it != variables_.end()) return it->second;
 
+        auto lazy = lazy_.find(name);
+        if (lazy != lazy_.end()) {
+            ValuePtr value = lazy->second.load();
+            lazy_.erase(lazy);
+            return variables_[name] = value;
+        }
+
         // Check global declarations
         if (globals_.count(name) && parent_) {
             return getGlobalEnv()->get(name);
@@ -48,12 +64,23 @@ public:
             getGlobalEnv()->set(name, std::move(value));
             return;
         }
+        lazy_.erase(name);
         variables_[name] = std::move(value);
     }
 
+    /// Bind a variable that is loaded on first access.
+    void setLazy(const std::string& name, LazyVariable lazy) {
+        if (globals_.count(name) && parent_) {
+            getGlobalEnv()->setLazy(name, std::move(lazy));
+            return;
+        }
+        variables_.erase(name);
+        lazy_[name] = std::move(lazy);
+    }
+
     /// Check if a variable exists in this scope.
     bool has(const std::string& name) const {
-        if (variables_.count(name)) return true;
+        if (variables_.count(name) || lazy_.count(name)) return true;
         if (globals_.count(name) && parent_) {
             return getGlobalEnv()->has(name);
         }
@@ -72,6 +99,7 @@ public:
     std::vector<std::string> variableNames() const {
         std::vector<std::string> names;
         for (auto& [k, v] : variables_) names.push_back(k);
+        for (auto& [k, v] : lazy_) names.push_back(k);
         return names;
     }
 
@@ -101,13 +129,23 @@ public:
             }
             os << std::endl;
         }
+        for (auto& [name, lazy] : lazy_) {
+            os << "  " << std::left << std::setw(16) << name << std::setw(16) << lazy.size
+               << lazy.className << std::endl;
+        }
     }
 
     /// Clear all variables.
-    void clear() { variables_.clear(); }
+    void clear() {
+        variables_.clear();
+        lazy_.clear();
+    }
 
     /// Clear a specific variable.
-    void clear(const std::string& name) { variables_.erase(name); }
+    void clear(const std::string& name) {
+        variables_.erase(name);
+        lazy_.erase(name);
+    }
 
 private:
     explicit Environment(Ptr parent) : parent_(std::move(parent)) {}
@@ -120,7 +158,9 @@ private:
     }
 
     Ptr parent_;
-    std::unordered_map<std::string, ValuePtr> variables_;
+    // Mutable so that get() can materialize a lazy variable in place
+    mutable std::unordered_map<std::string, ValuePtr> variables_;
+    mutable std::unordered_map<std::string, LazyVariable> lazy_;
     std::unordered_set<std::string> globals_;
 };
 
@@ -0,0 +1,508 @@
+// MatFree - Calls into C functions of shared libraries (loadlibrary, calllib)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+//
+// Calls go through thunks: one small function per combination of argument
+// classes (integer or pointer, double, float) and result class, generated
+// at compile time from templates and picked for each signature when the
+// library is loaded. Integer arguments narrower than 64 bits are passed as
+// 64-bit integers, which every supported 64-bit calling convention (x86-64
+// System V, Windows x64, AArch64) places in the same register the callee
+// reads its narrower value from.
+
+#include "ffi.h"
+#include "numeric_types.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+
+namespace matfree {
+
+namespace {
+
+constexpr size_t kMaxArgs = 6;
+
+// ----------------------------------------------------------------------------
+// Prototype parsing
+// ----------------------------------------------------------------------------
+
+// Header text without comments, preprocessor lines and string literals
+std::string stripHeader(const std::string& text) {
+    std::string out;
+    bool lineStart = true;
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c == '/' && i + 1 < text.size() && text[i + 1] == '/') {
+            while (i < text.size() && text[i] != '\n') i++;
+        } else if (c == '/' && i + 1 < text.size() && text[i + 1] == '*') {
+            size_t end = text.find("*/", i + 2);
+            i = end == std::string::npos ? text.size() : end + 1;
+            out += ' ';
+            continue;
+        } else if (c == '#' && lineStart) {
+            // Up to the end of the line, following continuations
+            while (i < text.size() && !(text[i] == '\n' && text[i - 1] != '\\')) i++;
+        } else if (c == '"') {
+            size_t end = text.find('"', i + 1);
+            i = end == std::string::npos ? text.size() : end;
+            out += ' ';
+            continue;
+        }
+        if (i >= text.size()) break;
+        c = text[i];
+        out += c;
+        if (c == '\n') lineStart = true;
+        else if (!std::isspace(static_cast<unsigned char>(c))) lineStart = false;
+    }
+    return out;
+}
+
+std::vector<std::string> tokenize(const std::string& s) {
+    std::vector<std::string> tokens;
+    for (size_t i = 0; i < s.size();) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (std::isspace(c)) {
+            i++;
+        } else if (std::isalnum(c) || c == '_') {
+            size_t j = i;
+            while (j < s.size() && (std::isalnum(static_cast<unsigned char>(s[j])) || s[j] == '_')) j++;
+            tokens.push_back(s.substr(i, j - i));
+            i = j;
+        } else {
+            tokens.push_back(std::string(1, s[i]));
+            i++;
+        }
+    }
+    return tokens;
+}
+
+// Type of a declaration's tokens (name already removed); false with a
+// reason if unsupported
+bool parseType(const std::vector<std::string>& tokens, CParam& out, std::string& why) {
+    static const std::unordered_map<std::string, CType> named = {
+        {"int8_t", CType::INT8},     {"uint8_t", CType::UINT8},   {"int16_t", CType::INT16},
+        {"uint16_t", CType::UINT16}, {"int32_t", CType::INT32},   {"uint32_t", CType::UINT32},
+        {"int64_t", CType::INT64},   {"uint64_t", CType::UINT64}, {"bool", CType::UINT8},
+        {"_Bool", CType::UINT8},     {"float", CType::FLOAT},     {"double", CType::DOUBLE},
+        {"void", CType::VOID},
+        {"size_t", sizeof(size_t) == 8 ? CType::UINT64 : CType::UINT32},
+        {"ptrdiff_t", sizeof(ptrdiff_t) == 8 ? CType::INT64 : CType::INT32},
+        {"intptr_t", sizeof(intptr_t) == 8 ? CType::INT64 : CType::INT32},
+        {"uintptr_t", sizeof(uintptr_t) == 8 ? CType::UINT64 : CType::UINT32},
+        {"ssize_t", sizeof(ptrdiff_t) == 8 ? CType::INT64 : CType::INT32},
+    };
+    out = CParam();
+    int pointers = 0, longs = 0;
+    bool isUnsigned = false, isSigned = false, isShort = false, isChar = false, isInt = false, constBase = false;
+    bool haveNamed = false;
+    for (auto& t : tokens) {
+        if (t == "*") {
+            pointers++;
+        } else if (t == "const") {
+            if (pointers == 0) constBase = true;
+        } else if (t == "volatile" || t == "restrict" || t == "__restrict" || t == "extern" || t == "static" ||
+                   t == "inline") {
+            continue;
+        } else if (t == "unsigned") {
+            isUnsigned = true;
+        } else if (t == "signed") {
+            isSigned = true;
+        } else if (t == "long") {
+            longs++;
+        } else if (t == "short") {
+            isShort = true;
+        } else if (t == "char") {
+            isChar = true;
+        } else if (t == "int") {
+            isInt = true;
+        } else if (named.count(t)) {
+            out.type = named.at(t);
+            haveNamed = true;
+        } else {
+            why = "unsupported type '" + t + "'";
+            return false;
+        }
+    }
+    if (pointers > 1) {
+        why = "pointers to pointers are not supported";
+        return false;
+    }
+    if (!haveNamed) {
+        if (isChar) {
+            out.type = isUnsigned ? CType::UINT8 : isSigned ? CType::INT8 : CType::CHAR;
+        } else if (isShort) {
+            out.type = isUnsigned ? CType::UINT16 : CType::INT16;
+        } else if (longs >= 2 || (longs == 1 && sizeof(long) == 8)) {
+            out.type = isUnsigned ? CType::UINT64 : CType::INT64;
+        } else if (longs == 1 || isInt || isUnsigned || isSigned) {
+            out.type = isUnsigned ? CType::UINT32 : CType::INT32;
+        } else {
+            why = "missing type";
+            return false;
+        }
+    }
+    out.pointer = pointers == 1;
+    out.isConst = out.pointer && constBase;
+    return true;
+}
+
+// Split "a, b, c" at top-level commas
+std::vector<std::vector<std::string>> splitParams(const std::vector<std::string>& tokens) {
+    std::vector<std::vector<std::string>> params(1);
+    for (auto& t : tokens) {
+        if (t == ",") params.emplace_back();
+        else params.back().push_back(t);
+    }
+    return params;
+}
+
+bool isTypeWord(const std::string& t) {
+    static const char* words[] = {"const",    "volatile",  "unsigned",  "signed",   "long",     "short",
+                                  "char",     "int",       "float",     "double",   "void",     "restrict",
+                                  "__restrict", "bool",    "_Bool",     "int8_t",   "uint8_t",  "int16_t",
+                                  "uint16_t", "int32_t",   "uint32_t",  "int64_t",  "uint64_t", "size_t",
+                                  "ssize_t",  "ptrdiff_t", "intptr_t",  "uintptr_t"};
+    for (const char* w : words)
+        if (t == w) return true;
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// Call thunks
+// ----------------------------------------------------------------------------
+
+enum class ResultClass { VOID, INT32, INT64, FLOAT, DOUBLE };
+
+char argClass(const CParam& p) {
+    if (p.pointer) return 'i';
+    if (p.type == CType::DOUBLE) return 'd';
+    if (p.type == CType::FLOAT) return 'f';
+    return 'i';
+}
+
+ResultClass resultClass(const CParam& r) {
+    if (r.pointer) return ResultClass::INT64;
+    switch (r.type) {
+        case CType::VOID: return ResultClass::VOID;
+        case CType::FLOAT: return ResultClass::FLOAT;
+        case CType::DOUBLE: return ResultClass::DOUBLE;
+        case CType::INT64:
+        case CType::UINT64: return ResultClass::INT64;
+        default: return ResultClass::INT32;
+    }
+}
+
+template <typename T>
+T fromSlot(const FfiSlot& s) {
+    if constexpr (std::is_same_v<T, double>) return s.d;
+    else if constexpr (std::is_same_v<T, float>) return s.f;
+    else return s.i;
+}
+
+template <typename R, typename... A>
+struct Caller {
+    template <size_t... I>
+    static FfiSlot invoke(void* fn, const FfiSlot* args, std::index_sequence<I...>) {
+        (void)args;
+        auto f = reinterpret_cast<R (*)(A...)>(fn);
+        FfiSlot out{};
+        if constexpr (std::is_void_v<R>) f(fromSlot<A>(args[I])...);
+        else if constexpr (std::is_same_v<R, double>) out.d = f(fromSlot<A>(args[I])...);
+        else if constexpr (std::is_same_v<R, float>) out.f = f(fromSlot<A>(args[I])...);
+        else out.i = f(fromSlot<A>(args[I])...);
+        return out;
+    }
+    static FfiSlot call(void* fn, const FfiSlot* args) {
+        return invoke(fn, args, std::index_sequence_for<A...>{});
+    }
+};
+
+// The thunk for argument classes `classes` ('i', 'd', 'f'), appended one
+// at a time to A...
+template <typename R, typename... A>
+FfiThunk selectThunk(const char* classes) {
+    if (*classes == '\0') return &Caller<R, A...>::call;
+    if constexpr (sizeof...(A) < kMaxArgs) {
+        switch (*classes) {
+            case 'i': return selectThunk<R, A..., int64_t>(classes + 1);
+            case 'd': return selectThunk<R, A..., double>(classes + 1);
+            case 'f': return selectThunk<R, A..., float>(classes + 1);
+        }
+    }
+    return nullptr;
+}
+
+// Thunks by signature class string, e.g. "d:iid" for double f(p, p, int)
+FfiThunk thunkFor(const CSignature& sig) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, FfiThunk> cache;
+    std::string classes;
+    for (auto& p : sig.params) classes += argClass(p);
+    ResultClass rc = resultClass(sig.result);
+    std::string key = std::to_string(static_cast<int>(rc)) + ":" + classes;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(key);
+    if (it != cache.end()) return it->second;
+    FfiThunk thunk = nullptr;
+    switch (rc) {
+        case ResultClass::VOID: thunk = selectThunk<void>(classes.c_str()); break;
+        case ResultClass::INT32: thunk = selectThunk<int32_t>(classes.c_str()); break;
+        case ResultClass::INT64: thunk = selectThunk<int64_t>(classes.c_str()); break;
+        case ResultClass::FLOAT: thunk = selectThunk<float>(classes.c_str()); break;
+        case ResultClass::DOUBLE: thunk = selectThunk<double>(classes.c_str()); break;
+    }
+    cache[key] = thunk;
+    return thunk;
+}
+
+// ----------------------------------------------------------------------------
+// Argument conversion
+// ----------------------------------------------------------------------------
+
+NumericClass numericClassOf(CType t) {
+    switch (t) {
+        case CType::CHAR:
+        case CType::INT8: return NumericClass::INT8;
+        case CType::UINT8: return NumericClass::UINT8;
+        case CType::INT16: return NumericClass::INT16;
+        case CType::UINT16: return NumericClass::UINT16;
+        case CType::INT32: return NumericClass::INT32;
+        case CType::UINT32: return NumericClass::UINT32;
+        case CType::INT64: return NumericClass::INT64;
+        case CType::UINT64: return NumericClass::UINT64;
+        case CType::FLOAT: return NumericClass::SINGLE;
+        default: return NumericClass::DOUBLE;
+    }
+}
+
+// A scalar argument in its slot; integers round like MATLAB's casts
+FfiSlot scalarSlot(const CParam& p, double x) {
+    FfiSlot s{};
+    switch (p.type) {
+        case CType::DOUBLE: s.d = x; break;
+        case CType::FLOAT: s.f = static_cast<float>(x); break;
+        case CType::UINT64:
+            s.i = x >= 9223372036854775808.0 ? static_cast<int64_t>(static_cast<uint64_t>(x))
+                                              : static_cast<int64_t>(std::llround(x));
+            break;
+        default: s.i = std::isfinite(x) ? static_cast<int64_t>(std::llround(x)) : 0; break;
+    }
+    return s;
+}
+
+double integerResult(CType t, int64_t v) {
+    switch (t) {
+        case CType::CHAR:
+        case CType::INT8: return static_cast<int8_t>(v);
+        case CType::UINT8: return static_cast<uint8_t>(v);
+        case CType::INT16: return static_cast<int16_t>(v);
+        case CType::UINT16: return static_cast<uint16_t>(v);
+        case CType::INT32: return static_cast<int32_t>(v);
+        case CType::UINT32: return static_cast<uint32_t>(v);
+        case CType::UINT64: return static_cast<double>(static_cast<uint64_t>(v));
+        default: return static_cast<double>(v);
+    }
+}
+
+} // namespace
+
+std::vector<CSignature> parsePrototypes(const std::string& text,
+                                        std::unordered_map<std::string, std::string>* unsupported) {
+    std::vector<CSignature> result;
+    auto tokens = tokenize(stripHeader(text));
+    std::vector<std::string> decl;
+    int braces = 0;
+    auto finish = [&] {
+        std::vector<std::string> d;
+        d.swap(decl);
+        if (d.empty() || d[0] == "typedef" || d[0] == "struct" || d[0] == "enum" || d[0] == "union") return;
+        auto open = std::find(d.begin(), d.end(), "(");
+        if (open == d.begin() || open == d.end()) return; // not a function
+        std::string name = *(open - 1);
+        if (isTypeWord(name) || !(std::isalpha(static_cast<unsigned char>(name[0])) || name[0] == '_')) return;
+        auto close = std::find(open, d.end(), ")");
+        std::string why;
+        if (close == d.end() || std::find(open + 1, close, "(") != close) {
+            why = "function pointer parameters are not supported";
+        }
+        CSignature sig;
+        sig.name = name;
+        if (why.empty() && !parseType({d.begin(), open - 1}, sig.result, why)) why = "result: " + why;
+        if (why.empty()) {
+            std::vector<std::string> inner(open + 1, close);
+            bool noParams = inner.empty() || (inner.size() == 1 && inner[0] == "void");
+            if (!noParams) {
+                for (auto& param : splitParams(inner)) {
+                    if (!param.empty() && param[0] == ".") {
+                        why = "variadic functions are not supported";
+                        break;
+                    }
+                    // Drop the parameter name, if any
+                    if (param.size() > 1 && !isTypeWord(param.back()) && param.back() != "*") param.pop_back();
+                    CParam p;
+                    if (!parseType(param, p, why)) break;
+                    if (p.type == CType::VOID && !p.pointer) {
+                        why = "void parameter";
+                        break;
+                    }
+                    sig.params.push_back(p);
+                }
+            }
+            if (why.empty() && sig.params.size() > kMaxArgs)
+                why = "more than " + std::to_string(kMaxArgs) + " parameters";
+            if (why.empty() && sig.result.pointer && sig.result.type != CType::CHAR)
+                why = "only char* results are supported among pointers";
+        }
+        if (why.empty()) result.push_back(std::move(sig));
+        else if (unsupported) (*unsupported)[name] = why;
+    };
+    for (size_t i = 0; i < tokens.size(); i++) {
+        const std::string& t = tokens[i];
+        if (t == "extern" && i + 1 < tokens.size() && tokens[i + 1] == "{") {
+            i++; // extern "C" { (the string is already gone)
+            continue;
+        }
+        if (t == "{") {
+            braces++;
+            continue;
+        }
+        if (t == "}") {
+            braces = std::max(0, braces - 1);
+            decl.clear();
+            continue;
+        }
+        if (braces > 0) continue; // bodies of structs and inline functions
+        if (t == ";") finish();
+        else decl.push_back(t);
+    }
+    return result;
+}
+
+std::shared_ptr<ForeignLibrary> ForeignLibrary::load(const std::string& path, const std::string& prototypes) {
+    auto lib = std::shared_ptr<ForeignLibrary>(new ForeignLibrary());
+    lib->library_ = SharedLibrary::open(path);
+    for (auto& sig : parsePrototypes(prototypes, &lib->unsupported_)) {
+        void* address = lib->library_->symbol(sig.name);
+        if (!address) continue;
+        Function fn;
+        fn.address = address;
+        fn.thunk = thunkFor(sig);
+        fn.signature = std::move(sig);
+        lib->functions_[fn.signature.name] = std::move(fn);
+    }
+    return lib;
+}
+
+std::vector<std::string> ForeignLibrary::functionNames() const {
+    std::vector<std::string> names;
+    for (auto& [name, fn] : functions_) names.push_back(name);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+ValueList ForeignLibrary::call(const std::string& name, const ValueList& args) const {
+    auto it = functions_.find(name);
+    if (it == functions_.end()) {
+        auto u = unsupported_.find(name);
+        if (u != unsupported_.end()) throw RuntimeError("calllib: cannot call '" + name + "': " + u->second);
+        throw RuntimeError("calllib: no declared function '" + name + "' in library '" + library_->path() + "'");
+    }
+    const Function& fn = it->second;
+    const auto& params = fn.signature.params;
+    if (args.size() != params.size())
+        throw RuntimeError("calllib: '" + name + "' needs " + std::to_string(params.size()) + " argument(s), got " +
+                           std::to_string(args.size()));
+
+    // Storage the pointers point into, alive until the call returns
+    struct Out {
+        size_t param;
+        Matrix matrix;           // double buffers, and converted results
+        std::vector<char> bytes; // other element types, and char buffers
+    };
+    std::vector<Out> outputs;
+    outputs.reserve(params.size());
+    std::vector<std::vector<char>> staging;
+    staging.reserve(params.size());
+
+    FfiSlot slots[kMaxArgs] = {};
+    for (size_t k = 0; k < params.size(); k++) {
+        const CParam& p = params[k];
+        const Value& v = *args[k];
+        if (!p.pointer) {
+            if (!v.isScalar()) throw RuntimeError("calllib: argument " + std::to_string(k + 1) + " of '" + name + "' must be a scalar");
+            slots[k] = scalarSlot(p, v.scalarDouble());
+            continue;
+        }
+        void* ptr = nullptr;
+        if (p.type == CType::CHAR && v.isString()) {
+            if (p.isConst) {
+                ptr = const_cast<char*>(v.string().c_str());
+            } else {
+                Out out{k, Matrix(), std::vector<char>(v.string().begin(), v.string().end())};
+                out.bytes.push_back('\0');
+                outputs.push_back(std::move(out));
+                ptr = outputs.back().bytes.data();
+            }
+        } else if (v.isNumeric() || v.isEmpty()) {
+            Matrix m = v.isEmpty() ? Matrix() : v.matrix();
+            bool asDouble = p.type == CType::DOUBLE || p.type == CType::VOID;
+            if (v.isEmpty() || m.numel() == 0) {
+                ptr = nullptr; // [] passes NULL
+            } else if (asDouble && p.isConst) {
+                ptr = const_cast<double*>(v.matrix().begin()); // no copy
+            } else if (asDouble) {
+                outputs.push_back({k, std::move(m), {}});
+                ptr = outputs.back().matrix.begin();
+            } else {
+                NumericClass cls = numericClassOf(p.type);
+                std::vector<char> bytes(m.numel() * numericClassSize(cls));
+                convertFromDouble(m.begin(), cls, m.numel(), bytes.data());
+                if (p.isConst) {
+                    staging.push_back(std::move(bytes));
+                    ptr = staging.back().data();
+                } else {
+                    outputs.push_back({k, Matrix(m.rows(), m.cols()), std::move(bytes)});
+                    ptr = outputs.back().bytes.data();
+                }
+            }
+        } else {
+            throw RuntimeError("calllib: argument " + std::to_string(k + 1) + " of '" + name +
+                               "' must be numeric" + (p.type == CType::CHAR ? " or char" : ""));
+        }
+        slots[k].i = static_cast<int64_t>(reinterpret_cast<intptr_t>(ptr));
+    }
+
+    FfiSlot r = fn.thunk(fn.address, slots);
+
+    ValueList results;
+    const CParam& rt = fn.signature.result;
+    if (rt.pointer) {
+        const char* s = reinterpret_cast<const char*>(static_cast<intptr_t>(r.i));
+        results.push_back(Value::makeString(s ? s : ""));
+    } else if (rt.type == CType::DOUBLE) {
+        results.push_back(Value::makeScalar(r.d));
+    } else if (rt.type == CType::FLOAT) {
+        results.push_back(Value::makeScalar(r.f));
+    } else if (rt.type != CType::VOID) {
+        results.push_back(Value::makeScalar(integerResult(rt.type, r.i)));
+    }
+    for (auto& out : outputs) {
+        const CParam& p = params[out.param];
+        if (p.type == CType::CHAR && args[out.param]->isString()) {
+            results.push_back(Value::makeString(std::string(out.bytes.data())));
+        } else if (!out.bytes.empty()) {
+            convertToDouble(out.bytes.data(), numericClassOf(p.type), out.matrix.numel(), out.matrix.begin());
+            results.push_back(Value::makeMatrix(std::move(out.matrix)));
+        } else {
+            results.push_back(Value::makeMatrix(std::move(out.matrix)));
+        }
+    }
+    if (results.empty()) results.push_back(Value::makeEmpty());
+    return results;
+}
+
+} // namespace matfree
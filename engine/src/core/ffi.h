@@ -0,0 +1,81 @@
+#pragma once
+// MatFree - Calls into C functions of shared libraries (loadlibrary, calllib)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "shared_library.h"
+#include "value.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace matfree {
+
+/// Scalar C types of a foreign function signature.
+enum class CType { VOID, CHAR, INT8, UINT8, INT16, UINT16, INT32, UINT32, INT64, UINT64, FLOAT, DOUBLE };
+
+struct CParam {
+    CType type = CType::VOID;
+    bool pointer = false; // T* (one level of indirection)
+    bool isConst = false; // const T*: the function only reads through it
+};
+
+struct CSignature {
+    std::string name;
+    CParam result;
+    std::vector<CParam> params;
+};
+
+/// Parse the function prototypes in C header text. Comments, preprocessor
+/// lines, extern "C" blocks and typedefs are skipped. Declarations whose
+/// types are not supported (structs, function pointers, pointers to
+/// pointers, more than six parameters) are returned in `unsupported` with
+/// the reason, by function name.
+std::vector<CSignature> parsePrototypes(const std::string& text,
+                                        std::unordered_map<std::string, std::string>* unsupported = nullptr);
+
+/// An argument or result of a call through a thunk.
+union FfiSlot {
+    int64_t i; // integers and pointers
+    double d;
+    float f;
+};
+
+/// Calls `fn` with `args` as the C types its signature's thunk was made for.
+using FfiThunk = FfiSlot (*)(void* fn, const FfiSlot* args);
+
+/// A C library with declared signatures. Each function gets a call thunk
+/// for its signature when the library is loaded, so a call only converts
+/// the arguments and jumps.
+class ForeignLibrary {
+public:
+    /// Load the library at `path` and resolve the functions declared in
+    /// `prototypes` (header text). Functions the library does not export are
+    /// left out. Throws RuntimeError if the library cannot be loaded.
+    static std::shared_ptr<ForeignLibrary> load(const std::string& path, const std::string& prototypes);
+
+    /// Declared functions the library exports, sorted.
+    std::vector<std::string> functionNames() const;
+
+    /// Call `name`. Numeric arguments convert to the parameter types;
+    /// matrices pass to pointer parameters, char arrays to char pointers.
+    /// Const pointers get MatFree's storage itself (no copy, as long as the
+    /// type is double); non-const pointers get a private copy that the
+    /// function may write. Returns the result (unless void) followed by the
+    /// final contents of each non-const pointer argument.
+    ValueList call(const std::string& name, const ValueList& args) const;
+
+private:
+    struct Function {
+        CSignature signature;
+        void* address = nullptr;
+        FfiThunk thunk = nullptr;
+    };
+
+    std::shared_ptr<SharedLibrary> library_;
+    std::unordered_map<std::string, Function> functions_;
+    std::unordered_map<std::string, std::string> unsupported_;
+};
+
+} // namespace matfree
@@ -0,0 +1,145 @@
+// MatFree - Files opened with fopen (fread, fwrite, fgetl, ...)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "file_io.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace matfree {
+
+namespace {
+
+// stdio buffer per open file: readahead for small reads, coalescing for
+// small writes.
+constexpr size_t kFileBuffer = size_t(1) << 20;
+
+// Elements converted per block of a bulk transfer, bounding the staging
+// buffer while keeping each fread/fwrite large.
+constexpr size_t kTransferBlock = size_t(1) << 20;
+
+} // namespace
+
+bool hostIsBigEndian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 0;
+}
+
+std::shared_ptr<FileHandle> FileHandle::open(const std::string& path, const std::string& permission,
+                                             bool bigEndian, std::string& message) {
+    std::string mode;
+    for (char c : permission)
+        if (c != 'b' && c != 't') mode += c;
+    if (mode != "r" && mode != "w" && mode != "a" && mode != "r+" && mode != "w+" && mode != "a+") {
+        message = "Invalid permission '" + permission + "'";
+        return nullptr;
+    }
+    std::FILE* f = std::fopen(path.c_str(), (mode + "b").c_str());
+    if (!f) {
+        message = std::strerror(errno);
+        return nullptr;
+    }
+    std::shared_ptr<FileHandle> h(new FileHandle());
+    h->file_ = f;
+    h->buffer_.resize(kFileBuffer);
+    std::setvbuf(f, h->buffer_.data(), _IOFBF, h->buffer_.size());
+    h->path_ = path;
+    h->permission_ = mode;
+    h->bigEndian_ = bigEndian;
+    message.clear();
+    return h;
+}
+
+FileHandle::~FileHandle() {
+    close();
+}
+
+bool FileHandle::close() {
+    if (!file_) return true;
+    bool ok = std::fclose(file_) == 0;
+    file_ = nullptr;
+    return ok;
+}
+
+size_t FileHandle::readNumeric(NumericClass cls, size_t n, bool bigEndian, double* out) {
+    size_t elem = numericClassSize(cls);
+    bool swap = bigEndian != hostIsBigEndian();
+    if (cls == NumericClass::DOUBLE) {
+        // Straight into the result
+        size_t got = std::fread(out, elem, n, file_);
+        if (swap) byteSwap(out, elem, got);
+        return got;
+    }
+    std::vector<char> staging(std::min(n, kTransferBlock) * elem);
+    size_t done = 0;
+    while (done < n) {
+        size_t want = std::min(n - done, kTransferBlock);
+        size_t got = std::fread(staging.data(), elem, want, file_);
+        if (swap) byteSwap(staging.data(), elem, got);
+        convertToDouble(staging.data(), cls, got, out + done);
+        done += got;
+        if (got < want) break;
+    }
+    return done;
+}
+
+size_t FileHandle::writeNumeric(const double* data, size_t n, NumericClass cls, bool bigEndian) {
+    size_t elem = numericClassSize(cls);
+    bool swap = bigEndian != hostIsBigEndian();
+    if (cls == NumericClass::DOUBLE && !swap) return std::fwrite(data, elem, n, file_);
+    std::vector<char> staging(std::min(n, kTransferBlock) * elem);
+    size_t done = 0;
+    while (done < n) {
+        size_t count = std::min(n - done, kTransferBlock);
+        convertFromDouble(data + done, cls, count, staging.data());
+        if (swap) byteSwap(staging.data(), elem, count);
+        size_t put = std::fwrite(staging.data(), elem, count, file_);
+        done += put;
+        if (put < count) break;
+    }
+    return done;
+}
+
+size_t FileHandle::writeText(const std::string& text) {
+    return std::fwrite(text.data(), 1, text.size(), file_);
+}
+
+uint64_t FileHandle::remaining() {
+    long pos = std::ftell(file_);
+    if (pos < 0 || std::fseek(file_, 0, SEEK_END) != 0) return 0;
+    long end = std::ftell(file_);
+    std::fseek(file_, pos, SEEK_SET);
+    return end > pos ? static_cast<uint64_t>(end - pos) : 0;
+}
+
+bool FileHandle::readLine(std::string& line, bool keepNewline) {
+    line.clear();
+    int c;
+    bool any = false;
+    while ((c = std::getc(file_)) != EOF) {
+        any = true;
+        if (c == '\n') {
+            if (keepNewline) line += '\n';
+            break;
+        }
+        line += static_cast<char>(c);
+    }
+    if (!keepNewline && !line.empty() && line.back() == '\r') line.pop_back();
+    return any;
+}
+
+bool FileHandle::seek(int64_t offset, int origin) {
+    return std::fseek(file_, static_cast<long>(offset), origin) == 0;
+}
+
+int64_t FileHandle::tell() {
+    return static_cast<int64_t>(std::ftell(file_));
+}
+
+bool FileHandle::eof() {
+    return std::feof(file_) != 0;
+}
+
+} // namespace matfree
@@ -0,0 +1,69 @@
+#pragma once
+// MatFree - Files opened with fopen (fread, fwrite, fgetl, ...)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "numeric_types.h"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace matfree {
+
+/// An open file. All transfers go through a large stdio buffer, so small
+/// reads are served from readahead and small writes are coalesced; bulk
+/// reads and writes of typed data move whole blocks at once and convert
+/// them in memory.
+class FileHandle {
+public:
+    /// Open `path` with an fopen permission ("r", "w", "a", "r+", "w+",
+    /// "a+"; 'b' and 't' are accepted and ignored). Returns nullptr and
+    /// sets `message` when the file cannot be opened.
+    static std::shared_ptr<FileHandle> open(const std::string& path, const std::string& permission,
+                                            bool bigEndian, std::string& message);
+
+    ~FileHandle();
+    FileHandle(const FileHandle&) = delete;
+    FileHandle& operator=(const FileHandle&) = delete;
+
+    const std::string& path() const { return path_; }
+    const std::string& permission() const { return permission_; }
+    bool bigEndian() const { return bigEndian_; }
+
+    /// Read up to `n` elements of class `cls` (stored with the given byte
+    /// order) as doubles. Returns the number of whole elements read.
+    size_t readNumeric(NumericClass cls, size_t n, bool bigEndian, double* out);
+    /// Write `n` doubles as class `cls`. Returns the number written.
+    size_t writeNumeric(const double* data, size_t n, NumericClass cls, bool bigEndian);
+    size_t writeText(const std::string& text);
+
+    /// Bytes from the current position to the end of the file.
+    uint64_t remaining();
+
+    /// Next line, with its line break when `keepNewline`. False at the end
+    /// of the file when nothing was read.
+    bool readLine(std::string& line, bool keepNewline);
+
+    /// origin: SEEK_SET, SEEK_CUR or SEEK_END. False on failure.
+    bool seek(int64_t offset, int origin);
+    int64_t tell();
+    /// True once a read has tried to go past the end of the file.
+    bool eof();
+
+    /// False if buffered data could not be written.
+    bool close();
+
+private:
+    FileHandle() = default;
+
+    std::FILE* file_ = nullptr;
+    std::vector<char> buffer_;
+    std::string path_, permission_;
+    bool bigEndian_ = false;
+};
+
+/// True when this machine stores numbers most significant byte first.
+bool hostIsBigEndian();
+
+} // namespace matfree
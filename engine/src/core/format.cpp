@@ -0,0 +1,256 @@
+// MatFree - printf-style formatting (sprintf, fprintf)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "format.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+namespace matfree {
+
+namespace {
+
+bool hasFlag(const std::string& flags, char f) { return flags.find(f) != std::string::npos; }
+
+// Append sign + digits padded to `width`: spaces on the left (or right with
+// '-'), or zeros between the sign and the digits with '0'.
+void appendPadded(std::string& out, const std::string& flags, int width, const char* sign, const char* body,
+                  size_t bodyLen, bool zeroPadAllowed = true) {
+    size_t signLen = std::char_traits<char>::length(sign);
+    size_t len = signLen + bodyLen;
+    size_t pad = width > 0 && static_cast<size_t>(width) > len ? static_cast<size_t>(width) - len : 0;
+    if (hasFlag(flags, '-')) {
+        out.append(sign).append(body, bodyLen).append(pad, ' ');
+    } else if (zeroPadAllowed && hasFlag(flags, '0')) {
+        out.append(sign).append(pad, '0').append(body, bodyLen);
+    } else {
+        out.append(pad, ' ').append(sign).append(body, bodyLen);
+    }
+}
+
+const char* signFor(bool negative, const std::string& flags) {
+    if (negative) return "-";
+    if (hasFlag(flags, '+')) return "+";
+    if (hasFlag(flags, ' ')) return " ";
+    return "";
+}
+
+bool isIntegral(double v) {
+    return std::isfinite(v) && v == std::floor(v) && std::fabs(v) < 9.2e18;
+}
+
+// A char argument, or the element cursor over numeric arguments
+struct Items {
+    const ValueList& args;
+    size_t arg, elem;
+
+    Items(const ValueList& a, size_t first) : args(a), arg(first), elem(0) { skipEmpty(); }
+
+    void skipEmpty() {
+        while (arg < args.size()) {
+            const ValuePtr& v = args[arg];
+            if (v->isString()) return;
+            if (v->isNumeric()) {
+                if (elem < v->matrix().numel()) return;
+            } else if (!v->isEmpty()) {
+                throw RuntimeError("Only numeric, logical and char arguments can be formatted");
+            }
+            arg++;
+            elem = 0;
+        }
+    }
+    bool done() const { return arg >= args.size(); }
+    bool isString() const { return args[arg]->isString(); }
+    const std::string& string() {
+        const std::string& s = args[arg]->string();
+        arg++;
+        elem = 0;
+        skipEmpty();
+        return s;
+    }
+    double number() {
+        double v = args[arg]->matrix()(elem++);
+        skipEmpty();
+        return v;
+    }
+};
+
+} // namespace
+
+PrintfFormat::PrintfFormat(const std::string& fmt) {
+    std::string literal;
+    auto flushLiteral = [&] {
+        if (literal.empty()) return;
+        Piece p;
+        p.literal = std::move(literal);
+        pieces_.push_back(std::move(p));
+        literal.clear();
+    };
+    for (size_t i = 0; i < fmt.size(); i++) {
+        char c = fmt[i];
+        if (c == '\\' && i + 1 < fmt.size()) {
+            char e = fmt[++i];
+            switch (e) {
+                case 'n': literal += '\n'; break;
+                case 't': literal += '\t'; break;
+                case 'r': literal += '\r'; break;
+                case 'a': literal += '\a'; break;
+                case 'b': literal += '\b'; break;
+                case 'f': literal += '\f'; break;
+                case 'v': literal += '\v'; break;
+                case '\\': literal += '\\'; break;
+                default: literal += e; break;
+            }
+            continue;
+        }
+        if (c != '%') {
+            literal += c;
+            continue;
+        }
+        if (i + 1 < fmt.size() && fmt[i + 1] == '%') {
+            literal += '%';
+            i++;
+            continue;
+        }
+        Spec spec;
+        size_t j = i + 1;
+        while (j < fmt.size() && std::string("-+ 0#").find(fmt[j]) != std::string::npos) spec.flags += fmt[j++];
+        if (j < fmt.size() && std::isdigit(static_cast<unsigned char>(fmt[j]))) {
+            spec.width = 0;
+            while (j < fmt.size() && std::isdigit(static_cast<unsigned char>(fmt[j]))) spec.width = spec.width * 10 + (fmt[j++] - '0');
+        }
+        if (j < fmt.size() && fmt[j] == '.') {
+            j++;
+            spec.precision = 0;
+            while (j < fmt.size() && std::isdigit(static_cast<unsigned char>(fmt[j]))) spec.precision = spec.precision * 10 + (fmt[j++] - '0');
+        }
+        // Length modifiers (%ld, %lu, %hd) mean nothing for doubles
+        while (j < fmt.size() && (fmt[j] == 'l' || fmt[j] == 'h')) j++;
+        if (j >= fmt.size() || std::string("diuoxXfFeEgGcs").find(fmt[j]) == std::string::npos) {
+            // Not a conversion: keep the text as it is
+            literal += fmt.substr(i, j - i);
+            i = j - 1;
+            continue;
+        }
+        spec.conversion = fmt[j];
+        i = j;
+        flushLiteral();
+        Piece p;
+        p.isSpec = true;
+        p.spec = spec;
+        pieces_.push_back(std::move(p));
+        specCount_++;
+    }
+    flushLiteral();
+}
+
+void PrintfFormat::formatNumber(const Spec& spec, double v, std::string& out) const {
+    char conv = spec.conversion;
+    if (std::isnan(v) || std::isinf(v)) {
+        const char* body = std::isnan(v) ? "NaN" : "Inf";
+        appendPadded(out, spec.flags, spec.width, signFor(v < 0, spec.flags), body, 3, false);
+        return;
+    }
+    char buf[700]; // a fixed 1e308 with precision 300
+    bool integerConv = conv == 'd' || conv == 'i' || conv == 'u' || conv == 'x' || conv == 'X' || conv == 'o';
+    if (integerConv && !isIntegral(v)) {
+        // Like MATLAB, non-integers in integer conversions print as %e
+        Spec e = spec;
+        e.conversion = 'e';
+        formatNumber(e, v, out);
+        return;
+    }
+    if (hasFlag(spec.flags, '#') || (integerConv && spec.precision >= 0) || spec.precision > 300 ||
+        ((conv == 'x' || conv == 'X' || conv == 'o') && v < 0)) {
+        // Rare forms: leave them to the C library
+        std::string f = "%" + spec.flags;
+        if (spec.width >= 0) f += std::to_string(spec.width);
+        if (spec.precision >= 0) f += "." + std::to_string(spec.precision);
+        f += integerConv ? std::string("ll") + (conv == 'i' || conv == 'u' ? 'd' : conv) : std::string(1, conv);
+        long long iv = integerConv ? static_cast<long long>(v) : 0;
+        int n = integerConv ? std::snprintf(nullptr, 0, f.c_str(), iv) : std::snprintf(nullptr, 0, f.c_str(), v);
+        std::string text(static_cast<size_t>(n) + 1, '\0');
+        if (integerConv) std::snprintf(text.data(), text.size(), f.c_str(), iv);
+        else std::snprintf(text.data(), text.size(), f.c_str(), v);
+        out.append(text.data(), static_cast<size_t>(n));
+        return;
+    }
+
+    bool negative = std::signbit(v) && v != 0;
+    double mag = std::fabs(v);
+    std::to_chars_result r;
+    if (integerConv) {
+        int base = conv == 'x' || conv == 'X' ? 16 : conv == 'o' ? 8 : 10;
+        r = std::to_chars(buf, buf + sizeof(buf), static_cast<unsigned long long>(mag), base);
+    } else {
+        int precision = spec.precision >= 0 ? spec.precision : 6;
+        std::chars_format cf = conv == 'f' || conv == 'F' ? std::chars_format::fixed
+                               : conv == 'e' || conv == 'E' ? std::chars_format::scientific
+                                                             : std::chars_format::general;
+        if (cf == std::chars_format::general && precision == 0) precision = 1;
+        r = std::to_chars(buf, buf + sizeof(buf), mag, cf, precision);
+    }
+    if (conv == 'X' || conv == 'E' || conv == 'G')
+        std::transform(buf, r.ptr, buf, [](char c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+    appendPadded(out, spec.flags, spec.width, signFor(negative, spec.flags), buf, static_cast<size_t>(r.ptr - buf));
+}
+
+void PrintfFormat::format(const ValueList& args, size_t first, std::string& out) const {
+    Items items(args, first);
+    bool anyData = !items.done();
+    if (specCount_ == 0 || !anyData) {
+        // Written once; conversions without data print nothing
+        for (auto& p : pieces_)
+            if (!p.isSpec) out += p.literal;
+        return;
+    }
+    while (true) {
+        for (auto& p : pieces_) {
+            if (!p.isSpec) {
+                out += p.literal;
+                continue;
+            }
+            if (items.done()) return;
+            const Spec& spec = p.spec;
+            if (items.isString()) {
+                // Text in any conversion prints as %s
+                const std::string& s = items.string();
+                size_t len = spec.precision >= 0 && spec.conversion == 's'
+                                 ? std::min(s.size(), static_cast<size_t>(spec.precision))
+                                 : s.size();
+                appendPadded(out, spec.flags, spec.width, "", s.data(), len, false);
+                continue;
+            }
+            double v = items.number();
+            if (spec.conversion == 'c' || spec.conversion == 's') {
+                std::string text;
+                if (isIntegral(v) && v >= 0 && v < 256) text += static_cast<char>(v);
+                else appendShortest(v, text);
+                size_t len = spec.precision >= 0 && spec.conversion == 's'
+                                 ? std::min(text.size(), static_cast<size_t>(spec.precision))
+                                 : text.size();
+                appendPadded(out, spec.flags, spec.width, "", text.data(), len, false);
+                continue;
+            }
+            formatNumber(spec, v, out);
+        }
+        if (items.done()) return;
+    }
+}
+
+void appendShortest(double v, std::string& out) {
+    if (std::isnan(v)) {
+        out += "NaN";
+        return;
+    }
+    if (std::isinf(v)) {
+        out += v < 0 ? "-Inf" : "Inf";
+        return;
+    }
+    char buf[32];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, r.ptr);
+}
+
+} // namespace matfree
@@ -0,0 +1,54 @@
+#pragma once
+// MatFree - printf-style formatting (sprintf, fprintf)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "value.h"
+#include <string>
+#include <vector>
+
+namespace matfree {
+
+/// A format string compiled once into literal text (escapes such as \n
+/// already resolved, %% as %) and conversion specifications.
+class PrintfFormat {
+public:
+    /// Throws RuntimeError for malformed conversions.
+    explicit PrintfFormat(const std::string& format);
+
+    /// Append the formatted `args[first..]` to `out`. The format is applied
+    /// again and again until every element of every argument is consumed:
+    /// numeric arguments supply their elements in linear index order, char
+    /// arguments supply the whole string. Output stops at the first
+    /// conversion left without data; a format applied to no data at all is
+    /// written once with its conversions empty.
+    ///
+    /// %d/%i/%u/%x/%o print integers, and fall back to %e for values that
+    /// are not; %s prints text, or a number (as a character when it is a
+    /// character code, otherwise in shortest round-trip form); %c prints
+    /// characters; %f/%e/%g print with the given precision. Non-finite
+    /// values print as Inf, -Inf and NaN.
+    void format(const ValueList& args, size_t first, std::string& out) const;
+
+private:
+    struct Spec {
+        std::string flags;
+        int width = -1;     // -1: none
+        int precision = -1; // -1: none
+        char conversion = 'd';
+    };
+    struct Piece {
+        std::string literal; // when !isSpec
+        bool isSpec = false;
+        Spec spec;
+    };
+
+    void formatNumber(const Spec& spec, double v, std::string& out) const;
+    std::vector<Piece> pieces_;
+    size_t specCount_ = 0;
+};
+
+/// Append the shortest decimal form of `v` that reads back as exactly `v`
+/// ("0.1", "1e+100", "3"), or Inf, -Inf, NaN.
+void appendShortest(double v, std::string& out);
+
+} // namespace matfree
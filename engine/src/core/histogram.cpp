@@ -0,0 +1,170 @@
+// MatFree - Histogram kernels
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "histogram.h"
+#include "parallel.h"
+#include "statistics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace matfree {
+
+namespace {
+
+// Upper bound on bins for automatically chosen edges.
+constexpr size_t kMaxAutoBins = 1000000;
+
+// Minimum elements per thread before counting is split.
+constexpr size_t kHistGrain = size_t(1) << 16;
+
+// Grain that gives roughly one chunk per thread, so each thread keeps one
+// private histogram and the merge cost stays proportional to the thread count.
+size_t perThreadGrain(size_t n) {
+    size_t threads = std::max<size_t>(parallelThreadCount(), 1);
+    return std::max(kHistGrain, (n + threads - 1) / threads);
+}
+
+} // namespace
+
+BinEdges BinEdges::uniform(double lo, double hi, size_t nbins) {
+    if (nbins == 0) throw RuntimeError("Number of bins must be positive");
+    if (!std::isfinite(lo) || !std::isfinite(hi) || hi < lo)
+        throw RuntimeError("Bin limits must be finite and increasing");
+    if (hi == lo) {
+        lo -= 0.5;
+        hi += 0.5;
+    }
+    std::vector<double> e(nbins + 1);
+    double width = (hi - lo) / static_cast<double>(nbins);
+    for (size_t k = 0; k < nbins; k++) e[k] = lo + static_cast<double>(k) * width;
+    e[nbins] = hi;
+    return fromEdges(std::move(e));
+}
+
+BinEdges BinEdges::fromEdges(std::vector<double> edges) {
+    if (edges.size() < 2) throw RuntimeError("Bin edges must contain at least two values");
+    for (size_t k = 0; k < edges.size(); k++) {
+        if (std::isnan(edges[k]) || (k > 0 && edges[k] < edges[k - 1]))
+            throw RuntimeError("Bin edges must be monotonically non-decreasing");
+    }
+    BinEdges b;
+    b.edges_ = std::move(edges);
+
+    // Evenly spaced finite edges allow an O(1) direct index (then a one-step
+    // correction against the actual edges, so results match the search path).
+    const auto& e = b.edges_;
+    size_t nb = e.size() - 1;
+    double lo = e.front(), hi = e.back();
+    if (std::isfinite(lo) && std::isfinite(hi) && hi > lo) {
+        double width = (hi - lo) / static_cast<double>(nb);
+        double tol = 4.0 * std::numeric_limits<double>::epsilon() *
+                     std::max(std::fabs(lo), std::fabs(hi));
+        bool even = true;
+        for (size_t k = 1; k < nb && even; k++)
+            even = std::fabs(e[k] - (lo + static_cast<double>(k) * width)) <= tol;
+        if (even) {
+            b.uniform_ = true;
+            b.lo_ = lo;
+            b.invWidth_ = 1.0 / width;
+        }
+    }
+    return b;
+}
+
+BinEdges BinEdges::automatic(const double* data, size_t n, size_t nbins) {
+    MomentAccumulator acc = accumulateMoments(data, n);
+    if (!std::isfinite(acc.mean) || !std::isfinite(acc.min) || !std::isfinite(acc.max)) {
+        // NaN or Inf present: redo the summary over finite values only.
+        acc = MomentAccumulator();
+        for (size_t i = 0; i < n; i++) {
+            if (std::isfinite(data[i])) acc.add(data[i]);
+        }
+    }
+    return automatic(acc, nbins);
+}
+
+BinEdges BinEdges::automatic(const MomentAccumulator& acc, size_t nbins) {
+    if (acc.count == 0.0) return uniform(0.0, 1.0, nbins ? nbins : 1);
+
+    if (nbins == 0) {
+        // Scott's normal reference rule
+        double sd = std::sqrt(acc.variance(0));
+        double width = 3.5 * sd * std::cbrt(1.0 / acc.count);
+        double range = acc.max - acc.min;
+        nbins = (width > 0.0 && range > 0.0)
+                    ? static_cast<size_t>(std::ceil(range / width))
+                    : 1;
+        nbins = std::clamp<size_t>(nbins, 1, kMaxAutoBins);
+    }
+    return uniform(acc.min, acc.max, nbins);
+}
+
+size_t BinEdges::binOf(double x) const {
+    const size_t nb = edges_.size() - 1;
+    if (!(x >= edges_.front() && x <= edges_.back())) return npos; // also NaN
+    if (x == edges_.back()) return nb - 1;
+
+    if (uniform_) {
+        size_t k = static_cast<size_t>((x - lo_) * invWidth_);
+        if (k >= nb) k = nb - 1;
+        if (x < edges_[k]) k--;
+        else if (x >= edges_[k + 1]) k++;
+        return k;
+    }
+    return static_cast<size_t>(
+        std::upper_bound(edges_.begin(), edges_.end(), x) - edges_.begin()) - 1;
+}
+
+std::vector<uint64_t> histCounts(const double* data, size_t n, const BinEdges& edges,
+                                 double* binIndex) {
+    const size_t nb = edges.bins();
+    size_t grain = perThreadGrain(n);
+    std::vector<std::vector<uint64_t>> partial(parallelChunkCount(n, grain));
+
+    parallelForChunks(n, grain, [&](size_t chunk, size_t begin, size_t end) {
+        auto& counts = partial[chunk];
+        counts.assign(nb, 0);
+        for (size_t i = begin; i < end; i++) {
+            size_t k = edges.binOf(data[i]);
+            if (k != BinEdges::npos) counts[k]++;
+            if (binIndex) binIndex[i] = (k == BinEdges::npos) ? 0.0 : static_cast<double>(k + 1);
+        }
+    });
+
+    if (partial.empty()) return std::vector<uint64_t>(nb, 0);
+    std::vector<uint64_t> total = std::move(partial[0]);
+    for (size_t c = 1; c < partial.size(); c++) {
+        for (size_t k = 0; k < nb; k++) total[k] += partial[c][k];
+    }
+    return total;
+}
+
+Matrix histCounts2(const double* x, const double* y, size_t n,
+                   const BinEdges& xEdges, const BinEdges& yEdges) {
+    const size_t nx = xEdges.bins(), ny = yEdges.bins();
+    const size_t cells = nx * ny;
+    // Very fine 2-D grids are counted serially rather than replicated per thread.
+    size_t grain = (cells > (size_t(1) << 22)) ? std::max<size_t>(n, 1) : perThreadGrain(n);
+    std::vector<std::vector<uint64_t>> partial(parallelChunkCount(n, grain));
+
+    parallelForChunks(n, grain, [&](size_t chunk, size_t begin, size_t end) {
+        auto& counts = partial[chunk];
+        counts.assign(cells, 0);
+        for (size_t i = begin; i < end; i++) {
+            size_t kx = xEdges.binOf(x[i]);
+            if (kx == BinEdges::npos) continue;
+            size_t ky = yEdges.binOf(y[i]);
+            if (ky == BinEdges::npos) continue;
+            counts[kx * ny + ky]++;
+        }
+    });
+
+    Matrix result(nx, ny);
+    for (auto& counts : partial) {
+        for (size_t k = 0; k < cells; k++) result(k) += static_cast<double>(counts[k]);
+    }
+    return result;
+}
+
+} // namespace matfree
@@ -0,0 +1,58 @@
+#pragma once
+// MatFree - Histogram kernels (uniform direct-index and arbitrary-edge binning)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "value.h"
+#include <cstdint>
+#include <vector>
+
+namespace matfree {
+
+struct MomentAccumulator;
+
+/// A set of histogram bins described by sorted edges. Bin k covers
+/// [edges[k], edges[k+1]); the last bin also includes its right edge. Evenly spaced edges are detected so lookups can use
+/// direct indexing instead of a binary search.
+class BinEdges {
+public:
+    BinEdges() = default;
+
+    /// `nbins` equal-width bins spanning [lo, hi].
+    static BinEdges uniform(double lo, double hi, size_t nbins);
+    /// Arbitrary monotonically non-decreasing edges (at least two).
+    static BinEdges fromEdges(std::vector<double> edges);
+    /// Edges for `data` following the MatFree defaults: `nbins` equal bins
+    /// over [min, max], or Scott's rule when nbins is 0. NaN/Inf are ignored.
+    static BinEdges automatic(const double* data, size_t n, size_t nbins = 0);
+    /// The same edges from the moments of the finite values, e.g. of data
+    /// that is streamed rather than held in memory.
+    static BinEdges automatic(const MomentAccumulator& finite, size_t nbins = 0);
+
+    size_t bins() const { return edges_.empty() ? 0 : edges_.size() - 1; }
+    const std::vector<double>& edges() const { return edges_; }
+    bool isUniform() const { return uniform_; }
+
+    /// 0-based bin of `x`, or npos when x is NaN or outside the edges.
+    size_t binOf(double x) const;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+    std::vector<double> edges_;
+    bool uniform_ = false;
+    double lo_ = 0.0, invWidth_ = 0.0;
+};
+
+/// Count `n` values into the given bins. Large inputs are split across
+/// threads, each filling a private histogram, and merged at the end.
+/// When `binIndex` is non-null it receives the 1-based bin of every value
+/// (0 when the value falls in no bin).
+std::vector<uint64_t> histCounts(const double* data, size_t n, const BinEdges& edges,
+                                 double* binIndex = nullptr);
+
+/// Bivariate counts: result(i, j) counts pairs with x in bin i of `xEdges`
+/// and y in bin j of `yEdges`.
+Matrix histCounts2(const double* x, const double* y, size_t n,
+                   const BinEdges& xEdges, const BinEdges& yEdges);
+
+} // namespace matfree
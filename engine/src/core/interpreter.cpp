@@ -4,15 +4,39 @@
 #include "interpreter.h"
 #include "lexer.h"
 #include "parser.h"
+#include "parfor.h"
 #include <fstream>
 #include <sstream>
 #include <cmath>
 #include <algorithm>
 #include <cassert>
+#include <mutex>
+#include <optional>
 
 namespace matfree {
 
-Interpreter::Interpreter() : output_(&std::cout) {
+namespace {
+
+// Interpreter whose built-in is running on this thread (see current()).
+thread_local Interpreter* tlsActive = nullptr;
+
+/// Marks `interp` as the running interpreter for the duration of a
+/// built-in call, restoring the previous one afterwards (calls nest).
+class ActiveScope {
+public:
+    explicit ActiveScope(Interpreter* interp) : saved_(tlsActive) { tlsActive = interp; }
+    ~ActiveScope() { tlsActive = saved_; }
+    ActiveScope(const ActiveScope&) = delete;
+    ActiveScope& operator=(const ActiveScope&) = delete;
+
+private:
+    Interpreter* saved_;
+};
+
+} // namespace
+
+Interpreter::Interpreter()
+    : output_(&std::cout), builtins_(std::make_shared<BuiltinTable>()) {
     globalEnv_ = Environment::createGlobal();
     currentEnv_ = globalEnv_;
 
@@ -32,8 +56,67 @@ Interpreter::Interpreter() : output_(&std::cout) {
     searchPath_.push_back(".");
 }
 
+BuiltinTable& Interpreter::mutableBuiltins() {
+    if (builtinsShared_) {
+        builtins_ = std::make_shared<BuiltinTable>(*builtins_);
+        builtinsShared_ = false;
+    }
+    return *builtins_;
+}
+
+std::shared_ptr<const BuiltinTable> Interpreter::builtinTable() {
+    builtinsShared_ = true;
+    return builtins_;
+}
+
+void Interpreter::useBuiltins(const std::shared_ptr<const BuiltinTable>& table) {
+    if (builtins_->functions.empty()) {
+        // Never modified through this interpreter: mutableBuiltins() copies first
+        builtins_ = std::const_pointer_cast<BuiltinTable>(table);
+        builtinsShared_ = true;
+        return;
+    }
+    BuiltinTable& own = mutableBuiltins();
+    for (auto& [name, fn] : table->functions) {
+        own.functions[name] = fn;
+        own.multi.erase(name);
+        own.traits.erase(name);
+    }
+    for (auto& [name, fn] : table->multi) own.multi[name] = fn;
+    for (auto& [name, traits] : table->traits) own.traits[name] = traits;
+}
+
+Interpreter& Interpreter::current() {
+    if (!tlsActive) throw RuntimeError("No interpreter is running a built-in on this thread");
+    return *tlsActive;
+}
+
 void Interpreter::registerBuiltin(const std::string& name, BuiltinFunc func) {
-    builtinFunctions_[name] = std::move(func);
+    BuiltinTable& table = mutableBuiltins();
+    table.functions[name] = std::move(func);
+    table.multi.erase(name);
+    table.traits.erase(name);
+}
+
+void Interpreter::registerMultiBuiltin(const std::string& name, BuiltinMultiFunc func) {
+    BuiltinTable& table = mutableBuiltins();
+    table.functions[name] = [func](const ValueList& args) -> ValuePtr {
+        auto outs = func(args, 1);
+        return outs.empty() ? Value::makeEmpty() : outs[0];
+    };
+    table.multi[name] = std::move(func);
+    table.traits.erase(name);
+}
+
+void Interpreter::setBuiltinTraits(const std::string& name, unsigned traits) {
+    if (!builtins_->functions.count(name))
+        throw RuntimeError("Cannot set traits of unknown built-in '" + name + "'");
+    mutableBuiltins().traits[name] = traits;
+}
+
+unsigned Interpreter::builtinTraits(const std::string& name) const {
+    auto it = builtins_->traits.find(name);
+    return it == builtins_->traits.end() ? 0u : it->second;
 }
 
 void Interpreter::addPath(const std::string& path) {
@@ -54,7 +137,13 @@ void Interpreter::execute(const Program& program) {
     for (auto& stmt : program.statements) {
         // Skip function definitions (already registered)
         if (stmt->is<FunctionDef>()) continue;
-        executeStmt(stmt);
+        try {
+            executeStmt(stmt);
+        } catch (...) {
+            flushOutput();
+            throw;
+        }
+        flushOutput();
     }
 }
 
@@ -76,10 +165,23 @@ void Interpreter::executeString(const std::string& code, const std::string& sour
     auto tokens = lexer.tokenize();
     Parser parser(tokens);
     auto program = parser.parse();
+    source_ = source;
+    if (profiling_) profiler_->setScript(source);
+    if (sampling_ && sampler_->stack().depth() == 1) sampler_->setScript(source);
     execute(program);
 }
 
 void Interpreter::executeStmt(const StmtPtr& stmt) {
+    if (sampling_) sampler_->stack().setLine(stmt->line);
+    if (profiling_) {
+        Profiler::LineScope scope(*profiler_, stmt->line);
+        dispatchStmt(stmt);
+    } else {
+        dispatchStmt(stmt);
+    }
+}
+
+void Interpreter::dispatchStmt(const StmtPtr& stmt) {
     std::visit([this](auto& node) {
         using T = std::decay_t<decltype(node)>;
         if constexpr (std::is_same_v<T, ExprStmt>)        execExprStmt(node);
@@ -87,6 +189,7 @@ void Interpreter::executeStmt(const StmtPtr& stmt) {
         else if constexpr (std::is_same_v<T, MultiAssignStmt>) execMultiAssign(node);
         else if constexpr (std::is_same_v<T, IfStmt>)     execIf(node);
         else if constexpr (std::is_same_v<T, ForStmt>)    execFor(node);
+        else if constexpr (std::is_same_v<T, ParforStmt>) execParfor(node);
         else if constexpr (std::is_same_v<T, WhileStmt>)  execWhile(node);
         else if constexpr (std::is_same_v<T, SwitchStmt>) execSwitch(node);
         else if constexpr (std::is_same_v<T, TryCatchStmt>) execTryCatch(node);
@@ -104,7 +207,22 @@ void Interpreter::executeStmt(const StmtPtr& stmt) {
 // ============================================================================
 
 void Interpreter::execExprStmt(const ExprStmt& stmt) {
-    auto val = evalExpr(stmt.expression);
+    ValuePtr val;
+    // A statement that only calls a multi-output built-in calls it with
+    // nargout = 0, so it can tell `load(f)` from `S = load(f)` (and `tic`
+    // from `t = tic`).
+    auto* call = stmt.expression->is<CallExpr>() ? &stmt.expression->as<CallExpr>() : nullptr;
+    const Expr& callee = call ? *call->callee : *stmt.expression;
+    if (callee.is<Identifier>() && builtins_->multi.count(callee.as<Identifier>().name) &&
+        !currentEnv_->has(callee.as<Identifier>().name)) {
+        ValueList args;
+        if (call)
+            for (auto& arg : call->arguments) args.push_back(evalExpr(arg));
+        auto outs = callFunctionMulti(callee.as<Identifier>().name, args, 0);
+        if (!outs.empty()) val = outs[0];
+    } else {
+        val = evalExpr(stmt.expression);
+    }
     if (stmt.printResult && val && !val->isEmpty()) {
         // Print "ans = ..." when there's no semicolon
         currentEnv_->set("ans", val);
@@ -113,6 +231,8 @@ void Interpreter::execExprStmt(const ExprStmt& stmt) {
 }
 
 void Interpreter::execAssign(const AssignStmt& stmt) {
+    if (parforCapture_ && parforCapture_->interceptAssign(*this, stmt)) return;
+
     auto value = evalExpr(stmt.value);
 
     if (stmt.target->is<Identifier>()) {
@@ -141,21 +261,37 @@ void Interpreter::execAssign(const AssignStmt& stmt) {
 }
 
 void Interpreter::execMultiAssign(const MultiAssignStmt& stmt) {
-    // Evaluate the RHS - should return multiple values
-    auto val = evalExpr(stmt.value);
+    int nargout = static_cast<int>(stmt.targets.size());
+    ValueList vals;
+
+    // Function calls produce one value per requested output
+    if (stmt.value->is<CallExpr>() &&
+        stmt.value->as<CallExpr>().callee->is<Identifier>()) {
+        auto& call = stmt.value->as<CallExpr>();
+        auto& name = call.callee->as<Identifier>().name;
+        auto var = lookupVariable(name);
+        if (!var || var->isFuncHandle() || isKnownFunction(name)) {
+            ValueList args;
+            for (auto& arg : call.arguments) args.push_back(evalExpr(arg));
+            vals = (var && var->isFuncHandle())
+                ? callFuncHandleMulti(var->funcHandle(), args, nargout)
+                : callFunctionMulti(name, args, nargout);
+        }
+    }
+    if (vals.empty()) vals.push_back(evalExpr(stmt.value));
 
-    // For now, single return value distributed
-    // TODO: Support proper multi-return from functions
     for (size_t i = 0; i < stmt.targets.size(); i++) {
         if (stmt.targets[i] == "~") continue; // skip ignored outputs
-        if (i == 0) {
-            currentEnv_->set(stmt.targets[i], val);
-        } else {
+        if (i < vals.size() && vals[i]) {
+            currentEnv_->set(stmt.targets[i], vals[i]);
+        } else if (i == 0) {
             currentEnv_->set(stmt.targets[i], Value::makeEmpty());
+        } else {
+            throw RuntimeError("Too many output arguments");
         }
     }
 
-    if (stmt.printResult && val && !val->isEmpty()) {
+    if (stmt.printResult && vals[0] && !vals[0]->isEmpty()) {
         for (auto& name : stmt.targets) {
             if (name == "~") continue;
             auto v = currentEnv_->get(name);
@@ -205,6 +341,10 @@ void Interpreter::execFor(const ForStmt& stmt) {
     }
 }
 
+void Interpreter::execParfor(const ParforStmt& stmt) {
+    runParfor(*this, stmt);
+}
+
 void Interpreter::execWhile(const WhileStmt& stmt) {
     while (true) {
         auto cond = evalExpr(stmt.condition);
@@ -732,10 +872,13 @@ ValuePtr Interpreter::evalFuncHandle(const FuncHandleExpr& expr) {
     fh.name = expr.name;
 
     // Check if it's a built-in
-    if (builtinFunctions_.count(expr.name)) {
-        fh.impl = builtinFunctions_[expr.name];
+    auto builtin = builtins_->functions.find(expr.name);
+    if (builtin != builtins_->functions.end()) {
+        fh.impl = builtin->second;
     } else if (userFunctions_.count(expr.name)) {
         fh.impl = userFunctions_[expr.name];
+    } else if (auto plugin = findPlugin(expr.name)) {
+        fh.impl = BuiltinFunc([plugin](const ValueList& args) { return plugin(args, 1).front(); });
     } else {
         throw RuntimeError("Undefined function '" + expr.name + "'");
     }
@@ -749,8 +892,10 @@ ValuePtr Interpreter::evalFuncHandle(const FuncHandleExpr& expr) {
 
 ValuePtr Interpreter::callFunction(const std::string& name, const ValueList& args) {
     // Check built-ins first
-    if (builtinFunctions_.count(name)) {
-        return builtinFunctions_[name](args);
+    auto builtin = builtins_->functions.find(name);
+    if (builtin != builtins_->functions.end()) {
+        ActiveScope active(this);
+        return builtin->second(args);
     }
 
     // Check user-defined functions
@@ -765,10 +910,67 @@ ValuePtr Interpreter::callFunction(const std::string& name, const ValueList& arg
         return callUserFunction(*fileFn, args);
     }
 
+    // Then a native plugin
+    if (auto plugin = findPlugin(name)) {
+        ActiveScope active(this);
+        return plugin(args, 1).front();
+    }
+
     throw RuntimeError("Undefined function '" + name + "'");
 }
 
+void Interpreter::setProfiling(bool on) {
+    if (on && !profiling_) {
+        if (!profiler_) profiler_ = std::make_unique<Profiler>();
+        if (!source_.empty()) profiler_->setScript(source_);
+    }
+    profiling_ = on;
+}
+
+void Interpreter::startSampling(double hz) {
+    if (!sampler_) sampler_ = std::make_unique<Sampler>();
+    sampler_->start(hz, source_.empty() ? "<script>" : source_);
+    sampling_ = true;
+}
+
+void Interpreter::stopSampling() {
+    if (sampler_) sampler_->stop();
+    sampling_ = false;
+}
+
+Sampler& Interpreter::sampler() {
+    if (!sampler_) sampler_ = std::make_unique<Sampler>();
+    return *sampler_;
+}
+
+Profiler& Interpreter::profiler() {
+    if (!profiler_) profiler_ = std::make_unique<Profiler>();
+    return *profiler_;
+}
+
+PluginFunction Interpreter::findPlugin(const std::string& name) {
+    auto it = plugins_.find(name);
+    if (it != plugins_.end()) return it->second;
+    PluginFunction fn = findPluginFunction(name, searchPath_);
+    if (!fn) fn = loadedPluginFunction(name);
+    if (fn) plugins_[name] = fn;
+    return fn;
+}
+
 ValuePtr Interpreter::callUserFunction(const FunctionDef& func, const ValueList& args, int nargout) {
+    return callUserFunctionMulti(func, args, nargout).front();
+}
+
+ValueList Interpreter::callUserFunctionMulti(const FunctionDef& func, const ValueList& args, int nargout) {
+    if (!profiling_ && !sampling_) return runUserFunction(func, args, nargout);
+    std::optional<Profiler::FunctionScope> timed;
+    if (profiling_) timed.emplace(*profiler_, func.name);
+    std::optional<Sampler::Scope> sampled;
+    if (sampling_) sampled.emplace(*sampler_, func.name);
+    return runUserFunction(func, args, nargout);
+}
+
+ValueList Interpreter::runUserFunction(const FunctionDef& func, const ValueList& args, int nargout) {
     // Create a new scope for the function
     auto funcEnv = globalEnv_->createChild();
     auto savedEnv = currentEnv_;
@@ -797,27 +999,27 @@ ValuePtr Interpreter::callUserFunction(const FunctionDef& func, const ValueList&
         }
     } catch (ReturnSignal&) {
         // Return was called
+    } catch (...) {
+        currentEnv_ = savedEnv;
+        throw;
     }
 
     // Collect return values
-    ValuePtr result;
-    if (func.returns.empty()) {
-        result = Value::makeEmpty();
-    } else if (func.returns.size() == 1) {
-        result = funcEnv->get(func.returns[0]);
-        if (!result) result = Value::makeEmpty();
-    } else {
-        // Multi-return: for now, return first
-        result = funcEnv->get(func.returns[0]);
-        if (!result) result = Value::makeEmpty();
+    ValueList results;
+    size_t count = std::min(func.returns.size(), static_cast<size_t>(std::max(nargout, 1)));
+    for (size_t i = 0; i < count; i++) {
+        auto v = funcEnv->get(func.returns[i]);
+        results.push_back(v ? v : Value::makeEmpty());
     }
+    if (results.empty()) results.push_back(Value::makeEmpty());
 
     currentEnv_ = savedEnv;
-    return result;
+    return results;
 }
 
 ValuePtr Interpreter::callFuncHandle(const FunctionHandle& fh, const ValueList& args) {
     if (auto* builtin = std::get_if<BuiltinFunc>(&fh.impl)) {
+        ActiveScope active(this);
         return (*builtin)(args);
     }
     if (auto* funcDef = std::get_if<std::shared_ptr<FunctionDef>>(&fh.impl)) {
@@ -826,25 +1028,96 @@ ValuePtr Interpreter::callFuncHandle(const FunctionHandle& fh, const ValueList&
     throw RuntimeError("Invalid function handle");
 }
 
+ValueList Interpreter::callFunctionMulti(const std::string& name, const ValueList& args, int nargout) {
+    auto it = builtins_->multi.find(name);
+    if (it != builtins_->multi.end()) {
+        ActiveScope active(this);
+        return it->second(args, nargout);
+    }
+    if (!builtins_->functions.count(name)) {
+        auto fn = userFunctions_.count(name) ? userFunctions_[name] : findFileFunction(name);
+        if (fn) {
+            userFunctions_[name] = fn;
+            return callUserFunctionMulti(*fn, args, nargout);
+        }
+        if (auto plugin = findPlugin(name)) {
+            ActiveScope active(this);
+            return plugin(args, nargout);
+        }
+    }
+    return {callFunction(name, args)};
+}
+
+ValueList Interpreter::callFuncHandleMulti(const FunctionHandle& fh, const ValueList& args, int nargout) {
+    if (std::holds_alternative<BuiltinFunc>(fh.impl)) {
+        auto it = builtins_->multi.find(fh.name);
+        if (it != builtins_->multi.end()) {
+            ActiveScope active(this);
+            return it->second(args, nargout);
+        }
+        return {callFuncHandle(fh, args)};
+    }
+    if (auto* funcDef = std::get_if<std::shared_ptr<FunctionDef>>(&fh.impl)) {
+        return callUserFunctionMulti(**funcDef, args, nargout);
+    }
+    throw RuntimeError("Invalid function handle");
+}
+
 // ============================================================================
 // Indexed assignment helpers
 // ============================================================================
 
-void Interpreter::assignIndexed(const CallExpr& target, ValuePtr value) {
-    if (!target.callee->is<Identifier>()) {
-        throw RuntimeError("Invalid indexed assignment target");
+namespace {
+
+// Store a scalar at A(i) or A(r, c), growing A to fit
+void storeElement(Matrix& mat, const ValueList& indices, const ValuePtr& value) {
+    if (indices.size() == 1 && indices[0]->isScalar()) {
+        size_t idx = static_cast<size_t>(indices[0]->scalarDouble()) - 1;
+        // Grow if needed
+        if (idx >= mat.numel()) {
+            Matrix newMat(1, idx + 1, 0.0);
+            for (size_t i = 0; i < mat.numel(); i++) newMat(i) = mat(i);
+            mat = newMat;
+        }
+        mat(idx) = value->scalarDouble();
+    } else if (indices.size() == 2 && indices[0]->isScalar() && indices[1]->isScalar()) {
+        size_t r = static_cast<size_t>(indices[0]->scalarDouble()) - 1;
+        size_t c = static_cast<size_t>(indices[1]->scalarDouble()) - 1;
+        // Grow if needed
+        size_t newRows = std::max(mat.rows(), r + 1);
+        size_t newCols = std::max(mat.cols(), c + 1);
+        if (newRows > mat.rows() || newCols > mat.cols()) {
+            Matrix newMat = Matrix::zeros(newRows, newCols);
+            for (size_t i = 0; i < mat.rows(); i++)
+                for (size_t j = 0; j < mat.cols(); j++)
+                    newMat(i, j) = mat(i, j);
+            mat = newMat;
+        }
+        mat(r, c) = value->scalarDouble();
     }
-    auto& name = target.callee->as<Identifier>().name;
+}
 
-    // Get or create the variable
-    auto var = currentEnv_->get(name);
+} // namespace
 
+void Interpreter::assignIndexed(const CallExpr& target, ValuePtr value) {
     // Evaluate indices
     ValueList indices;
     for (auto& arg : target.arguments) {
         indices.push_back(evalExpr(arg));
     }
 
+    if (target.callee->is<DotExpr>()) {
+        assignFieldIndexed(target.callee->as<DotExpr>(), indices, std::move(value));
+        return;
+    }
+    if (!target.callee->is<Identifier>()) {
+        throw RuntimeError("Invalid indexed assignment target");
+    }
+    auto& name = target.callee->as<Identifier>().name;
+
+    // Get or create the variable
+    auto var = currentEnv_->get(name);
+
     if (!var || var->isEmpty()) {
         // Create new matrix if doesn't exist
         if (indices.size() == 2 && indices[0]->isScalar() && indices[1]->isScalar()) {
@@ -861,34 +1134,49 @@ void Interpreter::assignIndexed(const CallExpr& target, ValuePtr value) {
 
     if (var && var->isNumeric()) {
         auto mat = var->matrix(); // copy
+        storeElement(mat, indices, value);
+        currentEnv_->set(name, Value::makeMatrix(std::move(mat)));
+    }
+}
+
+void Interpreter::assignFieldIndexed(const DotExpr& target, const ValueList& indices, ValuePtr value) {
+    if (!target.object->is<Identifier>()) {
+        throw RuntimeError("Invalid indexed assignment target");
+    }
+    auto& name = target.object->as<Identifier>().name;
+    auto obj = lookupVariable(name);
+    if (obj && !obj->isEmpty() && !obj->isStruct()) {
+        throw RuntimeError("Cannot set field on non-struct value");
+    }
+    ValuePtr field;
+    if (obj && obj->isStruct()) {
+        auto it = obj->structVal().fields.find(target.field);
+        if (it != obj->structVal().fields.end()) field = it->second;
+    }
 
+    // A writable memmapfile's Data: store into the mapped file in place
+    if (field && field->isNumeric() && field->matrix().writesThrough()) {
+        Matrix& mapped = field->matrix();
         if (indices.size() == 1 && indices[0]->isScalar()) {
-            size_t idx = static_cast<size_t>(indices[0]->scalarDouble()) - 1;
-            // Grow if needed
-            if (idx >= mat.numel()) {
-                Matrix newMat(1, idx + 1, 0.0);
-                for (size_t i = 0; i < mat.numel(); i++) newMat(i) = mat(i);
-                mat = newMat;
-            }
-            mat(idx) = value->scalarDouble();
+            double i = indices[0]->scalarDouble();
+            if (!(i >= 1 && i <= static_cast<double>(mapped.numel())))
+                throw RuntimeError("Index exceeds the mapped region");
+            mapped(static_cast<size_t>(i) - 1) = value->scalarDouble();
         } else if (indices.size() == 2 && indices[0]->isScalar() && indices[1]->isScalar()) {
-            size_t r = static_cast<size_t>(indices[0]->scalarDouble()) - 1;
-            size_t c = static_cast<size_t>(indices[1]->scalarDouble()) - 1;
-            // Grow if needed
-            size_t newRows = std::max(mat.rows(), r + 1);
-            size_t newCols = std::max(mat.cols(), c + 1);
-            if (newRows > mat.rows() || newCols > mat.cols()) {
-                Matrix newMat = Matrix::zeros(newRows, newCols);
-                for (size_t i = 0; i < mat.rows(); i++)
-                    for (size_t j = 0; j < mat.cols(); j++)
-                        newMat(i, j) = mat(i, j);
-                mat = newMat;
-            }
-            mat(r, c) = value->scalarDouble();
+            double i = indices[0]->scalarDouble(), j = indices[1]->scalarDouble();
+            if (!(i >= 1 && i <= static_cast<double>(mapped.rows()) && j >= 1 &&
+                  j <= static_cast<double>(mapped.cols())))
+                throw RuntimeError("Index exceeds the mapped region");
+            mapped(static_cast<size_t>(i) - 1, static_cast<size_t>(j) - 1) = value->scalarDouble();
+        } else {
+            throw RuntimeError("Mapped data can only be assigned one element at a time");
         }
-
-        currentEnv_->set(name, Value::makeMatrix(std::move(mat)));
+        return;
     }
+
+    Matrix mat = field && field->isNumeric() ? field->matrix() : Matrix(); // copy
+    storeElement(mat, indices, value);
+    assignDot(target, Value::makeMatrix(std::move(mat)));
 }
 
 void Interpreter::assignDot(const DotExpr& target, ValuePtr value) {
@@ -960,7 +1248,7 @@ ValuePtr Interpreter::lookupVariable(const std::string& name) {
 }
 
 bool Interpreter::isBuiltinFunction(const std::string& name) const {
-    return builtinFunctions_.count(name) > 0;
+    return builtins_->functions.count(name) > 0;
 }
 
 bool Interpreter::isUserFunction(const std::string& name) const {
@@ -968,31 +1256,196 @@ bool Interpreter::isUserFunction(const std::string& name) const {
 }
 
 bool Interpreter::isKnownFunction(const std::string& name) const {
-    return isBuiltinFunction(name) || isUserFunction(name);
+    return isBuiltinFunction(name) || isUserFunction(name) || plugins_.count(name) > 0;
 }
 
-std::shared_ptr<FunctionDef> Interpreter::findFileFunction(const std::string& name) {
-    for (auto& dir : searchPath_) {
-        std::string path = dir + "/" + name + ".m";
-        std::ifstream file(path);
-        if (file.is_open()) {
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            std::string source = buffer.str();
+ValuePtr Interpreter::makeFunctionHandle(const std::string& name) {
+    return evalFuncHandle(FuncHandleExpr{name});
+}
 
-            try {
-                Lexer lexer(source, path);
-                auto tokens = lexer.tokenize();
-                Parser parser(tokens);
-                auto program = parser.parse();
+bool Interpreter::isPureHandle(const FunctionHandle& fh) const {
+    return std::holds_alternative<BuiltinFunc>(fh.impl) &&
+           (builtinTraits(fh.name) & PURE_BUILTIN) != 0;
+}
 
-                if (!program.functions.empty()) {
-                    return program.functions[0];
-                }
-            } catch (...) {
-                // File exists but failed to parse
+bool Interpreter::isElementwiseHandle(const FunctionHandle& fh) {
+    auto* def = std::get_if<std::shared_ptr<FunctionDef>>(&fh.impl);
+    if (!def || (*def)->name != "<anonymous>" || (*def)->body.size() != 1) return false;
+    auto* assign = std::get_if<AssignStmt>(&(*def)->body[0]->node);
+    return assign && isElementwiseExpr(assign->value, (*def)->params);
+}
+
+// Anonymous bodies run in a child of the global scope, so free identifiers
+// resolve against globalEnv_.
+bool Interpreter::isElementwiseExpr(const ExprPtr& expr, const std::vector<std::string>& params) {
+    auto isParam = [&](const std::string& name) {
+        return std::find(params.begin(), params.end(), name) != params.end();
+    };
+    auto isScalarConstant = [&](const ExprPtr& e) {
+        if (auto* num = std::get_if<NumberLiteral>(&e->node)) return !num->isComplex;
+        if (auto* id = std::get_if<Identifier>(&e->node)) {
+            if (isParam(id->name)) return false;
+            auto v = globalEnv_->get(id->name);
+            return v && v->isNumeric() && v->matrix().isScalar();
+        }
+        return false;
+    };
+
+    return std::visit([&](auto& node) -> bool {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, NumberLiteral>) {
+            return !node.isComplex;
+        } else if constexpr (std::is_same_v<T, BoolLiteral>) {
+            return true;
+        } else if constexpr (std::is_same_v<T, Identifier>) {
+            if (isParam(node.name) || isScalarConstant(expr)) return true;
+            return !globalEnv_->get(node.name) && (builtinTraits(node.name) & PURE_BUILTIN);
+        } else if constexpr (std::is_same_v<T, UnaryExpr>) {
+            bool ok = node.op == TokenType::MINUS || node.op == TokenType::PLUS ||
+                      node.op == TokenType::NOT;
+            return ok && isElementwiseExpr(node.operand, params);
+        } else if constexpr (std::is_same_v<T, BinaryExpr>) {
+            switch (node.op) {
+                case TokenType::PLUS: case TokenType::MINUS:
+                case TokenType::DOT_STAR: case TokenType::DOT_SLASH: case TokenType::DOT_CARET:
+                case TokenType::EQ: case TokenType::NE: case TokenType::LT:
+                case TokenType::GT: case TokenType::LE: case TokenType::GE:
+                case TokenType::AND: case TokenType::OR:
+                    break;
+                case TokenType::STAR:
+                    // Scaling by a scalar is elementwise; a matrix product is not.
+                    if (!isScalarConstant(node.left) && !isScalarConstant(node.right)) return false;
+                    break;
+                case TokenType::SLASH:
+                    if (!isScalarConstant(node.right)) return false;
+                    break;
+                default:
+                    return false;
+            }
+            return isElementwiseExpr(node.left, params) && isElementwiseExpr(node.right, params);
+        } else if constexpr (std::is_same_v<T, CallExpr>) {
+            auto* callee = std::get_if<Identifier>(&node.callee->node);
+            if (!callee || isParam(callee->name) || globalEnv_->get(callee->name)) return false;
+            if ((builtinTraits(callee->name) & ELEMENTWISE_BUILTIN) != ELEMENTWISE_BUILTIN) return false;
+            for (auto& arg : node.arguments) {
+                if (!isElementwiseExpr(arg, params)) return false;
             }
+            return true;
+        } else {
+            return false;
+        }
+    }, expr->node);
+}
+
+// ============================================================================
+// HandleCaller
+// ============================================================================
+
+HandleCaller::HandleCaller(Interpreter& interp, const FunctionHandle& fh, int nargout)
+    : interp_(interp), fh_(fh), nargout_(nargout) {
+    if (std::holds_alternative<BuiltinFunc>(fh.impl)) {
+        if (nargout > 1) {
+            auto it = interp.builtins_->multi.find(fh.name);
+            if (it != interp.builtins_->multi.end()) multi_ = it->second;
+        }
+    } else if (auto* def = std::get_if<std::shared_ptr<FunctionDef>>(&fh.impl)) {
+        const FunctionDef& fn = **def;
+        auto* assign = (fn.name == "<anonymous>" && fn.body.size() == 1)
+                           ? std::get_if<AssignStmt>(&fn.body[0]->node) : nullptr;
+        if (assign && nargout <= 1) {
+            anon_ = &fn;
+            anonBody_ = assign->value;
+            scope_ = interp.globalEnv_->createChild();
+        }
+    }
+}
+
+ValueList HandleCaller::operator()(const ValueList& args) {
+    if (auto* builtin = std::get_if<BuiltinFunc>(&fh_.impl)) {
+        ActiveScope active(&interp_);
+        if (multi_) return multi_(args, nargout_);
+        return {(*builtin)(args)};
+    }
+    if (anon_ && args.size() == anon_->params.size()) {
+        for (size_t i = 0; i < args.size(); i++) scope_->set(anon_->params[i], args[i]);
+        auto savedEnv = interp_.currentEnv_;
+        interp_.currentEnv_ = scope_;
+        ValuePtr result;
+        try {
+            result = interp_.evalExpr(anonBody_);
+        } catch (...) {
+            interp_.currentEnv_ = savedEnv;
+            throw;
+        }
+        interp_.currentEnv_ = savedEnv;
+        return {result};
+    }
+    return interp_.callFuncHandleMulti(fh_, args, nargout_);
+}
+
+namespace {
+
+/// Functions parsed from .m files, shared by every interpreter in the
+/// process. Entries are keyed by path and reparsed when the file's
+/// modification time changes; parsed functions are never modified, so
+/// interpreters on any thread can run them concurrently.
+class FileFunctionCache {
+public:
+    static FileFunctionCache& instance() {
+        static FileFunctionCache cache;
+        return cache;
+    }
+
+    /// The function defined by `path`; nullptr when the file does not exist
+    /// or defines no function (a file that fails to parse counts as none).
+    std::shared_ptr<FunctionDef> lookup(const std::string& path) {
+        std::error_code ec;
+        auto mtime = std::filesystem::last_write_time(path, ec);
+        if (ec) return nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(path);
+            if (it != entries_.end() && it->second.mtime == mtime) return it->second.fn;
+        }
+        // Parse outside the lock; if two threads race, both results are equivalent
+        auto fn = parse(path);
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[path] = {mtime, fn};
+        return fn;
+    }
+
+private:
+    struct Entry {
+        std::filesystem::file_time_type mtime;
+        std::shared_ptr<FunctionDef> fn;
+    };
+
+    static std::shared_ptr<FunctionDef> parse(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) return nullptr;
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        try {
+            Lexer lexer(buffer.str(), path);
+            auto tokens = lexer.tokenize();
+            Parser parser(tokens);
+            auto program = parser.parse();
+            if (!program.functions.empty()) return program.functions[0];
+        } catch (...) {
+            // File exists but failed to parse
         }
+        return nullptr;
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+} // namespace
+
+std::shared_ptr<FunctionDef> Interpreter::findFileFunction(const std::string& name) {
+    for (auto& dir : searchPath_) {
+        if (auto fn = FileFunctionCache::instance().lookup(dir + "/" + name + ".m")) return fn;
     }
     return nullptr;
 }
@@ -5,12 +5,19 @@
 #include "ast.h"
 #include "value.h"
 #include "environment.h"
+#include "datastore.h"
+#include "file_io.h"
+#include "plugin.h"
+#include "ffi.h"
+#include "profiler.h"
+#include "sampler.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <functional>
 #include <iostream>
 #include <filesystem>
+#include <chrono>
 
 namespace matfree {
 
@@ -21,6 +28,44 @@ struct ReturnSignal {
     ValueList values;
 };
 
+class ParforCapture;
+
+/// Properties of a built-in that batched callers (cellfun/arrayfun) rely on.
+enum BuiltinTrait : unsigned {
+    PURE_BUILTIN = 1,        // no side effects or interpreter state: callable from any thread
+    ELEMENTWISE_BUILTIN = 3, // pure, and each output element depends only on the same input element
+};
+
+/// Built-in functions and their traits. Built-ins reach their session
+/// through Interpreter::current() rather than capturing an interpreter, so
+/// one table can be shared by any number of interpreters. A published table
+/// is never modified: registering on an interpreter that shares its table
+/// copies the table first.
+struct BuiltinTable {
+    std::unordered_map<std::string, BuiltinFunc> functions;
+    std::unordered_map<std::string, BuiltinMultiFunc> multi;
+    std::unordered_map<std::string, unsigned> traits;
+};
+
+/// Mutable state that built-ins keep per session (tic/toc, random numbers,
+/// open datastores, files and C libraries).
+/// Each interpreter owns its own, so interpreters on different threads
+/// never share any.
+struct SessionState {
+    std::chrono::steady_clock::time_point ticTime = std::chrono::steady_clock::now();
+    RandomStream rng;           // seed 0 at startup, like MATLAB; see rng()
+    uint64_t substreamsUsed = 0; // substreams of rng handed out (parfor iterations)
+    // Datastores by the Handle field of their struct values. They stay
+    // open (whatever happens to the struct: copies, save/load) until
+    // clear all; parfor workers share their client's.
+    std::unordered_map<uint64_t, std::shared_ptr<Datastore>> datastores;
+    // Files opened with fopen, by file identifier (0-2 are the standard streams)
+    std::unordered_map<int, std::shared_ptr<FileHandle>> files;
+    int nextFile = 3;
+    // C libraries loaded with loadlibrary, by name
+    std::unordered_map<std::string, std::shared_ptr<ForeignLibrary>> libraries;
+};
+
 class Interpreter {
 public:
     Interpreter();
@@ -46,13 +91,73 @@ public:
     /// Get/set output stream (for display/disp/fprintf).
     std::ostream& output() { return *output_; }
     void setOutput(std::ostream& os) { output_ = &os; }
+    /// Output is written without flushing; it is flushed at the end of each
+    /// top-level statement (and before reading input), so long printing
+    /// loops stay buffered while every statement's output still appears
+    /// before the next one starts.
+    void flushOutput() { output_->flush(); }
 
     /// Register a built-in function.
     void registerBuiltin(const std::string& name, BuiltinFunc func);
 
+    /// Register a built-in function with multiple outputs ([a, b] = f(x)).
+    /// It is also callable as a single-output built-in (nargout = 1).
+    void registerMultiBuiltin(const std::string& name, BuiltinMultiFunc func);
+
+    /// This interpreter's built-in table, shared from now on: later
+    /// registrations on this interpreter copy it first.
+    std::shared_ptr<const BuiltinTable> builtinTable();
+
+    /// Use a shared built-in table. An interpreter with no built-ins of its
+    /// own adopts the table as is; otherwise its table is copied and the
+    /// entries of `table` override same-named ones.
+    void useBuiltins(const std::shared_ptr<const BuiltinTable>& table);
+
+    /// The interpreter whose built-in is running on the calling thread.
+    /// Throws RuntimeError when no built-in call is in progress.
+    static Interpreter& current();
+
+    /// Per-session state used by built-ins.
+    SessionState& session() { return session_; }
+
+    /// Profiling (see profile()): while on, every statement and user
+    /// function call is timed. Turning it on keeps what was recorded.
+    void setProfiling(bool on);
+    bool profiling() const { return profiling_; }
+    Profiler& profiler();
+
+    /// Sampling (see profile('sample')): the call stack and current line
+    /// are sampled `hz` times per second of CPU time.
+    void startSampling(double hz);
+    void stopSampling();
+    bool sampling() const { return sampling_; }
+    Sampler& sampler();
+
+    /// Declare traits (BuiltinTrait flags) for a registered built-in.
+    /// Re-registering the built-in clears them.
+    void setBuiltinTraits(const std::string& name, unsigned traits);
+    unsigned builtinTraits(const std::string& name) const;
+
+    /// Function handle for a named function, as @name would create it.
+    ValuePtr makeFunctionHandle(const std::string& name);
+
+    /// True when `fh` is a built-in handle declared pure.
+    bool isPureHandle(const FunctionHandle& fh) const;
+
+    /// True when `fh` is an anonymous function whose body only combines its
+    /// parameters, numeric constants and scalar workspace variables through
+    /// elementwise operators and elementwise built-ins. Calling it once on
+    /// whole arrays then gives the same result as calling it per element.
+    bool isElementwiseHandle(const FunctionHandle& fh);
+
     /// Add a directory to the search path.
     void addPath(const std::string& path);
 
+    /// Forget the plugin functions this interpreter has bound (`clear mex`):
+    /// the next call finds them again, loading a fresh copy of any plugin
+    /// whose file has changed.
+    void clearPlugins() { plugins_.clear(); }
+
     /// Get the current environment
     Environment::Ptr currentEnv() const { return currentEnv_; }
 
@@ -61,6 +166,11 @@ public:
     ValuePtr callUserFunction(const FunctionDef& func, const ValueList& args, int nargout = 1);
     ValuePtr callFuncHandle(const FunctionHandle& fh, const ValueList& args);
 
+    // Multi-output variants: return up to nargout values (at least one)
+    ValueList callFunctionMulti(const std::string& name, const ValueList& args, int nargout);
+    ValueList callUserFunctionMulti(const FunctionDef& func, const ValueList& args, int nargout);
+    ValueList callFuncHandleMulti(const FunctionHandle& fh, const ValueList& args, int nargout);
+
 private:
     Environment::Ptr globalEnv_;
     Environment::Ptr currentEnv_;
@@ -69,7 +179,30 @@ private:
 
     // Function registry: user-defined and built-in
     std::unordered_map<std::string, std::shared_ptr<FunctionDef>> userFunctions_;
-    std::unordered_map<std::string, BuiltinFunc> builtinFunctions_;
+    std::shared_ptr<BuiltinTable> builtins_;
+    std::unordered_map<std::string, PluginFunction> plugins_; // bound on first call
+    PluginFunction findPlugin(const std::string& name);
+    bool builtinsShared_ = false; // builtins_ is published and must not change
+    BuiltinTable& mutableBuiltins();
+
+    SessionState session_;
+
+    ValueList runUserFunction(const FunctionDef& func, const ValueList& args, int nargout);
+    void dispatchStmt(const StmtPtr& stmt);
+    std::string source_; // of the statements executeString runs
+    std::unique_ptr<Profiler> profiler_;
+    bool profiling_ = false;
+    std::unique_ptr<Sampler> sampler_;
+    bool sampling_ = false;
+
+    // parfor: cached worker interpreters, and the capture installed on a
+    // worker while it runs iterations
+    std::vector<std::unique_ptr<Interpreter>> parforWorkers_;
+    ParforCapture* parforCapture_ = nullptr;
+
+    friend class HandleCaller;
+    friend class ParforCapture;
+    friend void runParfor(Interpreter& client, const ParforStmt& stmt);
 
     // Statement execution
     void execExprStmt(const ExprStmt& stmt);
@@ -77,6 +210,7 @@ private:
     void execMultiAssign(const MultiAssignStmt& stmt);
     void execIf(const IfStmt& stmt);
     void execFor(const ForStmt& stmt);
+    void execParfor(const ParforStmt& stmt);
     void execWhile(const WhileStmt& stmt);
     void execSwitch(const SwitchStmt& stmt);
     void execTryCatch(const TryCatchStmt& stmt);
@@ -103,6 +237,7 @@ private:
     // Indexed assignment helpers
     void assignIndexed(const CallExpr& target, ValuePtr value);
     void assignDot(const DotExpr& target, ValuePtr value);
+    void assignFieldIndexed(const DotExpr& target, const ValueList& indices, ValuePtr value);
     void assignCellIndex(const CellIndexExpr& target, ValuePtr value);
 
     // Utility
@@ -110,10 +245,32 @@ private:
     bool isBuiltinFunction(const std::string& name) const;
     bool isUserFunction(const std::string& name) const;
     bool isKnownFunction(const std::string& name) const;
+    bool isElementwiseExpr(const ExprPtr& expr, const std::vector<std::string>& params);
     std::shared_ptr<FunctionDef> findFileFunction(const std::string& name);
 
     // Colon range generation
     Matrix generateRange(double start, double step, double stop);
 };
 
+/// Calls one function handle many times (cellfun/arrayfun). Built-ins are
+/// resolved once; anonymous functions evaluate their body expression in a
+/// single reused scope instead of creating an Environment per call. Calls on
+/// a pure built-in handle may be made concurrently from several threads.
+class HandleCaller {
+public:
+    HandleCaller(Interpreter& interp, const FunctionHandle& fh, int nargout);
+
+    /// Call with `args`, returning up to nargout values (at least one).
+    ValueList operator()(const ValueList& args);
+
+private:
+    Interpreter& interp_;
+    const FunctionHandle& fh_;
+    int nargout_;
+    BuiltinMultiFunc multi_;                   // built-in with multiple outputs
+    const FunctionDef* anon_ = nullptr;        // anonymous function (single expression)
+    ExprPtr anonBody_;
+    Environment::Ptr scope_;                   // reused scope for anon_
+};
+
 } // namespace matfree
@@ -8,32 +8,38 @@
 
 namespace matfree {
 
-std::unordered_map<std::string, TokenType> Lexer::keywords_ = {
-    {"if",          TokenType::IF},
-    {"elseif",      TokenType::ELSEIF},
-    {"else",        TokenType::ELSE},
-    {"end",         TokenType::END},
-    {"for",         TokenType::FOR},
-    {"while",       TokenType::WHILE},
-    {"switch",      TokenType::SWITCH},
-    {"case",        TokenType::CASE},
-    {"otherwise",   TokenType::OTHERWISE},
-    {"try",         TokenType::TRY},
-    {"catch",       TokenType::CATCH},
-    {"function",    TokenType::FUNCTION},
-    {"return",      TokenType::RETURN},
-    {"break",       TokenType::BREAK},
-    {"continue",    TokenType::CONTINUE},
-    {"global",      TokenType::GLOBAL},
-    {"persistent",  TokenType::PERSISTENT},
-    {"classdef",    TokenType::CLASSDEF},
-    {"properties",  TokenType::PROPERTIES},
-    {"methods",     TokenType::METHODS},
-    {"events",      TokenType::EVENTS},
-    {"enumeration", TokenType::ENUMERATION},
-    {"true",        TokenType::TRUE_KW},
-    {"false",       TokenType::FALSE_KW},
-};
+// Function-local static so the table is initialized on first use, even when
+// lexing happens during another translation unit's static initialization.
+const std::unordered_map<std::string, TokenType>& Lexer::keywords() {
+    static const std::unordered_map<std::string, TokenType> table = {
+        {"if",          TokenType::IF},
+        {"elseif",      TokenType::ELSEIF},
+        {"else",        TokenType::ELSE},
+        {"end",         TokenType::END},
+        {"for",         TokenType::FOR},
+        {"parfor",      TokenType::PARFOR},
+        {"while",       TokenType::WHILE},
+        {"switch",      TokenType::SWITCH},
+        {"case",        TokenType::CASE},
+        {"otherwise",   TokenType::OTHERWISE},
+        {"try",         TokenType::TRY},
+        {"catch",       TokenType::CATCH},
+        {"function",    TokenType::FUNCTION},
+        {"return",      TokenType::RETURN},
+        {"break",       TokenType::BREAK},
+        {"continue",    TokenType::CONTINUE},
+        {"global",      TokenType::GLOBAL},
+        {"persistent",  TokenType::PERSISTENT},
+        {"classdef",    TokenType::CLASSDEF},
+        {"properties",  TokenType::PROPERTIES},
+        {"methods",     TokenType::METHODS},
+        {"events",      TokenType::EVENTS},
+        {"enumeration", TokenType::ENUMERATION},
+        {"true",        TokenType::TRUE_KW},
+        {"false",       TokenType::FALSE_KW},
+    };
+    return table;
+}
 
 Lexer::Lexer(const std::string& source, const std::string& filename)
     : source_(source), filename_(filename)
@@ -375,8 +381,9 @@ Token Lexer::scanIdentifierOrKeyword() {
     }
 
     // Check if it's a keyword
-    auto it = keywords_.find(ident);
-    TokenType type = (it != keywords_.end()) ? it->second : TokenType::IDENTIFIER;
+    auto& kw = keywords();
+    auto it = kw.find(ident);
+    TokenType type = (it != kw.end()) ? it->second : TokenType::IDENTIFIER;
 
     Token tok(type, ident, line_, startCol);
     lastToken_ = tok;
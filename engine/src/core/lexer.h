@@ -40,7 +40,7 @@ private:
     bool hasPeeked_ = false;
     Token peekedToken_;
 
-    static std::unordered_map<std::string, TokenType> keywords_;
+    static const std::unordered_map<std::string, TokenType>& keywords();
 
     char current() const;
     char peek(int offset = 1) const;
@@ -0,0 +1,117 @@
+// MatFree - Memory-mapped files
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "mapped_file.h"
+#include "value.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace matfree {
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, MapMode mode, uint64_t offset,
+                                             size_t length) {
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    file->mode_ = mode;
+    bool writable = mode != MapMode::READ_ONLY;
+    auto regionSize = [&](uint64_t fileSize) {
+        if (offset > fileSize) throw RuntimeError("Offset is past the end of file '" + path + "'");
+        if (length == SIZE_MAX) return static_cast<size_t>(fileSize - offset);
+        if (length > fileSize - offset) throw RuntimeError("File '" + path + "' is too short for the mapped region");
+        return length;
+    };
+#ifdef _WIN32
+    bool shared = mode == MapMode::SHARED;
+    HANDLE h = CreateFileA(path.c_str(), shared ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) throw RuntimeError("Unable to open file '" + path + "'");
+    file->file_ = h;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(h, &fileSize)) throw RuntimeError("Unable to read the size of '" + path + "'");
+    file->size_ = regionSize(static_cast<uint64_t>(fileSize.QuadPart));
+    if (file->size_ == 0) return file;
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    uint64_t start = offset - offset % info.dwAllocationGranularity;
+    file->mapped_ = static_cast<size_t>(offset - start) + file->size_;
+    DWORD protect = shared ? PAGE_READWRITE : writable ? PAGE_WRITECOPY : PAGE_READONLY;
+    HANDLE m = CreateFileMappingA(h, nullptr, protect, 0, 0, nullptr);
+    if (!m) throw RuntimeError("Unable to map file '" + path + "'");
+    file->mapping_ = m;
+    DWORD access = shared ? FILE_MAP_WRITE : writable ? FILE_MAP_COPY : FILE_MAP_READ;
+    file->base_ = static_cast<char*>(MapViewOfFile(m, access, static_cast<DWORD>(start >> 32),
+                                                   static_cast<DWORD>(start), file->mapped_));
+    if (!file->base_) throw RuntimeError("Unable to map file '" + path + "'");
+    file->data_ = file->base_ + (offset - start);
+#else
+    int fd = ::open(path.c_str(), mode == MapMode::SHARED ? O_RDWR : O_RDONLY);
+    if (fd < 0) throw RuntimeError("Unable to open file '" + path + "'");
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw RuntimeError("Unable to read the size of '" + path + "'");
+    }
+    try {
+        file->size_ = regionSize(static_cast<uint64_t>(st.st_size));
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    if (file->size_ > 0) {
+        uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        uint64_t start = offset - offset % page;
+        file->mapped_ = static_cast<size_t>(offset - start) + file->size_;
+        int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        int flags = mode == MapMode::SHARED ? MAP_SHARED : MAP_PRIVATE;
+        void* p = mmap(nullptr, file->mapped_, prot, flags, fd, static_cast<off_t>(start));
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw RuntimeError("Unable to map file '" + path + "'");
+        }
+        file->base_ = static_cast<char*>(p);
+        file->data_ = file->base_ + (offset - start);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+#endif
+    return file;
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    if (base_) UnmapViewOfFile(base_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+#else
+    if (base_) munmap(base_, mapped_);
+#endif
+}
+
+void MappedFile::advise(MapAccess access) const {
+#ifdef _WIN32
+    if (access == MapAccess::WILL_NEED && base_) {
+        WIN32_MEMORY_RANGE_ENTRY range{base_, mapped_};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    if (!base_) return;
+    int advice = MADV_NORMAL;
+    switch (access) {
+        case MapAccess::NORMAL: advice = MADV_NORMAL; break;
+        case MapAccess::SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+        case MapAccess::RANDOM: advice = MADV_RANDOM; break;
+        case MapAccess::WILL_NEED: advice = MADV_WILLNEED; break;
+    }
+    madvise(base_, mapped_, advice);
+#endif
+}
+
+} // namespace matfree
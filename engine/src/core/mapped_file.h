@@ -0,0 +1,61 @@
+#pragma once
+// MatFree - Memory-mapped files
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace matfree {
+
+/// How a mapping may be written.
+enum class MapMode {
+    READ_ONLY, // writing faults
+    PRIVATE,   // writable; written pages become private copies, the file is unchanged
+    SHARED,    // writable; writes go through to the file
+};
+
+/// Access pattern hints (madvise) for the kernel's readahead.
+enum class MapAccess { NORMAL, SEQUENTIAL, RANDOM, WILL_NEED };
+
+/// A region of a file mapped into memory. Pages are read from disk only
+/// when first touched, so opening a large file is cheap. Shared ownership
+/// keeps the mapping alive for as long as anything still uses it (e.g. a
+/// Matrix viewing it).
+class MappedFile {
+public:
+    /// Map `length` bytes of `path` starting at `offset` (any offset; the
+    /// mapping itself starts on a page boundary). length = SIZE_MAX maps
+    /// to the end of the file. Throws RuntimeError if the file cannot be
+    /// opened or mapped, or is shorter than the region.
+    static std::shared_ptr<MappedFile> open(const std::string& path, MapMode mode = MapMode::READ_ONLY,
+                                            uint64_t offset = 0, size_t length = SIZE_MAX);
+
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// Start of the requested region (not writable in READ_ONLY mode).
+    char* data() const { return data_; }
+    size_t size() const { return size_; }
+    MapMode mode() const { return mode_; }
+
+    /// Hint how the region will be accessed. Advisory; errors are ignored.
+    void advise(MapAccess access) const;
+
+private:
+    MappedFile() = default;
+
+    char* base_ = nullptr; // page-aligned start of the mapping
+    size_t mapped_ = 0;    // bytes mapped from base_
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    MapMode mode_ = MapMode::READ_ONLY;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+} // namespace matfree
@@ -0,0 +1,49 @@
+// MatFree - memmapfile: file regions as matrices
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "memmap.h"
+#include <filesystem>
+
+namespace matfree {
+
+Matrix memmapMatrix(const MemmapSpec& spec) {
+    size_t elemSize = numericClassSize(spec.format);
+    bool direct = spec.format == NumericClass::DOUBLE && spec.offset % alignof(double) == 0;
+    if (spec.writable && !direct)
+        throw RuntimeError("memmapfile: Writable requires the 'double' format at an 8-byte aligned offset");
+
+    std::error_code ec;
+    uint64_t fileSize = std::filesystem::file_size(spec.path, ec);
+    if (ec) throw RuntimeError("memmapfile: unable to open file '" + spec.path + "'");
+    if (spec.offset > fileSize) throw RuntimeError("memmapfile: Offset is past the end of the file");
+
+    size_t rows, cols;
+    if (spec.hasShape) {
+        if (spec.repeat != SIZE_MAX && spec.repeat != 1)
+            throw RuntimeError("memmapfile: Repeat must be 1 when Format gives a size");
+        rows = spec.rows;
+        cols = spec.cols;
+    } else {
+        size_t fit = static_cast<size_t>((fileSize - spec.offset) / elemSize);
+        rows = spec.repeat == SIZE_MAX ? fit : spec.repeat;
+        cols = 1;
+    }
+    size_t n = rows * cols;
+    if (static_cast<uint64_t>(n) * elemSize > fileSize - spec.offset)
+        throw RuntimeError("memmapfile: the file is too short for the requested format");
+    if (n == 0) return Matrix(rows, cols);
+
+    MapMode mode = !direct ? MapMode::READ_ONLY : spec.writable ? MapMode::SHARED : MapMode::PRIVATE;
+    auto file = MappedFile::open(spec.path, mode, spec.offset, n * elemSize);
+    if (direct) {
+        file->advise(spec.access);
+        return Matrix::external(rows, cols, reinterpret_cast<double*>(file->data()), file, spec.writable);
+    }
+    // Converted once, front to back
+    file->advise(MapAccess::SEQUENTIAL);
+    Matrix m(rows, cols);
+    convertToDouble(file->data(), spec.format, n, m.begin());
+    return m;
+}
+
+} // namespace matfree
@@ -0,0 +1,37 @@
+#pragma once
+// MatFree - memmapfile: file regions as matrices
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "value.h"
+#include "mapped_file.h"
+#include "numeric_types.h"
+#include <cstdint>
+#include <string>
+
+namespace matfree {
+
+/// A file region described the way memmapfile's options describe it.
+struct MemmapSpec {
+    std::string path;
+    NumericClass format = NumericClass::UINT8; // MATLAB's default Format
+    bool hasShape = false;                     // Format gave [rows cols]
+    size_t rows = 0, cols = 0;
+    uint64_t offset = 0;                       // bytes from the start of the file
+    size_t repeat = SIZE_MAX;                  // elements (or 1 shaped record); SIZE_MAX = all that fit
+    bool writable = false;
+    MapAccess access = MapAccess::NORMAL;
+};
+
+/// The region as a matrix: rows x cols with a shape, otherwise a column of
+/// `repeat` elements. Elements are taken in MatFree's linear index order.
+///
+/// 'double' data at an 8-byte aligned offset is not copied: the matrix is a
+/// view of the mapping (Matrix::external), so indexing and the existing
+/// kernels read the file page by page as they go. When writable, the
+/// mapping is shared and `m.Data(i) = v` stores into the file; copies of
+/// the matrix (`y = m.Data`, function arguments) are ordinary matrices and
+/// never write back. Other classes (and unaligned doubles) are converted
+/// into an in-memory matrix.
+Matrix memmapMatrix(const MemmapSpec& spec);
+
+} // namespace matfree
@@ -0,0 +1,143 @@
+// MatFree - Numeric storage classes of binary data
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "numeric_types.h"
+#include "parallel.h"
+#include "value.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace matfree {
+
+namespace {
+
+// Elements per chunk of a parallel conversion.
+constexpr size_t kConvertGrain = size_t(1) << 16;
+
+template <class T>
+void convertRange(const char* src, size_t n, double* out) {
+    parallelFor(n, kConvertGrain, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+            T v;
+            std::memcpy(&v, src + i * sizeof(T), sizeof(T));
+            out[i] = static_cast<double>(v);
+        }
+    });
+}
+
+template <class T>
+T castFromDouble(double v) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return static_cast<T>(v);
+    } else {
+        if (std::isnan(v)) return 0;
+        double r = std::round(v);
+        if (r <= static_cast<double>(std::numeric_limits<T>::min())) return std::numeric_limits<T>::min();
+        if (r >= static_cast<double>(std::numeric_limits<T>::max())) return std::numeric_limits<T>::max();
+        return static_cast<T>(r);
+    }
+}
+
+template <class T>
+void convertRangeFrom(const double* src, size_t n, char* out) {
+    parallelFor(n, kConvertGrain, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+            T v = castFromDouble<T>(src[i]);
+            std::memcpy(out + i * sizeof(T), &v, sizeof(T));
+        }
+    });
+}
+
+} // namespace
+
+NumericClass parseNumericClass(const std::string& name) {
+    if (name == "double" || name == "float64") return NumericClass::DOUBLE;
+    if (name == "single" || name == "float32" || name == "float") return NumericClass::SINGLE;
+    if (name == "int8" || name == "schar") return NumericClass::INT8;
+    if (name == "uint8" || name == "uchar" || name == "char") return NumericClass::UINT8;
+    if (name == "int16") return NumericClass::INT16;
+    if (name == "uint16") return NumericClass::UINT16;
+    if (name == "int32") return NumericClass::INT32;
+    if (name == "uint32") return NumericClass::UINT32;
+    if (name == "int64") return NumericClass::INT64;
+    if (name == "uint64") return NumericClass::UINT64;
+    throw RuntimeError("Unknown numeric class '" + name + "'");
+}
+
+std::string numericClassName(NumericClass cls) {
+    switch (cls) {
+        case NumericClass::DOUBLE: return "double";
+        case NumericClass::SINGLE: return "single";
+        case NumericClass::INT8: return "int8";
+        case NumericClass::UINT8: return "uint8";
+        case NumericClass::INT16: return "int16";
+        case NumericClass::UINT16: return "uint16";
+        case NumericClass::INT32: return "int32";
+        case NumericClass::UINT32: return "uint32";
+        case NumericClass::INT64: return "int64";
+        case NumericClass::UINT64: return "uint64";
+    }
+    return "double";
+}
+
+size_t numericClassSize(NumericClass cls) {
+    switch (cls) {
+        case NumericClass::DOUBLE: return 8;
+        case NumericClass::SINGLE: return 4;
+        case NumericClass::INT8: return 1;
+        case NumericClass::UINT8: return 1;
+        case NumericClass::INT16: return 2;
+        case NumericClass::UINT16: return 2;
+        case NumericClass::INT32: return 4;
+        case NumericClass::UINT32: return 4;
+        case NumericClass::INT64: return 8;
+        case NumericClass::UINT64: return 8;
+    }
+    return 8;
+}
+
+void convertToDouble(const void* src, NumericClass cls, size_t n, double* out) {
+    const char* p = static_cast<const char*>(src);
+    switch (cls) {
+        case NumericClass::DOUBLE: convertRange<double>(p, n, out); break;
+        case NumericClass::SINGLE: convertRange<float>(p, n, out); break;
+        case NumericClass::INT8: convertRange<int8_t>(p, n, out); break;
+        case NumericClass::UINT8: convertRange<uint8_t>(p, n, out); break;
+        case NumericClass::INT16: convertRange<int16_t>(p, n, out); break;
+        case NumericClass::UINT16: convertRange<uint16_t>(p, n, out); break;
+        case NumericClass::INT32: convertRange<int32_t>(p, n, out); break;
+        case NumericClass::UINT32: convertRange<uint32_t>(p, n, out); break;
+        case NumericClass::INT64: convertRange<int64_t>(p, n, out); break;
+        case NumericClass::UINT64: convertRange<uint64_t>(p, n, out); break;
+    }
+}
+
+void convertFromDouble(const double* src, NumericClass cls, size_t n, void* out) {
+    char* p = static_cast<char*>(out);
+    switch (cls) {
+        case NumericClass::DOUBLE: convertRangeFrom<double>(src, n, p); break;
+        case NumericClass::SINGLE: convertRangeFrom<float>(src, n, p); break;
+        case NumericClass::INT8: convertRangeFrom<int8_t>(src, n, p); break;
+        case NumericClass::UINT8: convertRangeFrom<uint8_t>(src, n, p); break;
+        case NumericClass::INT16: convertRangeFrom<int16_t>(src, n, p); break;
+        case NumericClass::UINT16: convertRangeFrom<uint16_t>(src, n, p); break;
+        case NumericClass::INT32: convertRangeFrom<int32_t>(src, n, p); break;
+        case NumericClass::UINT32: convertRangeFrom<uint32_t>(src, n, p); break;
+        case NumericClass::INT64: convertRangeFrom<int64_t>(src, n, p); break;
+        case NumericClass::UINT64: convertRangeFrom<uint64_t>(src, n, p); break;
+    }
+}
+
+void byteSwap(void* data, size_t elemSize, size_t n) {
+    if (elemSize <= 1) return;
+    char* p = static_cast<char*>(data);
+    parallelFor(n, kConvertGrain, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) std::reverse(p + i * elemSize, p + (i + 1) * elemSize);
+    });
+}
+
+} // namespace matfree
@@ -0,0 +1,36 @@
+#pragma once
+// MatFree - Numeric storage classes of binary data (uint8, int16, single, ...)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include <cstddef>
+#include <string>
+
+namespace matfree {
+
+/// Element type of raw binary data. MatFree values are always double; other
+/// classes only describe data in files, which is converted when read.
+enum class NumericClass { DOUBLE, SINGLE, INT8, UINT8, INT16, UINT16, INT32, UINT32, INT64, UINT64 };
+
+/// Parse a MATLAB class name ("uint16", "double", ...). Also accepts the
+/// aliases "float32", "float64", "float", "char" (uint8) and "uchar".
+/// Throws RuntimeError for unknown names.
+NumericClass parseNumericClass(const std::string& name);
+
+std::string numericClassName(NumericClass cls);
+
+/// Bytes per element.
+size_t numericClassSize(NumericClass cls);
+
+/// Convert `n` elements of class `cls` starting at `src` (any alignment) to
+/// double. Long inputs are converted in parallel.
+void convertToDouble(const void* src, NumericClass cls, size_t n, double* out);
+
+/// Convert `n` doubles to class `cls` at `out` (any alignment), the way
+/// MATLAB casts: integers are rounded half away from zero and saturated,
+/// NaN becomes 0. Long inputs are converted in parallel.
+void convertFromDouble(const double* src, NumericClass cls, size_t n, void* out);
+
+/// Reverse the byte order of `n` elements of `elemSize` bytes in place.
+void byteSwap(void* data, size_t elemSize, size_t n);
+
+} // namespace matfree
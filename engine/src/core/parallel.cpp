@@ -0,0 +1,186 @@
+// MatFree - Shared worker pool implementation
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace matfree {
+
+namespace {
+
+// Upper bound on chunks per parallel call, so per-chunk partial results stay small.
+constexpr size_t kMaxChunks = 1024;
+
+thread_local bool tlsInWorker = false;
+
+std::atomic<size_t> overrideThreads{0};
+
+size_t defaultThreadCount() {
+    if (const char* env = std::getenv("MATFREE_NUM_THREADS")) {
+        long n = std::strtol(env, nullptr, 10);
+        if (n > 0) return static_cast<size_t>(n);
+    }
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+/// Long-lived worker threads fed from a single task queue. Each parallel call
+/// enqueues "helper" tasks that pull chunk numbers from a shared counter, so
+/// load balancing is dynamic while chunk boundaries stay deterministic.
+class WorkerPool {
+public:
+    static WorkerPool& instance() {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    void run(size_t nchunks, size_t helpers, const std::function<void(size_t)>& body) {
+        // Shared so that helpers which only get scheduled after the caller has
+        // returned still find valid (exhausted) state and exit immediately.
+        struct Job {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> remaining{0};
+            const std::function<void(size_t)>* body = nullptr;
+            size_t nchunks = 0;
+            std::mutex mutex;
+            std::condition_variable done;
+            std::exception_ptr error;
+
+            void drain() {
+                size_t c;
+                while ((c = next.fetch_add(1)) < nchunks) {
+                    try {
+                        (*body)(c);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!error) error = std::current_exception();
+                    }
+                    if (remaining.fetch_sub(1) == 1) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        done.notify_all();
+                    }
+                }
+            }
+        };
+        auto job = std::make_shared<Job>();
+        job->body = &body;
+        job->nchunks = nchunks;
+        job->remaining = nchunks;
+
+        ensureThreads(helpers);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < helpers; i++) tasks_.push_back([job] { job->drain(); });
+        }
+        cv_.notify_all();
+
+        // The caller works too, then waits for chunks still held by helpers.
+        job->drain();
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->done.wait(lock, [&job] { return job->remaining.load() == 0; });
+        if (job->error) std::rethrow_exception(job->error);
+    }
+
+private:
+    WorkerPool() = default;
+
+    void ensureThreads(size_t n) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (threads_.size() < n) {
+            threads_.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    void workerLoop() {
+        tlsInWorker = true;
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (stopping_ && tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> threads_;
+    bool stopping_ = false;
+};
+
+} // namespace
+
+size_t parallelThreadCount() {
+    size_t n = overrideThreads.load();
+    if (n > 0) return n;
+    static const size_t def = defaultThreadCount();
+    return def;
+}
+
+void setParallelThreadCount(size_t n) {
+    overrideThreads.store(n);
+}
+
+bool inParallelRegion() {
+    return tlsInWorker;
+}
+
+size_t parallelChunkCount(size_t n, size_t grain) {
+    if (n == 0) return 0;
+    if (grain == 0) grain = 1;
+    return std::min((n + grain - 1) / grain, kMaxChunks);
+}
+
+void parallelForChunks(size_t n, size_t grain,
+                       const std::function<void(size_t, size_t, size_t)>& fn) {
+    size_t nchunks = parallelChunkCount(n, grain);
+    if (nchunks == 0) return;
+    size_t chunkSize = (n + nchunks - 1) / nchunks;
+
+    auto body = [&](size_t c) {
+        size_t begin = c * chunkSize;
+        size_t end = std::min(n, begin + chunkSize);
+        if (begin < end) fn(c, begin, end);
+    };
+
+    size_t threads = parallelThreadCount();
+    if (nchunks == 1 || threads <= 1 || tlsInWorker) {
+        for (size_t c = 0; c < nchunks; c++) body(c);
+        return;
+    }
+    size_t helpers = std::min(threads, nchunks) - 1;
+    WorkerPool::instance().run(nchunks, helpers, body);
+}
+
+void parallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    if (n < 2 * std::max<size_t>(grain, 1)) {
+        if (n > 0) fn(0, n);
+        return;
+    }
+    parallelForChunks(n, grain, [&fn](size_t, size_t begin, size_t end) { fn(begin, end); });
+}
+
+} // namespace matfree
@@ -0,0 +1,35 @@
+#pragma once
+// MatFree - Shared worker pool for data-parallel kernels
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include <cstddef>
+#include <functional>
+
+namespace matfree {
+
+/// Number of threads used by parallel kernels (including the caller).
+/// Defaults to std::thread::hardware_concurrency(), overridable with the
+/// MATFREE_NUM_THREADS environment variable or setParallelThreadCount().
+size_t parallelThreadCount();
+
+/// Override the thread count used by subsequent parallel kernels (0 = default).
+void setParallelThreadCount(size_t n);
+
+/// True when called from inside a pool worker (nested parallelism runs serially).
+bool inParallelRegion();
+
+/// Split [0, n) into contiguous chunks of at least `grain` elements and run
+/// fn(begin, end) on each, using the pool workers plus the calling thread.
+/// Chunks are numbered in order, so callers can keep per-chunk partial
+/// results and merge them deterministically. Runs inline when n < 2 * grain.
+void parallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+/// Like parallelFor, but hands fn the chunk number as well:
+/// fn(chunk, begin, end) with chunk in [0, parallelChunkCount(n, grain)).
+void parallelForChunks(size_t n, size_t grain,
+                       const std::function<void(size_t, size_t, size_t)>& fn);
+
+/// Number of chunks parallelForChunks() will use for the given size.
+size_t parallelChunkCount(size_t n, size_t grain);
+
+} // namespace matfree
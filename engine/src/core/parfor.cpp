@@ -0,0 +1,651 @@
+// MatFree - parfor implementation
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "parfor.h"
+#include "builtins.h"
+#include "interpreter.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <unordered_set>
+
+namespace matfree {
+
+const char* const kParforValueSlot = "parfor value";
+
+ParforVarKind ParforAnalysis::kindOf(const std::string& name) const {
+    auto it = kinds.find(name);
+    if (it == kinds.end()) throw RuntimeError("parfor: unclassified variable '" + name + "'");
+    return it->second;
+}
+
+namespace {
+
+bool isIdentifier(const ExprPtr& e, const std::string& name) {
+    auto* id = std::get_if<Identifier>(&e->node);
+    return id && id->name == name;
+}
+
+ExprPtr identifier(const std::string& name) {
+    return std::make_shared<Expr>(Identifier{name});
+}
+
+/// Names an expression reads. Anonymous function bodies are skipped: they
+/// do not capture the workspace. `loopIndexed` receives names indexed with
+/// the loop variable as a whole subscript, e.g. x in x(i, :).
+void collectReads(const ExprPtr& expr, const std::string& loopVar,
+                  std::unordered_set<std::string>& reads,
+                  std::unordered_set<std::string>* loopIndexed) {
+    if (!expr) return;
+    auto visitSubscripts = [&](const ExprPtr& base, const ExprList& subscripts) {
+        collectReads(base, loopVar, reads, loopIndexed);
+        auto* id = std::get_if<Identifier>(&base->node);
+        for (auto& s : subscripts) {
+            if (id && loopIndexed && isIdentifier(s, loopVar)) loopIndexed->insert(id->name);
+            collectReads(s, loopVar, reads, loopIndexed);
+        }
+    };
+    std::visit([&](auto& node) {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, Identifier>) {
+            reads.insert(node.name);
+        } else if constexpr (std::is_same_v<T, UnaryExpr>) {
+            collectReads(node.operand, loopVar, reads, loopIndexed);
+        } else if constexpr (std::is_same_v<T, BinaryExpr>) {
+            collectReads(node.left, loopVar, reads, loopIndexed);
+            collectReads(node.right, loopVar, reads, loopIndexed);
+        } else if constexpr (std::is_same_v<T, MatrixLiteral> || std::is_same_v<T, CellArrayLiteral>) {
+            for (auto& row : node.rows)
+                for (auto& e : row) collectReads(e, loopVar, reads, loopIndexed);
+        } else if constexpr (std::is_same_v<T, CallExpr>) {
+            visitSubscripts(node.callee, node.arguments);
+        } else if constexpr (std::is_same_v<T, CellIndexExpr>) {
+            visitSubscripts(node.object, node.indices);
+        } else if constexpr (std::is_same_v<T, DotExpr>) {
+            collectReads(node.object, loopVar, reads, loopIndexed);
+        } else if constexpr (std::is_same_v<T, ColonExpr>) {
+            collectReads(node.start, loopVar, reads, loopIndexed);
+            collectReads(node.step, loopVar, reads, loopIndexed);
+            collectReads(node.stop, loopVar, reads, loopIndexed);
+        }
+    }, expr->node);
+}
+
+bool mentions(const ExprPtr& expr, const std::string& name) {
+    std::unordered_set<std::string> reads;
+    collectReads(expr, "", reads, nullptr);
+    return reads.count(name) != 0;
+}
+
+/// A reduction statement found in the body, before classification.
+struct ReductionCandidate {
+    const AssignStmt* stmt;
+    std::string op; // operator or function; must agree across statements
+    ExprPtr operand;
+    ExprPtr combiner;
+};
+
+/// An indexed assignment x(...) = v or x{...} = v found in the body.
+struct IndexedWrite {
+    bool cell;
+    size_t subscripts;
+    bool loopSubscript; // the loop variable is one of the subscripts
+};
+
+/// Match s = s op e, s = e op s, max/min(s, e), [s, e] and [s; e].
+bool matchReduction(const std::string& s, const ExprPtr& value, ReductionCandidate& out) {
+    const ExprPtr slot = identifier(kParforValueSlot);
+    const ExprPtr acc = identifier(s);
+
+    if (auto* bin = std::get_if<BinaryExpr>(&value->node)) {
+        switch (bin->op) {
+            case TokenType::PLUS: case TokenType::MINUS: case TokenType::STAR:
+            case TokenType::DOT_STAR: case TokenType::AND: case TokenType::OR:
+                break;
+            default:
+                return false;
+        }
+        out.op = tokenTypeName(bin->op);
+        if (isIdentifier(bin->left, s) && !mentions(bin->right, s)) {
+            out.operand = bin->right;
+            out.combiner = std::make_shared<Expr>(BinaryExpr{bin->op, acc, slot});
+            return true;
+        }
+        if (bin->op != TokenType::MINUS && isIdentifier(bin->right, s) && !mentions(bin->left, s)) {
+            out.operand = bin->left;
+            out.combiner = std::make_shared<Expr>(BinaryExpr{bin->op, slot, acc});
+            return true;
+        }
+        return false;
+    }
+
+    auto matchPair = [&](const ExprPtr& a, const ExprPtr& b, auto makeCombiner) {
+        if (isIdentifier(a, s) && !mentions(b, s)) {
+            out.operand = b;
+            out.combiner = makeCombiner(acc, slot);
+            return true;
+        }
+        if (isIdentifier(b, s) && !mentions(a, s)) {
+            out.operand = a;
+            out.combiner = makeCombiner(slot, acc);
+            return true;
+        }
+        return false;
+    };
+
+    if (auto* call = std::get_if<CallExpr>(&value->node)) {
+        auto* fn = std::get_if<Identifier>(&call->callee->node);
+        if (!fn || (fn->name != "max" && fn->name != "min") || call->arguments.size() != 2) return false;
+        out.op = fn->name;
+        return matchPair(call->arguments[0], call->arguments[1], [&](ExprPtr a, ExprPtr b) {
+            return std::make_shared<Expr>(CallExpr{call->callee, {a, b}});
+        });
+    }
+
+    if (auto* mat = std::get_if<MatrixLiteral>(&value->node)) {
+        if (mat->rows.size() == 1 && mat->rows[0].size() == 2) {
+            out.op = "[,]";
+            return matchPair(mat->rows[0][0], mat->rows[0][1], [](ExprPtr a, ExprPtr b) {
+                return std::make_shared<Expr>(MatrixLiteral{{{a, b}}});
+            });
+        }
+        if (mat->rows.size() == 2 && mat->rows[0].size() == 1 && mat->rows[1].size() == 1) {
+            out.op = "[;]";
+            return matchPair(mat->rows[0][0], mat->rows[1][0], [](ExprPtr a, ExprPtr b) {
+                return std::make_shared<Expr>(MatrixLiteral{{{a}, {b}}});
+            });
+        }
+    }
+    return false;
+}
+
+/// Walks a parfor body collecting how each name is read and written.
+class BodyScanner {
+public:
+    explicit BodyScanner(const std::string& loopVar) : loopVar_(loopVar) {}
+
+    void scan(const StmtList& body) {
+        for (auto& s : body) scanStmt(s);
+    }
+
+    std::unordered_set<std::string> reads, loopIndexedReads, plainWrites;
+    std::unordered_map<std::string, std::vector<IndexedWrite>> indexedWrites;
+    std::unordered_map<std::string, std::vector<ReductionCandidate>> reductions;
+
+private:
+    void read(const ExprPtr& e) { collectReads(e, loopVar_, reads, &loopIndexedReads); }
+
+    void indexedWrite(const ExprPtr& base, const ExprList& subscripts, bool cell) {
+        auto* id = std::get_if<Identifier>(&base->node);
+        if (!id) {
+            read(base);
+            return;
+        }
+        bool loopSubscript = false;
+        for (auto& s : subscripts) {
+            loopSubscript = loopSubscript || isIdentifier(s, loopVar_);
+            read(s);
+        }
+        indexedWrites[id->name].push_back({cell, subscripts.size(), loopSubscript});
+    }
+
+    void scanBody(const StmtList& body, bool loop) {
+        if (loop) loopDepth_++;
+        for (auto& s : body) scanStmt(s);
+        if (loop) loopDepth_--;
+    }
+
+    void scanStmt(const StmtPtr& stmt) {
+        std::visit([&](auto& node) {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, ExprStmt>) {
+                read(node.expression);
+                if (node.printResult) plainWrites.insert("ans");
+            } else if constexpr (std::is_same_v<T, AssignStmt>) {
+                if (auto* id = std::get_if<Identifier>(&node.target->node)) {
+                    ReductionCandidate r;
+                    if (matchReduction(id->name, node.value, r)) {
+                        r.stmt = &node;
+                        read(r.operand);
+                        reductions[id->name].push_back(std::move(r));
+                    } else {
+                        read(node.value);
+                        plainWrites.insert(id->name);
+                    }
+                    return;
+                }
+                read(node.value);
+                if (auto* call = std::get_if<CallExpr>(&node.target->node)) {
+                    indexedWrite(call->callee, call->arguments, false);
+                } else if (auto* ci = std::get_if<CellIndexExpr>(&node.target->node)) {
+                    indexedWrite(ci->object, ci->indices, true);
+                } else if (auto* dot = std::get_if<DotExpr>(&node.target->node)) {
+                    // s.f = v updates s as a whole: s is local to the iteration
+                    read(dot->object);
+                    if (auto* base = std::get_if<Identifier>(&dot->object->node)) plainWrites.insert(base->name);
+                }
+            } else if constexpr (std::is_same_v<T, MultiAssignStmt>) {
+                read(node.value);
+                for (auto& t : node.targets)
+                    if (t != "~") plainWrites.insert(t);
+            } else if constexpr (std::is_same_v<T, IfStmt>) {
+                for (auto& b : node.branches) {
+                    read(b.condition);
+                    scanBody(b.body, false);
+                }
+            } else if constexpr (std::is_same_v<T, ForStmt>) {
+                read(node.range);
+                plainWrites.insert(node.variable);
+                scanBody(node.body, true);
+            } else if constexpr (std::is_same_v<T, ParforStmt>) {
+                read(node.range);
+                read(node.maxWorkers);
+                plainWrites.insert(node.variable);
+                scanBody(node.body, true);
+            } else if constexpr (std::is_same_v<T, WhileStmt>) {
+                read(node.condition);
+                scanBody(node.body, true);
+            } else if constexpr (std::is_same_v<T, SwitchStmt>) {
+                read(node.expression);
+                for (auto& c : node.cases) {
+                    read(c.value);
+                    scanBody(c.body, false);
+                }
+            } else if constexpr (std::is_same_v<T, TryCatchStmt>) {
+                scanBody(node.tryBody, false);
+                if (!node.catchVar.empty()) plainWrites.insert(node.catchVar);
+                scanBody(node.catchBody, false);
+            } else if constexpr (std::is_same_v<T, ReturnStmt>) {
+                throw RuntimeError("parfor: 'return' is not allowed in the loop body");
+            } else if constexpr (std::is_same_v<T, BreakStmt>) {
+                if (loopDepth_ == 0) throw RuntimeError("parfor: 'break' is not allowed in the loop body");
+            } else if constexpr (std::is_same_v<T, GlobalStmt> || std::is_same_v<T, PersistentStmt>) {
+                throw RuntimeError("parfor: global and persistent declarations are not allowed in the loop body");
+            }
+        }, stmt->node);
+    }
+
+    const std::string& loopVar_;
+    int loopDepth_ = 0;
+};
+
+} // namespace
+
+ParforAnalysis analyzeParfor(const ParforStmt& stmt,
+                             const std::function<bool(const std::string&)>& isVariable) {
+    const std::string& loopVar = stmt.variable;
+    BodyScanner scan(loopVar);
+    scan.scan(stmt.body);
+
+    if (scan.plainWrites.count(loopVar) || scan.indexedWrites.count(loopVar) || scan.reductions.count(loopVar))
+        throw RuntimeError("parfor: the loop variable '" + loopVar + "' cannot be assigned in the loop body");
+
+    std::unordered_set<std::string> names(scan.reads.begin(), scan.reads.end());
+    names.insert(scan.plainWrites.begin(), scan.plainWrites.end());
+    for (auto& [name, w] : scan.indexedWrites) names.insert(name);
+    for (auto& [name, r] : scan.reductions) names.insert(name);
+    // Visit names in a fixed order so slots and reductions are numbered deterministically
+    std::vector<std::string> ordered(names.begin(), names.end());
+    std::sort(ordered.begin(), ordered.end());
+
+    ParforAnalysis a;
+    a.kinds[loopVar] = ParforVarKind::LOOP;
+    for (auto& name : ordered) {
+        if (name == loopVar) continue;
+        if (scan.plainWrites.count(name)) {
+            // Assigned as a whole: reduction-shaped updates are ordinary
+            // statements on a per-iteration temporary
+            a.kinds[name] = ParforVarKind::TEMPORARY;
+            a.temporaries.push_back(name);
+        } else if (scan.reductions.count(name)) {
+            auto& stmts = scan.reductions[name];
+            if (scan.reads.count(name) || scan.indexedWrites.count(name))
+                throw RuntimeError("parfor: reduction variable '" + name +
+                                   "' is also used outside its reduction assignments");
+            for (auto& r : stmts) {
+                if (r.op != stmts.front().op)
+                    throw RuntimeError("parfor: reduction variable '" + name +
+                                       "' must use the same operation in every assignment");
+            }
+            if (!isVariable(name))
+                throw RuntimeError("parfor: reduction variable '" + name + "' must be defined before the loop");
+            a.kinds[name] = ParforVarKind::REDUCTION;
+            for (auto& r : stmts) {
+                a.reductionOf[r.stmt] = a.reductions.size();
+                a.reductions.push_back({name, r.operand, r.combiner});
+            }
+        } else if (scan.indexedWrites.count(name)) {
+            auto& writes = scan.indexedWrites[name];
+            for (auto& w : writes) {
+                if (!w.loopSubscript)
+                    throw RuntimeError("parfor: variable '" + name +
+                                       "' is assigned by index but not indexed by the loop variable '" +
+                                       loopVar + "'");
+                if (w.cell != writes.front().cell || w.subscripts != writes.front().subscripts)
+                    throw RuntimeError("parfor: sliced variable '" + name +
+                                       "' must be indexed the same way in every assignment");
+            }
+            a.kinds[name] = ParforVarKind::SLICED_OUTPUT;
+            a.sliceOf[name] = a.slicedOutputs.size();
+            a.slicedOutputs.push_back(name);
+            a.slicedOutputRead.push_back(scan.reads.count(name) != 0);
+        } else if (isVariable(name)) {
+            a.kinds[name] = scan.loopIndexedReads.count(name) ? ParforVarKind::SLICED_INPUT
+                                                              : ParforVarKind::BROADCAST;
+        }
+        // Anything else is a function name (or undefined, reported when evaluated)
+    }
+    return a;
+}
+
+// ============================================================================
+// Worker side
+// ============================================================================
+
+bool ParforCapture::interceptAssign(Interpreter& worker, const AssignStmt& stmt) {
+    auto r = analysis_.reductionOf.find(&stmt);
+    if (r != analysis_.reductionOf.end()) {
+        current_->contributions.emplace_back(r->second, worker.evalExpr(analysis_.reductions[r->second].operand));
+        return true;
+    }
+
+    const ExprPtr* base = nullptr;
+    const ExprList* subscripts = nullptr;
+    bool cell = false;
+    if (auto* call = std::get_if<CallExpr>(&stmt.target->node)) {
+        base = &call->callee;
+        subscripts = &call->arguments;
+    } else if (auto* ci = std::get_if<CellIndexExpr>(&stmt.target->node)) {
+        base = &ci->object;
+        subscripts = &ci->indices;
+        cell = true;
+    } else {
+        return false;
+    }
+    auto* id = std::get_if<Identifier>(&(*base)->node);
+    if (!id) return false;
+    auto slot = analysis_.sliceOf.find(id->name);
+    if (slot == analysis_.sliceOf.end()) return false;
+
+    ParforSliceWrite write{slot->second, cell, {}, worker.evalExpr(stmt.value)};
+    for (auto& s : *subscripts) write.indices.push_back(worker.evalExpr(s));
+    if (analysis_.slicedOutputRead[slot->second]) {
+        // Later reads in this iteration must see the write
+        if (cell) worker.assignCellIndex(std::get<CellIndexExpr>(stmt.target->node), write.value);
+        else worker.assignIndexed(std::get<CallExpr>(stmt.target->node), write.value);
+    }
+    current_->writes.push_back(std::move(write));
+    return true;
+}
+
+namespace {
+
+/// Iteration ranges for range-splitting work stealing. Each worker starts
+/// with a contiguous share and takes iterations from its front; an idle
+/// worker steals the back half of another worker's remaining range, so
+/// stolen work stays contiguous and load balances without a central queue.
+class StealingRanges {
+public:
+    StealingRanges(size_t n, size_t workers) : ranges_(workers) {
+        for (size_t w = 0; w < workers; w++) {
+            ranges_[w].next = n * w / workers;
+            ranges_[w].end = n * (w + 1) / workers;
+        }
+    }
+
+    /// Next iteration for worker `w`; false when no work is left anywhere.
+    bool next(size_t w, size_t& k) {
+        {
+            std::lock_guard<std::mutex> lock(ranges_[w].mutex);
+            if (ranges_[w].next < ranges_[w].end) {
+                k = ranges_[w].next++;
+                return true;
+            }
+        }
+        size_t workers = ranges_.size();
+        for (size_t d = 1; d < workers; d++) {
+            Range& victim = ranges_[(w + d) % workers];
+            size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                size_t remaining = victim.end - victim.next;
+                if (remaining == 0) continue;
+                begin = victim.next + remaining / 2;
+                end = victim.end;
+                victim.end = begin;
+            }
+            std::lock_guard<std::mutex> lock(ranges_[w].mutex);
+            ranges_[w].next = begin + 1;
+            ranges_[w].end = end;
+            k = begin;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    struct Range {
+        std::mutex mutex;
+        size_t next = 0;
+        size_t end = 0;
+    };
+    std::vector<Range> ranges_;
+};
+
+} // namespace
+
+void runParfor(Interpreter& client, const ParforStmt& stmt) {
+    auto rangeVal = client.evalExpr(stmt.range);
+    if (!rangeVal->isNumeric()) throw RuntimeError("parfor: range must be numeric");
+    const Matrix& range = rangeVal->matrix();
+    size_t n = range.numel();
+    double first = n > 0 ? range(0) : 0.0;
+    bool consecutive = (n == 0 || range.rows() == 1) && std::floor(first) == first;
+    for (size_t k = 1; consecutive && k < n; k++) consecutive = range(k) == first + static_cast<double>(k);
+    if (!consecutive) throw RuntimeError("parfor: range must be a row vector of consecutive increasing integers");
+
+    size_t maxWorkers = parallelThreadCount();
+    if (stmt.maxWorkers) {
+        double m = client.evalExpr(stmt.maxWorkers)->scalarDouble();
+        if (!(m >= 0) || std::floor(m) != m) throw RuntimeError("parfor: number of workers must be a nonnegative integer");
+        maxWorkers = std::max<size_t>(1, static_cast<size_t>(std::min(m, 1024.0)));
+    }
+    if (client.parforCapture_) maxWorkers = 1; // nested inside a worker: run in place
+
+    Environment::Ptr env = client.currentEnv_;
+    ParforAnalysis analysis = analyzeParfor(stmt, [&](const std::string& name) { return env->get(name) != nullptr; });
+    if (n == 0) return;
+
+    // Values shared by every worker; values are never modified in place, so
+    // sharing the pointers is safe.
+    std::vector<std::pair<std::string, ValuePtr>> shared;
+    for (auto& [name, kind] : analysis.kinds) {
+        bool needed = kind == ParforVarKind::BROADCAST || kind == ParforVarKind::SLICED_INPUT ||
+                      (kind == ParforVarKind::SLICED_OUTPUT && analysis.slicedOutputRead[analysis.sliceOf.at(name)]);
+        if (!needed) continue;
+        if (auto v = env->get(name)) shared.emplace_back(name, v);
+    }
+
+    // Worker interpreters are cached on the client. Each gets the built-ins
+    // of a fresh session plus any pure built-ins registered on the client.
+    size_t nworkers = std::min(maxWorkers, n);
+    auto& workers = client.parforWorkers_;
+    while (workers.size() < nworkers) {
+        auto worker = std::make_unique<Interpreter>();
+        registerAllBuiltins(*worker);
+        const BuiltinTable& own = *client.builtins_;
+        for (auto& [name, fn] : own.functions) {
+            if (worker->builtins_->functions.count(name) || !(client.builtinTraits(name) & PURE_BUILTIN)) continue;
+            auto multi = own.multi.find(name);
+            if (multi != own.multi.end()) worker->registerMultiBuiltin(name, multi->second);
+            else worker->registerBuiltin(name, fn);
+            worker->setBuiltinTraits(name, client.builtinTraits(name));
+        }
+        workers.push_back(std::move(worker));
+    }
+    for (size_t w = 0; w < nworkers; w++) {
+        workers[w]->userFunctions_ = client.userFunctions_;
+        workers[w]->searchPath_ = client.searchPath_;
+        workers[w]->session().datastores = client.session().datastores;
+    }
+
+    // Iteration k draws random numbers from its own substream of the
+    // client's generator, so results do not depend on the worker count or
+    // on which worker ran the iteration.
+    SessionState& session = client.session();
+    uint64_t firstSubstream = session.substreamsUsed;
+    session.substreamsUsed += n;
+
+    std::vector<ParforIterationResult> results(n);
+    StealingRanges ranges(n, nworkers);
+    // Lowest failing iteration so far. Iterations above it are skipped, but
+    // every iteration below it still runs, so the error reported is always
+    // that of the first failing iteration, as in the serial loop.
+    std::atomic<size_t> firstFailure{n};
+    std::vector<std::exception_ptr> errors(nworkers);
+    std::vector<size_t> errorAt(nworkers, n);
+
+    parallelForChunks(nworkers, 1, [&](size_t w, size_t, size_t) {
+        Interpreter& worker = *workers[w];
+        std::ostringstream out;
+        ParforCapture capture(analysis);
+        Environment::Ptr scope = worker.globalEnv_->createChild();
+        for (auto& [name, v] : shared) scope->set(name, v);
+        worker.currentEnv_ = scope;
+        worker.setOutput(out);
+        worker.parforCapture_ = &capture;
+
+        size_t k;
+        while (ranges.next(w, k)) {
+            if (k > firstFailure.load()) continue;
+            try {
+                for (auto& name : analysis.temporaries) scope->clear(name);
+                scope->set(stmt.variable, Value::makeScalar(first + static_cast<double>(k)));
+                worker.session().rng = session.rng.substream(firstSubstream + k);
+                capture.setIteration(&results[k]);
+                try {
+                    for (auto& s : stmt.body) worker.executeStmt(s);
+                } catch (ContinueSignal&) {
+                }
+                results[k].output = out.str();
+                out.str("");
+            } catch (...) {
+                if (k < errorAt[w]) {
+                    errors[w] = std::current_exception();
+                    errorAt[w] = k;
+                }
+                size_t seen = firstFailure.load();
+                while (k < seen && !firstFailure.compare_exchange_weak(seen, k)) {
+                }
+            }
+        }
+
+        worker.parforCapture_ = nullptr;
+        worker.session().datastores.clear();
+        worker.setOutput(std::cout);
+        worker.currentEnv_ = worker.globalEnv_;
+    });
+
+    if (firstFailure.load() < n) {
+        size_t w = std::min_element(errorAt.begin(), errorAt.end()) - errorAt.begin();
+        std::rethrow_exception(errors[w]);
+    }
+
+    // Merge in iteration order, so results match the serial loop
+    for (auto& r : results) client.output() << r.output;
+
+    for (size_t slot = 0; slot < analysis.slicedOutputs.size(); slot++) {
+        const std::string& name = analysis.slicedOutputs[slot];
+        std::vector<const ParforSliceWrite*> writes;
+        for (auto& r : results)
+            for (auto& w : r.writes)
+                if (w.slot == slot) writes.push_back(&w);
+        if (writes.empty()) continue;
+        auto unsupported = [&]() {
+            return RuntimeError("parfor: unsupported assignment to sliced variable '" + name + "'");
+        };
+        auto indexOf = [&](const ValuePtr& v) -> size_t {
+            double d = v->scalarDouble();
+            if (!(d >= 1) || std::floor(d) != d) throw RuntimeError("Index must be a positive integer");
+            return static_cast<size_t>(d) - 1;
+        };
+        ValuePtr current = env->get(name);
+
+        if (writes.front()->cell) {
+            // Mirrors assignCellIndex: linear subscripts, growing the column count
+            CellArray cell = current && current->isCellArray() ? current->cellArray() : CellArray(1, 0);
+            if (writes.front()->indices.size() != 1) throw unsupported();
+            size_t need = cell.data.size();
+            for (auto* w : writes) need = std::max(need, indexOf(w->indices[0]) + 1);
+            if (need > cell.data.size()) {
+                cell.data.resize(need);
+                cell.rows = 1;
+                cell.cols = need;
+            }
+            for (auto* w : writes) cell.data[indexOf(w->indices[0])] = w->value;
+            env->set(name, Value::makeCellArray(std::move(cell)));
+            continue;
+        }
+
+        // Mirrors assignIndexed: scalar subscripts and values, growing once
+        Matrix m = current && current->isNumeric() ? current->matrix() : Matrix();
+        if (writes.front()->indices.size() == 1) {
+            size_t need = 0;
+            for (auto* w : writes) need = std::max(need, indexOf(w->indices[0]) + 1);
+            if (need > m.numel()) {
+                Matrix grown(1, need, 0.0);
+                for (size_t i = 0; i < m.numel(); i++) grown(i) = m(i);
+                m = std::move(grown);
+            }
+            for (auto* w : writes) m(indexOf(w->indices[0])) = w->value->scalarDouble();
+        } else if (writes.front()->indices.size() == 2) {
+            size_t rows = m.rows(), cols = m.cols();
+            for (auto* w : writes) {
+                rows = std::max(rows, indexOf(w->indices[0]) + 1);
+                cols = std::max(cols, indexOf(w->indices[1]) + 1);
+            }
+            if (rows > m.rows() || cols > m.cols()) {
+                Matrix grown = Matrix::zeros(rows, cols);
+                for (size_t i = 0; i < m.rows(); i++)
+                    for (size_t j = 0; j < m.cols(); j++) grown(i, j) = m(i, j);
+                m = std::move(grown);
+            }
+            for (auto* w : writes)
+                m(indexOf(w->indices[0]), indexOf(w->indices[1])) = w->value->scalarDouble();
+        } else {
+            throw unsupported();
+        }
+        env->set(name, Value::makeMatrix(std::move(m)));
+    }
+
+    if (!analysis.reductions.empty()) {
+        // Fold each reduction in iteration order by evaluating its combiner
+        // (e.g. s + <value>) in a scratch scope on the client
+        std::unordered_map<std::string, ValuePtr> acc;
+        for (auto& red : analysis.reductions) acc.emplace(red.variable, env->get(red.variable));
+        Environment::Ptr scratch = client.globalEnv_->createChild();
+        Environment::Ptr saved = client.currentEnv_;
+        client.currentEnv_ = scratch;
+        try {
+            for (auto& r : results) {
+                for (auto& [index, value] : r.contributions) {
+                    const ParforReduction& red = analysis.reductions[index];
+                    scratch->set(red.variable, acc[red.variable]);
+                    scratch->set(kParforValueSlot, value);
+                    acc[red.variable] = client.evalExpr(red.combiner);
+                }
+            }
+        } catch (...) {
+            client.currentEnv_ = saved;
+            throw;
+        }
+        client.currentEnv_ = saved;
+        for (auto& [name, value] : acc) env->set(name, value);
+    }
+}
+
+} // namespace matfree
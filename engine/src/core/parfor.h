@@ -0,0 +1,98 @@
+#pragma once
+// MatFree - parfor: variable classification and parallel execution
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "ast.h"
+#include "value.h"
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace matfree {
+
+class Interpreter;
+
+/// How a parfor body uses a variable (the MATLAB classification).
+enum class ParforVarKind {
+    LOOP,          // the loop index
+    SLICED_INPUT,  // read as x(..., i, ...); sent to workers as is
+    SLICED_OUTPUT, // assigned only as x(..., i, ...) = v or x{..., i, ...} = v
+    BROADCAST,     // read only; shared with every worker
+    REDUCTION,     // updated only as s = s op e (op: + - * .* & | max min [,] [;])
+    TEMPORARY,     // assigned in the body; local to each iteration, not copied back
+};
+
+/// One reduction statement `s = s op e`. Workers evaluate `operand` (e);
+/// the client folds the values in iteration order by evaluating `combiner`
+/// (the statement's expression with e replaced by kParforValueSlot), so the
+/// result matches the serial loop exactly.
+struct ParforReduction {
+    std::string variable;
+    ExprPtr operand;
+    ExprPtr combiner;
+};
+
+/// Name bound to a reduction operand while its combiner is evaluated.
+/// Not a valid identifier, so it cannot clash with user variables.
+extern const char* const kParforValueSlot;
+
+struct ParforAnalysis {
+    std::unordered_map<std::string, ParforVarKind> kinds;
+    std::vector<ParforReduction> reductions;
+    std::unordered_map<const AssignStmt*, size_t> reductionOf; // statement -> index in reductions
+    std::unordered_map<std::string, size_t> sliceOf;           // sliced output -> slot
+    std::vector<std::string> slicedOutputs;                    // by slot
+    std::vector<bool> slicedOutputRead;                        // by slot: body also reads it
+    std::vector<std::string> temporaries;
+
+    ParforVarKind kindOf(const std::string& name) const;
+    bool has(const std::string& name) const { return kinds.count(name) != 0; }
+};
+
+/// Classify the variables of a parfor body. `isVariable` reports whether a
+/// name is defined in the enclosing workspace (other names are functions).
+/// Throws RuntimeError for uses that have no valid classification, such as
+/// a reduction variable that is also read, or break/return in the body.
+ParforAnalysis analyzeParfor(const ParforStmt& stmt,
+                             const std::function<bool(const std::string&)>& isVariable);
+
+/// One captured write to a sliced output.
+struct ParforSliceWrite {
+    size_t slot;
+    bool cell; // x{...} = v rather than x(...) = v
+    ValueList indices;
+    ValuePtr value;
+};
+
+/// Everything one iteration hands back to the client.
+struct ParforIterationResult {
+    std::string output;
+    std::vector<ParforSliceWrite> writes;
+    std::vector<std::pair<size_t, ValuePtr>> contributions; // (reduction, operand value)
+};
+
+/// Installed on a worker interpreter while it runs parfor iterations:
+/// assignments to sliced outputs and reduction variables are recorded for
+/// the current iteration instead of touching the worker's workspace.
+class ParforCapture {
+public:
+    explicit ParforCapture(const ParforAnalysis& analysis) : analysis_(analysis) {}
+
+    void setIteration(ParforIterationResult* result) { current_ = result; }
+
+    /// Returns true when the assignment was captured (the caller skips it).
+    bool interceptAssign(Interpreter& worker, const AssignStmt& stmt);
+
+private:
+    const ParforAnalysis& analysis_;
+    ParforIterationResult* current_ = nullptr;
+};
+
+/// Execute a parfor loop on behalf of `client`: iterations run on worker
+/// interpreters (each with its own Environment) scheduled by range-splitting
+/// work stealing, then outputs, sliced writes and reductions are merged into
+/// the client workspace in iteration order.
+void runParfor(Interpreter& client, const ParforStmt& stmt);
+
+} // namespace matfree
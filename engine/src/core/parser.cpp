@@ -139,6 +139,7 @@ StmtPtr Parser::parseStatement() {
     switch (current().type) {
         case TokenType::IF:       return parseIfStmt();
         case TokenType::FOR:      return parseForStmt();
+        case TokenType::PARFOR:   return parseParforStmt();
         case TokenType::WHILE:    return parseWhileStmt();
         case TokenType::SWITCH:   return parseSwitchStmt();
         case TokenType::TRY:      return parseTryCatchStmt();
@@ -278,6 +279,27 @@ StmtPtr Parser::parseForStmt() {
     return makeStmt<ForStmt>(ln, cl, var, std::move(range), std::move(body));
 }
 
+StmtPtr Parser::parseParforStmt() {
+    int ln = current().line, cl = current().col;
+    expect(TokenType::PARFOR, "Expected 'parfor'");
+
+    bool parens = match(TokenType::LPAREN);
+    std::string var = expect(TokenType::IDENTIFIER, "Expected loop variable").lexeme;
+    expect(TokenType::ASSIGN, "Expected '='");
+    auto range = parseExpression();
+    ExprPtr maxWorkers;
+    if (parens) {
+        if (match(TokenType::COMMA)) maxWorkers = parseExpression();
+        expect(TokenType::RPAREN, "Expected ')' after parfor range");
+    }
+    expectStatementEnd();
+    auto body = parseBlock({TokenType::END});
+    expect(TokenType::END, "Expected 'end' to close 'parfor'");
+    expectStatementEnd();
+
+    return makeStmt<ParforStmt>(ln, cl, var, std::move(range), std::move(maxWorkers), std::move(body));
+}
+
 StmtPtr Parser::parseWhileStmt() {
     int ln = current().line, cl = current().col;
     expect(TokenType::WHILE, "Expected 'while'");
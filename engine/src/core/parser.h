@@ -48,6 +48,7 @@ private:
     // Statement parsing
     StmtPtr parseIfStmt();
     StmtPtr parseForStmt();
+    StmtPtr parseParforStmt();
     StmtPtr parseWhileStmt();
     StmtPtr parseSwitchStmt();
     StmtPtr parseTryCatchStmt();
@@ -0,0 +1,232 @@
+// MatFree - Native extension plugins (<name>.mfx shared libraries)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "plugin.h"
+#include "shared_library.h"
+#include "capi/matfree_plugin.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+struct mf_call {
+    size_t maxOutputs;
+    std::vector<matfree::ValuePtr> outputs;
+    std::string error;
+    bool failed = false;
+};
+
+struct mf_registry {
+    struct Definition {
+        mf_plugin_function fn;
+        void* data;
+    };
+    std::unordered_map<std::string, Definition> definitions;
+};
+
+namespace matfree {
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// Host services
+// ----------------------------------------------------------------------------
+
+Value* setOutput(mf_call* call, int index, ValuePtr value) {
+    if (index < 0 || static_cast<size_t>(index) >= call->maxOutputs) return nullptr;
+    if (call->outputs.size() <= static_cast<size_t>(index)) call->outputs.resize(static_cast<size_t>(index) + 1);
+    call->outputs[static_cast<size_t>(index)] = std::move(value);
+    return call->outputs[static_cast<size_t>(index)].get();
+}
+
+double* hostOutputMatrix(mf_call* call, int index, size_t rows, size_t cols) {
+    try {
+        Value* v = setOutput(call, index, Value::makeMatrix(Matrix(rows, cols)));
+        return v ? v->matrix().begin() : nullptr;
+    } catch (...) {
+        return nullptr; // out of memory
+    }
+}
+
+void hostOutputScalar(mf_call* call, int index, double value) {
+    setOutput(call, index, Value::makeScalar(value));
+}
+
+void hostOutputString(mf_call* call, int index, const char* text) {
+    setOutput(call, index, Value::makeString(text ? text : ""));
+}
+
+int hostError(mf_call* call, const char* message) {
+    call->failed = true;
+    call->error = message ? message : "";
+    return 1;
+}
+
+void hostDefine(mf_registry* registry, const char* name, mf_plugin_function fn, void* data) {
+    if (name && fn) registry->definitions[name] = {fn, data};
+}
+
+const mf_host kHost = {MATFREE_PLUGIN_ABI, hostOutputMatrix, hostOutputScalar, hostOutputString, hostError,
+                       hostDefine};
+
+// ----------------------------------------------------------------------------
+// Libraries
+// ----------------------------------------------------------------------------
+
+/// A loaded plugin library. The cache holds the current version of each
+/// file; a replaced version is unloaded when the last function bound to
+/// it goes away.
+class PluginLibrary {
+public:
+    /// Load `path`, or with `fresh`, a private copy of it: the loader hands
+    /// back an already loaded library of the same name, and the previous
+    /// version may still be in use.
+    static std::shared_ptr<PluginLibrary> load(const std::string& path, bool fresh) {
+        std::shared_ptr<PluginLibrary> lib(new PluginLibrary());
+        std::string file = path;
+        if (fresh) {
+            static std::atomic<uint64_t> copies{0};
+            auto copy = std::filesystem::temp_directory_path() /
+                        ("matfree_" + std::to_string(processId()) + "_" + std::to_string(copies++) + "_" +
+                         std::filesystem::path(path).filename().string());
+            std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing);
+            file = copy.string();
+            lib->copy_ = file;
+        }
+        lib->library_ = SharedLibrary::open(file);
+        auto init = reinterpret_cast<mf_plugin_init_function>(lib->library_->symbol("mf_plugin_init"));
+        if (!init) throw RuntimeError("Plugin '" + path + "' does not export mf_plugin_init");
+        int abi = init(&kHost, &lib->registry_);
+        if (abi != MATFREE_PLUGIN_ABI)
+            throw RuntimeError("Plugin '" + path + "' " +
+                               (abi < 0 ? std::string("failed to initialize")
+                                        : "was built for plugin ABI " + std::to_string(abi) + ", not " +
+                                              std::to_string(MATFREE_PLUGIN_ABI)));
+        return lib;
+    }
+
+    ~PluginLibrary() {
+        library_.reset();
+        std::error_code ec;
+        if (!copy_.empty()) std::filesystem::remove(copy_, ec);
+    }
+
+    const mf_registry& registry() const { return registry_; }
+
+private:
+    PluginLibrary() = default;
+    std::shared_ptr<SharedLibrary> library_;
+    std::string copy_; // private copy loaded instead of the file, removed on unload
+    mf_registry registry_;
+
+    static long processId() {
+#ifdef _WIN32
+        return static_cast<long>(GetCurrentProcessId());
+#else
+        return static_cast<long>(getpid());
+#endif
+    }
+};
+
+// Call a plugin function: zero-copy argument views in, outputs filled in place
+ValueList callPlugin(const std::string& name, const mf_registry::Definition& def, const ValueList& args,
+                     int nargout) {
+    std::vector<mf_arg> views(args.size());
+    for (size_t i = 0; i < args.size(); i++) {
+        const Value& v = *args[i];
+        mf_arg& a = views[i];
+        a = mf_arg{MF_ARG_OTHER, 1, 1, nullptr, nullptr};
+        if (v.isEmpty()) {
+            a = mf_arg{MF_ARG_EMPTY, 0, 0, nullptr, nullptr};
+        } else if (v.isMatrix() || v.isLogical()) {
+            const Matrix& m = v.matrix();
+            a = mf_arg{v.isMatrix() ? MF_ARG_MATRIX : MF_ARG_LOGICAL, m.rows(), m.cols(), m.begin(), nullptr};
+        } else if (v.isString()) {
+            a = mf_arg{MF_ARG_STRING, 1, v.string().size(), nullptr, v.string().c_str()};
+        }
+    }
+    mf_call call;
+    call.maxOutputs = static_cast<size_t>(std::max(nargout, 1));
+    int status = def.fn(&kHost, &call, nargout, static_cast<int>(args.size()), views.data(), def.data);
+    if (call.failed) throw RuntimeError(call.error);
+    if (status != 0) throw RuntimeError(name + ": plugin function failed");
+    if (call.outputs.empty()) return {Value::makeEmpty()};
+    // Outputs the function left unset (between set ones) are empty
+    for (auto& out : call.outputs)
+        if (!out) out = Value::makeEmpty();
+    return call.outputs;
+}
+
+PluginFunction bindFunction(const std::string& name, const std::shared_ptr<PluginLibrary>& lib) {
+    auto it = lib->registry().definitions.find(name);
+    if (it == lib->registry().definitions.end()) return nullptr;
+    mf_registry::Definition def = it->second;
+    return [name, def, lib](const ValueList& args, int nargout) { return callPlugin(name, def, args, nargout); };
+}
+
+/// Loaded libraries by path, shared by every interpreter in the process.
+/// A library whose file has a new modification time is loaded again;
+/// functions bound to the old one keep it loaded until they go away.
+class PluginCache {
+public:
+    static PluginCache& instance() {
+        static PluginCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<PluginLibrary> lookup(const std::string& path) {
+        std::error_code ec;
+        auto mtime = std::filesystem::last_write_time(path, ec);
+        if (ec) return nullptr;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(path);
+        if (it != entries_.end() && it->second.mtime == mtime) return it->second.lib;
+        auto lib = PluginLibrary::load(path, it != entries_.end());
+        entries_[path] = {mtime, lib};
+        for (auto& [fn, def] : lib->registry().definitions) byName_[fn] = lib;
+        return lib;
+    }
+
+    std::shared_ptr<PluginLibrary> definedBy(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = byName_.find(name);
+        return it == byName_.end() ? nullptr : it->second;
+    }
+
+private:
+    struct Entry {
+        std::filesystem::file_time_type mtime;
+        std::shared_ptr<PluginLibrary> lib;
+    };
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::unordered_map<std::string, std::shared_ptr<PluginLibrary>> byName_;
+};
+
+} // namespace
+
+PluginFunction findPluginFunction(const std::string& name, const std::vector<std::string>& dirs) {
+    for (auto& dir : dirs) {
+        std::string path = dir + "/" + name + ".mfx";
+        auto lib = PluginCache::instance().lookup(path);
+        if (!lib) continue;
+        if (auto fn = bindFunction(name, lib)) return fn;
+        throw RuntimeError("Plugin '" + path + "' does not define '" + name + "'");
+    }
+    return nullptr;
+}
+
+PluginFunction loadedPluginFunction(const std::string& name) {
+    auto lib = PluginCache::instance().definedBy(name);
+    return lib ? bindFunction(name, lib) : nullptr;
+}
+
+} // namespace matfree
@@ -0,0 +1,28 @@
+#pragma once
+// MatFree - Native extension plugins (<name>.mfx shared libraries)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "value.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace matfree {
+
+/// A plugin function bound to its library: callable like a multi-output
+/// built-in, and keeping the library loaded while it exists.
+using PluginFunction = std::function<ValueList(const ValueList& args, int nargout)>;
+
+/// Find `name` in `<dir>/<name>.mfx` for each directory in turn and load
+/// the library if needed. Libraries are shared by every interpreter in the
+/// process and reloaded when the file's modification time changes. Returns
+/// nullptr when no directory has the plugin. Throws RuntimeError when a
+/// plugin exists but cannot be loaded, or does not define `name`.
+PluginFunction findPluginFunction(const std::string& name, const std::vector<std::string>& dirs);
+
+/// A function already defined by a loaded plugin library (including the
+/// ones besides each library's own name), or nullptr.
+PluginFunction loadedPluginFunction(const std::string& name);
+
+} // namespace matfree
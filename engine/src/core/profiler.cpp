@@ -0,0 +1,154 @@
+// MatFree - Profiler: time and call counts per function and per line
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+namespace matfree {
+
+namespace {
+
+double seconds(Profiler::Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+void Profiler::clear() {
+    functions_.clear();
+    frames_.clear();
+    script_ = Frame{nullptr, {}, 0, {}};
+}
+
+void Profiler::setScript(const std::string& name) {
+    auto& stats = functions_[name];
+    stats.name = name;
+    stats.calls++;
+    script_.stats = &stats;
+}
+
+Profiler::Frame& Profiler::current() {
+    if (!frames_.empty()) return frames_.back();
+    if (!script_.stats) setScript("<script>");
+    return script_;
+}
+
+void Profiler::enterFunction(const std::string& name) {
+    auto& stats = functions_[name];
+    stats.name = name;
+    stats.calls++;
+    frames_.push_back(Frame{&stats, Clock::now(), 0, {}});
+}
+
+void Profiler::exitFunction() {
+    if (frames_.empty()) return; // cleared while running
+    Frame& f = frames_.back();
+    double elapsed = seconds(Clock::now() - f.start);
+    f.stats->totalTime += elapsed;
+    f.stats->childTime += f.children;
+    frames_.pop_back();
+    Frame& caller = current();
+    caller.children += elapsed;
+    if (&caller == &script_) caller.stats->childTime += elapsed;
+}
+
+void Profiler::enterLine(int line) {
+    Frame& f = current();
+    f.lines.push_back(OpenLine{&f.stats->lines[line], Clock::now(), 0});
+}
+
+void Profiler::exitLine() {
+    Frame& f = current();
+    if (f.lines.empty()) return; // profiling started or cleared inside the statement
+    OpenLine& l = f.lines.back();
+    double elapsed = seconds(Clock::now() - l.start);
+    l.stats->calls++;
+    l.stats->time += elapsed - l.nested;
+    f.lines.pop_back();
+    if (!f.lines.empty()) f.lines.back().nested += elapsed;
+    else if (&f == &script_) f.stats->totalTime += elapsed;
+}
+
+std::vector<const FunctionStats*> Profiler::functions() const {
+    std::vector<const FunctionStats*> result;
+    for (auto& [name, stats] : functions_)
+        if (!stats.lines.empty() || stats.calls > 0) result.push_back(&stats);
+    std::sort(result.begin(), result.end(), [](const FunctionStats* a, const FunctionStats* b) {
+        if (a->totalTime != b->totalTime) return a->totalTime > b->totalTime;
+        return a->name < b->name;
+    });
+    return result;
+}
+
+std::string Profiler::textReport() const {
+    auto stats = functions();
+    std::ostringstream os;
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "%-32s %10s %12s %12s\n", "Function", "Calls", "Total (s)", "Self (s)");
+    os << buf;
+    for (auto* f : stats) {
+        std::snprintf(buf, sizeof(buf), "%-32s %10llu %12.6f %12.6f\n", f->name.c_str(),
+                      static_cast<unsigned long long>(f->calls), f->totalTime, f->selfTime());
+        os << buf;
+    }
+    for (auto* f : stats) {
+        if (f->lines.empty()) continue;
+        os << "\n" << f->name << "\n";
+        std::snprintf(buf, sizeof(buf), "  %6s %10s %12s %7s\n", "Line", "Calls", "Time (s)", "%");
+        os << buf;
+        std::vector<std::pair<int, const LineStats*>> lines;
+        for (auto& [line, ls] : f->lines) lines.emplace_back(line, &ls);
+        std::stable_sort(lines.begin(), lines.end(),
+                         [](auto& a, auto& b) { return a.second->time > b.second->time; });
+        for (auto& [line, ls] : lines) {
+            double share = f->totalTime > 0 ? 100.0 * ls->time / f->totalTime : 0.0;
+            std::snprintf(buf, sizeof(buf), "  %6d %10llu %12.6f %6.1f%%\n", line,
+                          static_cast<unsigned long long>(ls->calls), ls->time, share);
+            os << buf;
+        }
+    }
+    return os.str();
+}
+
+std::string Profiler::jsonReport() const {
+    std::ostringstream os;
+    os.precision(9);
+    os << "{\"functions\": [";
+    bool firstFn = true;
+    for (auto* f : functions()) {
+        os << (firstFn ? "\n" : ",\n");
+        firstFn = false;
+        os << "  {\"name\": " << jsonString(f->name) << ", \"calls\": " << f->calls
+           << ", \"totalTime\": " << f->totalTime << ", \"selfTime\": " << f->selfTime() << ", \"lines\": [";
+        bool firstLine = true;
+        for (auto& [line, ls] : f->lines) {
+            os << (firstLine ? "" : ", ");
+            firstLine = false;
+            os << "{\"line\": " << line << ", \"calls\": " << ls.calls << ", \"time\": " << ls.time << "}";
+        }
+        os << "]}";
+    }
+    os << "\n]}\n";
+    return os.str();
+}
+
+} // namespace matfree
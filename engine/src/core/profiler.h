@@ -0,0 +1,106 @@
+#pragma once
+// MatFree - Profiler: time and call counts per function and per line
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace matfree {
+
+struct LineStats {
+    uint64_t calls = 0;
+    double time = 0; // seconds, including called functions but not nested statements
+};
+
+struct FunctionStats {
+    std::string name;
+    uint64_t calls = 0;
+    double totalTime = 0; // seconds, including called functions
+    double childTime = 0; // seconds spent in called user functions
+    std::map<int, LineStats> lines;
+
+    double selfTime() const { return totalTime - childTime; }
+};
+
+/// Records what the interpreter runs while profiling is on. The interpreter
+/// opens a FunctionScope for each user function call and a LineScope for
+/// each statement; nothing is recorded (or called) while profiling is off.
+/// Statements that do not run inside a user function count toward the
+/// script being run.
+///
+/// A line's time excludes the statements nested in it (the body of a for
+/// loop counts on its own lines), but includes the functions it calls, so
+/// the slowest lines lead to the slowest calls.
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Drop everything recorded.
+    void clear();
+
+    /// Name of the script whose top-level statements run next.
+    void setScript(const std::string& name);
+
+    void enterFunction(const std::string& name);
+    void exitFunction();
+    void enterLine(int line);
+    void exitLine();
+
+    class FunctionScope {
+    public:
+        FunctionScope(Profiler& p, const std::string& name) : p_(p) { p_.enterFunction(name); }
+        ~FunctionScope() { p_.exitFunction(); }
+        FunctionScope(const FunctionScope&) = delete;
+        FunctionScope& operator=(const FunctionScope&) = delete;
+
+    private:
+        Profiler& p_;
+    };
+
+    class LineScope {
+    public:
+        LineScope(Profiler& p, int line) : p_(p) { p_.enterLine(line); }
+        ~LineScope() { p_.exitLine(); }
+        LineScope(const LineScope&) = delete;
+        LineScope& operator=(const LineScope&) = delete;
+
+    private:
+        Profiler& p_;
+    };
+
+    /// Functions and scripts with anything recorded, slowest (total time)
+    /// first.
+    std::vector<const FunctionStats*> functions() const;
+
+    /// Summary table and the lines of each function, slowest first.
+    std::string textReport() const;
+
+    /// {"functions": [{"name", "calls", "totalTime", "selfTime",
+    ///   "lines": [{"line", "calls", "time"}, ...]}, ...]}
+    std::string jsonReport() const;
+
+private:
+    struct OpenLine {
+        LineStats* stats;
+        Clock::time_point start;
+        double nested = 0; // time of statements nested in this one
+    };
+    struct Frame {
+        FunctionStats* stats;
+        Clock::time_point start;
+        double children = 0; // time of user functions called
+        std::vector<OpenLine> lines;
+    };
+
+    Frame& current();
+
+    std::unordered_map<std::string, FunctionStats> functions_;
+    std::vector<Frame> frames_; // open user function calls
+    Frame script_{nullptr, {}, 0, {}};
+};
+
+} // namespace matfree
@@ -0,0 +1,236 @@
+// MatFree - Counter-based random number streams
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "random.h"
+#include "parallel.h"
+#include "value.h"
+#include <cmath>
+
+namespace matfree {
+
+namespace {
+
+constexpr uint32_t kPhiloxM0 = 0xD2511F53u;
+constexpr uint32_t kPhiloxM1 = 0xCD9E8D57u;
+constexpr uint32_t kPhiloxW0 = 0x9E3779B9u;
+constexpr uint32_t kPhiloxW1 = 0xBB67AE85u;
+
+// Values per chunk of a multithreaded fill.
+constexpr size_t kRandomGrain = size_t(1) << 14;
+
+// Blocks generated together by the lane-wise uniform kernel.
+constexpr size_t kLanes = 8;
+
+// What a counter block is used for (word 2 of the counter), so the
+// different draws of one stream never reuse a block.
+enum BlockKind : uint32_t { UNIFORM_BLOCK = 0, NORMAL_BLOCK = 1, INTEGER_BLOCK = 2, PERMUTATION_BLOCK = 3 };
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+std::array<uint32_t, 2> streamKey(uint64_t seed, uint64_t stream) {
+    uint64_t k = splitmix64(seed ^ splitmix64(stream));
+    return {static_cast<uint32_t>(k), static_cast<uint32_t>(k >> 32)};
+}
+
+std::array<uint32_t, 4> block(const std::array<uint32_t, 2>& key, uint64_t index, uint32_t kind,
+                              uint32_t attempt = 0) {
+    return philox4x32({static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), kind, attempt}, key);
+}
+
+// 53 random bits from two words, as a double in [0, 1).
+double unit53(uint32_t hi, uint32_t lo) {
+    uint64_t bits = ((static_cast<uint64_t>(hi) << 32) | lo) >> 11;
+    return static_cast<double>(bits) * 0x1.0p-53;
+}
+
+// The same bits shifted by half a step: a double in (0, 1).
+double openUnit53(uint32_t hi, uint32_t lo) {
+    uint64_t bits = ((static_cast<uint64_t>(hi) << 32) | lo) >> 11;
+    return (static_cast<double>(bits) + 0.5) * 0x1.0p-53;
+}
+
+// Ziggurat for the standard normal (Marsaglia & Tsang 2000) with 256
+// layers of equal area. x[i] is the right edge of layer i; layer 0 is the
+// base strip whose part beyond x[1] = r is the tail.
+struct ZigguratTables {
+    static constexpr int kLayers = 256;
+    static constexpr double kR = 3.6541528853610088;
+    static constexpr double kArea = 4.92867323399e-3;
+    double x[kLayers + 1];
+    double f[kLayers + 1]; // exp(-x^2 / 2)
+
+    ZigguratTables() {
+        auto density = [](double v) { return std::exp(-0.5 * v * v); };
+        x[0] = kArea / density(kR);
+        x[1] = kR;
+        for (int i = 1; i < kLayers - 1; i++)
+            x[i + 1] = std::sqrt(-2.0 * std::log(kArea / x[i] + density(x[i])));
+        x[kLayers] = 0.0;
+        for (int i = 0; i <= kLayers; i++) f[i] = density(x[i]);
+    }
+};
+
+const ZigguratTables& ziggurat() {
+    static const ZigguratTables tables;
+    return tables;
+}
+
+// One normal value from its own sequence of counter blocks (attempt 0, 1,
+// ...), so the value depends only on its index. Each attempt uses one
+// block: 8 bits pick the layer, 53 bits the signed abscissa and 32 bits the
+// wedge test; about 1% of attempts are rejected.
+double normalAt(const std::array<uint32_t, 2>& key, uint64_t index) {
+    const ZigguratTables& z = ziggurat();
+    for (uint32_t attempt = 0;; attempt++) {
+        auto w = block(key, index, NORMAL_BLOCK, attempt);
+        int layer = static_cast<int>(w[0] & 0xFF);
+        double u = 2.0 * unit53(w[1], w[2]) - 1.0;
+        double v = u * z.x[layer];
+        if (std::fabs(v) < z.x[layer + 1]) return v;
+        if (layer == 0) {
+            // Tail beyond r: Marsaglia's exponential rejection. Uses the
+            // next attempt's block for its two uniforms.
+            for (attempt++;; attempt++) {
+                auto t = block(key, index, NORMAL_BLOCK, attempt);
+                double a = -std::log(openUnit53(t[0], t[1])) / ZigguratTables::kR;
+                double b = -std::log(openUnit53(t[2], t[3]));
+                if (b + b >= a * a) return u < 0 ? -(ZigguratTables::kR + a) : ZigguratTables::kR + a;
+            }
+        }
+        double y = z.f[layer] + (w[3] + 0.5) * 0x1.0p-32 * (z.f[layer + 1] - z.f[layer]);
+        if (y < std::exp(-0.5 * v * v)) return v;
+    }
+}
+
+// Uniforms for positions [first, first + n): two per counter block. Whole
+// groups of kLanes blocks are generated lane-wise (the rounds run across
+// the lanes in plain loops the compiler vectorizes); the ragged ends go
+// one block at a time.
+void uniformRange(const std::array<uint32_t, 2>& key, uint64_t first, double* out, size_t n) {
+    size_t k = 0;
+    auto single = [&](uint64_t p) {
+        auto w = block(key, p >> 1, UNIFORM_BLOCK);
+        size_t h = (p & 1) * 2;
+        out[k++] = openUnit53(w[h], w[h + 1]);
+    };
+    if (n > 0 && (first & 1)) single(first);
+    while (n - k >= 2 * kLanes) {
+        uint64_t b0 = (first + k) >> 1;
+        uint32_t c0[kLanes], c1[kLanes], c2[kLanes], c3[kLanes], k0[kLanes], k1[kLanes];
+        for (size_t l = 0; l < kLanes; l++) {
+            c0[l] = static_cast<uint32_t>(b0 + l);
+            c1[l] = static_cast<uint32_t>((b0 + l) >> 32);
+            c2[l] = UNIFORM_BLOCK;
+            c3[l] = 0;
+            k0[l] = key[0];
+            k1[l] = key[1];
+        }
+        for (int round = 0; round < 10; round++) {
+            for (size_t l = 0; l < kLanes; l++) {
+                uint64_t p0 = static_cast<uint64_t>(kPhiloxM0) * c0[l];
+                uint64_t p1 = static_cast<uint64_t>(kPhiloxM1) * c2[l];
+                uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[l] ^ k0[l];
+                uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[l] ^ k1[l];
+                c1[l] = static_cast<uint32_t>(p1);
+                c3[l] = static_cast<uint32_t>(p0);
+                c0[l] = n0;
+                c2[l] = n2;
+                k0[l] += kPhiloxW0;
+                k1[l] += kPhiloxW1;
+            }
+        }
+        for (size_t l = 0; l < kLanes; l++) {
+            out[k + 2 * l] = openUnit53(c0[l], c1[l]);
+            out[k + 2 * l + 1] = openUnit53(c2[l], c3[l]);
+        }
+        k += 2 * kLanes;
+    }
+    while (k < n) single(first + k);
+}
+
+} // namespace
+
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> c, std::array<uint32_t, 2> key) {
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = static_cast<uint64_t>(kPhiloxM0) * c[0];
+        uint64_t p1 = static_cast<uint64_t>(kPhiloxM1) * c[2];
+        c = {static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ key[0], static_cast<uint32_t>(p1),
+             static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ key[1], static_cast<uint32_t>(p0)};
+        key[0] += kPhiloxW0;
+        key[1] += kPhiloxW1;
+    }
+    return c;
+}
+
+RandomStream::RandomStream(uint64_t seed, uint64_t stream, uint64_t position)
+    : seed_(seed), stream_(stream), position_(position) {}
+
+void RandomStream::reset(uint64_t seed) {
+    seed_ = seed;
+    stream_ = 0;
+    position_ = 0;
+}
+
+RandomStream RandomStream::substream(uint64_t id) const {
+    return RandomStream(seed_, splitmix64(stream_ ^ splitmix64(id + 1)), 0);
+}
+
+void RandomStream::fillUniform(double* out, size_t n) {
+    auto key = streamKey(seed_, stream_);
+    uint64_t first = position_;
+    parallelFor(n, kRandomGrain, [&](size_t b, size_t e) {
+        uniformRange(key, first + b, out + b, e - b);
+    });
+    position_ += n;
+}
+
+void RandomStream::fillNormal(double* out, size_t n) {
+    auto key = streamKey(seed_, stream_);
+    uint64_t first = position_;
+    parallelFor(n, kRandomGrain, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) out[i] = normalAt(key, first + i);
+    });
+    position_ += n;
+}
+
+void RandomStream::fillIntegers(double* out, size_t n, double lo, double hi) {
+    if (!(lo <= hi)) throw RuntimeError("randi: the lower limit must not exceed the upper limit");
+    double span = hi - lo + 1;
+    if (span > 0x1.0p53) throw RuntimeError("randi: the range of integers must not exceed 2^53");
+    auto key = streamKey(seed_, stream_);
+    uint64_t first = position_;
+    parallelFor(n, kRandomGrain, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+            uint64_t p = first + i;
+            auto w = block(key, p >> 1, INTEGER_BLOCK);
+            size_t h = (p & 1) * 2;
+            out[i] = lo + std::floor(unit53(w[h], w[h + 1]) * span);
+        }
+    });
+    position_ += n;
+}
+
+std::vector<double> RandomStream::permutation(size_t n, size_t k) {
+    if (k > n) throw RuntimeError("randperm: k must not exceed n");
+    // Partial Fisher-Yates: step i swaps in a random element of [i, n)
+    std::vector<double> values(n);
+    for (size_t i = 0; i < n; i++) values[i] = static_cast<double>(i + 1);
+    auto key = streamKey(seed_, stream_);
+    for (size_t i = 0; i < k; i++) {
+        uint64_t p = position_ + i;
+        auto w = block(key, p >> 1, PERMUTATION_BLOCK);
+        size_t h = (p & 1) * 2;
+        size_t j = i + static_cast<size_t>(unit53(w[h], w[h + 1]) * static_cast<double>(n - i));
+        std::swap(values[i], values[j]);
+    }
+    position_ += k;
+    values.resize(k);
+    return values;
+}
+
+} // namespace matfree
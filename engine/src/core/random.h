@@ -0,0 +1,57 @@
+#pragma once
+// MatFree - Counter-based random number streams (Philox4x32-10)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace matfree {
+
+/// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+/// A pure function of (counter, key): no state, so any element of a sequence
+/// can be generated independently of the others.
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key);
+
+/// A reproducible random stream: a seed, a stream id and a position.
+///
+/// Value k of a draw is a function of (seed, stream, position + k) only, so
+/// fills are split across threads freely and give the same bits for any
+/// thread count. Each draw advances the position by the number of values.
+/// Streams with different ids (see substream()) are independent.
+class RandomStream {
+public:
+    explicit RandomStream(uint64_t seed = 0, uint64_t stream = 0, uint64_t position = 0);
+
+    uint64_t seed() const { return seed_; }
+    uint64_t stream() const { return stream_; }
+    uint64_t position() const { return position_; }
+
+    /// Restart at position 0 of stream 0 for `seed` (rng(seed)).
+    void reset(uint64_t seed);
+
+    /// An independent stream derived from this one (e.g. one per parfor
+    /// iteration). Deterministic: the same id always gives the same stream.
+    RandomStream substream(uint64_t id) const;
+
+    /// Uniform doubles in the open interval (0, 1), 53 random bits each.
+    void fillUniform(double* out, size_t n);
+
+    /// Standard normal doubles (256-layer Ziggurat).
+    void fillNormal(double* out, size_t n);
+
+    /// Uniform integers in [lo, hi] (as doubles). Requires lo <= hi.
+    void fillIntegers(double* out, size_t n, double lo, double hi);
+
+    /// `k` distinct integers drawn from 1..n in random order (randperm).
+    /// Requires k <= n.
+    std::vector<double> permutation(size_t n, size_t k);
+
+private:
+    uint64_t seed_;
+    uint64_t stream_;
+    uint64_t position_;
+};
+
+} // namespace matfree
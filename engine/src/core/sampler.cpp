@@ -0,0 +1,253 @@
+// MatFree - Sampling profiler: flame graphs and Chrome traces of running code
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "sampler.h"
+#include "value.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+#endif
+
+namespace matfree {
+
+namespace {
+
+constexpr size_t kBufferWords = size_t(1) << 22; // 16 MB: ~4 minutes of 10-frame stacks at 1 kHz
+
+std::atomic<Sampler*> activeSampler{nullptr};
+
+#ifndef _WIN32
+uint64_t monotonicNs() {
+    timespec ts; // clock_gettime is async-signal-safe
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+#endif
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+void CallStack::push(int name) {
+    int d = depth_.load(std::memory_order_relaxed);
+    if (d < kMaxDepth) {
+        frames_[d].name.store(name, std::memory_order_relaxed);
+        frames_[d].line.store(0, std::memory_order_relaxed);
+    }
+    // Published after the frame is filled in
+    depth_.store(d + 1, std::memory_order_release);
+}
+
+void CallStack::pop() {
+    int d = depth_.load(std::memory_order_relaxed);
+    if (d > 0) depth_.store(d - 1, std::memory_order_release);
+}
+
+Sampler::Sampler() = default;
+
+Sampler::~Sampler() { stop(); }
+
+int Sampler::intern(const std::string& name) {
+    auto it = nameIds_.find(name);
+    if (it != nameIds_.end()) return it->second;
+    int id = static_cast<int>(names_.size());
+    names_.push_back(name);
+    nameIds_.emplace(name, id);
+    return id;
+}
+
+void Sampler::setScript(const std::string& name) {
+    if (stack_.depth() > 0) stack_.frames_[0].name.store(intern(name), std::memory_order_relaxed);
+}
+
+void Sampler::start(double hz, const std::string& script) {
+#ifdef _WIN32
+    (void)hz;
+    (void)script;
+    throw RuntimeError("profile: sampling needs SIGPROF, which this platform does not have");
+#else
+    if (running()) stop();
+    if (!(hz >= 1 && hz <= 100000)) throw RuntimeError("profile: sampling rate must be between 1 and 100000 Hz");
+    Sampler* expected = nullptr;
+    if (!activeSampler.compare_exchange_strong(expected, this))
+        throw RuntimeError("profile: another interpreter is already sampling");
+
+    buffer_.assign(kBufferWords, 0);
+    writePos_ = 0;
+    dropped_ = 0;
+    hz_ = hz;
+    stack_.reset();
+    stack_.push(intern(script));
+    startNs_ = monotonicNs();
+    running_ = true;
+
+    struct sigaction action {};
+    action.sa_handler = &Sampler::onSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+
+    long usec = std::max(1L, static_cast<long>(1e6 / hz));
+    itimerval timer{};
+    timer.it_interval.tv_sec = usec / 1000000;
+    timer.it_interval.tv_usec = usec % 1000000;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+#endif
+}
+
+void Sampler::stop() {
+#ifndef _WIN32
+    if (!running()) return;
+    itimerval off{};
+    setitimer(ITIMER_PROF, &off, nullptr);
+    running_ = false;
+    // A signal already being handled on another thread finishes first
+    while (inHandler_.load() > 0) std::this_thread::yield();
+    // Not the previous action: that is usually SIG_DFL, which terminates,
+    // and a SIGPROF raised before the timer stopped may still be pending
+    struct sigaction ignore {};
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&ignore.sa_mask);
+    sigaction(SIGPROF, &ignore, nullptr);
+    activeSampler = nullptr;
+#endif
+}
+
+void Sampler::onSignal(int) {
+    int savedErrno = errno;
+    if (Sampler* s = activeSampler.load(std::memory_order_acquire)) s->record();
+    errno = savedErrno;
+}
+
+void Sampler::record() {
+#ifndef _WIN32
+    inHandler_++;
+    if (running_.load(std::memory_order_relaxed)) {
+        int depth = std::min(stack_.depth_.load(std::memory_order_acquire), CallStack::kMaxDepth);
+        size_t need = 3 + 2 * static_cast<size_t>(depth);
+        size_t pos = writePos_.fetch_add(need);
+        if (pos + need < buffer_.size()) { // keep a 0 header after the last sample
+            uint64_t t = monotonicNs() - startNs_;
+            uint32_t* w = buffer_.data() + pos;
+            w[1] = static_cast<uint32_t>(t);
+            w[2] = static_cast<uint32_t>(t >> 32);
+            for (int i = 0; i < depth; i++) {
+                w[3 + 2 * i] = static_cast<uint32_t>(stack_.frames_[i].name.load(std::memory_order_relaxed));
+                w[4 + 2 * i] = static_cast<uint32_t>(stack_.frames_[i].line.load(std::memory_order_relaxed));
+            }
+            // The header last: a sample is complete once it is non-zero
+            __atomic_store_n(&w[0], static_cast<uint32_t>(depth + 1), __ATOMIC_RELEASE);
+        } else {
+            dropped_++;
+        }
+    }
+    inHandler_--;
+#endif
+}
+
+std::vector<Sampler::Sample> Sampler::decode() const {
+    std::vector<Sample> samples;
+    size_t end = std::min(writePos_.load(), buffer_.size());
+    for (size_t pos = 0; pos < end;) {
+        uint32_t header = buffer_[pos];
+        if (header == 0) break;
+        Sample s;
+        s.time = buffer_[pos + 1] | (static_cast<uint64_t>(buffer_[pos + 2]) << 32);
+        for (uint32_t i = 0; i + 1 < header; i++)
+            s.frames.emplace_back(static_cast<int>(buffer_[pos + 3 + 2 * i]),
+                                  static_cast<int>(buffer_[pos + 4 + 2 * i]));
+        pos += 3 + 2 * static_cast<size_t>(header - 1);
+        samples.push_back(std::move(s));
+    }
+    // Signals on several threads can finish out of order
+    std::stable_sort(samples.begin(), samples.end(), [](const Sample& a, const Sample& b) { return a.time < b.time; });
+    return samples;
+}
+
+size_t Sampler::samples() const { return decode().size(); }
+
+std::string Sampler::frameLabel(int name, int line) const {
+    std::string label = name >= 0 && name < static_cast<int>(names_.size()) ? names_[name] : "?";
+    if (line > 0) label += ":" + std::to_string(line);
+    return label;
+}
+
+std::string Sampler::foldedStacks() const {
+    std::map<std::string, size_t> counts;
+    for (auto& s : decode()) {
+        std::string stack;
+        for (auto& [name, line] : s.frames) {
+            std::string label = frameLabel(name, line);
+            // ';' separates frames and ' ' the count
+            std::replace(label.begin(), label.end(), ';', ',');
+            std::replace(label.begin(), label.end(), ' ', '_');
+            if (!stack.empty()) stack += ';';
+            stack += label;
+        }
+        if (!stack.empty()) counts[stack]++;
+    }
+    std::ostringstream os;
+    for (auto& [stack, n] : counts) os << stack << ' ' << n << '\n';
+    return os.str();
+}
+
+std::string Sampler::chromeTrace() const {
+    auto samples = decode();
+    std::ostringstream os;
+    os.precision(3);
+    os << std::fixed;
+    os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    auto event = [&](char phase, const std::pair<int, int>& frame, double us) {
+        os << (first ? "\n" : ",\n") << "  {\"name\": " << jsonString(frameLabel(frame.first, frame.second))
+           << ", \"ph\": \"" << phase << "\", \"ts\": " << us << ", \"pid\": 1, \"tid\": 1}";
+        first = false;
+    };
+    // Each sample stands for the interval up to the next one. Frames shared
+    // with the previous sample stay open; the rest end and begin.
+    std::vector<std::pair<int, int>> open;
+    double period = 1e6 / hz_;
+    double lastUs = 0;
+    for (auto& s : samples) {
+        double us = s.time / 1000.0;
+        size_t same = 0;
+        while (same < open.size() && same < s.frames.size() && open[same] == s.frames[same]) same++;
+        while (open.size() > same) {
+            event('E', open.back(), us);
+            open.pop_back();
+        }
+        for (size_t i = same; i < s.frames.size(); i++) {
+            event('B', s.frames[i], us);
+            open.push_back(s.frames[i]);
+        }
+        lastUs = us;
+    }
+    while (!open.empty()) {
+        event('E', open.back(), lastUs + period);
+        open.pop_back();
+    }
+    os << "\n]}\n";
+    return os.str();
+}
+
+} // namespace matfree
@@ -0,0 +1,117 @@
+#pragma once
+// MatFree - Sampling profiler: flame graphs and Chrome traces of running code
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace matfree {
+
+/// The interpreter's call stack as the sampler sees it: one frame per
+/// running user function (the script at the bottom), each with the line of
+/// the statement it is executing. Written by the interpreter thread, read
+/// from the sampling signal handler, so every field is atomic.
+class CallStack {
+public:
+    static constexpr int kMaxDepth = 256; // deeper frames are not recorded
+
+    void push(int name);
+    void pop();
+    void setLine(int line) {
+        int d = depth_.load(std::memory_order_relaxed);
+        if (d > 0 && d <= kMaxDepth) frames_[d - 1].line.store(line, std::memory_order_relaxed);
+    }
+    int depth() const { return depth_.load(std::memory_order_relaxed); }
+    void reset() { depth_.store(0, std::memory_order_relaxed); }
+
+private:
+    friend class Sampler;
+    struct Frame {
+        std::atomic<int> name{0};
+        std::atomic<int> line{0};
+    };
+    Frame frames_[kMaxDepth];
+    std::atomic<int> depth_{0};
+};
+
+/// Samples the call stack of one interpreter on a timer signal (SIGPROF,
+/// counting CPU time of every thread, so time spent in parallel kernels
+/// shows under the line that started them). One sampler can run at a time
+/// per process. Samples go to a buffer allocated when sampling starts;
+/// the signal handler only copies frames into it.
+class Sampler {
+public:
+    Sampler();
+    ~Sampler();
+    Sampler(const Sampler&) = delete;
+    Sampler& operator=(const Sampler&) = delete;
+
+    /// Start sampling `hz` times per second of CPU time, dropping earlier
+    /// samples. `script` names the bottom frame. Throws RuntimeError if
+    /// another sampler is running or the platform has no SIGPROF.
+    void start(double hz, const std::string& script);
+    void stop();
+    bool running() const { return running_.load(std::memory_order_relaxed); }
+
+    CallStack& stack() { return stack_; }
+
+    /// Id of a function or script name, for CallStack::push.
+    int intern(const std::string& name);
+
+    /// Rename the bottom frame (a new script starts at top level).
+    void setScript(const std::string& name);
+
+    /// Samples taken, and samples lost because the buffer was full.
+    size_t samples() const;
+    size_t dropped() const { return dropped_.load(); }
+
+    /// Collapsed stacks, one "script:line;fn:line;... count" line per
+    /// distinct stack, as flamegraph.pl and speedscope read them.
+    std::string foldedStacks() const;
+
+    /// Chrome trace-event JSON (chrome://tracing, Perfetto): the sampled
+    /// stacks as nested begin/end events on one timeline.
+    std::string chromeTrace() const;
+
+    /// Pushes a function's frame for the duration of its call.
+    class Scope {
+    public:
+        Scope(Sampler& s, const std::string& name) : stack_(s.stack_) { stack_.push(s.intern(name)); }
+        ~Scope() { stack_.pop(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        CallStack& stack_;
+    };
+
+private:
+    struct Sample {
+        uint64_t time; // ns since sampling started
+        std::vector<std::pair<int, int>> frames; // (name, line), bottom first
+    };
+
+    static void onSignal(int);
+    void record();
+    std::vector<Sample> decode() const;
+    std::string frameLabel(int name, int line) const;
+
+    CallStack stack_;
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, int> nameIds_;
+
+    // Each sample is [depth + 1, time low, time high, (name, line) x depth];
+    // a 0 header ends the data
+    std::vector<uint32_t> buffer_;
+    std::atomic<size_t> writePos_{0};
+    std::atomic<size_t> dropped_{0};
+    std::atomic<int> inHandler_{0};
+    std::atomic<bool> running_{false};
+    uint64_t startNs_ = 0;
+    double hz_ = 0;
+};
+
+} // namespace matfree
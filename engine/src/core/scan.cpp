@@ -0,0 +1,250 @@
+// MatFree - Prefix scan kernels
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "scan.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace matfree {
+
+namespace {
+
+// Elements per block of the two-pass scan over a single line.
+constexpr size_t kScanGrain = size_t(1) << 16;
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+// Scan operators: an identity and an associative combine(carry, x).
+struct SumOp {
+    static double identity() { return 0.0; }
+    double operator()(double a, double b) const { return a + b; }
+};
+struct ProdOp {
+    static double identity() { return 1.0; }
+    double operator()(double a, double b) const { return a * b; }
+};
+// fmax/fmin already skip NaN, and NaN is their identity: a run of leading
+// NaNs stays NaN until the first number appears.
+struct MaxOmitOp {
+    static double identity() { return kNaN; }
+    double operator()(double a, double b) const { return std::fmax(a, b); }
+};
+struct MinOmitOp {
+    static double identity() { return kNaN; }
+    double operator()(double a, double b) const { return std::fmin(a, b); }
+};
+struct MaxIncludeOp {
+    static double identity() { return -kInf; }
+    double operator()(double a, double b) const {
+        return (std::isnan(a) || std::isnan(b)) ? kNaN : std::max(a, b);
+    }
+};
+struct MinIncludeOp {
+    static double identity() { return kInf; }
+    double operator()(double a, double b) const {
+        return (std::isnan(a) || std::isnan(b)) ? kNaN : std::min(a, b);
+    }
+};
+// Treat NaN inputs as the identity ('omitnan' sums and products).
+template <class Op>
+struct SkipNaNOp {
+    static double identity() { return Op::identity(); }
+    double operator()(double a, double b) const { return std::isnan(b) ? a : Op()(a, b); }
+};
+
+template <class F>
+void withScanOp(ScanOp op, NanFlag nanFlag, F&& f) {
+    bool omit = (nanFlag == NanFlag::OMIT);
+    switch (op) {
+    case ScanOp::SUM:
+        if (omit) f(SkipNaNOp<SumOp>()); else f(SumOp());
+        break;
+    case ScanOp::PROD:
+        if (omit) f(SkipNaNOp<ProdOp>()); else f(ProdOp());
+        break;
+    case ScanOp::MAX:
+        if (omit) f(MaxOmitOp()); else f(MaxIncludeOp());
+        break;
+    case ScanOp::MIN:
+        if (omit) f(MinOmitOp()); else f(MinIncludeOp());
+        break;
+    }
+}
+
+// Scan n values spaced `step` apart, starting from `carry`; returns the last
+// output. Each group of four is prefix-combined on its own (independent of
+// the carry), then offset by the carry: the loop-carried dependency is one
+// combine per four elements instead of one per element.
+template <class Op>
+double scanLine(const double* in, double* out, size_t n, ptrdiff_t step, double carry, Op op) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        double a0 = op(Op::identity(), in[0]);
+        double a1 = op(a0, in[step]);
+        double a2 = op(a1, in[2 * step]);
+        double a3 = op(a2, in[3 * step]);
+        out[0] = op(carry, a0);
+        out[step] = op(carry, a1);
+        out[2 * step] = op(carry, a2);
+        carry = op(carry, a3);
+        out[3 * step] = carry;
+        in += 4 * step;
+        out += 4 * step;
+    }
+    for (; i < n; i++) {
+        carry = op(carry, *in);
+        *out = carry;
+        in += step;
+        out += step;
+    }
+    return carry;
+}
+
+// Combine of n values spaced `step` apart, with four independent partials.
+template <class Op>
+double reduceLine(const double* in, size_t n, ptrdiff_t step, Op op) {
+    double t0 = Op::identity(), t1 = t0, t2 = t0, t3 = t0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4, in += 4 * step) {
+        t0 = op(t0, in[0]);
+        t1 = op(t1, in[step]);
+        t2 = op(t2, in[2 * step]);
+        t3 = op(t3, in[3 * step]);
+    }
+    for (; i < n; i++, in += step) t0 = op(t0, *in);
+    return op(op(t0, t1), op(t2, t3));
+}
+
+// Scan one contiguous line; long lines use the blocked two-pass scheme.
+template <class Op>
+void scanContiguous(const double* in, double* out, size_t n, bool reverse, Op op) {
+    if (n == 0) return;
+    ptrdiff_t step = reverse ? -1 : 1;
+    const double* inBase = reverse ? in + (n - 1) : in;
+    double* outBase = reverse ? out + (n - 1) : out;
+
+    size_t nchunks = parallelChunkCount(n, kScanGrain);
+    if (nchunks <= 1 || inParallelRegion()) {
+        scanLine(inBase, outBase, n, step, Op::identity(), op);
+        return;
+    }
+    std::vector<double> offsets(nchunks);
+    parallelForChunks(n, kScanGrain, [&](size_t chunk, size_t begin, size_t end) {
+        offsets[chunk] = reduceLine(inBase + static_cast<ptrdiff_t>(begin) * step, end - begin, step, op);
+    });
+    // Exclusive scan of the block totals gives each block's starting carry.
+    double carry = Op::identity();
+    for (auto& t : offsets) {
+        double total = t;
+        t = carry;
+        carry = op(carry, total);
+    }
+    parallelForChunks(n, kScanGrain, [&](size_t chunk, size_t begin, size_t end) {
+        ptrdiff_t off = static_cast<ptrdiff_t>(begin) * step;
+        scanLine(inBase + off, outBase + off, end - begin, step, offsets[chunk], op);
+    });
+}
+
+} // namespace
+
+NanFlag defaultScanNanFlag(ScanOp op) {
+    return (op == ScanOp::MAX || op == ScanOp::MIN) ? NanFlag::OMIT : NanFlag::INCLUDE;
+}
+
+void scanValues(const double* in, double* out, size_t n, ScanOp op,
+                NanFlag nanFlag, bool reverse) {
+    withScanOp(op, nanFlag, [&](auto fn) { scanContiguous(in, out, n, reverse, fn); });
+}
+
+Matrix scanAlongDim(const Matrix& m, int dim, ScanOp op, NanFlag nanFlag, bool reverse) {
+    if (dim < 1) throw RuntimeError("Dimension argument must be a positive integer");
+    size_t rows = m.rows(), cols = m.cols();
+    Matrix result(rows, cols);
+    if (dim > 2 || m.numel() == 0) {
+        // Scanning along a singleton dimension: each element stands alone.
+        withScanOp(op, nanFlag, [&](auto fn) {
+            using Op = decltype(fn);
+            for (size_t i = 0; i < m.numel(); i++) result(i) = fn(Op::identity(), m(i));
+        });
+        return result;
+    }
+    const double* in = m.begin();
+    double* out = result.begin();
+
+    withScanOp(op, nanFlag, [&](auto fn) {
+        using Op = decltype(fn);
+        if (dim == 2 || cols == 1) {
+            // Lines are contiguous: one long line gets the two-pass scan,
+            // many lines are spread across threads.
+            size_t lines = (dim == 2) ? rows : 1;
+            size_t len = (dim == 2) ? cols : rows;
+            if (lines == 1) {
+                scanContiguous(in, out, len, reverse, fn);
+                return;
+            }
+            size_t grain = std::max<size_t>(1, 16384 / std::max<size_t>(len, 1));
+            parallelFor(lines, grain, [&](size_t begin, size_t end) {
+                for (size_t r = begin; r < end; r++) {
+                    const double* x = in + r * len;
+                    double* y = out + r * len;
+                    if (reverse) scanLine(x + len - 1, y + len - 1, len, -1, Op::identity(), fn);
+                    else scanLine(x, y, len, 1, Op::identity(), fn);
+                }
+            });
+            return;
+        }
+
+        // Column scan: sweep rows top to bottom (or bottom to top), combining
+        // each row with the previous output row. Threads own column ranges.
+        size_t grain = std::max<size_t>(64, 65536 / std::max<size_t>(rows, 1));
+        parallelFor(cols, grain, [&](size_t c0, size_t c1) {
+            for (size_t k = 0; k < rows; k++) {
+                size_t r = reverse ? rows - 1 - k : k;
+                const double* x = in + r * cols;
+                double* y = out + r * cols;
+                if (k == 0) {
+                    for (size_t c = c0; c < c1; c++) y[c] = fn(Op::identity(), x[c]);
+                } else {
+                    const double* prev = reverse ? y + cols : y - cols;
+                    for (size_t c = c0; c < c1; c++) y[c] = fn(prev[c], x[c]);
+                }
+            }
+        });
+    });
+    return result;
+}
+
+Matrix diffAlongDim(const Matrix& m, size_t order, int dim) {
+    if (dim != 1 && dim != 2) throw RuntimeError("diff: dimension must be 1 or 2");
+    Matrix cur = m;
+    for (size_t k = 0; k < order; k++) {
+        size_t rows = cur.rows(), cols = cur.cols();
+        size_t len = (dim == 1) ? rows : cols;
+        if (len == 0) break;
+        size_t outRows = (dim == 1) ? rows - 1 : rows;
+        size_t outCols = (dim == 2) ? cols - 1 : cols;
+        Matrix next(outRows, outCols);
+        const double* in = cur.begin();
+        double* out = next.begin();
+        size_t grain = std::max<size_t>(1, 16384 / std::max<size_t>(cols, 1));
+        parallelFor(outRows, grain, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++) {
+                const double* x = in + r * cols;
+                double* y = out + r * outCols;
+                if (dim == 1) {
+                    // Row r+1 minus row r: both contiguous
+                    for (size_t c = 0; c < cols; c++) y[c] = x[c + cols] - x[c];
+                } else {
+                    for (size_t c = 0; c < outCols; c++) y[c] = x[c + 1] - x[c];
+                }
+            }
+        });
+        cur = std::move(next);
+    }
+    return cur;
+}
+
+} // namespace matfree
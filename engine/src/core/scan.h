@@ -0,0 +1,32 @@
+#pragma once
+// MatFree - Prefix scan kernels (cumsum, cumprod, cummax, cummin) and diff
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "value.h"
+#include "statistics.h"
+
+namespace matfree {
+
+enum class ScanOp { SUM, PROD, MAX, MIN };
+
+/// Inclusive scan of `n` contiguous values into `out` (which may alias `in`).
+/// Long inputs use a blocked two-pass parallel scan: per-block totals, a
+/// serial scan over the totals, then every block scanned from its offset.
+/// NaN handling follows the cum* builtins: cumsum/cumprod propagate NaN
+/// unless OMIT; cummax/cummin skip NaN unless INCLUDE.
+void scanValues(const double* in, double* out, size_t n, ScanOp op,
+                NanFlag nanFlag, bool reverse = false);
+
+/// Scan every column (dim 1) or row (dim 2) of `m`. Traversal follows the
+/// row-major storage: a column scan sweeps whole rows at a time, so each
+/// step is one contiguous vector operation.
+Matrix scanAlongDim(const Matrix& m, int dim, ScanOp op, NanFlag nanFlag, bool reverse = false);
+
+/// Default NaN treatment for `op` ('includenan' for sums and products,
+/// 'omitnan' for running extrema).
+NanFlag defaultScanNanFlag(ScanOp op);
+
+/// `order`-th difference along `dim`; the result shrinks by `order` along it.
+Matrix diffAlongDim(const Matrix& m, size_t order, int dim);
+
+} // namespace matfree
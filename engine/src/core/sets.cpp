@@ -0,0 +1,299 @@
+// MatFree - Set kernels
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "sets.h"
+#include "parallel.h"
+#include "sorting.h"
+#include "value.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+namespace matfree {
+
+namespace {
+
+// Inputs below this size use a single table on the calling thread.
+constexpr size_t kParallelHashThreshold = size_t(1) << 16;
+
+// Element grain for the parallel passes.
+constexpr size_t kSetGrain = size_t(1) << 14;
+
+uint64_t mix64(uint64_t x) {
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t hashNumber(double v) {
+    if (v == 0.0) v = 0.0; // -0 hashes like +0
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return mix64(bits);
+}
+
+// Keys that can never match anything (NaN).
+bool isUnmatchable(const SetKeys& keys, size_t i) {
+    return !keys.isString && std::isnan(keys.numbers[i]);
+}
+
+bool keysEqual(const SetKeys& x, size_t i, const SetKeys& y, size_t j) {
+    return x.isString ? x.strings[i] == y.strings[j] : x.numbers[i] == y.numbers[j];
+}
+
+std::vector<uint64_t> hashKeys(const SetKeys& keys) {
+    std::vector<uint64_t> h(keys.size());
+    parallelFor(h.size(), kSetGrain, [&](size_t begin, size_t end) {
+        if (keys.isString) {
+            std::hash<std::string> hs;
+            for (size_t i = begin; i < end; i++) h[i] = mix64(hs(keys.strings[i]));
+        } else {
+            for (size_t i = begin; i < end; i++) h[i] = hashNumber(keys.numbers[i]);
+        }
+    });
+    return h;
+}
+
+/// Open-addressing (linear probing) table from key to the position of its
+/// first insertion. Slots keep the full hash so most probes skip the key
+/// comparison entirely.
+class IndexTable {
+public:
+    explicit IndexTable(size_t expected) {
+        size_t cap = 16;
+        while (cap < expected * 2) cap <<= 1;
+        slots_.assign(cap, Slot{});
+        mask_ = cap - 1;
+    }
+
+    /// Insert position `i` unless an equal key is present; return the
+    /// position stored for the key either way.
+    template <typename Eq>
+    size_t findOrInsert(uint64_t hash, size_t i, Eq&& eq) {
+        for (size_t s = hash & mask_;; s = (s + 1) & mask_) {
+            Slot& slot = slots_[s];
+            if (slot.pos == kNotFound) {
+                slot.hash = hash;
+                slot.pos = i;
+                return i;
+            }
+            if (slot.hash == hash && eq(slot.pos)) return slot.pos;
+        }
+    }
+
+    template <typename Eq>
+    size_t find(uint64_t hash, Eq&& eq) const {
+        for (size_t s = hash & mask_;; s = (s + 1) & mask_) {
+            const Slot& slot = slots_[s];
+            if (slot.pos == kNotFound) return kNotFound;
+            if (slot.hash == hash && eq(slot.pos)) return slot.pos;
+        }
+    }
+
+private:
+    struct Slot {
+        uint64_t hash = 0;
+        size_t pos = kNotFound;
+    };
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+};
+
+/// firstOf[i] = position of the first key equal to key i (i itself for NaN).
+std::vector<size_t> firstOccurrences(const SetKeys& keys) {
+    size_t n = keys.size();
+    std::vector<size_t> firstOf(n);
+    std::vector<uint64_t> h = hashKeys(keys);
+    auto processRange = [&](IndexTable& table, const size_t* pos, size_t count) {
+        for (size_t k = 0; k < count; k++) {
+            size_t i = pos[k];
+            firstOf[i] = isUnmatchable(keys, i)
+                ? i
+                : table.findOrInsert(h[i], i, [&](size_t j) { return keysEqual(keys, i, keys, j); });
+        }
+    };
+
+    size_t threads = parallelThreadCount();
+    if (n < kParallelHashThreshold || threads <= 1 || inParallelRegion()) {
+        std::vector<size_t> all(n);
+        std::iota(all.begin(), all.end(), size_t(0));
+        IndexTable table(n);
+        processRange(table, all.data(), n);
+        return firstOf;
+    }
+
+    // Partition positions by the top hash bits (stable, so each partition
+    // stays in ascending position order), then build one table per
+    // partition in parallel. Equal keys always share a partition.
+    size_t bits = 0;
+    while ((size_t(1) << bits) < threads * 4 && bits < 8) bits++;
+    size_t parts = size_t(1) << bits;
+    auto partOf = [&](size_t i) { return static_cast<size_t>(h[i] >> (64 - bits)); };
+
+    size_t nchunks = parallelChunkCount(n, kSetGrain);
+    std::vector<size_t> counts(nchunks * parts, 0);
+    parallelForChunks(n, kSetGrain, [&](size_t chunk, size_t begin, size_t end) {
+        size_t* c = counts.data() + chunk * parts;
+        for (size_t i = begin; i < end; i++) c[partOf(i)]++;
+    });
+    std::vector<size_t> partStart(parts + 1, 0);
+    size_t offset = 0;
+    for (size_t p = 0; p < parts; p++) {
+        partStart[p] = offset;
+        for (size_t c = 0; c < nchunks; c++) {
+            size_t cnt = counts[c * parts + p];
+            counts[c * parts + p] = offset;
+            offset += cnt;
+        }
+    }
+    partStart[parts] = offset;
+    std::vector<size_t> order(n);
+    parallelForChunks(n, kSetGrain, [&](size_t chunk, size_t begin, size_t end) {
+        size_t* c = counts.data() + chunk * parts;
+        for (size_t i = begin; i < end; i++) order[c[partOf(i)]++] = i;
+    });
+    parallelFor(parts, 1, [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; p++) {
+            size_t count = partStart[p + 1] - partStart[p];
+            IndexTable table(count);
+            processRange(table, order.data() + partStart[p], count);
+        }
+    });
+    return firstOf;
+}
+
+UniqueResult uniqueSorted(const SetKeys& keys, bool wantGroups) {
+    size_t n = keys.size();
+    std::vector<size_t> perm(n);
+    UniqueResult result;
+    if (keys.isString) {
+        std::iota(perm.begin(), perm.end(), size_t(0));
+        std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) {
+            return keys.strings[a] < keys.strings[b];
+        });
+    } else {
+        std::vector<double> values = keys.numbers;
+        std::vector<uint64_t> p64(n);
+        std::iota(p64.begin(), p64.end(), uint64_t(0));
+        sortValues(values.data(), n, SortOrder::ASCEND, p64.data());
+        for (size_t k = 0; k < n; k++) perm[k] = static_cast<size_t>(p64[k]);
+    }
+    if (wantGroups) result.group.resize(n);
+    // Stable sort: the first position of each run of equal keys is its
+    // earliest occurrence.
+    for (size_t k = 0; k < n; k++) {
+        size_t i = perm[k];
+        if (k == 0 || isUnmatchable(keys, i) || !keysEqual(keys, i, keys, perm[k - 1]))
+            result.first.push_back(i);
+        if (wantGroups) result.group[i] = result.first.size() - 1;
+    }
+    return result;
+}
+
+} // namespace
+
+SetKeys SetKeys::subset(const std::vector<size_t>& positions) const {
+    SetKeys out;
+    out.isString = isString;
+    if (isString) {
+        out.strings.reserve(positions.size());
+        for (size_t p : positions) out.strings.push_back(strings[p]);
+    } else {
+        out.numbers.reserve(positions.size());
+        for (size_t p : positions) out.numbers.push_back(numbers[p]);
+    }
+    return out;
+}
+
+SetKeys SetKeys::concat(const SetKeys& a, const SetKeys& b) {
+    if (a.isString != b.isString)
+        throw RuntimeError("Set inputs must both be numeric or both be cell arrays of strings");
+    SetKeys out = a;
+    out.numbers.insert(out.numbers.end(), b.numbers.begin(), b.numbers.end());
+    out.strings.insert(out.strings.end(), b.strings.begin(), b.strings.end());
+    return out;
+}
+
+UniqueResult uniqueKeys(const SetKeys& keys, bool sorted, bool wantGroups) {
+    if (sorted) return uniqueSorted(keys, wantGroups);
+
+    size_t n = keys.size();
+    std::vector<size_t> firstOf = firstOccurrences(keys);
+    UniqueResult result;
+    std::vector<size_t> rank(wantGroups ? n : 0);
+    for (size_t i = 0; i < n; i++) {
+        if (firstOf[i] != i) continue;
+        if (wantGroups) rank[i] = result.first.size();
+        result.first.push_back(i);
+    }
+    if (wantGroups) {
+        result.group.resize(n);
+        parallelFor(n, kSetGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) result.group[i] = rank[firstOf[i]];
+        });
+    }
+    return result;
+}
+
+std::vector<size_t> memberIndex(const SetKeys& query, const SetKeys& set) {
+    if (query.isString != set.isString)
+        throw RuntimeError("Set inputs must both be numeric or both be cell arrays of strings");
+    std::vector<uint64_t> hs = hashKeys(set);
+    IndexTable table(set.size());
+    for (size_t j = 0; j < set.size(); j++) {
+        if (isUnmatchable(set, j)) continue;
+        table.findOrInsert(hs[j], j, [&](size_t k) { return keysEqual(set, j, set, k); });
+    }
+
+    std::vector<uint64_t> hq = hashKeys(query);
+    std::vector<size_t> result(query.size());
+    parallelFor(query.size(), kSetGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            result[i] = isUnmatchable(query, i)
+                ? kNotFound
+                : table.find(hq[i], [&](size_t k) { return keysEqual(query, i, set, k); });
+        }
+    });
+    return result;
+}
+
+std::vector<SetElement> intersectKeys(const SetKeys& a, const SetKeys& b, bool sorted) {
+    auto ua = uniqueKeys(a, sorted, false);
+    auto inB = memberIndex(a.subset(ua.first), b);
+    std::vector<SetElement> out;
+    for (size_t k = 0; k < ua.first.size(); k++) {
+        if (inB[k] != kNotFound) out.push_back({ua.first[k], inB[k]});
+    }
+    return out;
+}
+
+std::vector<SetElement> unionKeys(const SetKeys& a, const SetKeys& b, bool sorted) {
+    auto u = uniqueKeys(SetKeys::concat(a, b), sorted, false);
+    size_t na = a.size();
+    std::vector<SetElement> out(u.first.size());
+    for (size_t k = 0; k < u.first.size(); k++) {
+        size_t p = u.first[k];
+        if (p < na) out[k].a = p;
+        else out[k].b = p - na;
+    }
+    return out;
+}
+
+std::vector<SetElement> setdiffKeys(const SetKeys& a, const SetKeys& b, bool sorted) {
+    auto ua = uniqueKeys(a, sorted, false);
+    auto inB = memberIndex(a.subset(ua.first), b);
+    std::vector<SetElement> out;
+    for (size_t k = 0; k < ua.first.size(); k++) {
+        if (inB[k] == kNotFound) out.push_back({ua.first[k], kNotFound});
+    }
+    return out;
+}
+
+} // namespace matfree
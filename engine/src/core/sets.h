@@ -0,0 +1,60 @@
+#pragma once
+// MatFree - Set kernels (unique, ismember, intersect, union, setdiff)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace matfree {
+
+/// Keys handed to the set kernels: either numbers (numeric, logical and
+/// char data) or strings (cell arrays of strings). NaN never equals
+/// anything, including another NaN; -0 and +0 are equal.
+struct SetKeys {
+    bool isString = false;
+    std::vector<double> numbers;
+    std::vector<std::string> strings;
+
+    size_t size() const { return isString ? strings.size() : numbers.size(); }
+    /// Keys at the given positions, in that order.
+    SetKeys subset(const std::vector<size_t>& positions) const;
+    /// `a` followed by `b` (both must hold the same kind of key).
+    static SetKeys concat(const SetKeys& a, const SetKeys& b);
+};
+
+constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+/// Distinct keys. `first` holds the position of the first occurrence of
+/// each distinct key, in output order (ascending keys when sorted, order of
+/// first appearance otherwise). `group` maps every input position to its
+/// 0-based index in `first` (only filled when requested).
+struct UniqueResult {
+    std::vector<size_t> first;
+    std::vector<size_t> group;
+};
+
+/// Sorted output uses a stable (radix) sort and a merge of equal runs;
+/// stable output uses open-addressing hash tables, partitioned by hash and
+/// built in parallel for large inputs.
+UniqueResult uniqueKeys(const SetKeys& keys, bool sorted, bool wantGroups);
+
+/// For each query key, the lowest position of an equal key in `set`, or
+/// kNotFound. Lookups into the hash table run in parallel.
+std::vector<size_t> memberIndex(const SetKeys& query, const SetKeys& set);
+
+/// One output element of a two-input set operation: its position in A
+/// and/or B (kNotFound when it is not taken from that input).
+struct SetElement {
+    size_t a = kNotFound;
+    size_t b = kNotFound;
+};
+
+/// Distinct keys present in both inputs; `a` and `b` are first occurrences.
+std::vector<SetElement> intersectKeys(const SetKeys& a, const SetKeys& b, bool sorted);
+/// Distinct keys of either input; keys present in A are taken from A.
+std::vector<SetElement> unionKeys(const SetKeys& a, const SetKeys& b, bool sorted);
+/// Distinct keys of A that do not occur in B.
+std::vector<SetElement> setdiffKeys(const SetKeys& a, const SetKeys& b, bool sorted);
+
+} // namespace matfree
@@ -0,0 +1,47 @@
+// MatFree - Shared libraries loaded at run time (dlopen / LoadLibrary)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "shared_library.h"
+#include "value.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace matfree {
+
+std::shared_ptr<SharedLibrary> SharedLibrary::open(const std::string& path) {
+    std::shared_ptr<SharedLibrary> lib(new SharedLibrary());
+    lib->path_ = path;
+#ifdef _WIN32
+    lib->handle_ = LoadLibraryA(path.c_str());
+    if (!lib->handle_)
+        throw RuntimeError("Cannot load library '" + path + "' (error " + std::to_string(GetLastError()) + ")");
+#else
+    lib->handle_ = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!lib->handle_) throw RuntimeError("Cannot load library '" + path + "': " + dlerror());
+#endif
+    return lib;
+}
+
+SharedLibrary::~SharedLibrary() {
+    if (!handle_) return;
+#ifdef _WIN32
+    FreeLibrary(static_cast<HMODULE>(handle_));
+#else
+    dlclose(handle_);
+#endif
+}
+
+void* SharedLibrary::symbol(const std::string& name) const {
+#ifdef _WIN32
+    return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(handle_), name.c_str()));
+#else
+    return dlsym(handle_, name.c_str());
+#endif
+}
+
+} // namespace matfree
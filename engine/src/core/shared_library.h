@@ -0,0 +1,32 @@
+#pragma once
+// MatFree - Shared libraries loaded at run time (dlopen / LoadLibrary)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include <memory>
+#include <string>
+
+namespace matfree {
+
+/// A loaded shared library, unloaded when the last reference goes away.
+class SharedLibrary {
+public:
+    /// Throws RuntimeError (with the loader's reason) if `path` cannot be
+    /// loaded.
+    static std::shared_ptr<SharedLibrary> open(const std::string& path);
+
+    ~SharedLibrary();
+    SharedLibrary(const SharedLibrary&) = delete;
+    SharedLibrary& operator=(const SharedLibrary&) = delete;
+
+    /// Address of an exported symbol, or nullptr.
+    void* symbol(const std::string& name) const;
+
+    const std::string& path() const { return path_; }
+
+private:
+    SharedLibrary() = default;
+    void* handle_ = nullptr;
+    std::string path_;
+};
+
+} // namespace matfree
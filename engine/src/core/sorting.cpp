@@ -0,0 +1,318 @@
+// MatFree - Sorting kernels
+// Copyright (c) 2026 MatFree Contributors - MIT License
+//
+// Doubles are sorted as 64-bit unsigned keys (see sortKey) with an LSD radix
+// sort: 6 passes of 11 bits, skipping passes whose digit is constant across the
+// input. Each pass is split into chunks that histogram and scatter in parallel;
+// chunks scatter into disjoint, ordered ranges of each bucket, so the sort is
+// stable and the result does not depend on the thread count.
+
+#include "sorting.h"
+#include "parallel.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+
+namespace matfree {
+
+namespace {
+
+constexpr uint64_t kSignBit = 0x8000000000000000ULL;
+constexpr uint64_t kCanonicalNaN = 0x7FF8000000000000ULL;
+
+// Below this size a comparison sort beats the fixed cost of the radix passes.
+constexpr size_t kRadixThreshold = 2048;
+
+// Elements per chunk for the parallel radix passes.
+constexpr size_t kRadixGrain = size_t(1) << 16;
+
+constexpr int kDigitBits = 11;
+constexpr int kBuckets = 1 << kDigitBits;
+constexpr int kPasses = (64 + kDigitBits - 1) / kDigitBits;
+
+using Histogram = std::array<size_t, kBuckets>;
+
+double keyToDouble(uint64_t key) {
+    uint64_t bits = (key & kSignBit) ? (key ^ kSignBit) : ~key;
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/// LSD radix sort of `keys` (ascending, stable), carrying `payload` along.
+void radixSortKeys(uint64_t* keys, uint64_t* payload, size_t n, bool parallel) {
+    size_t grain = parallel ? kRadixGrain : n;
+    size_t nchunks = parallelChunkCount(n, grain);
+
+    // One read of the input gives the digit histograms for every pass; a
+    // pass whose digit is identical for all keys can be skipped entirely.
+    std::array<Histogram, kPasses> global{};
+    std::mutex globalMutex;
+    parallelForChunks(n, grain, [&](size_t, size_t begin, size_t end) {
+        std::array<Histogram, kPasses> local{};
+        for (size_t i = begin; i < end; i++) {
+            uint64_t k = keys[i];
+            for (int p = 0; p < kPasses; p++)
+                local[p][(k >> (p * kDigitBits)) & (kBuckets - 1)]++;
+        }
+        std::lock_guard<std::mutex> lock(globalMutex);
+        for (int p = 0; p < kPasses; p++)
+            for (int b = 0; b < kBuckets; b++) global[p][b] += local[p][b];
+    });
+
+    std::vector<uint64_t> tmpKeys(n);
+    std::vector<uint64_t> tmpPayload(payload ? n : 0);
+    uint64_t* srcK = keys;
+    uint64_t* dstK = tmpKeys.data();
+    uint64_t* srcP = payload;
+    uint64_t* dstP = payload ? tmpPayload.data() : nullptr;
+
+    std::vector<Histogram> offsets(nchunks);
+    for (int p = 0; p < kPasses; p++) {
+        bool trivial = false;
+        for (int b = 0; b < kBuckets; b++) {
+            if (global[p][b] == n) { trivial = true; break; }
+        }
+        if (trivial) continue;
+
+        int shift = p * kDigitBits;
+        if (nchunks == 1) {
+            // A single chunk's histogram is the global one: skip the re-count.
+            offsets[0] = global[p];
+        } else {
+            for (auto& h : offsets) h.fill(0);
+            parallelForChunks(n, grain, [&](size_t c, size_t begin, size_t end) {
+                Histogram& h = offsets[c];
+                for (size_t i = begin; i < end; i++) h[(srcK[i] >> shift) & (kBuckets - 1)]++;
+            });
+        }
+
+        // Exclusive prefix over (bucket, chunk): chunk c writes its share of
+        // bucket b right after chunks 0..c-1, which keeps the pass stable.
+        size_t running = 0;
+        for (int b = 0; b < kBuckets; b++) {
+            for (size_t c = 0; c < nchunks; c++) {
+                size_t cnt = offsets[c][b];
+                offsets[c][b] = running;
+                running += cnt;
+            }
+        }
+
+        parallelForChunks(n, grain, [&](size_t c, size_t begin, size_t end) {
+            Histogram pos = offsets[c];
+            if (srcP) {
+                for (size_t i = begin; i < end; i++) {
+                    uint64_t k = srcK[i];
+                    size_t dst = pos[(k >> shift) & (kBuckets - 1)]++;
+                    dstK[dst] = k;
+                    dstP[dst] = srcP[i];
+                }
+            } else {
+                for (size_t i = begin; i < end; i++) {
+                    uint64_t k = srcK[i];
+                    dstK[pos[(k >> shift) & (kBuckets - 1)]++] = k;
+                }
+            }
+        });
+
+        std::swap(srcK, dstK);
+        std::swap(srcP, dstP);
+    }
+
+    if (srcK != keys) {
+        parallelFor(n, grain, [&](size_t begin, size_t end) {
+            std::memcpy(keys + begin, srcK + begin, (end - begin) * sizeof(uint64_t));
+            if (payload)
+                std::memcpy(payload + begin, srcP + begin, (end - begin) * sizeof(uint64_t));
+        });
+    }
+}
+
+void sortValuesImpl(double* data, size_t n, SortOrder order, uint64_t* perm, bool parallel) {
+    if (n < 2) return;
+    uint64_t flip = (order == SortOrder::DESCEND) ? ~uint64_t(0) : 0;
+    size_t grain = parallel ? kRadixGrain : n;
+
+    std::vector<uint64_t> keys(n);
+    parallelFor(n, grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) keys[i] = sortKey(data[i]) ^ flip;
+    });
+
+    if (n < kRadixThreshold) {
+        if (perm) {
+            // Equal keys must keep their relative order for the index output.
+            std::vector<std::pair<uint64_t, uint64_t>> pairs(n);
+            for (size_t i = 0; i < n; i++) pairs[i] = {keys[i], perm[i]};
+            std::stable_sort(pairs.begin(), pairs.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (size_t i = 0; i < n; i++) {
+                keys[i] = pairs[i].first;
+                perm[i] = pairs[i].second;
+            }
+        } else {
+            // Keys are unique per value, so stability is irrelevant here.
+            std::sort(keys.begin(), keys.end());
+        }
+    } else {
+        radixSortKeys(keys.data(), perm, n, parallel);
+    }
+
+    parallelFor(n, grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) data[i] = keyToDouble(keys[i] ^ flip);
+    });
+}
+
+/// Cache-blocked out-of-place transpose of a rows x cols row-major array.
+void transposeInto(const double* src, size_t rows, size_t cols, double* dst) {
+    constexpr size_t B = 32;
+    parallelFor(rows, 256, [&](size_t r0, size_t r1) {
+        for (size_t ib = r0; ib < r1; ib += B) {
+            size_t iend = std::min(ib + B, r1);
+            for (size_t jb = 0; jb < cols; jb += B) {
+                size_t jend = std::min(jb + B, cols);
+                for (size_t i = ib; i < iend; i++)
+                    for (size_t j = jb; j < jend; j++)
+                        dst[j * rows + i] = src[i * cols + j];
+            }
+        }
+    });
+}
+
+/// Sort each of `count` contiguous lines of length `len` in `data`, writing
+/// 1-based source positions to `idx` when non-null. Many short lines are
+/// sorted in parallel (one line per task); a few long lines parallelize
+/// inside the radix sort instead.
+void sortLines(double* data, size_t count, size_t len, SortOrder order, double* idx) {
+    bool batch = count >= parallelThreadCount() && count > 1;
+    size_t grain = std::max<size_t>(1, kRadixGrain / std::max<size_t>(len, 1));
+    auto sortOne = [&](size_t line, bool parallelInside) {
+        double* row = data + line * len;
+        if (idx) {
+            std::vector<uint64_t> perm(len);
+            std::iota(perm.begin(), perm.end(), uint64_t(0));
+            sortValuesImpl(row, len, order, perm.data(), parallelInside);
+            double* out = idx + line * len;
+            for (size_t i = 0; i < len; i++) out[i] = static_cast<double>(perm[i] + 1);
+        } else {
+            sortValuesImpl(row, len, order, nullptr, parallelInside);
+        }
+    };
+    if (batch) {
+        parallelFor(count, grain, [&](size_t begin, size_t end) {
+            for (size_t line = begin; line < end; line++) sortOne(line, false);
+        });
+    } else {
+        for (size_t line = 0; line < count; line++) sortOne(line, true);
+    }
+}
+
+} // namespace
+
+uint64_t sortKey(double v) {
+    uint64_t bits;
+    if (std::isnan(v)) {
+        bits = kCanonicalNaN;
+    } else {
+        std::memcpy(&bits, &v, sizeof(bits));
+    }
+    return (bits & kSignBit) ? ~bits : (bits | kSignBit);
+}
+
+void sortValues(double* data, size_t n, SortOrder order, uint64_t* perm) {
+    sortValuesImpl(data, n, order, perm, true);
+}
+
+int defaultSortDim(const Matrix& m) {
+    if (m.rows() != 1) return 1;
+    return 2;
+}
+
+SortResult sortAlongDim(const Matrix& m, int dim, SortOrder order, bool wantIndices) {
+    size_t rows = m.rows(), cols = m.cols();
+    SortResult res;
+    if (dim != 1 && dim != 2) {
+        // Every slice along a trailing dimension holds one element.
+        res.values = m;
+        if (wantIndices) res.indices = Matrix::ones(rows, cols);
+        return res;
+    }
+
+    if (dim == 2) {
+        // Rows are contiguous in storage: sort them in place.
+        res.values = m;
+        if (wantIndices) res.indices = Matrix(rows, cols);
+        sortLines(res.values.begin(), rows, cols, order,
+                  wantIndices ? res.indices.begin() : nullptr);
+        return res;
+    }
+
+    // Columns are strided; transpose so each column becomes a contiguous
+    // line, sort the lines, and transpose back.
+    if (cols == 1) {
+        res.values = m;
+        if (wantIndices) res.indices = Matrix(rows, 1);
+        sortLines(res.values.begin(), 1, rows, order,
+                  wantIndices ? res.indices.begin() : nullptr);
+        return res;
+    }
+    std::vector<double> lines(rows * cols);
+    std::vector<double> lineIdx(wantIndices ? rows * cols : 0);
+    transposeInto(m.begin(), rows, cols, lines.data());
+    sortLines(lines.data(), cols, rows, order, wantIndices ? lineIdx.data() : nullptr);
+    res.values = Matrix(rows, cols);
+    transposeInto(lines.data(), cols, rows, res.values.begin());
+    if (wantIndices) {
+        res.indices = Matrix(rows, cols);
+        transposeInto(lineIdx.data(), cols, rows, res.indices.begin());
+    }
+    return res;
+}
+
+SortResult sortRows(const Matrix& m, const std::vector<int>& columns, bool wantIndices) {
+    size_t rows = m.rows(), cols = m.cols();
+    std::vector<int> keys = columns;
+    if (keys.empty()) {
+        for (size_t j = 0; j < cols; j++) keys.push_back(static_cast<int>(j + 1));
+    }
+    for (int k : keys) {
+        size_t c = static_cast<size_t>(std::abs(k));
+        if (k == 0 || c > cols)
+            throw RuntimeError("sortrows: column index " + std::to_string(k) +
+                               " out of range for " + std::to_string(cols) + " columns");
+    }
+
+    // LSD over the key columns: stable-sort by the last key first, so after
+    // the final (primary) key, ties are resolved by the later keys in order.
+    std::vector<uint64_t> perm(rows), step(rows);
+    std::iota(perm.begin(), perm.end(), uint64_t(0));
+    std::vector<double> column(rows);
+    for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
+        size_t c = static_cast<size_t>(std::abs(*it)) - 1;
+        SortOrder order = (*it < 0) ? SortOrder::DESCEND : SortOrder::ASCEND;
+        for (size_t i = 0; i < rows; i++) column[i] = m(perm[i], c);
+        std::iota(step.begin(), step.end(), uint64_t(0));
+        sortValues(column.data(), rows, order, step.data());
+        std::vector<uint64_t> next(rows);
+        for (size_t i = 0; i < rows; i++) next[i] = perm[step[i]];
+        perm.swap(next);
+    }
+
+    SortResult res;
+    res.values = Matrix(rows, cols);
+    const double* src = m.begin();
+    double* dst = res.values.begin();
+    parallelFor(rows, std::max<size_t>(1, 4096 / std::max<size_t>(cols, 1)),
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                std::copy_n(src + perm[i] * cols, cols, dst + i * cols);
+        });
+    if (wantIndices) {
+        res.indices = Matrix(rows, 1);
+        for (size_t i = 0; i < rows; i++) res.indices(i) = static_cast<double>(perm[i] + 1);
+    }
+    return res;
+}
+
+} // namespace matfree
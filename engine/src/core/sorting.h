@@ -0,0 +1,43 @@
+#pragma once
+// MatFree - Sorting kernels (radix sort on IEEE-754 keys, sort along dims, sortrows)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "value.h"
+#include <cstdint>
+#include <vector>
+
+namespace matfree {
+
+enum class SortOrder { ASCEND, DESCEND };
+
+/// Map a double onto an unsigned key whose integer order matches the
+/// MatFree sort order: -Inf < ... < -0 < +0 < ... < +Inf < NaN.
+/// All NaNs map to one key; every other value maps to a distinct key.
+uint64_t sortKey(double v);
+
+/// Stable sort of `n` doubles in place. When `perm` is non-null it must hold
+/// n entries; it is permuted alongside the values (callers typically seed it
+/// with 0..n-1 to obtain the source position of each sorted element).
+/// Large inputs use a parallel LSD radix sort; small ones a comparison sort.
+/// NaNs go last for ASCEND and first for DESCEND.
+void sortValues(double* data, size_t n, SortOrder order, uint64_t* perm = nullptr);
+
+/// Result of a sort over a matrix: sorted values plus 1-based indices
+/// (indices is empty unless requested).
+struct SortResult {
+    Matrix values;
+    Matrix indices;
+};
+
+/// Sort every column (dim 1) or row (dim 2) of `m` independently.
+SortResult sortAlongDim(const Matrix& m, int dim, SortOrder order, bool wantIndices);
+
+/// Sort the rows of `m` lexicographically by the given 1-based columns; a
+/// negative column number sorts that key descending. An empty `columns`
+/// means all columns in order. The sort is stable.
+SortResult sortRows(const Matrix& m, const std::vector<int>& columns, bool wantIndices);
+
+/// Default dimension for the sort family: first non-singleton, else 1.
+int defaultSortDim(const Matrix& m);
+
+} // namespace matfree
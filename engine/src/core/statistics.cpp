@@ -0,0 +1,351 @@
+// MatFree - Statistics kernels
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "statistics.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace matfree {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+/// Move NaNs to the end and return the number of non-NaN values, or return
+/// n unchanged with `hasNaN` set when NaNs should propagate.
+size_t prepareForSelection(double* data, size_t n, NanFlag nanFlag, bool& hasNaN) {
+    hasNaN = false;
+    if (nanFlag == NanFlag::OMIT) {
+        return static_cast<size_t>(
+            std::partition(data, data + n, [](double v) { return !std::isnan(v); }) - data);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (std::isnan(data[i])) { hasNaN = true; break; }
+    }
+    return n;
+}
+
+/// Place the order statistics with the given (sorted, distinct, 0-based)
+/// ranks at their final positions in [first, last). Each partition step
+/// splits the remaining ranks, so k ranks cost O(n log k) overall.
+void multiSelect(double* first, double* last, double* base,
+                 const size_t* rankBegin, const size_t* rankEnd) {
+    while (rankBegin < rankEnd) {
+        const size_t* mid = rankBegin + (rankEnd - rankBegin) / 2;
+        double* nth = base + *mid;
+        std::nth_element(first, nth, last);
+        // Left ranks live in [first, nth); continue with the right side here.
+        multiSelect(first, nth, base, rankBegin, mid);
+        first = nth + 1;
+        rankBegin = mid + 1;
+    }
+}
+
+} // namespace
+
+double medianInPlace(double* data, size_t n, NanFlag nanFlag) {
+    double out;
+    quantilesInPlace(data, n, {0.5}, &out, nanFlag);
+    return out;
+}
+
+void quantilesInPlace(double* data, size_t n, const std::vector<double>& probs,
+                      double* out, NanFlag nanFlag) {
+    bool hasNaN;
+    size_t m = prepareForSelection(data, n, nanFlag, hasNaN);
+    if (hasNaN || m == 0) {
+        std::fill(out, out + probs.size(), kNaN);
+        return;
+    }
+
+    // Positions (1-based, fractional) of each requested quantile.
+    std::vector<size_t> ranks;
+    std::vector<std::pair<size_t, double>> where(probs.size());
+    for (size_t q = 0; q < probs.size(); q++) {
+        double p = probs[q];
+        if (std::isnan(p) || p < 0.0 || p > 1.0)
+            throw RuntimeError("quantile: probabilities must be between 0 and 1");
+        double pos = std::clamp(p * static_cast<double>(m) + 0.5, 1.0, static_cast<double>(m));
+        size_t lo = static_cast<size_t>(std::floor(pos)) - 1;
+        double frac = pos - std::floor(pos);
+        where[q] = {lo, frac};
+        ranks.push_back(lo);
+        if (frac > 0.0 && lo + 1 < m) ranks.push_back(lo + 1);
+    }
+    std::sort(ranks.begin(), ranks.end());
+    ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+    multiSelect(data, data + m, data, ranks.data(), ranks.data() + ranks.size());
+
+    for (size_t q = 0; q < probs.size(); q++) {
+        auto [lo, frac] = where[q];
+        double v = data[lo];
+        if (frac > 0.0 && lo + 1 < m) v += frac * (data[lo + 1] - v);
+        out[q] = v;
+    }
+}
+
+std::pair<double, double> modeOf(const double* data, size_t n) {
+    std::unordered_map<double, size_t> counts;
+    counts.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        double v = data[i];
+        if (std::isnan(v)) continue;
+        counts[v == 0.0 ? 0.0 : v]++; // -0 and +0 count together
+    }
+    double best = kNaN;
+    size_t bestCount = 0;
+    for (auto& [v, c] : counts) {
+        if (c > bestCount || (c == bestCount && v < best)) {
+            best = v;
+            bestCount = c;
+        }
+    }
+    return {best, static_cast<double>(bestCount)};
+}
+
+// ----------------------------------------------------------------------------
+// Moments
+// ----------------------------------------------------------------------------
+
+namespace {
+
+// Values per locally computed block; small enough to stay in L1/L2 between
+// the sum pass and the squared-deviation pass.
+constexpr size_t kMomentBlock = 4096;
+
+// Rows per block in the column-wise kernels.
+constexpr size_t kRowBlock = 256;
+
+} // namespace
+
+void MomentAccumulator::add(double x) {
+    count += 1.0;
+    double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+    min = std::min(min, x);
+    max = std::max(max, x);
+}
+
+void MomentAccumulator::add(const double* data, size_t n) {
+    for (size_t b = 0; b < n; b += kMomentBlock) {
+        size_t len = std::min(kMomentBlock, n - b);
+        const double* x = data + b;
+        MomentAccumulator block;
+        double sum = 0.0;
+        for (size_t i = 0; i < len; i++) sum += x[i];
+        block.count = static_cast<double>(len);
+        block.mean = sum / block.count;
+        double ss = 0.0, lo = block.min, hi = block.max;
+        for (size_t i = 0; i < len; i++) {
+            double d = x[i] - block.mean;
+            ss += d * d;
+            lo = std::min(lo, x[i]);
+            hi = std::max(hi, x[i]);
+        }
+        block.m2 = ss;
+        block.min = lo;
+        block.max = hi;
+        merge(block);
+    }
+}
+
+void MomentAccumulator::addOmittingNaN(const double* data, size_t n) {
+    double buf[kMomentBlock];
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (std::isnan(data[i])) continue;
+        buf[len++] = data[i];
+        if (len == kMomentBlock) {
+            add(buf, len);
+            len = 0;
+        }
+    }
+    add(buf, len);
+}
+
+void MomentAccumulator::merge(const MomentAccumulator& other) {
+    if (other.count == 0.0) return;
+    if (count == 0.0) {
+        *this = other;
+        return;
+    }
+    double total = count + other.count;
+    double delta = other.mean - mean;
+    mean += delta * (other.count / total);
+    m2 += other.m2 + delta * delta * (count * other.count / total);
+    count = total;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+double MomentAccumulator::variance(int normalization) const {
+    if (count == 0.0) return kNaN;
+    double denom = (normalization == 1 || count == 1.0) ? count : count - 1.0;
+    return m2 / denom;
+}
+
+MomentAccumulator accumulateMoments(const double* data, size_t n, NanFlag nanFlag) {
+    constexpr size_t grain = size_t(1) << 16;
+    bool omit = nanFlag == NanFlag::OMIT;
+    std::vector<MomentAccumulator> partial(parallelChunkCount(n, grain));
+    parallelForChunks(n, grain, [&](size_t chunk, size_t begin, size_t end) {
+        if (omit) partial[chunk].addOmittingNaN(data + begin, end - begin);
+        else partial[chunk].add(data + begin, end - begin);
+    });
+    MomentAccumulator total;
+    for (auto& acc : partial) total.merge(acc);
+    return total;
+}
+
+std::vector<MomentAccumulator> momentsAlongDim(const Matrix& m, int dim, NanFlag nanFlag) {
+    if (dim != 1 && dim != 2)
+        throw RuntimeError("Dimension argument must be 1 or 2");
+    size_t rows = m.rows(), cols = m.cols();
+    const double* data = m.begin();
+    bool omit = nanFlag == NanFlag::OMIT;
+
+    if (dim == 2) {
+        std::vector<MomentAccumulator> out(rows);
+        size_t grain = std::max<size_t>(1, 16384 / std::max<size_t>(cols, 1));
+        parallelFor(rows, grain, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++) {
+                if (omit) out[r].addOmittingNaN(data + r * cols, cols);
+                else out[r].add(data + r * cols, cols);
+            }
+        });
+        return out;
+    }
+
+    if (omit) {
+        // Columns with NaNs skipped: per-element updates, columns split
+        // across threads
+        std::vector<MomentAccumulator> out(cols);
+        size_t grain = std::max<size_t>(1, 16384 / std::max<size_t>(rows, 1));
+        parallelFor(cols, grain, [&](size_t begin, size_t end) {
+            for (size_t r = 0; r < rows; r++) {
+                const double* row = data + r * cols;
+                for (size_t c = begin; c < end; c++)
+                    if (!std::isnan(row[c])) out[c].add(row[c]);
+            }
+        });
+        return out;
+    }
+
+    // Columns: stream whole rows (contiguous) into per-column accumulators.
+    // Row chunks get private accumulators, bounded to ~1M in total.
+    size_t grain = std::max<size_t>(65536 / std::max<size_t>(cols, 1), 1);
+    grain = std::max(grain, (rows * cols + (size_t(1) << 20) - 1) >> 20);
+    size_t nchunks = parallelChunkCount(rows, grain);
+    std::vector<std::vector<MomentAccumulator>> partial(nchunks);
+    parallelForChunks(rows, grain, [&](size_t chunk, size_t begin, size_t end) {
+        auto& acc = partial[chunk];
+        acc.resize(cols);
+        std::vector<double> sum(cols), ss(cols), lo(cols), hi(cols);
+        for (size_t r0 = begin; r0 < end; r0 += kRowBlock) {
+            size_t r1 = std::min(r0 + kRowBlock, end);
+            double cnt = static_cast<double>(r1 - r0);
+            std::fill(sum.begin(), sum.end(), 0.0);
+            std::fill(ss.begin(), ss.end(), 0.0);
+            std::fill(lo.begin(), lo.end(), std::numeric_limits<double>::infinity());
+            std::fill(hi.begin(), hi.end(), -std::numeric_limits<double>::infinity());
+            for (size_t r = r0; r < r1; r++) {
+                const double* row = data + r * cols;
+                for (size_t c = 0; c < cols; c++) sum[c] += row[c];
+            }
+            for (size_t c = 0; c < cols; c++) sum[c] /= cnt; // block means
+            for (size_t r = r0; r < r1; r++) {
+                const double* row = data + r * cols;
+                for (size_t c = 0; c < cols; c++) {
+                    double d = row[c] - sum[c];
+                    ss[c] += d * d;
+                    lo[c] = std::min(lo[c], row[c]);
+                    hi[c] = std::max(hi[c], row[c]);
+                }
+            }
+            for (size_t c = 0; c < cols; c++) {
+                MomentAccumulator block;
+                block.count = cnt;
+                block.mean = sum[c];
+                block.m2 = ss[c];
+                block.min = lo[c];
+                block.max = hi[c];
+                acc[c].merge(block);
+            }
+        }
+    });
+
+    std::vector<MomentAccumulator> out(cols);
+    for (auto& acc : partial) {
+        for (size_t c = 0; c < acc.size(); c++) out[c].merge(acc[c]);
+    }
+    return out;
+}
+
+Matrix covariance(const Matrix& m, int normalization) {
+    size_t n = m.rows(), p = m.cols();
+    if (n == 0) return Matrix(p, p, kNaN);
+
+    // Center once, then accumulate the upper triangle of Xc' * Xc row by row
+    // (contiguous in j). Output rows are independent, so split them across
+    // threads; row blocks keep a slab of Xc hot while it is reused.
+    auto moments = momentsAlongDim(m, 1);
+    std::vector<double> xc(m.begin(), m.end());
+    for (size_t r = 0; r < n; r++) {
+        double* row = xc.data() + r * p;
+        for (size_t c = 0; c < p; c++) row[c] -= moments[c].mean;
+    }
+
+    double denom = (normalization == 1 || n == 1) ? static_cast<double>(n)
+                                                  : static_cast<double>(n - 1);
+    Matrix result(p, p);
+    double* out = result.begin();
+    size_t grain = std::max<size_t>(1, (size_t(1) << 18) / std::max<size_t>(n * p, 1));
+    parallelFor(p, grain, [&](size_t begin, size_t end) {
+        for (size_t k0 = 0; k0 < n; k0 += kRowBlock) {
+            size_t k1 = std::min(k0 + kRowBlock, n);
+            for (size_t i = begin; i < end; i++) {
+                double* ci = out + i * p;
+                for (size_t k = k0; k < k1; k++) {
+                    const double* xk = xc.data() + k * p;
+                    double xi = xk[i];
+                    for (size_t j = i; j < p; j++) ci[j] += xi * xk[j];
+                }
+            }
+        }
+        for (size_t i = begin; i < end; i++) {
+            for (size_t j = i; j < p; j++) out[i * p + j] /= denom;
+        }
+    });
+    for (size_t i = 0; i < p; i++) {
+        for (size_t j = 0; j < i; j++) out[i * p + j] = out[j * p + i];
+    }
+    return result;
+}
+
+Matrix reduceLines(const Matrix& m, int dim, size_t outPerLine,
+                   const std::function<void(double* line, size_t len, double* out)>& fn) {
+    if (dim != 1 && dim != 2)
+        throw RuntimeError("Dimension argument must be 1 or 2");
+
+    // Lay lines out contiguously: rows already are; columns via transpose.
+    Matrix lines = (dim == 1) ? m.transpose() : m;
+    size_t count = lines.rows(), len = lines.cols();
+    std::vector<double> results(count * outPerLine);
+    double* base = lines.begin();
+
+    size_t grain = std::max<size_t>(1, 16384 / std::max<size_t>(len, 1));
+    parallelFor(count, grain, [&](size_t begin, size_t end) {
+        for (size_t line = begin; line < end; line++)
+            fn(base + line * len, len, results.data() + line * outPerLine);
+    });
+
+    // results is count x outPerLine; dim 1 wants it transposed.
+    Matrix out(count, outPerLine, std::move(results));
+    return (dim == 1) ? out.transpose() : out;
+}
+
+} // namespace matfree
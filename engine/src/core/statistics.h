@@ -0,0 +1,75 @@
+#pragma once
+// MatFree - Statistics kernels (order statistics, quantiles, mode)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "value.h"
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace matfree {
+
+/// How reductions treat NaN: propagate it ('includenan') or drop it ('omitnan').
+enum class NanFlag { INCLUDE, OMIT };
+
+/// Median of `n` values in O(n) via selection. Reorders `data`.
+double medianInPlace(double* data, size_t n, NanFlag nanFlag);
+
+/// Quantiles of `n` values for probabilities in [0, 1], written to `out`
+/// (one per probability). All order statistics needed are found in a single
+/// recursive multi-selection pass. Uses the same interpolation as MatFree's
+/// quantile/prctile: sorted x(i) sits at probability (i - 0.5) / n, with
+/// linear interpolation in between and clamping at the ends. Reorders `data`.
+void quantilesInPlace(double* data, size_t n, const std::vector<double>& probs,
+                      double* out, NanFlag nanFlag);
+
+/// Most frequent non-NaN value (smallest on ties) and its count, in O(n)
+/// expected time. Returns {NaN, 0} when there are no non-NaN values.
+std::pair<double, double> modeOf(const double* data, size_t n);
+
+/// One-pass running moments (count, mean, sum of squared deviations, range).
+/// Accumulators built over disjoint pieces of data combine exactly with
+/// merge() (Chan et al.), so they can be filled per thread or per chunk and
+/// reduced afterwards, or kept across calls to summarize streamed data.
+struct MomentAccumulator {
+    double count = 0.0;
+    double mean = 0.0;
+    double m2 = 0.0; // sum of squared deviations from the mean
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    /// Add one value (Welford update).
+    void add(double x);
+    /// Add a block of values: moments of the block are computed locally
+    /// (cache-resident two-pass) and merged in, avoiding a division per element.
+    void add(const double* data, size_t n);
+    /// Add the non-NaN values of a block.
+    void addOmittingNaN(const double* data, size_t n);
+    /// Fold in the moments of a disjoint data set.
+    void merge(const MomentAccumulator& other);
+
+    /// Variance normalized by N-1 (normalization 0) or N (normalization 1).
+    double variance(int normalization = 0) const;
+};
+
+/// Moments of `n` contiguous values, accumulated in parallel chunks and
+/// merged in chunk order so the result does not depend on the thread count.
+/// NanFlag::OMIT skips NaNs.
+MomentAccumulator accumulateMoments(const double* data, size_t n, NanFlag nanFlag = NanFlag::INCLUDE);
+
+/// Per-column (dim 1) or per-row (dim 2) moments of `m` in one pass over memory.
+std::vector<MomentAccumulator> momentsAlongDim(const Matrix& m, int dim, NanFlag nanFlag = NanFlag::INCLUDE);
+
+/// Covariance of the columns of `m` (rows are observations), computed as the
+/// centered product Xc' * Xc. normalization 0 divides by N-1, 1 by N.
+Matrix covariance(const Matrix& m, int normalization = 0);
+
+/// Apply `fn` to every line of `m` along `dim` (1 = columns, 2 = rows), in
+/// parallel across lines. `fn` receives a mutable copy of the line and writes
+/// `outPerLine` results; they are laid out along `dim` in the returned matrix
+/// (outPerLine x cols for dim 1, rows x outPerLine for dim 2).
+Matrix reduceLines(const Matrix& m, int dim, size_t outPerLine,
+                   const std::function<void(double* line, size_t len, double* out)>& fn);
+
+} // namespace matfree
@@ -19,7 +19,7 @@ enum class TokenType {
     // Keywords
     IF, ELSEIF, ELSE,
     END,
-    FOR, WHILE,
+    FOR, PARFOR, WHILE,
     SWITCH, CASE, OTHERWISE,
     TRY, CATCH,
     FUNCTION, RETURN,
@@ -95,6 +95,7 @@ inline const char* tokenTypeName(TokenType type) {
         case TokenType::ELSE:         return "ELSE";
         case TokenType::END:          return "END";
         case TokenType::FOR:          return "FOR";
+        case TokenType::PARFOR:       return "PARFOR";
         case TokenType::WHILE:        return "WHILE";
         case TokenType::SWITCH:       return "SWITCH";
         case TokenType::CASE:         return "CASE";
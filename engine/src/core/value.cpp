@@ -2,8 +2,9 @@
 // Copyright (c) 2026 MatFree Contributors - MIT License
 
 #include "value.h"
-#include <random>
+#include <algorithm>
 #include <cassert>
+#include <charconv>
 
 namespace matfree {
 
@@ -11,30 +12,72 @@ namespace matfree {
 // Matrix implementation
 // ============================================================================
 
-static std::mt19937& rng() {
-    static std::mt19937 gen(std::random_device{}());
-    return gen;
+Matrix::Matrix(const Matrix& other)
+    : rows_(other.rows_), cols_(other.cols_), data_(other.begin(), other.end()), ptr_(data_.data()) {}
+
+Matrix::Matrix(Matrix&& other) noexcept
+    : rows_(other.rows_), cols_(other.cols_), data_(std::move(other.data_)),
+      owner_(std::move(other.owner_)), writable_(other.writable_) {
+    ptr_ = owner_ ? other.ptr_ : data_.data();
+    other.rows_ = other.cols_ = 0;
+    other.data_.clear();
+    other.ptr_ = other.data_.data();
+    other.writable_ = false;
+}
+
+Matrix& Matrix::operator=(const Matrix& other) {
+    if (this != &other) *this = Matrix(other);
+    return *this;
+}
+
+Matrix& Matrix::operator=(Matrix&& other) noexcept {
+    if (this == &other) return *this;
+    rows_ = other.rows_;
+    cols_ = other.cols_;
+    data_ = std::move(other.data_);
+    owner_ = std::move(other.owner_);
+    writable_ = other.writable_;
+    ptr_ = owner_ ? other.ptr_ : data_.data();
+    other.rows_ = other.cols_ = 0;
+    other.data_.clear();
+    other.ptr_ = other.data_.data();
+    other.writable_ = false;
+    return *this;
+}
+
+Matrix Matrix::external(size_t rows, size_t cols, double* data, std::shared_ptr<void> owner, bool writable) {
+    Matrix m;
+    m.rows_ = rows;
+    m.cols_ = cols;
+    m.ptr_ = data;
+    m.owner_ = std::move(owner);
+    m.writable_ = writable;
+    return m;
 }
 
-Matrix Matrix::rand(size_t rows, size_t cols) {
+Matrix Matrix::rand(size_t rows, size_t cols, RandomStream& stream) {
     Matrix m(rows, cols);
-    std::uniform_real_distribution<double> dist(0.0, 1.0);
-    for (auto& v : m.data_) v = dist(rng());
+    stream.fillUniform(m.ptr_, m.numel());
     return m;
 }
 
-Matrix Matrix::randn(size_t rows, size_t cols) {
+Matrix Matrix::randn(size_t rows, size_t cols, RandomStream& stream) {
     Matrix m(rows, cols);
-    std::normal_distribution<double> dist(0.0, 1.0);
-    for (auto& v : m.data_) v = dist(rng());
+    stream.fillNormal(m.ptr_, m.numel());
     return m;
 }
 
 Matrix Matrix::transpose() const {
     Matrix result(cols_, rows_);
-    for (size_t i = 0; i < rows_; i++) {
-        for (size_t j = 0; j < cols_; j++) {
-            result(j, i) = (*this)(i, j);
+    // Cache-blocked so both the reads and the writes stay within a few lines
+    constexpr size_t B = 32;
+    for (size_t i0 = 0; i0 < rows_; i0 += B) {
+        size_t i1 = std::min(i0 + B, rows_);
+        for (size_t j0 = 0; j0 < cols_; j0 += B) {
+            size_t j1 = std::min(j0 + B, cols_);
+            for (size_t i = i0; i < i1; i++)
+                for (size_t j = j0; j < j1; j++)
+                    result.ptr_[j * rows_ + i] = ptr_[i * cols_ + j];
         }
     }
     return result;
@@ -146,43 +189,43 @@ Matrix Matrix::elementPow(const Matrix& other) const {
 
 Matrix Matrix::operator-() const {
     Matrix result(rows_, cols_);
-    for (size_t i = 0; i < data_.size(); i++)
-        result.data_[i] = -data_[i];
+    for (size_t i = 0; i < numel(); i++)
+        result.ptr_[i] = -ptr_[i];
     return result;
 }
 
 Matrix Matrix::operator+(double s) const {
     Matrix result(rows_, cols_);
-    for (size_t i = 0; i < data_.size(); i++)
-        result.data_[i] = data_[i] + s;
+    for (size_t i = 0; i < numel(); i++)
+        result.ptr_[i] = ptr_[i] + s;
     return result;
 }
 
 Matrix Matrix::operator-(double s) const {
     Matrix result(rows_, cols_);
-    for (size_t i = 0; i < data_.size(); i++)
-        result.data_[i] = data_[i] - s;
+    for (size_t i = 0; i < numel(); i++)
+        result.ptr_[i] = ptr_[i] - s;
     return result;
 }
 
 Matrix Matrix::operator*(double s) const {
     Matrix result(rows_, cols_);
-    for (size_t i = 0; i < data_.size(); i++)
-        result.data_[i] = data_[i] * s;
+    for (size_t i = 0; i < numel(); i++)
+        result.ptr_[i] = ptr_[i] * s;
     return result;
 }
 
 Matrix Matrix::operator/(double s) const {
     Matrix result(rows_, cols_);
-    for (size_t i = 0; i < data_.size(); i++)
-        result.data_[i] = data_[i] / s;
+    for (size_t i = 0; i < numel(); i++)
+        result.ptr_[i] = ptr_[i] / s;
     return result;
 }
 
 Matrix Matrix::power(double s) const {
     Matrix result(rows_, cols_);
-    for (size_t i = 0; i < data_.size(); i++)
-        result.data_[i] = std::pow(data_[i], s);
+    for (size_t i = 0; i < numel(); i++)
+        result.ptr_[i] = std::pow(ptr_[i], s);
     return result;
 }
 
@@ -244,13 +287,13 @@ Matrix Matrix::ge(const Matrix& other) const {
 // Reductions
 double Matrix::sum() const {
     double s = 0;
-    for (auto v : data_) s += v;
+    for (double v : *this) s += v;
     return s;
 }
 
 double Matrix::prod() const {
     double p = 1;
-    for (auto v : data_) p *= v;
+    for (double v : *this) p *= v;
     return p;
 }
 
@@ -259,34 +302,34 @@ double Matrix::mean() const {
 }
 
 double Matrix::minVal() const {
-    if (data_.empty()) throw RuntimeError("Cannot find min of empty matrix");
-    return *std::min_element(data_.begin(), data_.end());
+    if (isEmpty()) throw RuntimeError("Cannot find min of empty matrix");
+    return *std::min_element(begin(), end());
 }
 
 double Matrix::maxVal() const {
-    if (data_.empty()) throw RuntimeError("Cannot find max of empty matrix");
-    return *std::max_element(data_.begin(), data_.end());
+    if (isEmpty()) throw RuntimeError("Cannot find max of empty matrix");
+    return *std::max_element(begin(), end());
 }
 
 double Matrix::norm(double p) const {
     if (p == 2.0 && isVector()) {
         double s = 0;
-        for (auto v : data_) s += v * v;
+        for (double v : *this) s += v * v;
         return std::sqrt(s);
     }
     if (p == 1.0) {
         double s = 0;
-        for (auto v : data_) s += std::abs(v);
+        for (double v : *this) s += std::abs(v);
         return s;
     }
     if (std::isinf(p)) {
         double mx = 0;
-        for (auto v : data_) mx = std::max(mx, std::abs(v));
+        for (double v : *this) mx = std::max(mx, std::abs(v));
         return mx;
     }
     // General p-norm for vectors
     double s = 0;
-    for (auto v : data_) s += std::pow(std::abs(v), p);
+    for (double v : *this) s += std::pow(std::abs(v), p);
     return std::pow(s, 1.0 / p);
 }
 
@@ -315,7 +358,7 @@ Matrix Matrix::sumAlongDim(int dim) const {
 Matrix Matrix::meanAlongDim(int dim) const {
     Matrix s = sumAlongDim(dim);
     double divisor = (dim == 1) ? static_cast<double>(rows_) : static_cast<double>(cols_);
-    for (auto& v : s.data()) v /= divisor;
+    for (double& v : s) v /= divisor;
     return s;
 }
 
@@ -356,7 +399,7 @@ Matrix Matrix::reshape(size_t newRows, size_t newCols) const {
             std::to_string(cols_) + " to " + std::to_string(newRows) + "x" +
             std::to_string(newCols));
     }
-    return Matrix(newRows, newCols, data_);
+    return Matrix(newRows, newCols, std::vector<double>(begin(), end()));
 }
 
 Matrix Matrix::horzcat(const std::vector<Matrix>& matrices) {
@@ -408,47 +451,56 @@ std::string Matrix::toString() const {
 }
 
 void Matrix::display(std::ostream& os, const std::string& name) const {
-    if (!name.empty()) {
-        os << name << " =" << std::endl << std::endl;
-    }
+    // Rendered into a buffer written in large pieces: no per-element stream
+    // formatting and no flush per line
+    std::string buf;
+    if (!name.empty()) buf += name + " =\n\n";
+    char num[400];
+    auto emit = [&](double v, std::chars_format fmt, int precision, int width) {
+        auto r = std::to_chars(num, num + sizeof(num), v, fmt, precision);
+        size_t len = static_cast<size_t>(r.ptr - num);
+        if (width > 0 && static_cast<size_t>(width) > len) buf.append(static_cast<size_t>(width) - len, ' ');
+        buf.append(num, len);
+    };
 
     if (isEmpty()) {
-        os << "     []" << std::endl;
-        return;
-    }
-
-    if (isScalar()) {
-        os << "   " << std::setprecision(4) << data_[0] << std::endl;
-        return;
-    }
-
-    // Determine formatting
-    bool allIntegers = true;
-    double maxAbs = 0;
-    for (auto v : data_) {
-        if (v != std::floor(v)) allIntegers = false;
-        maxAbs = std::max(maxAbs, std::abs(v));
-    }
-
-    int width = 10;
-    int precision = 4;
-    if (allIntegers && maxAbs < 1e6) {
-        width = static_cast<int>(std::to_string(static_cast<long long>(maxAbs)).size()) + 5;
-        precision = 0;
-    }
+        buf += "     []\n";
+    } else if (isScalar()) {
+        buf += "   ";
+        emit(ptr_[0], std::chars_format::general, 4, 0);
+        buf += '\n';
+    } else {
+        // Determine formatting
+        bool allIntegers = true;
+        double maxAbs = 0;
+        for (double v : *this) {
+            if (v != std::floor(v)) allIntegers = false;
+            maxAbs = std::max(maxAbs, std::abs(v));
+        }
+        bool integers = allIntegers && maxAbs < 1e6;
+        int width = integers ? static_cast<int>(std::to_string(static_cast<long long>(maxAbs)).size()) + 5 : 10;
 
-    for (size_t i = 0; i < rows_; i++) {
-        os << "   ";
-        for (size_t j = 0; j < cols_; j++) {
-            if (allIntegers && maxAbs < 1e6) {
-                os << std::setw(width) << static_cast<long long>((*this)(i, j));
-            } else {
-                os << std::setw(width) << std::setprecision(precision)
-                   << std::fixed << (*this)(i, j);
+        for (size_t i = 0; i < rows_; i++) {
+            buf += "   ";
+            for (size_t j = 0; j < cols_; j++) {
+                double v = (*this)(i, j);
+                if (integers) {
+                    auto r = std::to_chars(num, num + sizeof(num), static_cast<long long>(v));
+                    size_t len = static_cast<size_t>(r.ptr - num);
+                    if (static_cast<size_t>(width) > len) buf.append(static_cast<size_t>(width) - len, ' ');
+                    buf.append(num, len);
+                } else {
+                    emit(v, std::chars_format::fixed, 4, width);
+                }
+            }
+            buf += '\n';
+            if (buf.size() >= (size_t(1) << 16)) {
+                os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                buf.clear();
             }
         }
-        os << std::endl;
     }
+    os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
 }
 
 // ============================================================================
@@ -522,36 +574,36 @@ void Value::display(std::ostream& os, const std::string& name) const {
     switch (type_) {
         case ValueType::MATRIX:
         case ValueType::LOGICAL:
-            if (!name.empty()) os << name << " =" << std::endl << std::endl;
+            if (!name.empty()) os << name << " =\n\n";
             matrix_.display(os);
-            os << std::endl;
+            os << '\n';
             break;
         case ValueType::STRING:
-            if (!name.empty()) os << name << " =" << std::endl << std::endl;
-            os << "    '" << string_ << "'" << std::endl << std::endl;
+            if (!name.empty()) os << name << " =\n\n";
+            os << "    '" << string_ << "'\n\n";
             break;
         case ValueType::CELL_ARRAY:
-            if (!name.empty()) os << name << " =" << std::endl << std::endl;
-            os << "  {" << cellArray_.rows << "x" << cellArray_.cols << " cell}" << std::endl << std::endl;
+            if (!name.empty()) os << name << " =\n\n";
+            os << "  {" << cellArray_.rows << "x" << cellArray_.cols << " cell}\n\n";
             break;
         case ValueType::STRUCT:
-            if (!name.empty()) os << name << " =" << std::endl << std::endl;
-            os << "  struct with fields:" << std::endl;
+            if (!name.empty()) os << name << " =\n\n";
+            os << "  struct with fields:\n";
             for (auto& [k, v] : struct_.fields) {
                 os << "    " << k << ": ";
                 if (v) os << v->toString();
                 else os << "[]";
-                os << std::endl;
+                os << '\n';
             }
-            os << std::endl;
+            os << '\n';
             break;
         case ValueType::FUNC_HANDLE:
-            if (!name.empty()) os << name << " =" << std::endl << std::endl;
-            os << "    @" << funcHandle_.name << std::endl << std::endl;
+            if (!name.empty()) os << name << " =\n\n";
+            os << "    @" << funcHandle_.name << "\n\n";
             break;
         case ValueType::EMPTY:
-            if (!name.empty()) os << name << " =" << std::endl << std::endl;
-            os << "     []" << std::endl << std::endl;
+            if (!name.empty()) os << name << " =\n\n";
+            os << "     []\n\n";
             break;
         default:
             break;
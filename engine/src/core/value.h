@@ -16,6 +16,7 @@
 #include <iomanip>
 #include <algorithm>
 #include <numeric>
+#include "random.h"
 
 namespace matfree {
 
@@ -35,12 +36,27 @@ using ValueList = std::vector<ValuePtr>;
 
 class Matrix {
 public:
-    Matrix() : rows_(0), cols_(0) {}
-    Matrix(size_t rows, size_t cols) : rows_(rows), cols_(cols), data_(rows * cols, 0.0) {}
+    Matrix() : rows_(0), cols_(0), ptr_(data_.data()) {}
+    Matrix(size_t rows, size_t cols) : rows_(rows), cols_(cols), data_(rows * cols, 0.0), ptr_(data_.data()) {}
     Matrix(size_t rows, size_t cols, double fillValue)
-        : rows_(rows), cols_(cols), data_(rows * cols, fillValue) {}
+        : rows_(rows), cols_(cols), data_(rows * cols, fillValue), ptr_(data_.data()) {}
     Matrix(size_t rows, size_t cols, std::vector<double> data)
-        : rows_(rows), cols_(cols), data_(std::move(data)) {}
+        : rows_(rows), cols_(cols), data_(std::move(data)), ptr_(data_.data()) {}
+
+    Matrix(const Matrix& other);
+    Matrix(Matrix&& other) noexcept;
+    Matrix& operator=(const Matrix& other);
+    Matrix& operator=(Matrix&& other) noexcept;
+
+    /// A matrix over memory it does not own (a mapped file region).
+    /// `owner` keeps the memory alive for as long as the matrix exists.
+    /// Copying always gives an ordinary in-memory matrix, so a copy never
+    /// writes to the file; only code that holds the matrix itself and checks
+    /// `writesThrough()` may store into it in place.
+    static Matrix external(size_t rows, size_t cols, double* data,
+                           std::shared_ptr<void> owner, bool writable);
+    bool isExternal() const { return owner_ != nullptr; }
+    bool writesThrough() const { return owner_ && writable_; }
 
     // Factory methods
     static Matrix scalar(double val) {
@@ -77,21 +93,21 @@ public:
         return m;
     }
 
-    static Matrix rand(size_t rows, size_t cols);
-    static Matrix randn(size_t rows, size_t cols);
+    static Matrix rand(size_t rows, size_t cols, RandomStream& stream);
+    static Matrix randn(size_t rows, size_t cols, RandomStream& stream);
 
     // Element access (0-indexed internally, 1-indexed externally)
-    double& operator()(size_t row, size_t col) { return data_[row * cols_ + col]; }
-    double operator()(size_t row, size_t col) const { return data_[row * cols_ + col]; }
+    double& operator()(size_t row, size_t col) { return ptr_[row * cols_ + col]; }
+    double operator()(size_t row, size_t col) const { return ptr_[row * cols_ + col]; }
 
     // Linear indexing
-    double& operator()(size_t idx) { return data_[idx]; }
-    double operator()(size_t idx) const { return data_[idx]; }
+    double& operator()(size_t idx) { return ptr_[idx]; }
+    double operator()(size_t idx) const { return ptr_[idx]; }
 
     size_t rows() const { return rows_; }
     size_t cols() const { return cols_; }
-    size_t numel() const { return data_.size(); }
-    bool isEmpty() const { return data_.empty(); }
+    size_t numel() const { return rows_ * cols_; }
+    bool isEmpty() const { return numel() == 0; }
     bool isScalar() const { return rows_ == 1 && cols_ == 1; }
     bool isVector() const { return rows_ == 1 || cols_ == 1; }
     bool isRowVector() const { return rows_ == 1 && cols_ > 1; }
@@ -100,11 +116,18 @@ public:
 
     double scalarValue() const {
         if (!isScalar()) throw RuntimeError("Not a scalar");
-        return data_[0];
+        return ptr_[0];
     }
 
-    const std::vector<double>& data() const { return data_; }
-    std::vector<double>& data() { return data_; }
+    // Contiguous element storage (row-major), owned or external
+    const double* begin() const { return ptr_; }
+    const double* end() const { return ptr_ + numel(); }
+    double* begin() { return ptr_; }
+    double* end() { return ptr_ + numel(); }
+
+    // The owned element vector; external matrices have none
+    const std::vector<double>& data() const { requireOwned(); return data_; }
+    std::vector<double>& data() { requireOwned(); return data_; }
 
     // Matrix operations
     Matrix transpose() const;
@@ -164,6 +187,13 @@ public:
 private:
     size_t rows_, cols_;
     std::vector<double> data_;
+    double* ptr_;                  // data_.data(), or the external memory
+    std::shared_ptr<void> owner_;  // keeps external memory alive
+    bool writable_ = false;
+
+    void requireOwned() const {
+        if (owner_) throw RuntimeError("Operation not supported on a memory-mapped array");
+    }
 
     // Helper for broadcasting
     static void broadcastCheck(const Matrix& a, const Matrix& b,
@@ -206,6 +236,10 @@ class Interpreter;
 
 using BuiltinFunc = std::function<ValuePtr(const ValueList&)>;
 
+// Built-in with several outputs: receives the number of requested outputs
+// (nargout) and returns at least max(nargout, 1) values.
+using BuiltinMultiFunc = std::function<ValueList(const ValueList&, int nargout)>;
+
 struct FunctionHandle {
     std::string name;
     std::variant<
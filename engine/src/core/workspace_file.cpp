@@ -0,0 +1,383 @@
+// MatFree - Binary workspace files (save/load)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "workspace_file.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+namespace matfree {
+
+namespace {
+
+constexpr char kMagic[8] = {'M', 'A', 'T', 'F', 'R', 'E', 'E', 'W'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint64_t kHeaderSize = 64;
+constexpr uint64_t kPayloadAlignment = 64;
+constexpr uint64_t kRecordAlignment = 8;
+
+// Nesting limit for cells and structs, so corrupt files cannot recurse forever.
+constexpr int kMaxDepth = 512;
+
+enum RecordTag : uint32_t {
+    TAG_EMPTY = 0,
+    TAG_MATRIX = 1,
+    TAG_LOGICAL = 2,
+    TAG_STRING = 3,
+    TAG_CELL = 4,
+    TAG_STRUCT = 5,
+    TAG_FUNCTION = 6,
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint64_t reserved[4];
+};
+static_assert(sizeof(Header) == kHeaderSize, "workspace header must be 64 bytes");
+
+RecordTag tagOf(ValueType type) {
+    switch (type) {
+        case ValueType::MATRIX: return TAG_MATRIX;
+        case ValueType::LOGICAL: return TAG_LOGICAL;
+        case ValueType::STRING: return TAG_STRING;
+        case ValueType::CELL_ARRAY: return TAG_CELL;
+        case ValueType::STRUCT: return TAG_STRUCT;
+        case ValueType::FUNC_HANDLE: return TAG_FUNCTION;
+        case ValueType::EMPTY: return TAG_EMPTY;
+        default: throw RuntimeError("save: complex values are not supported");
+    }
+}
+
+ValueType typeOf(uint32_t tag) {
+    switch (tag) {
+        case TAG_EMPTY: return ValueType::EMPTY;
+        case TAG_MATRIX: return ValueType::MATRIX;
+        case TAG_LOGICAL: return ValueType::LOGICAL;
+        case TAG_STRING: return ValueType::STRING;
+        case TAG_CELL: return ValueType::CELL_ARRAY;
+        case TAG_STRUCT: return ValueType::STRUCT;
+        case TAG_FUNCTION: return ValueType::FUNC_HANDLE;
+        default: throw RuntimeError("load: corrupt workspace file (unknown record type)");
+    }
+}
+
+std::pair<uint64_t, uint64_t> sizeOf(const Value& v) {
+    switch (v.type()) {
+        case ValueType::MATRIX:
+        case ValueType::LOGICAL: return {v.matrix().rows(), v.matrix().cols()};
+        case ValueType::STRING: return {1, v.string().size()};
+        case ValueType::CELL_ARRAY: return {v.cellArray().rows, v.cellArray().cols};
+        case ValueType::EMPTY: return {0, 0};
+        default: return {1, 1};
+    }
+}
+
+// Sequential writer that tracks the file position for record offsets.
+class RecordWriter {
+public:
+    RecordWriter(std::ostream& out, uint64_t pos) : out_(out), pos_(pos) {}
+
+    uint64_t pos() const { return pos_; }
+
+    void bytes(const void* p, size_t n) {
+        out_.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+        pos_ += n;
+    }
+    void u32(uint32_t v) { bytes(&v, sizeof v); }
+    void u64(uint64_t v) { bytes(&v, sizeof v); }
+    void align(uint64_t a) {
+        static const char zeros[kPayloadAlignment] = {};
+        uint64_t pad = (a - pos_ % a) % a;
+        bytes(zeros, pad);
+    }
+
+    // Children are written before their parent, so every record can refer
+    // to offsets that are already known. Returns the record's offset.
+    uint64_t value(const Value& v) {
+        switch (v.type()) {
+            case ValueType::MATRIX:
+            case ValueType::LOGICAL: {
+                const Matrix& m = v.matrix();
+                align(kPayloadAlignment);
+                uint64_t data = pos_;
+                bytes(m.begin(), m.numel() * sizeof(double));
+                return record(tagOf(v.type()), {m.rows(), m.cols(), data});
+            }
+            case ValueType::STRING: {
+                uint64_t at = record(TAG_STRING, {v.string().size()});
+                bytes(v.string().data(), v.string().size());
+                return at;
+            }
+            case ValueType::CELL_ARRAY: {
+                const CellArray& c = v.cellArray();
+                std::vector<uint64_t> fields = {c.rows, c.cols};
+                for (auto& e : c.data) fields.push_back(e ? value(*e) : value(Value()));
+                return record(TAG_CELL, fields);
+            }
+            case ValueType::STRUCT: {
+                const MFStruct& s = v.structVal();
+                std::vector<uint64_t> children;
+                for (auto& [name, e] : s.fields) children.push_back(e ? value(*e) : value(Value()));
+                uint64_t at = record(TAG_STRUCT, {s.fields.size()});
+                size_t i = 0;
+                for (auto& [name, e] : s.fields) {
+                    u64(name.size());
+                    u64(children[i++]);
+                    bytes(name.data(), name.size());
+                    align(kRecordAlignment);
+                }
+                return at;
+            }
+            case ValueType::FUNC_HANDLE: {
+                const std::string& name = v.funcHandle().name;
+                if (name == "<anonymous>") throw RuntimeError("save: anonymous functions cannot be saved");
+                uint64_t at = record(TAG_FUNCTION, {name.size()});
+                bytes(name.data(), name.size());
+                return at;
+            }
+            case ValueType::EMPTY:
+                return record(TAG_EMPTY, {});
+            default:
+                throw RuntimeError("save: complex values are not supported");
+        }
+    }
+
+private:
+    std::ostream& out_;
+    uint64_t pos_;
+
+    uint64_t record(uint32_t tag, std::initializer_list<uint64_t> fields) {
+        return record(tag, std::vector<uint64_t>(fields));
+    }
+    uint64_t record(uint32_t tag, const std::vector<uint64_t>& fields) {
+        align(kRecordAlignment);
+        uint64_t at = pos_;
+        u32(tag);
+        u32(0);
+        for (uint64_t f : fields) u64(f);
+        return at;
+    }
+};
+
+void writeIndex(RecordWriter& w, const std::vector<WorkspaceEntry>& entries) {
+    for (auto& e : entries) {
+        w.u64(e.name.size());
+        w.u64(e.offset);
+        w.u32(tagOf(e.type));
+        w.u32(0);
+        w.u64(e.rows);
+        w.u64(e.cols);
+        w.bytes(e.name.data(), e.name.size());
+        w.align(kRecordAlignment);
+    }
+}
+
+Header makeHeader(uint64_t indexOffset, uint64_t count) {
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof kMagic);
+    h.version = kVersion;
+    h.byteOrder = kByteOrderMark;
+    h.indexOffset = indexOffset;
+    h.indexCount = count;
+    return h;
+}
+
+// Bounds-checked reads from the mapping.
+struct Cursor {
+    const char* base;
+    uint64_t size;
+    uint64_t pos;
+
+    void need(uint64_t n) const {
+        if (pos > size || n > size - pos) throw RuntimeError("load: corrupt workspace file (truncated)");
+    }
+    uint32_t u32() {
+        need(4);
+        uint32_t v;
+        std::memcpy(&v, base + pos, 4);
+        pos += 4;
+        return v;
+    }
+    uint64_t u64() {
+        need(8);
+        uint64_t v;
+        std::memcpy(&v, base + pos, 8);
+        pos += 8;
+        return v;
+    }
+    std::string str(uint64_t n) {
+        need(n);
+        std::string s(base + pos, n);
+        pos += n;
+        return s;
+    }
+    void align(uint64_t a) { pos += (a - pos % a) % a; }
+};
+
+} // namespace
+
+std::string workspaceClassName(ValueType type) {
+    switch (type) {
+        case ValueType::MATRIX: return "double";
+        case ValueType::LOGICAL: return "logical";
+        case ValueType::STRING: return "char";
+        case ValueType::CELL_ARRAY: return "cell";
+        case ValueType::STRUCT: return "struct";
+        case ValueType::FUNC_HANDLE: return "function_handle";
+        default: return "double";
+    }
+}
+
+void saveWorkspace(const std::string& path,
+                   const std::vector<std::pair<std::string, ValuePtr>>& variables, bool append) {
+    std::vector<WorkspaceEntry> kept;
+    if (append && std::filesystem::exists(path)) {
+        std::unordered_set<std::string> replaced;
+        for (auto& [name, v] : variables) replaced.insert(name);
+        WorkspaceReader existing(path);
+        for (auto& e : existing.entries())
+            if (!replaced.count(e.name)) kept.push_back(e);
+    } else {
+        append = false;
+    }
+
+    std::string target = append ? path : path + ".tmp";
+    std::fstream out;
+    if (append) out.open(target, std::ios::in | std::ios::out | std::ios::binary | std::ios::ate);
+    else out.open(target, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out) throw RuntimeError("save: unable to write file '" + path + "'");
+
+    uint64_t start = append ? static_cast<uint64_t>(out.tellp()) : 0;
+    RecordWriter w(out, start);
+    if (!append) {
+        Header placeholder = makeHeader(0, 0);
+        w.bytes(&placeholder, sizeof placeholder);
+    }
+
+    std::vector<WorkspaceEntry> entries = std::move(kept);
+    for (auto& [name, v] : variables) {
+        auto [rows, cols] = sizeOf(*v);
+        entries.push_back({name, v->type(), rows, cols, w.value(*v)});
+    }
+    w.align(kRecordAlignment);
+    uint64_t indexOffset = w.pos();
+    writeIndex(w, entries);
+
+    // Repoint the header last, so an interrupted append leaves the old index valid
+    out.flush();
+    Header header = makeHeader(indexOffset, entries.size());
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof header);
+    out.close();
+    if (!out) throw RuntimeError("save: error writing file '" + path + "'");
+
+    if (!append) {
+        std::error_code ec;
+        std::filesystem::rename(target, path, ec);
+        if (ec) {
+            std::filesystem::remove(target, ec);
+            throw RuntimeError("save: unable to replace file '" + path + "'");
+        }
+    }
+}
+
+WorkspaceReader::WorkspaceReader(const std::string& path) : path_(path), file_(MappedFile::open(path, MapMode::PRIVATE)) {
+    const char* base = file_->data();
+    uint64_t size = file_->size();
+    Header h;
+    if (size < kHeaderSize || std::memcmp(base, kMagic, sizeof kMagic) != 0)
+        throw RuntimeError("load: '" + path + "' is not a MatFree workspace file");
+    std::memcpy(&h, base, sizeof h);
+    if (h.byteOrder != kByteOrderMark)
+        throw RuntimeError("load: '" + path + "' was written with a different byte order");
+    if (h.version != kVersion)
+        throw RuntimeError("load: unsupported workspace file version " + std::to_string(h.version));
+
+    Cursor c{base, size, h.indexOffset};
+    for (uint64_t i = 0; i < h.indexCount; i++) {
+        WorkspaceEntry e;
+        uint64_t nameLen = c.u64();
+        e.offset = c.u64();
+        e.type = typeOf(c.u32());
+        c.u32();
+        e.rows = c.u64();
+        e.cols = c.u64();
+        e.name = c.str(nameLen);
+        c.align(kRecordAlignment);
+        entries_.push_back(std::move(e));
+    }
+}
+
+const WorkspaceEntry* WorkspaceReader::find(const std::string& name) const {
+    for (auto& e : entries_)
+        if (e.name == name) return &e;
+    return nullptr;
+}
+
+ValuePtr WorkspaceReader::read(const WorkspaceEntry& entry, const HandleFactory& makeHandle) const {
+    return readRecord(entry.offset, makeHandle, 0);
+}
+
+ValuePtr WorkspaceReader::readRecord(uint64_t offset, const HandleFactory& makeHandle, int depth) const {
+    if (depth > kMaxDepth) throw RuntimeError("load: corrupt workspace file (nesting too deep)");
+    Cursor c{file_->data(), file_->size(), offset};
+    uint32_t tag = c.u32();
+    c.u32();
+    switch (tag) {
+        case TAG_EMPTY:
+            return Value::makeEmpty();
+        case TAG_MATRIX:
+        case TAG_LOGICAL: {
+            uint64_t rows = c.u64(), cols = c.u64(), data = c.u64();
+            if (cols != 0 && rows > (file_->size() / sizeof(double)) / cols)
+                throw RuntimeError("load: corrupt workspace file (bad array size)");
+            size_t bytes = rows * cols * sizeof(double);
+            Cursor payload{file_->data(), file_->size(), data};
+            payload.need(bytes);
+            // A view of the mapped payload: no copy, and pages are only
+            // read when touched. The mapping is private, so writing to the
+            // matrix never changes the file.
+            Matrix m = Matrix::external(rows, cols, reinterpret_cast<double*>(file_->data() + data), file_, false);
+            if (tag == TAG_LOGICAL) {
+                auto v = Value::makeBool(false);
+                v->matrix() = std::move(m);
+                return v;
+            }
+            return Value::makeMatrix(std::move(m));
+        }
+        case TAG_STRING:
+            return Value::makeString(c.str(c.u64()));
+        case TAG_CELL: {
+            uint64_t rows = c.u64(), cols = c.u64();
+            if (cols != 0 && rows > (file_->size() / sizeof(uint64_t)) / cols)
+                throw RuntimeError("load: corrupt workspace file (bad cell size)");
+            CellArray cell(rows, cols);
+            for (auto& e : cell.data) e = readRecord(c.u64(), makeHandle, depth + 1);
+            return Value::makeCellArray(std::move(cell));
+        }
+        case TAG_STRUCT: {
+            uint64_t n = c.u64();
+            MFStruct s;
+            for (uint64_t i = 0; i < n; i++) {
+                uint64_t nameLen = c.u64();
+                uint64_t child = c.u64();
+                std::string name = c.str(nameLen);
+                c.align(kRecordAlignment);
+                s.fields[name] = readRecord(child, makeHandle, depth + 1);
+            }
+            return Value::makeStruct(std::move(s));
+        }
+        case TAG_FUNCTION:
+            return makeHandle(c.str(c.u64()));
+        default:
+            throw RuntimeError("load: corrupt workspace file (unknown record type)");
+    }
+}
+
+} // namespace matfree
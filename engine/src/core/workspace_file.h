@@ -0,0 +1,73 @@
+#pragma once
+// MatFree - Binary workspace files (save/load)
+// Copyright (c) 2026 MatFree Contributors - MIT License
+
+#include "value.h"
+#include "mapped_file.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace matfree {
+
+/// Layout of a workspace file (native byte order, recorded in the header):
+///
+///   header   64 bytes: magic "MATFREEW", version, byte-order mark,
+///            offset and length of the index
+///   records  one tree of value records per variable; every record starts
+///            on an 8-byte boundary and every numeric payload on a 64-byte
+///            boundary, so a mapped payload can be used as a double array
+///   index    name, type, size and record offset of each variable
+///
+/// `save -append` writes the new records and a new index after the old
+/// ones and then repoints the header, so existing bytes never change.
+
+/// One variable in a workspace file.
+struct WorkspaceEntry {
+    std::string name;
+    ValueType type;
+    uint64_t rows, cols;
+    uint64_t offset; // of the variable's value record
+};
+
+/// Write `variables` to `path`. Without `append` the file is replaced
+/// (written beside it and renamed into place, so readers that still map
+/// the old file are unaffected). With `append`, variables already in the
+/// file are kept unless one of `variables` has the same name.
+/// Anonymous function handles cannot be saved.
+void saveWorkspace(const std::string& path,
+                   const std::vector<std::pair<std::string, ValuePtr>>& variables, bool append);
+
+/// A workspace file mapped into memory. Opening reads only the header and
+/// the index; each variable's records and payload are read when it is
+/// decoded, and pages the decoder does not touch are never read.
+class WorkspaceReader {
+public:
+    /// Creates function handles for saved handle names.
+    using HandleFactory = std::function<ValuePtr(const std::string&)>;
+
+    /// Throws RuntimeError for missing, truncated or foreign files.
+    explicit WorkspaceReader(const std::string& path);
+
+    const std::vector<WorkspaceEntry>& entries() const { return entries_; }
+    const WorkspaceEntry* find(const std::string& name) const;
+
+    /// Decode a variable. Numeric arrays are views of the mapped payload
+    /// (see Matrix::external), so they cost nothing until their pages are
+    /// read, and keep the mapping alive.
+    ValuePtr read(const WorkspaceEntry& entry, const HandleFactory& makeHandle) const;
+
+private:
+    std::string path_;
+    std::shared_ptr<MappedFile> file_;
+    std::vector<WorkspaceEntry> entries_;
+
+    ValuePtr readRecord(uint64_t offset, const HandleFactory& makeHandle, int depth) const;
+};
+
+/// "double", "cell", ... for a value type, as class() reports it.
+std::string workspaceClassName(ValueType type);
+
+} // namespace matfree
@@ -5,6 +5,12 @@
 //   matfree              - Start interactive REPL
 //   matfree script.m     - Execute a .m file
 //   matfree -e "code"    - Execute a string of code
+//   matfree --profile script.m
+//                        - Execute a .m file and print its profile
+//   matfree --profile-json out.json script.m
+//                        - Execute a .m file and write its profile as JSON
+//   matfree --flamegraph out.folded [--trace out.json] [--sample-rate hz] script.m
+//                        - Execute a .m file under the sampling profiler
 //   matfree --version    - Print version
 //   matfree --help       - Print help
 
@@ -13,8 +19,10 @@
 #include "core/lexer.h"
 #include "core/parser.h"
 #include "repl/repl.h"
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <cstdlib>
 #include <cstring>
 
 using namespace matfree;
@@ -33,11 +41,49 @@ static void printHelp() {
     std::cout << "  matfree              Start interactive REPL" << std::endl;
     std::cout << "  matfree <file.m>     Execute a script file" << std::endl;
     std::cout << "  matfree -e \"code\"    Execute code string" << std::endl;
+    std::cout << "  matfree --profile <file.m>" << std::endl;
+    std::cout << "                       Execute a script and print time per function and line" << std::endl;
+    std::cout << "  matfree --profile-json <out.json> <file.m>" << std::endl;
+    std::cout << "                       Execute a script and write its profile as JSON" << std::endl;
+    std::cout << "  matfree --flamegraph <out.folded> [--trace <out.json>] [--sample-rate <hz>] <file.m>" << std::endl;
+    std::cout << "                       Sample a script's call stack; write collapsed stacks" << std::endl;
+    std::cout << "                       and/or Chrome trace events" << std::endl;
     std::cout << "  matfree --version    Print version information" << std::endl;
     std::cout << "  matfree --help       Print this help message" << std::endl;
 }
 
+struct ProfileOutputs {
+    bool instrumented = false;
+    std::string json;       // --profile-json
+    std::string flamegraph; // --flamegraph
+    std::string trace;      // --trace
+    double sampleRate = 1000;
+
+    bool sampled() const { return !flamegraph.empty() || !trace.empty(); }
+};
+
+static void writeText(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw RuntimeError("Cannot write profile to " + path);
+    out << text;
+}
+
+// Text profile on stderr (so it does not mix with the script's output), or
+// JSON to a file; samples to their files
+static void reportProfile(Interpreter& interp, const ProfileOutputs& outputs) {
+    interp.setProfiling(false);
+    interp.stopSampling();
+    if (outputs.instrumented) {
+        if (outputs.json.empty()) std::cerr << interp.profiler().textReport();
+        else writeText(outputs.json, interp.profiler().jsonReport());
+    }
+    if (!outputs.flamegraph.empty()) writeText(outputs.flamegraph, interp.sampler().foldedStacks());
+    if (!outputs.trace.empty()) writeText(outputs.trace, interp.sampler().chromeTrace());
+}
+
 int main(int argc, char* argv[]) {
+    // Output is flushed by the interpreter at statement ends, not per write
+    std::ios::sync_with_stdio(false);
     try {
         // Create interpreter and register built-in functions
         Interpreter interp;
@@ -51,6 +97,7 @@ int main(int argc, char* argv[]) {
         }
 
         // Parse command-line arguments
+        ProfileOutputs profile;
         for (int i = 1; i < argc; i++) {
             std::string arg = argv[i];
 
@@ -78,8 +125,47 @@ int main(int argc, char* argv[]) {
                 continue;
             }
 
+            if (arg == "--profile") {
+                profile.instrumented = true;
+                continue;
+            }
+
+            if (arg == "--profile-json" && i + 1 < argc) {
+                profile.instrumented = true;
+                profile.json = argv[++i];
+                continue;
+            }
+
+            if (arg == "--flamegraph" && i + 1 < argc) {
+                profile.flamegraph = argv[++i];
+                continue;
+            }
+
+            if (arg == "--trace" && i + 1 < argc) {
+                profile.trace = argv[++i];
+                continue;
+            }
+
+            if (arg == "--sample-rate" && i + 1 < argc) {
+                profile.sampleRate = std::atof(argv[++i]);
+                continue;
+            }
+
             // Assume it's a .m file
-            interp.executeFile(arg);
+            if (!profile.instrumented && !profile.sampled()) {
+                interp.executeFile(arg);
+                return 0;
+            }
+            if (profile.instrumented) interp.setProfiling(true);
+            // The profile is reported even if the script fails
+            try {
+                if (profile.sampled()) interp.startSampling(profile.sampleRate);
+                interp.executeFile(arg);
+            } catch (...) {
+                reportProfile(interp, profile);
+                throw;
+            }
+            reportProfile(interp, profile);
             return 0;
         }
 
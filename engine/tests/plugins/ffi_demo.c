@@ -0,0 +1,50 @@
+/* MatFree - Plain C library used by the loadlibrary/calllib tests
+ * Copyright (c) 2026 MatFree Contributors - MIT License
+ */
+
+#include <ctype.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define FFI_EXPORT __declspec(dllexport)
+#else
+#define FFI_EXPORT __attribute__((visibility("default")))
+#endif
+
+FFI_EXPORT double ffi_dot(const double* x, const double* y, int n) {
+    double s = 0;
+    int i;
+    for (i = 0; i < n; i++) s += x[i] * y[i];
+    return s;
+}
+
+FFI_EXPORT void ffi_scale(double* x, int n, double k) {
+    int i;
+    for (i = 0; i < n; i++) x[i] *= k;
+}
+
+FFI_EXPORT unsigned int ffi_sum_u8(const unsigned char* x, size_t n) {
+    unsigned int s = 0;
+    size_t i;
+    for (i = 0; i < n; i++) s += x[i];
+    return s;
+}
+
+FFI_EXPORT double ffi_mix(int a, float b, double c, long long d, short e, unsigned int f) {
+    return a + b + c + (double)d + e + f;
+}
+
+FFI_EXPORT unsigned int ffi_wrap(int x) { return (unsigned int)x; }
+
+FFI_EXPORT void ffi_fill_i16(short* out, int n) {
+    int i;
+    for (i = 0; i < n; i++) out[i] = (short)(-1000 * (i + 1));
+}
+
+FFI_EXPORT size_t ffi_strlen(const char* s) { return strlen(s); }
+
+FFI_EXPORT void ffi_upper(char* s) {
+    for (; *s; s++) *s = (char)toupper((unsigned char)*s);
+}
+
+FFI_EXPORT const char* ffi_name(void) { return "ffi_demo"; }
@@ -0,0 +1,40 @@
+/* MatFree - Demo plugin used by the test suite
+ * Copyright (c) 2026 MatFree Contributors - MIT License
+ *
+ * mfx_demo(A, k)        -> A * k, and the number of elements
+ * mfx_demo_loads()      -> calls since this copy of the library was loaded
+ */
+
+#include "capi/matfree_plugin.h"
+
+static int calls = 0;
+
+static int demo(const mf_host* host, mf_call* call, int nargout, int nargin, const mf_arg* args, void* data) {
+    size_t i, n;
+    double* out;
+    (void)data;
+    calls++;
+    if (nargin != 2 || args[0].kind != MF_ARG_MATRIX || args[1].kind != MF_ARG_MATRIX)
+        return host->error(call, "mfx_demo: expected a matrix and a scalar");
+    n = args[0].rows * args[0].cols;
+    out = host->output_matrix(call, 0, args[0].rows, args[0].cols);
+    for (i = 0; i < n; i++) out[i] = args[0].data[i] * args[1].data[0];
+    if (nargout > 1) host->output_scalar(call, 1, (double)n);
+    return 0;
+}
+
+static int loads(const mf_host* host, mf_call* call, int nargout, int nargin, const mf_arg* args, void* data) {
+    (void)nargout;
+    (void)nargin;
+    (void)args;
+    (void)data;
+    host->output_scalar(call, 0, (double)calls);
+    return 0;
+}
+
+MF_PLUGIN_EXPORT int mf_plugin_init(const mf_host* host, mf_registry* registry) {
+    if (host->abi != MATFREE_PLUGIN_ABI) return -1;
+    host->define(registry, "mfx_demo", demo, NULL);
+    host->define(registry, "mfx_demo_loads", loads, NULL);
+    return MATFREE_PLUGIN_ABI;
+}
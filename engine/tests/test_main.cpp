@@ -7,11 +7,30 @@
 #include "core/builtins.h"
 #include "core/lexer.h"
 #include "core/parser.h"
+#include "core/sorting.h"
+#include "core/statistics.h"
+#include "core/histogram.h"
+#include "core/scan.h"
+#include "core/sets.h"
+#include "core/accumulate.h"
+#include "core/parallel.h"
+#include "core/random.h"
+#include "core/workspace_file.h"
+#include "core/delimited_text.h"
+#include "core/datastore.h"
+#ifdef MATFREE_HAS_CAPI
+#include "capi/matfree.h"
+#endif
 #include <iostream>
 #include <sstream>
 #include <cmath>
 #include <cassert>
 #include <type_traits>
+#include <algorithm>
+#include <limits>
+#include <filesystem>
+#include <fstream>
+#include <thread>
 
 using namespace matfree;
 
@@ -404,6 +423,1360 @@ TEST(interp_linspace) {
     ASSERT_NEAR(val->matrix()(0, 4), 1.0, 1e-10);
 }
 
+TEST(interp_sort_descend_with_indices) {
+    auto interp = createTestInterp();
+    interp.executeString("[s, i] = sort([3 1 2 1], 'descend');");
+    auto s = interp.globalEnv()->get("s");
+    auto i = interp.globalEnv()->get("i");
+    ASSERT_NEAR(s->matrix()(0, 0), 3.0, 1e-10);
+    ASSERT_NEAR(s->matrix()(0, 3), 1.0, 1e-10);
+    // Stable: the two 1s keep their original order
+    ASSERT_NEAR(i->matrix()(0, 0), 1.0, 1e-10);
+    ASSERT_NEAR(i->matrix()(0, 2), 2.0, 1e-10);
+    ASSERT_NEAR(i->matrix()(0, 3), 4.0, 1e-10);
+}
+
+TEST(interp_sort_along_dim) {
+    auto interp = createTestInterp();
+    interp.executeString("A = [3 1; 1 2; 2 0]; B = sort(A); C = sort(A, 2);");
+    auto b = interp.globalEnv()->get("B");
+    ASSERT_NEAR(b->matrix()(0, 0), 1.0, 1e-10);
+    ASSERT_NEAR(b->matrix()(2, 0), 3.0, 1e-10);
+    ASSERT_NEAR(b->matrix()(0, 1), 0.0, 1e-10);
+    auto c = interp.globalEnv()->get("C");
+    ASSERT_NEAR(c->matrix()(0, 0), 1.0, 1e-10);
+    ASSERT_NEAR(c->matrix()(0, 1), 3.0, 1e-10);
+}
+
+TEST(interp_sortrows_multikey) {
+    auto interp = createTestInterp();
+    interp.executeString("A = [1 5; 2 3; 1 7; 2 1]; [B, i] = sortrows(A, [1, -2]);");
+    auto b = interp.globalEnv()->get("B");
+    ASSERT_NEAR(b->matrix()(0, 1), 7.0, 1e-10);
+    ASSERT_NEAR(b->matrix()(1, 1), 5.0, 1e-10);
+    ASSERT_NEAR(b->matrix()(2, 1), 3.0, 1e-10);
+    ASSERT_NEAR(b->matrix()(3, 1), 1.0, 1e-10);
+    auto i = interp.globalEnv()->get("i");
+    ASSERT_NEAR(i->matrix()(0), 3.0, 1e-10);
+    ASSERT_NEAR(i->matrix()(3), 4.0, 1e-10);
+}
+
+TEST(interp_multi_output_size_max_min_find) {
+    auto interp = createTestInterp();
+    interp.executeString("A = [4 9 2; 7 1 8];"
+                         "[r, c] = size(A); [r3, c3, p3] = size(A);"
+                         "[m, i] = max([3 8 1 8]); [n, j] = min([3 8 1 8]);"
+                         "[cm, ci] = max(A); [cn, cj] = min(A);"
+                         "[fr, fc] = find([0 5; 6 0]); [gr, gc, gv] = find([0 5; 6 0]);");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("r")->scalarDouble(), 2.0);
+    ASSERT_EQ(env->get("c")->scalarDouble(), 3.0);
+    ASSERT_EQ(env->get("p3")->scalarDouble(), 1.0);
+    ASSERT_EQ(env->get("m")->scalarDouble(), 8.0);
+    ASSERT_EQ(env->get("i")->scalarDouble(), 2.0); // the first of the ties
+    ASSERT_EQ(env->get("n")->scalarDouble(), 1.0);
+    ASSERT_EQ(env->get("j")->scalarDouble(), 3.0);
+    ASSERT_EQ(env->get("cm")->matrix()(1), 9.0);
+    ASSERT_EQ(env->get("ci")->matrix()(0), 2.0);
+    ASSERT_EQ(env->get("ci")->matrix()(1), 1.0);
+    ASSERT_EQ(env->get("cj")->matrix()(2), 1.0);
+    const Matrix& fr = env->get("fr")->matrix();
+    const Matrix& fc = env->get("fc")->matrix();
+    ASSERT_EQ(fr.numel(), 2u);
+    ASSERT_EQ(fr(0), 1.0);
+    ASSERT_EQ(fc(0), 2.0);
+    ASSERT_EQ(fr(1), 2.0);
+    ASSERT_EQ(fc(1), 1.0);
+    ASSERT_EQ(env->get("gv")->matrix()(1), 6.0);
+
+    interp.executeString("try\n [a, b] = max([1 2], [2 1]);\n msg = 'none';\ncatch e\n msg = e.message;\nend");
+    ASSERT_TRUE(env->get("msg")->string().find("two outputs") != std::string::npos);
+}
+
+TEST(radix_sort_matches_std_sort) {
+    std::vector<double> data(100000);
+    for (size_t k = 0; k < data.size(); k++)
+        data[k] = std::sin(static_cast<double>(k) * 12.9898) * 1e6;
+    data[17] = std::numeric_limits<double>::quiet_NaN();
+    data[99] = -std::numeric_limits<double>::infinity();
+    auto expected = data;
+    std::sort(expected.begin(), expected.end(), [](double a, double b) {
+        return std::isnan(b) ? !std::isnan(a) : a < b;
+    });
+    sortValues(data.data(), data.size(), SortOrder::ASCEND);
+    for (size_t k = 0; k + 1 < data.size(); k++) ASSERT_EQ(data[k], expected[k]);
+    ASSERT_TRUE(std::isnan(data.back()));
+}
+
+TEST(interp_median_dims_and_nan) {
+    auto interp = createTestInterp();
+    interp.executeString("A = [4 1; 2 NaN; 9 3; 1 5]; a = median(A); b = median(A, 2);"
+                         "c = median(A, 'omitnan'); d = median(A, 'all', 'omitnan');");
+    auto a = interp.globalEnv()->get("a");
+    ASSERT_NEAR(a->matrix()(0, 0), 3.0, 1e-10);
+    ASSERT_TRUE(std::isnan(a->matrix()(0, 1)));
+    auto b = interp.globalEnv()->get("b");
+    ASSERT_EQ(b->matrix().rows(), (size_t)4);
+    ASSERT_NEAR(b->matrix()(2, 0), 6.0, 1e-10);
+    auto c = interp.globalEnv()->get("c");
+    ASSERT_NEAR(c->matrix()(0, 1), 3.0, 1e-10);
+    ASSERT_NEAR(interp.globalEnv()->get("d")->scalarDouble(), 3.0, 1e-10);
+}
+
+TEST(interp_quantile_prctile_mode) {
+    auto interp = createTestInterp();
+    interp.executeString("x = [2 4 1 3]; q = quantile(x, [0.25, 0.5, 1]); p = prctile(x, 50);"
+                         "[m, f] = mode([3 1 3 2 1 NaN]);");
+    auto q = interp.globalEnv()->get("q");
+    ASSERT_EQ(q->matrix().cols(), (size_t)3);
+    ASSERT_NEAR(q->matrix()(0), 1.5, 1e-10);
+    ASSERT_NEAR(q->matrix()(1), 2.5, 1e-10);
+    ASSERT_NEAR(q->matrix()(2), 4.0, 1e-10);
+    ASSERT_NEAR(interp.globalEnv()->get("p")->scalarDouble(), 2.5, 1e-10);
+    ASSERT_NEAR(interp.globalEnv()->get("m")->scalarDouble(), 1.0, 1e-10);
+    ASSERT_NEAR(interp.globalEnv()->get("f")->scalarDouble(), 2.0, 1e-10);
+
+    // Along dimension 3 and up each element stands alone
+    interp.executeString("A = [1 2 3; 4 NaN 6]; md = median(A, 3); q3 = quantile(A, 0.3, 4);"
+                         "[m3, f3] = mode(A, 3); v3 = var(A, 0, 3);");
+    auto env = interp.globalEnv();
+    const Matrix& md = env->get("md")->matrix();
+    ASSERT_EQ(md.rows(), (size_t)2);
+    ASSERT_EQ(md.cols(), (size_t)3);
+    ASSERT_EQ(md(1, 0), 4.0);
+    ASSERT_TRUE(std::isnan(md(1, 1)));
+    ASSERT_EQ(env->get("q3")->matrix()(0, 2), 3.0);
+    ASSERT_EQ(env->get("m3")->matrix()(1, 2), 6.0);
+    ASSERT_EQ(env->get("f3")->matrix()(0, 1), 1.0);
+    ASSERT_EQ(env->get("v3")->matrix()(0, 0), 0.0);
+    ASSERT_EQ(env->get("v3")->matrix().cols(), (size_t)3);
+}
+
+TEST(multi_quantile_selection_matches_sort) {
+    std::vector<double> data(10001);
+    for (size_t k = 0; k < data.size(); k++)
+        data[k] = std::sin(static_cast<double>(k) * 78.233) * 1e3;
+    auto sorted = data;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<double> probs = {0.0, 0.1, 0.5, 0.9, 1.0};
+    std::vector<double> out(probs.size());
+    quantilesInPlace(data.data(), data.size(), probs, out.data(), NanFlag::INCLUDE);
+    ASSERT_EQ(out[0], sorted.front());
+    ASSERT_EQ(out[2], sorted[5000]);
+    ASSERT_EQ(out[4], sorted.back());
+    double pos = 0.1 * 10001 + 0.5; // 1-based position
+    size_t lo = static_cast<size_t>(pos) - 1;
+    ASSERT_NEAR(out[1], sorted[lo] + (pos - std::floor(pos)) * (sorted[lo + 1] - sorted[lo]), 1e-9);
+}
+
+TEST(interp_var_std_cov_along_dims) {
+    auto interp = createTestInterp();
+    interp.executeString("A = [1 2; 3 6; 5 10]; v = var(A); s = std(A, 1, 2); c = cov(A);"
+                         "r = corrcoef(A(:, 1), [1; 2; 4]);");
+    auto v = interp.globalEnv()->get("v");
+    ASSERT_NEAR(v->matrix()(0, 0), 4.0, 1e-12);
+    ASSERT_NEAR(v->matrix()(0, 1), 16.0, 1e-12);
+    auto sd = interp.globalEnv()->get("s");
+    ASSERT_EQ(sd->matrix().rows(), (size_t)3);
+    ASSERT_NEAR(sd->matrix()(1, 0), 1.5, 1e-12);
+    auto c = interp.globalEnv()->get("c");
+    ASSERT_NEAR(c->matrix()(0, 1), 8.0, 1e-12);
+    ASSERT_NEAR(c->matrix()(1, 0), 8.0, 1e-12);
+    ASSERT_NEAR(c->matrix()(1, 1), 16.0, 1e-12);
+    auto r = interp.globalEnv()->get("r");
+    ASSERT_NEAR(r->matrix()(0, 0), 1.0, 1e-12);
+    ASSERT_NEAR(r->matrix()(0, 1), 6.0 / std::sqrt(8.0 * 42.0 / 9.0), 1e-12);
+}
+
+TEST(interp_moments_incremental) {
+    auto interp = createTestInterp();
+    interp.executeString("s = moments([1 2 3]); s = moments(s, [4 5]); t = moments(moments(6), s);");
+    auto s = interp.globalEnv()->get("s")->structVal();
+    ASSERT_NEAR(s.fields["mean"]->scalarDouble(), 3.0, 1e-12);
+    ASSERT_NEAR(s.fields["var"]->scalarDouble(), 2.5, 1e-12);
+    auto t = interp.globalEnv()->get("t")->structVal();
+    ASSERT_NEAR(t.fields["count"]->scalarDouble(), 6.0, 1e-12);
+    ASSERT_NEAR(t.fields["max"]->scalarDouble(), 6.0, 1e-12);
+    ASSERT_NEAR(t.fields["var"]->scalarDouble(), 3.5, 1e-12);
+}
+
+TEST(moment_accumulator_is_stable_and_mergeable) {
+    // Large offset with small spread: the naive sum-of-squares formula loses
+    // every significant digit here.
+    std::vector<double> data(300000);
+    for (size_t k = 0; k < data.size(); k++) data[k] = 1e9 + static_cast<double>(k % 4);
+    auto whole = accumulateMoments(data.data(), data.size());
+    ASSERT_NEAR(whole.mean, 1e9 + 1.5, 1e-6);
+    ASSERT_NEAR(whole.variance(1), 1.25, 1e-9);
+    MomentAccumulator a, b;
+    a.add(data.data(), 1000);
+    for (size_t k = 1000; k < data.size(); k++) b.add(data[k]);
+    a.merge(b);
+    ASSERT_NEAR(a.variance(1), whole.variance(1), 1e-9);
+    ASSERT_EQ(a.count, whole.count);
+}
+
+TEST(interp_histcounts_and_hist) {
+    auto interp = createTestInterp();
+    interp.executeString("x = [0 0.5 1 1.5 2 2 NaN 5]; [n, e, b] = histcounts(x, [0, 1, 2]);"
+                         "h = hist([1 2 2 3 3 3], 3); c = histc([1 2 2 3 7], [1, 2, 3]);");
+    auto n = interp.globalEnv()->get("n");
+    ASSERT_NEAR(n->matrix()(0), 2.0, 1e-12);
+    ASSERT_NEAR(n->matrix()(1), 4.0, 1e-12); // last bin includes its right edge
+    auto b = interp.globalEnv()->get("b");
+    ASSERT_NEAR(b->matrix()(2), 2.0, 1e-12);
+    ASSERT_NEAR(b->matrix()(6), 0.0, 1e-12);
+    ASSERT_NEAR(b->matrix()(7), 0.0, 1e-12);
+    auto h = interp.globalEnv()->get("h");
+    ASSERT_NEAR(h->matrix()(0), 1.0, 1e-12);
+    ASSERT_NEAR(h->matrix()(2), 3.0, 1e-12);
+    auto c = interp.globalEnv()->get("c");
+    ASSERT_NEAR(c->matrix()(0), 1.0, 1e-12);
+    ASSERT_NEAR(c->matrix()(1), 2.0, 1e-12);
+    ASSERT_NEAR(c->matrix()(2), 1.0, 1e-12);
+}
+
+TEST(interp_histcounts2) {
+    auto interp = createTestInterp();
+    interp.executeString("N = histcounts2([0 0 1 1 1], [0 1 0 1 1], [0, 0.5, 1], [0, 0.5, 1]);");
+    auto n = interp.globalEnv()->get("N");
+    ASSERT_NEAR(n->matrix()(0, 0), 1.0, 1e-12);
+    ASSERT_NEAR(n->matrix()(0, 1), 1.0, 1e-12);
+    ASSERT_NEAR(n->matrix()(1, 0), 1.0, 1e-12);
+    ASSERT_NEAR(n->matrix()(1, 1), 2.0, 1e-12);
+}
+
+TEST(uniform_bins_match_binary_search) {
+    // Direct indexing must agree with the edge search right at bin boundaries.
+    auto uniform = BinEdges::uniform(-1.0, 2.0, 30);
+    ASSERT_TRUE(uniform.isUniform());
+    auto edges = uniform.edges();
+    edges.push_back(edges.back()); // breaks even spacing
+    auto searched = BinEdges::fromEdges(edges);
+    ASSERT_TRUE(!searched.isUniform());
+    std::vector<double> data(200000);
+    for (size_t k = 0; k < data.size(); k++)
+        data[k] = (k % 3 == 0) ? uniform.edges()[k % 31] : -1.5 + 4.0 * std::fmod(k * 0.6180339887, 1.0);
+    auto a = histCounts(data.data(), data.size(), uniform);
+    auto b = histCounts(data.data(), data.size(), searched);
+    for (size_t k = 0; k + 1 < a.size(); k++) ASSERT_EQ(a[k], b[k]);
+    ASSERT_EQ(a.back(), b[a.size() - 1] + b.back());
+}
+
+TEST(interp_cumulative_along_dims) {
+    auto interp = createTestInterp();
+    interp.executeString("A = [1 2; 3 4; 5 6]; s1 = cumsum(A); s2 = cumsum(A, 2); p = cumprod([1 2 3 4]);"
+                         "r = cumsum([1 2 3], 'reverse'); mx = cummax([NaN 1 3 2 5]); mn = cummin([4, -1, 2], 2);");
+    auto s1 = interp.globalEnv()->get("s1")->matrix();
+    ASSERT_NEAR(s1(2, 0), 9.0, 1e-12);
+    ASSERT_NEAR(s1(2, 1), 12.0, 1e-12);
+    auto s2 = interp.globalEnv()->get("s2")->matrix();
+    ASSERT_NEAR(s2(1, 1), 7.0, 1e-12);
+    ASSERT_NEAR(interp.globalEnv()->get("p")->matrix()(3), 24.0, 1e-12);
+    auto r = interp.globalEnv()->get("r")->matrix();
+    ASSERT_NEAR(r(0), 6.0, 1e-12);
+    ASSERT_NEAR(r(2), 3.0, 1e-12);
+    auto mx = interp.globalEnv()->get("mx")->matrix();
+    ASSERT_TRUE(std::isnan(mx(0)));
+    ASSERT_NEAR(mx(3), 3.0, 1e-12);
+    ASSERT_NEAR(mx(4), 5.0, 1e-12);
+    auto mn = interp.globalEnv()->get("mn")->matrix();
+    ASSERT_NEAR(mn(2), -1.0, 1e-12);
+}
+
+TEST(interp_diff_inverts_cumsum) {
+    auto interp = createTestInterp();
+    interp.executeString("x = [3 1 4 1 5 9]; d = diff(cumsum(x)); d2 = diff(x, 2); D = diff([1 2; 4 8; 9 18]);");
+    auto d = interp.globalEnv()->get("d")->matrix();
+    ASSERT_EQ(d.numel(), (size_t)5);
+    ASSERT_NEAR(d(4), 9.0, 1e-12);
+    auto d2 = interp.globalEnv()->get("d2")->matrix();
+    ASSERT_EQ(d2.numel(), (size_t)4);
+    ASSERT_NEAR(d2(0), 5.0, 1e-12);
+    auto D = interp.globalEnv()->get("D")->matrix();
+    ASSERT_EQ(D.rows(), (size_t)2);
+    ASSERT_NEAR(D(1, 1), 10.0, 1e-12);
+}
+
+TEST(parallel_scan_matches_serial) {
+    std::vector<double> data(1000003);
+    for (size_t k = 0; k < data.size(); k++) data[k] = static_cast<double>((k * 7919) % 13) - 6.0;
+    std::vector<double> out(data.size());
+    scanValues(data.data(), out.data(), data.size(), ScanOp::SUM, NanFlag::INCLUDE);
+    double s = 0;
+    for (size_t k = 0; k < data.size(); k++) {
+        s += data[k];
+        ASSERT_EQ(out[k], s); // small integers: exact in any association
+    }
+    scanValues(data.data(), out.data(), data.size(), ScanOp::MAX, NanFlag::OMIT, true);
+    ASSERT_EQ(out.back(), data.back());
+    ASSERT_EQ(out.front(), 6.0);
+}
+
+TEST(interp_unique_with_indices) {
+    auto interp = createTestInterp();
+    interp.executeString("[C, ia, ic] = unique([3 1 3 2 1]); S = unique([3 1 3 2 1], 'stable');"
+                         "[u, ~, g] = unique({'b', 'a', 'b'});");
+    auto c = interp.globalEnv()->get("C")->matrix();
+    ASSERT_EQ(c.cols(), (size_t)3);
+    ASSERT_NEAR(c(0), 1.0, 1e-12);
+    ASSERT_NEAR(c(2), 3.0, 1e-12);
+    auto ia = interp.globalEnv()->get("ia")->matrix();
+    ASSERT_NEAR(ia(0), 2.0, 1e-12);
+    ASSERT_NEAR(ia(2), 1.0, 1e-12);
+    auto ic = interp.globalEnv()->get("ic")->matrix();
+    ASSERT_NEAR(ic(0), 3.0, 1e-12);
+    ASSERT_NEAR(ic(4), 1.0, 1e-12);
+    auto st = interp.globalEnv()->get("S")->matrix();
+    ASSERT_NEAR(st(0), 3.0, 1e-12);
+    ASSERT_NEAR(st(2), 2.0, 1e-12);
+    auto u = interp.globalEnv()->get("u")->cellArray();
+    ASSERT_EQ(u.data.size(), (size_t)2);
+    ASSERT_EQ(u.data[0]->string(), "a");
+    ASSERT_NEAR(interp.globalEnv()->get("g")->matrix()(2), 2.0, 1e-12);
+}
+
+TEST(interp_set_operations) {
+    auto interp = createTestInterp();
+    interp.executeString("[tf, loc] = ismember([5 2 NaN 7], [7 5 5]); m = ismember('b', {'a', 'b'});"
+                         "[I, ia, ib] = intersect([4 1 2 4], [2 4 9]); U = union([3 1], [2 1]);"
+                         "[D, id] = setdiff([5 4 3 4], [3]);"
+                         "c = class(ismember([1 5 2], [2 1])); l = islogical(ismember([1; 5], 5));");
+    ASSERT_TRUE(interp.globalEnv()->get("tf")->isLogical());
+    ASSERT_EQ(interp.globalEnv()->get("c")->string(), std::string("logical"));
+    ASSERT_TRUE(interp.globalEnv()->get("l")->toBool());
+    auto tf = interp.globalEnv()->get("tf")->matrix();
+    ASSERT_NEAR(tf(0), 1.0, 1e-12);
+    ASSERT_NEAR(tf(2), 0.0, 1e-12);
+    auto loc = interp.globalEnv()->get("loc")->matrix();
+    ASSERT_NEAR(loc(0), 2.0, 1e-12);
+    ASSERT_NEAR(loc(3), 1.0, 1e-12);
+    ASSERT_TRUE(interp.globalEnv()->get("m")->toBool());
+    auto in = interp.globalEnv()->get("I")->matrix();
+    ASSERT_EQ(in.numel(), (size_t)2);
+    ASSERT_NEAR(in(0), 2.0, 1e-12);
+    ASSERT_NEAR(interp.globalEnv()->get("ia")->matrix()(1), 1.0, 1e-12);
+    ASSERT_NEAR(interp.globalEnv()->get("ib")->matrix()(1), 2.0, 1e-12);
+    auto un = interp.globalEnv()->get("U")->matrix();
+    ASSERT_EQ(un.numel(), (size_t)3);
+    ASSERT_NEAR(un(2), 3.0, 1e-12);
+    auto d = interp.globalEnv()->get("D")->matrix();
+    ASSERT_EQ(d.numel(), (size_t)2);
+    ASSERT_NEAR(d(1), 5.0, 1e-12);
+    ASSERT_NEAR(interp.globalEnv()->get("id")->matrix()(0), 2.0, 1e-12);
+}
+
+TEST(hash_unique_matches_sorted_unique) {
+    // Large enough to take the partitioned parallel path when threads exist.
+    SetKeys keys;
+    for (size_t k = 0; k < 200000; k++) keys.numbers.push_back(static_cast<double>((k * 2654435761u) % 5003));
+    keys.numbers[10] = -0.0;
+    auto hashed = uniqueKeys(keys, false, true);
+    auto sorted = uniqueKeys(keys, true, true);
+    ASSERT_EQ(hashed.first.size(), sorted.first.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        ASSERT_EQ(keys.numbers[hashed.first[hashed.group[i]]], keys.numbers[i]);
+        ASSERT_EQ(keys.numbers[sorted.first[sorted.group[i]]], keys.numbers[i]);
+    }
+    for (size_t k = 1; k < hashed.first.size(); k++) ASSERT_TRUE(hashed.first[k - 1] < hashed.first[k]);
+}
+
+TEST(interp_accumarray_reductions) {
+    auto interp = createTestInterp();
+    interp.executeString("ids = [1; 3; 1; 2; 3; 3]; v = [10; 1; 20; 5; 2; 3];"
+                         "s = accumarray(ids, v); m = accumarray(ids, v, [], @max);"
+                         "a = accumarray(ids, v, [4 1], @mean, -1); c = accumarray(ids, 1);"
+                         "G = accumarray([1 1; 2 2; 1 1], [4; 5; 6]);"
+                         "r = accumarray(ids, v, [], @(x) numel(x) * 100 + x(1));");
+    auto sv = interp.globalEnv()->get("s")->matrix();
+    ASSERT_EQ(sv.rows(), (size_t)3);
+    ASSERT_NEAR(sv(0), 30.0, 1e-12);
+    ASSERT_NEAR(sv(2), 6.0, 1e-12);
+    ASSERT_NEAR(interp.globalEnv()->get("m")->matrix()(0), 20.0, 1e-12);
+    auto a = interp.globalEnv()->get("a")->matrix();
+    ASSERT_NEAR(a(0), 15.0, 1e-12);
+    ASSERT_NEAR(a(3), -1.0, 1e-12);
+    ASSERT_NEAR(interp.globalEnv()->get("c")->matrix()(2), 3.0, 1e-12);
+    auto g = interp.globalEnv()->get("G")->matrix();
+    ASSERT_NEAR(g(0, 0), 10.0, 1e-12);
+    ASSERT_NEAR(g(1, 1), 5.0, 1e-12);
+    ASSERT_NEAR(g(0, 1), 0.0, 1e-12);
+    auto r = interp.globalEnv()->get("r")->matrix();
+    ASSERT_NEAR(r(0), 210.0, 1e-12); // first value of each group, in input order
+    ASSERT_NEAR(r(2), 301.0, 1e-12);
+}
+
+TEST(accumulate_partials_match_serial) {
+    size_t n = 300000, cells = 97;
+    std::vector<size_t> target(n);
+    std::vector<double> vals(n);
+    std::vector<double> expected(cells, 0.0);
+    for (size_t i = 0; i < n; i++) {
+        target[i] = (i * 31) % cells;
+        vals[i] = static_cast<double>(i % 7);
+        expected[target[i]] += vals[i];
+    }
+    auto sums = accumulate(target.data(), n, vals.data(), 0.0, cells + 1, AccumOp::SUM, -1.0);
+    for (size_t k = 0; k < cells; k++) ASSERT_EQ(sums[k], expected[k]);
+    ASSERT_EQ(sums[cells], -1.0);
+    auto counts = accumulate(target.data(), n, nullptr, 1.0, cells, AccumOp::COUNT, 0.0);
+    double total = 0;
+    for (double c : counts) total += c;
+    ASSERT_EQ(total, static_cast<double>(n));
+}
+
+TEST(interp_cellfun_options) {
+    auto interp = createTestInterp();
+    interp.executeString("e = cellfun(@(x) x * 2, {1, [1, 2]}, 'UniformOutput', false);"
+                         "[m, f] = cellfun(@mode, {[1, 5, 5], [7, 3, 3, 3]});"
+                         "s = arrayfun(@(x, y) x + y, [1, 2], [10, 20]);"
+                         "n = cellfun('isempty', {[1, 2], [], 'abc'});"
+                         "h = cellfun(@(x) error('bad'), {1, 2}, 'ErrorHandler', @(err, x) err.index * 10);"
+                         "try cellfun(@(x) [x, x], {1, 2}); msg = ''; catch err; msg = err.message; end");
+    auto e = interp.globalEnv()->get("e");
+    ASSERT_TRUE(e->isCellArray());
+    ASSERT_EQ(e->cellArray().data[1]->matrix().numel(), (size_t)2);
+    ASSERT_NEAR(interp.globalEnv()->get("m")->matrix()(1), 3.0, 1e-12);
+    ASSERT_NEAR(interp.globalEnv()->get("f")->matrix()(0), 2.0, 1e-12);
+    ASSERT_NEAR(interp.globalEnv()->get("s")->matrix()(1), 22.0, 1e-12);
+    ASSERT_NEAR(interp.globalEnv()->get("n")->matrix()(1), 1.0, 1e-12);
+    ASSERT_NEAR(interp.globalEnv()->get("h")->matrix()(1), 20.0, 1e-12);
+    ASSERT_TRUE(interp.globalEnv()->get("msg")->string().find("UniformOutput") != std::string::npos);
+}
+
+TEST(interp_arrayfun_fast_paths_match_serial) {
+    auto interp = createTestInterp();
+    ASSERT_TRUE(interp.isPureHandle(interp.makeFunctionHandle("sin")->funcHandle()));
+    ASSERT_TRUE(!interp.isPureHandle(interp.makeFunctionHandle("disp")->funcHandle()));
+    interp.executeString("x = (1:2000) / 100;"
+                         "v = arrayfun(@(t) 2 * sin(t) .^ 2 + abs(t - 3), x);"
+                         "w = arrayfun(@(t) [2 * sin(t) .^ 2 + abs(t - 3), 0], x, 'UniformOutput', false);"
+                         "p = arrayfun(@sqrt, x); c = arrayfun(@(t) 4, x);");
+    auto v = interp.globalEnv()->get("v")->matrix();
+    auto p = interp.globalEnv()->get("p")->matrix();
+    const auto& w = interp.globalEnv()->get("w")->cellArray();
+    ASSERT_EQ(v.cols(), (size_t)2000);
+    for (size_t i = 0; i < 2000; i++) {
+        ASSERT_NEAR(v(i), w.data[i]->matrix()(0), 1e-12);
+        ASSERT_NEAR(p(i), std::sqrt((i + 1) / 100.0), 1e-12);
+    }
+    ASSERT_NEAR(interp.globalEnv()->get("c")->matrix()(1999), 4.0, 1e-12);
+}
+
+TEST(interp_parfor_matches_for) {
+    auto interp = createTestInterp();
+    setParallelThreadCount(4);
+    std::string out = captureOutput(interp,
+        "n = 200; x = zeros(1, n); y = zeros(1, n); s = 0; t = 0; m = -Inf; v = 0; c = {};"
+        "parfor i = 1:n\n tmp = 1 / i^2; x(i) = tmp; s = s + tmp; m = max(m, mod(i * 37, 101));"
+        " c{i} = i; if i <= 3, fprintf('%d;', i); end\nend\n"
+        "for i = 1:n\n tmp = 1 / i^2; y(i) = tmp; t = t + tmp;\nend\n"
+        "parfor (k = 1:4, 2)\n v = [v, k];\nend");
+    setParallelThreadCount(0);
+    auto x = interp.globalEnv()->get("x")->matrix();
+    auto y = interp.globalEnv()->get("y")->matrix();
+    for (size_t k = 0; k < 200; k++) ASSERT_EQ(x(k), y(k));
+    // Reductions fold in iteration order: bitwise equal to the serial loop
+    ASSERT_EQ(interp.globalEnv()->get("s")->scalarDouble(), interp.globalEnv()->get("t")->scalarDouble());
+    ASSERT_NEAR(interp.globalEnv()->get("m")->scalarDouble(), 100.0, 1e-12);
+    ASSERT_EQ(interp.globalEnv()->get("c")->cellArray().data.size(), (size_t)200);
+    auto v = interp.globalEnv()->get("v")->matrix();
+    ASSERT_EQ(v.cols(), (size_t)5);
+    ASSERT_NEAR(v(4), 4.0, 1e-12);
+    ASSERT_EQ(out, std::string("1;2;3;"));
+}
+
+TEST(interp_parfor_classification_errors) {
+    auto interp = createTestInterp();
+    auto message = [&](const std::string& code) {
+        interp.executeString("try\n" + code + "\nmsg = '';\ncatch err\nmsg = err.message;\nend");
+        return interp.globalEnv()->get("msg")->string();
+    };
+    ASSERT_TRUE(message("s = 0; parfor i = 1:3\n s = s + i; disp(s);\nend").find("reduction") != std::string::npos);
+    ASSERT_TRUE(message("parfor i = 1:3\n break;\nend").find("break") != std::string::npos);
+    ASSERT_TRUE(message("x = zeros(1, 3); parfor i = 1:3\n x(2) = i;\nend").find("loop variable") != std::string::npos);
+    ASSERT_TRUE(message("parfor i = 1:2:5\n a = i;\nend").find("consecutive") != std::string::npos);
+    ASSERT_TRUE(message("parfor i = 1:3\n if i > 1, error(num2str(i)); end\nend") == "2");
+    // Temporaries do not leak out of the loop
+    interp.executeString("parfor i = 1:3\n tmpval = i;\nend");
+    ASSERT_TRUE(interp.globalEnv()->get("tmpval") == nullptr);
+}
+
+TEST(interp_concurrent_sessions) {
+    // 64 interpreters on 64 threads: each has its own rand stream, tic
+    // timer and workspace, while built-ins and parsed .m files are shared.
+    auto dir = std::filesystem::temp_directory_path() / "matfree_sessions_test";
+    std::filesystem::create_directories(dir);
+    {
+        std::ofstream f(dir / "sessiontwice.m");
+        f << "function y = sessiontwice(x)\n    y = 2 * x;\nend\n";
+    }
+
+    constexpr int kSessions = 64;
+    std::vector<std::string> failures(kSessions);
+    std::vector<const BuiltinTable*> tables(kSessions);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kSessions; t++) {
+        threads.emplace_back([&, t] {
+            try {
+                Interpreter interp;
+                registerAllBuiltins(interp);
+                tables[t] = interp.builtinTable().get();
+                interp.addPath(dir.string());
+                interp.executeString(
+                    "id = " + std::to_string(t) + ";\n"
+                    "tic; r = rand(1, 200); s = sort(r);\n"
+                    "c = cellfun(@(v) v + 1, {id, id + 1, id + 2});\n"
+                    "total = 0;\n"
+                    "for k = 1:50\n total = total + sessiontwice(k);\nend\n"
+                    "e = toc;");
+                auto env = interp.globalEnv();
+                const Matrix& s = env->get("s")->matrix();
+                if (!std::is_sorted(s.data().begin(), s.data().end())) failures[t] = "sort";
+                const Matrix& c = env->get("c")->matrix();
+                if (c(0, 0) != t + 1 || c(0, 2) != t + 3) failures[t] = "cellfun";
+                if (env->get("total")->scalarDouble() != 2550) failures[t] = "user function";
+                if (env->get("e")->scalarDouble() < 0) failures[t] = "toc";
+            } catch (std::exception& e) {
+                failures[t] = e.what();
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    std::filesystem::remove_all(dir);
+
+    for (int t = 0; t < kSessions; t++) ASSERT_EQ(failures[t], std::string());
+    for (int t = 1; t < kSessions; t++) ASSERT_TRUE(tables[t] == tables[0]);
+}
+
+TEST(philox_known_answers) {
+    // Random123 known-answer vectors for Philox4x32-10
+    auto a = philox4x32({0, 0, 0, 0}, {0, 0});
+    ASSERT_EQ(a[0], 0x6627e8d5u);
+    ASSERT_EQ(a[3], 0x9b00dbd8u);
+    auto b = philox4x32({0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}, {0xa4093822u, 0x299f31d0u});
+    ASSERT_EQ(b[0], 0xd16cfe09u);
+    ASSERT_EQ(b[1], 0x94fdccebu);
+    ASSERT_EQ(b[2], 0x5001e420u);
+    ASSERT_EQ(b[3], 0x24126ea1u);
+}
+
+TEST(random_streams_reproducible_across_thread_counts) {
+    const size_t n = 100003;
+    auto draw = [&](size_t threads, bool normal, size_t split) {
+        setParallelThreadCount(threads);
+        RandomStream rng(42);
+        std::vector<double> v(n);
+        // Drawing in two pieces gives the same values as one draw
+        if (normal) {
+            rng.fillNormal(v.data(), split);
+            rng.fillNormal(v.data() + split, n - split);
+        } else {
+            rng.fillUniform(v.data(), split);
+            rng.fillUniform(v.data() + split, n - split);
+        }
+        setParallelThreadCount(0);
+        return v;
+    };
+    ASSERT_TRUE(draw(1, false, n) == draw(4, false, 333));
+    ASSERT_TRUE(draw(1, true, n) == draw(4, true, 77777));
+
+    auto u = draw(4, false, n);
+    auto z = draw(4, true, n);
+    double mu = 0, mz = 0, vz = 0;
+    size_t tail = 0;
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_TRUE(u[i] > 0 && u[i] < 1);
+        mu += u[i];
+        mz += z[i];
+        vz += z[i] * z[i];
+        if (std::fabs(z[i]) > 3) tail++;
+    }
+    ASSERT_NEAR(mu / n, 0.5, 0.01);
+    ASSERT_NEAR(mz / n, 0.0, 0.02);
+    ASSERT_NEAR(vz / n, 1.0, 0.02);
+    ASSERT_NEAR(static_cast<double>(tail) / n, 0.0027, 0.001);
+    ASSERT_TRUE(RandomStream(42).substream(1).stream() != RandomStream(42).substream(2).stream());
+}
+
+TEST(interp_rng_builtins) {
+    auto interp = createTestInterp();
+    interp.executeString("rng(7); a = rand(2, 3); b = randn([2 2]); rng(7); c = rand(2, 3);"
+                         "s = rng; x = randi([5 9], 1, 200); rng(s); y = randi([5 9], 1, 200);"
+                         "p = randperm(10); q = randperm(50, 5);"
+                         "w = randsample(3, 500, true, [0 1 0]); r = randsample([10 20 30 40], 4);");
+    auto env = interp.globalEnv();
+    ASSERT_TRUE(env->get("a")->matrix().data() == env->get("c")->matrix().data());
+    ASSERT_EQ(env->get("b")->matrix().rows(), 2u);
+    const Matrix& x = env->get("x")->matrix();
+    ASSERT_TRUE(x.data() == env->get("y")->matrix().data());
+    ASSERT_EQ(*std::min_element(x.data().begin(), x.data().end()), 5.0);
+    ASSERT_EQ(*std::max_element(x.data().begin(), x.data().end()), 9.0);
+    auto p = env->get("p")->matrix().data();
+    std::sort(p.begin(), p.end());
+    for (size_t i = 0; i < 10; i++) ASSERT_EQ(p[i], static_cast<double>(i + 1));
+    ASSERT_EQ(env->get("q")->matrix().cols(), 5u);
+    const Matrix& w = env->get("w")->matrix();
+    ASSERT_EQ(w.rows(), 500u);
+    ASSERT_TRUE(std::all_of(w.data().begin(), w.data().end(), [](double v) { return v == 2; }));
+    auto r = env->get("r")->matrix().data();
+    std::sort(r.begin(), r.end());
+    ASSERT_TRUE(r == std::vector<double>({10, 20, 30, 40}));
+
+    // A shuffled seed survives the trip through s = rng and rng(s)
+    for (int i = 0; i < 8; i++) {
+        interp.executeString("rng('shuffle'); s = rng; a = rand(1, 3); rng(s); b = rand(1, 3);");
+        ASSERT_TRUE(env->get("a")->matrix().data() == env->get("b")->matrix().data());
+    }
+
+    // parfor iterations draw from per-iteration streams: the same seed gives
+    // the same values whatever the worker count
+    auto run = [&](size_t threads) {
+        setParallelThreadCount(threads);
+        interp.executeString("rng(3); v = zeros(1, 16); parfor i = 1:16\n v(i) = rand;\nend");
+        setParallelThreadCount(0);
+        return env->get("v")->matrix().data();
+    };
+    auto v1 = run(1);
+    ASSERT_TRUE(v1 == run(4));
+    ASSERT_TRUE(v1[0] != v1[1]);
+}
+
+TEST(interp_save_load_roundtrip) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_save_test";
+    std::filesystem::create_directories(dir);
+    std::string file = (dir / "ws").string();
+    auto interp = createTestInterp();
+    interp.executeString("a = reshape(1:12, 3, 4); b = true; s = 'hello';"
+                         "c = {1, 'two', {3, [4 5]}}; st.x = 1; in.y = 'deep'; st.inner = in; f = @sin;"
+                         "save('" + file + "');");
+    ASSERT_TRUE(std::filesystem::exists(file + ".mat"));
+
+    auto other = createTestInterp();
+    other.executeString("load('" + file + "'); d = a(2, 3); v = f(0); w = st.inner.y;"
+                        "S = load('" + file + ".mat', 's');");
+    auto env = other.globalEnv();
+    auto orig = interp.globalEnv();
+    ASSERT_TRUE(std::equal(env->get("a")->matrix().begin(), env->get("a")->matrix().end(),
+                           orig->get("a")->matrix().begin(), orig->get("a")->matrix().end()));
+    ASSERT_EQ(env->get("a")->matrix().rows(), 3u);
+    ASSERT_TRUE(env->get("a")->matrix().isExternal());
+    ASSERT_TRUE(env->get("b")->isLogical());
+    ASSERT_TRUE(std::equal(env->get("b")->matrix().begin(), env->get("b")->matrix().end(),
+                           orig->get("b")->matrix().begin(), orig->get("b")->matrix().end()));
+    ASSERT_EQ(env->get("d")->scalarDouble(), orig->get("a")->matrix()(1, 2));
+    ASSERT_EQ(env->get("v")->scalarDouble(), 0.0);
+    ASSERT_EQ(env->get("w")->string(), std::string("deep"));
+    const CellArray& c = env->get("c")->cellArray();
+    ASSERT_EQ(c.data[1]->string(), std::string("two"));
+    ASSERT_EQ(c.data[2]->cellArray().data[1]->matrix()(1), 5.0);
+    auto S = env->get("S")->structVal();
+    ASSERT_EQ(S.fields.size(), 1u);
+    ASSERT_EQ(S.fields["s"]->string(), std::string("hello"));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(interp_save_append_and_lazy_load) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_append_test";
+    std::filesystem::create_directories(dir);
+    std::string file = (dir / "ws.mat").string();
+    auto interp = createTestInterp();
+    interp.executeString("x = 1; y = [1 2 3]; save('" + file + "', 'x', 'y');"
+                         "x = 10; z = 'new'; save('" + file + "', 'x', 'z', '-append');"
+                         "clear; load('" + file + "');");
+    auto env = interp.globalEnv();
+    // Loaded variables stay unread until used, but are listed
+    auto names = env->variableNames();
+    std::sort(names.begin(), names.end());
+    ASSERT_TRUE(names == std::vector<std::string>({"x", "y", "z"}));
+    ASSERT_EQ(env->get("x")->scalarDouble(), 10.0);
+    ASSERT_EQ(env->get("y")->matrix()(2), 3.0);
+    ASSERT_EQ(env->get("z")->string(), std::string("new"));
+
+    WorkspaceReader reader(file);
+    ASSERT_EQ(reader.entries().size(), 3u);
+    ASSERT_TRUE(reader.find("y") != nullptr && reader.find("y")->cols == 3);
+
+    // Errors: foreign file, unknown variable
+    {
+        std::ofstream junk(dir / "junk.mat");
+        junk << "not a workspace file at all, just some text padding it out";
+    }
+    interp.executeString("try\n load('" + (dir / "junk.mat").string() + "');\n msg = 'none';\n"
+                         "catch e\n msg = e.message;\nend");
+    ASSERT_TRUE(env->get("msg")->string().find("not a MatFree workspace") != std::string::npos);
+    interp.executeString("try\n load('" + file + "', 'nope');\n msg = 'none';\n"
+                         "catch e\n msg = e.message;\nend");
+    ASSERT_TRUE(env->get("msg")->string().find("not found") != std::string::npos);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(interp_memmapfile_double_view_and_write_through) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_memmap_test";
+    std::filesystem::create_directories(dir);
+    std::string file = (dir / "data.bin").string();
+    {
+        std::vector<double> values(1000);
+        for (size_t i = 0; i < values.size(); i++) values[i] = static_cast<double>(i + 1);
+        std::ofstream out(file, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+    }
+    auto interp = createTestInterp();
+    interp.executeString("m = memmapfile('" + file + "', 'Format', 'double', 'Access', 'sequential');"
+                         "d = m.Data; s = sum(d); n = numel(d); e = d(10) * 2;"
+                         "w = memmapfile('" + file + "', 'Format', {'double', [10 100]}, 'Writable', true);"
+                         "g = w.Data; sz = size(g); g(4) = 77; z = g; z(5) = 0; w.Data(3) = -5;"
+                         "r = memmapfile('" + file + "', 'Format', 'double', 'Offset', 16, 'Repeat', 4);"
+                         "q = r.Data; q(1) = 99;");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("s")->scalarDouble(), 500500.0);
+    ASSERT_EQ(env->get("n")->scalarDouble(), 1000.0);
+    ASSERT_EQ(env->get("e")->scalarDouble(), 20.0);
+    ASSERT_TRUE(env->get("d")->matrix().isExternal());
+    ASSERT_EQ(env->get("sz")->matrix()(0), 10.0);
+    ASSERT_EQ(env->get("sz")->matrix()(1), 100.0);
+    // Offset/Repeat select elements 3..6, already showing the write through
+    // w.Data; the read-only view copies on write
+    ASSERT_EQ(env->get("q")->matrix()(0), 99.0);
+    ASSERT_EQ(env->get("q")->matrix()(3), 6.0);
+    ASSERT_EQ(env->get("r")->structVal().fields.at("Data")->matrix()(0), -5.0);
+
+    ASSERT_EQ(env->get("g")->matrix()(3), 77.0);
+    ASSERT_TRUE(!env->get("g")->matrix().isExternal());
+
+    // Only w.Data(i) = v wrote through to the file; copies of the data did not
+    std::vector<double> back(1000);
+    {
+        std::ifstream in(file, std::ios::binary);
+        in.read(reinterpret_cast<char*>(back.data()), back.size() * sizeof(double));
+    }
+    ASSERT_EQ(back[2], -5.0);
+    ASSERT_EQ(back[3], 4.0);
+    ASSERT_EQ(back[4], 5.0);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(interp_memmapfile_converted_classes) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_memmap_conv_test";
+    std::filesystem::create_directories(dir);
+    std::string file = (dir / "data.bin").string();
+    {
+        std::ofstream out(file, std::ios::binary);
+        out.write("HDR", 3);
+        for (uint16_t v : {uint16_t(1), uint16_t(65535), uint16_t(300), uint16_t(7)})
+            out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+    auto interp = createTestInterp();
+    interp.executeString("m = memmapfile('" + file + "', 'Format', 'uint16', 'Offset', 3);"
+                         "d = m.Data; n = numel(d);"
+                         "b = memmapfile('" + file + "'); bd = b.Data; h = bd(1:3)';"
+                         "f = memmapfile('" + file + "', 'Format', {'uint16', [2 2], 'x'}, 'Offset', 3);"
+                         "fd = f.Data; x = fd.x;"
+                         "try\n memmapfile('" + file + "', 'Format', 'uint16', 'Writable', true);\n msg = 'none';\n"
+                         "catch err\n msg = err.message;\nend");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("n")->scalarDouble(), 4.0);
+    const Matrix& d = env->get("d")->matrix();
+    ASSERT_EQ(d(0), 1.0);
+    ASSERT_EQ(d(1), 65535.0);
+    ASSERT_EQ(d(3), 7.0);
+    ASSERT_EQ(env->get("h")->matrix()(0), static_cast<double>('H'));
+    ASSERT_EQ(env->get("x")->matrix().rows(), 2u);
+    ASSERT_EQ(env->get("x")->matrix()(2), 300.0);
+    ASSERT_TRUE(env->get("msg")->string().find("Writable") != std::string::npos);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(interp_read_delimited_text) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_csv_test";
+    std::filesystem::create_directories(dir);
+    std::string file = (dir / "data.csv").string();
+    {
+        std::ofstream out(file, std::ios::binary);
+        out << "id,name,score,\"weight, kg\"\r\n"
+               "1,alpha,3.5,70\r\n"
+               "\r\n"
+               "2,\"beta, \"\"b\"\"\",NA,+81.5\r\n"
+               "3,gamma,,1e3";
+    }
+    auto interp = createTestInterp();
+    interp.executeString("M = readmatrix('" + file + "', 'TreatAsMissing', 'NA');"
+                         "E = readmatrix('" + file + "', 'Columns', [1 3], 'EmptyValue', -1);"
+                         "T = readtable('" + file + "'); names = T.name; w = T.weight__kg;"
+                         "C = readcell('" + file + "'); c1 = C{1,4}; c2 = C{3,2}; c3 = C{2,1};"
+                         "X = csvread('" + file + "', 1, 2);");
+    auto env = interp.globalEnv();
+    const Matrix& m = env->get("M")->matrix();
+    ASSERT_EQ(m.rows(), 3u);
+    ASSERT_EQ(m.cols(), 4u);
+    ASSERT_EQ(m(0, 2), 3.5);
+    ASSERT_TRUE(std::isnan(m(0, 1)));   // text
+    ASSERT_TRUE(std::isnan(m(1, 2)));   // NA
+    ASSERT_EQ(m(1, 3), 81.5);
+    ASSERT_EQ(m(2, 3), 1000.0);
+    const Matrix& e = env->get("E")->matrix();
+    ASSERT_EQ(e.cols(), 2u);
+    ASSERT_EQ(e(2, 1), -1.0);           // empty field
+    ASSERT_TRUE(std::isnan(e(1, 1)));   // NA is text here
+    auto names = env->get("names");
+    ASSERT_TRUE(names->isCellArray());
+    ASSERT_EQ(names->cellArray().data[1]->string(), std::string("beta, \"b\""));
+    ASSERT_EQ(env->get("w")->matrix()(0), 70.0);
+    ASSERT_EQ(env->get("c1")->string(), std::string("weight, kg"));
+    ASSERT_EQ(env->get("c2")->string(), std::string("beta, \"b\""));
+    ASSERT_EQ(env->get("c3")->scalarDouble(), 1.0);
+    const Matrix& x = env->get("X")->matrix();
+    ASSERT_EQ(x.cols(), 2u);
+    ASSERT_EQ(x(2, 0), 0.0);            // csvread reads empty fields as 0
+    ASSERT_EQ(x(2, 1), 1000.0);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(read_delimited_chunks_match_across_thread_counts) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_csv_chunk_test";
+    std::filesystem::create_directories(dir);
+    std::string file = (dir / "big.tsv").string();
+    const size_t rows = 150000;
+    {
+        std::ofstream out(file, std::ios::binary);
+        out.precision(17);
+        out << "a\tb\tc\n";
+        for (size_t i = 0; i < rows; i++) out << i << "\t" << i * 0.25 << "\t" << (i % 7 == 0 ? "" : "-1") << "\n";
+    }
+    DelimitedOptions opts;
+    setParallelThreadCount(1);
+    DelimitedData serial = readDelimited(file, opts, true);
+    setParallelThreadCount(4);
+    DelimitedData parallel = readDelimited(file, opts, true);
+    setParallelThreadCount(0);
+    ASSERT_EQ(parallel.numbers.rows(), rows);
+    ASSERT_TRUE(parallel.names == std::vector<std::string>({"a", "b", "c"}));
+    ASSERT_TRUE(std::equal(serial.numbers.begin(), serial.numbers.end(), parallel.numbers.begin(),
+                           [](double x, double y) { return x == y || (std::isnan(x) && std::isnan(y)); }));
+    ASSERT_EQ(parallel.numbers(rows - 1, 0), static_cast<double>(rows - 1));
+    ASSERT_EQ(parallel.numbers(rows - 1, 1), (rows - 1) * 0.25);
+    ASSERT_TRUE(std::isnan(parallel.numbers(7, 2)));
+    ASSERT_TRUE(!parallel.isText[2]);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(interp_datastore_blocks_and_tall_reductions) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_datastore_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    for (int f = 0; f < 2; f++) {
+        std::ofstream out(dir / ("part" + std::to_string(f) + ".csv"));
+        out << "x,y\n";
+        for (int i = 1; i <= 5; i++) out << (f * 5 + i) << "," << (i % 2 ? -i : i) << "\n";
+        out << "\n";
+    }
+    auto interp = createTestInterp();
+    interp.executeString("ds = datastore('" + dir.string() + "', 'ReadSize', 2);"
+                         "n = 0; blocks = 0; total = 0;"
+                         "while hasdata(ds)\n b = read(ds); n = n + size(b, 1); blocks = blocks + 1; total = total + sum(b(:, 1));\nend\n"
+                         "reset(ds); first = read(ds);"
+                         "t = tall(ds);"
+                         "[s, m, lo, hi, h, all] = gather(sum(t), mean(t), min(t), max(t), histcounts(t, [-10 0 10]), t);"
+                         "names = ds.VariableNames;");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("n")->scalarDouble(), 10.0);
+    ASSERT_EQ(env->get("blocks")->scalarDouble(), 6.0); // 3 per file: blocks never span files
+    ASSERT_EQ(env->get("total")->scalarDouble(), 55.0);
+    ASSERT_EQ(env->get("first")->matrix()(0, 0), 1.0);
+    const Matrix& sm = env->get("s")->matrix();
+    ASSERT_EQ(sm(0), 55.0);
+    ASSERT_EQ(sm(1), -6.0);
+    ASSERT_EQ(env->get("m")->matrix()(0), 5.5);
+    ASSERT_EQ(env->get("lo")->matrix()(1), -5.0);
+    ASSERT_EQ(env->get("hi")->matrix()(0), 10.0);
+    const Matrix& h = env->get("h")->matrix();
+    ASSERT_EQ(h(0), 6.0);   // -1 -3 -5 twice
+    ASSERT_EQ(h(1), 14.0);  // 1..10, 2 and 4 twice
+    ASSERT_EQ(env->get("all")->matrix().rows(), 10u);
+    ASSERT_EQ(env->get("names")->cellArray().data[1]->string(), std::string("y"));
+
+    // The datastore stays open through save/load and is shared with parfor
+    // workers; clear all closes it
+    std::string mat = (dir / "ds.mat").string();
+    interp.executeString("reset(ds); save('" + mat + "', 'ds'); clear('ds'); load('" + mat + "');"
+                         "again = read(ds); v = zeros(1, 4);"
+                         "parfor k = 1:4\n s = gather(sum(tall(ds))); v(k) = s(1) + hasdata(ds);\nend");
+    ASSERT_EQ(env->get("again")->matrix()(0, 0), 1.0);
+    for (size_t k = 0; k < 4; k++) ASSERT_EQ(env->get("v")->matrix()(k), 56.0);
+    interp.executeString("d = datastore('" + dir.string() + "'); clear('all');");
+    ASSERT_TRUE(interp.session().datastores.empty());
+    std::filesystem::remove_all(dir);
+}
+
+TEST(datastore_binary_prefetch_matches_whole_file) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_datastore_bin_test";
+    std::filesystem::create_directories(dir);
+    std::string file = (dir / "samples.bin").string();
+    const size_t n = 100003;
+    {
+        std::ofstream out(file, std::ios::binary);
+        for (size_t i = 0; i < n; i++) {
+            int16_t v = static_cast<int16_t>(static_cast<int>(i % 2001) - 1000);
+            out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+        }
+    }
+    DatastoreOptions opts;
+    opts.kind = DatastoreKind::BINARY;
+    opts.format = NumericClass::INT16;
+    opts.readSize = 4096;
+    Datastore ds({file}, opts);
+    size_t seen = 0;
+    bool inOrder = true;
+    while (ds.hasData()) {
+        Matrix b = ds.read();
+        for (size_t i = 0; i < b.numel(); i++, seen++)
+            inOrder = inOrder && b(i) == static_cast<double>(static_cast<int>(seen % 2001) - 1000);
+    }
+    ASSERT_EQ(seen, n);
+    ASSERT_TRUE(inOrder);
+
+    auto results = evaluateTall(ds, {{TallReduction::MIN, {}, 0}, {TallReduction::HISTCOUNTS, {}, 4}});
+    ASSERT_EQ(results[0](0), -1000.0);
+    double counted = 0;
+    for (double c : results[1]) counted += c;
+    ASSERT_EQ(counted, static_cast<double>(n));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(interp_sprintf_cycles_format_over_arrays) {
+    auto interp = createTestInterp();
+    interp.executeString("a = sprintf('%d, ', [1 2 3]);"
+                         "b = sprintf('%d %d\\n', [1 2 3]);"
+                         "c = sprintf('%s=%g;', 'x', 0.5, 'y', 1e-7);"
+                         "d = sprintf('%d|%5.2f|%-4d|%+d|%05d|%x|%E', 1.5, pi, 7, 3, -42, 255, 1234.5);"
+                         "e = sprintf('%f %d %s', Inf, -Inf, NaN);"
+                         "f = sprintf('%s %s', 72, 0.1);"
+                         "g = sprintf('100%% done\\t%c', 'ok');"
+                         "h = sprintf('no data: %d.');");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("a")->string(), std::string("1, 2, 3, "));
+    ASSERT_EQ(env->get("b")->string(), std::string("1 2\n3 "));
+    ASSERT_EQ(env->get("c")->string(), std::string("x=0.5;y=1e-07;"));
+    ASSERT_EQ(env->get("d")->string(), std::string("1.500000e+00| 3.14|7   |+3|-0042|ff|1.234500E+03"));
+    ASSERT_EQ(env->get("e")->string(), std::string("Inf -Inf NaN"));
+    ASSERT_EQ(env->get("f")->string(), std::string("H 0.1"));
+    ASSERT_EQ(env->get("g")->string(), std::string("100% done\tok"));
+    ASSERT_EQ(env->get("h")->string(), std::string("no data: ."));
+}
+
+TEST(interp_fprintf_and_disp_write_whole_arrays) {
+    auto interp = createTestInterp();
+    std::string out = captureOutput(interp, "fprintf('%d:%.1f\\n', [1 2; 3 4]); fprintf(1, 'x%s\\n', 'y');"
+                                            "disp([1 2; 30 4]); disp([0.5 1]);");
+    ASSERT_EQ(out, std::string("1:2.0\n3:4.0\nxy\n"
+                               "         1      2\n        30      4\n"
+                               "       0.5000    1.0000\n"));
+    // A long array is formatted in one piece
+    std::string big = captureOutput(interp, "fprintf('%d\\n', 1:100000);");
+    ASSERT_EQ(std::count(big.begin(), big.end(), '\n'), 100000);
+    ASSERT_TRUE(big.compare(big.size() - 7, 7, "100000\n") == 0);
+}
+
+TEST(interp_fwrite_fread_typed_blocks_and_byte_order) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_fileio_test";
+    std::filesystem::create_directories(dir);
+    std::string file = (dir / "typed.bin").string();
+    auto interp = createTestInterp();
+    interp.executeString("f = fopen('" + file + "', 'w');"
+                         "n1 = fwrite(f, [1, 2, 70000, -3], 'uint16');"   // saturates to 65535 and 0
+                         "n2 = fwrite(f, [-2.5, 300], 'int16', 0, 'ieee-be');"
+                         "n3 = fwrite(f, 0:999, 'double');"
+                         "fclose(f);"
+                         "f = fopen('" + file + "');"
+                         "[a, c] = fread(f, 4, 'uint16');"
+                         "b = fread(f, 2, 'int16=>double', 0, 'b');"
+                         "p = ftell(f);"
+                         "m = fread(f, [2 Inf], '*double');"
+                         "e = feof(f);"
+                         "fseek(f, -16, 'eof'); t = fread(f, Inf, 'double');"
+                         "frewind(f); k = fread(f, [3 2], 'uint8');"
+                         "fclose(f);"
+                         "[bad, msg] = fopen('" + (dir / "missing" / "x.bin").string() + "');");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("n1")->scalarDouble(), 4.0);
+    ASSERT_EQ(env->get("n3")->scalarDouble(), 1000.0);
+    const Matrix& a = env->get("a")->matrix();
+    ASSERT_EQ(a.rows(), 4u);
+    ASSERT_EQ(a(2), 65535.0);
+    ASSERT_EQ(a(3), 0.0);
+    ASSERT_EQ(env->get("c")->scalarDouble(), 4.0);
+    // Rounded half away from zero, stored big-endian
+    ASSERT_EQ(env->get("b")->matrix()(0), -3.0);
+    ASSERT_EQ(env->get("b")->matrix()(1), 300.0);
+    ASSERT_EQ(env->get("p")->scalarDouble(), 12.0);
+    const Matrix& m = env->get("m")->matrix();
+    ASSERT_EQ(m.rows(), 2u);
+    ASSERT_EQ(m.cols(), 500u);
+    ASSERT_EQ(m(999), 999.0);
+    ASSERT_TRUE(env->get("e")->toBool());
+    ASSERT_EQ(env->get("t")->matrix().numel(), 2u);
+    ASSERT_EQ(env->get("t")->matrix()(1), 999.0);
+    // Little-endian uint16 1 and 2, then the low bytes of 65535
+    const Matrix& k = env->get("k")->matrix();
+    ASSERT_EQ(k.rows(), 3u);
+    ASSERT_EQ(k(0), 1.0);
+    ASSERT_EQ(k(2), 2.0);
+    ASSERT_EQ(k(4), 255.0);
+    ASSERT_EQ(env->get("bad")->scalarDouble(), -1.0);
+    ASSERT_TRUE(!env->get("msg")->string().empty());
+}
+
+TEST(interp_fprintf_to_file_and_read_lines) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_fileio_test";
+    std::filesystem::create_directories(dir);
+    std::string file = (dir / "lines.txt").string();
+    auto interp = createTestInterp();
+    interp.executeString("f = fopen('" + file + "', 'wt');"
+                         "fprintf(f, 'row %d\\n', 1:3);"
+                         "fwrite(f, 'tail');"
+                         "fclose(f);"
+                         "f = fopen('" + file + "', 'r');"
+                         "first = fgets(f); n = 1;"
+                         "while true\n line = fgetl(f);\n if ~ischar(line), break; end\n n = n + 1; last = line;\nend\n"
+                         "done = feof(f);"
+                         "frewind(f); txt = fread(f, [1 Inf], 'uint8=>char');"
+                         "fclose('all');"
+                         "try fread(f); msg = ''; catch err; msg = err.message; end");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("first")->string(), std::string("row 1\n"));
+    ASSERT_EQ(env->get("n")->scalarDouble(), 4.0);
+    ASSERT_EQ(env->get("last")->string(), std::string("tail"));
+    ASSERT_TRUE(env->get("done")->toBool());
+    ASSERT_EQ(env->get("txt")->string(), std::string("row 1\nrow 2\nrow 3\ntail"));
+    ASSERT_EQ(env->get("msg")->string(), std::string("fread: invalid file identifier"));
+}
+
+#ifdef MATFREE_HAS_CAPI
+TEST(capi_eval_call_and_values) {
+    ASSERT_EQ(mf_api_version(), MATFREE_CAPI_VERSION);
+    mf_engine* e = mf_engine_create();
+    ASSERT_TRUE(e != nullptr);
+    ASSERT_EQ(mf_eval(e, "a = [1 2; 3 4]; disp(7)"), MF_OK);
+    ASSERT_EQ(std::string(mf_output(e)), std::string("   7\n"));
+
+    mf_value* a = mf_get(e, "a");
+    size_t r, c;
+    mf_value_size(a, &r, &c);
+    ASSERT_EQ(r, 2u);
+    ASSERT_EQ(c, 2u);
+    ASSERT_EQ(mf_value_kind(a), MF_KIND_MATRIX);
+    ASSERT_EQ(mf_value_data(a)[1], 2.0);
+
+    // Typed input, two outputs, typed output
+    const int16_t raw[] = {5, -9, 300};
+    mf_value* x = mf_value_matrix(1, 3, MF_INT16, raw);
+    mf_value* out[3];
+    ASSERT_EQ(mf_call(e, "sort", &x, 1, out, 3), MF_OK);
+    ASSERT_EQ(mf_value_data(out[0])[0], -9.0);
+    ASSERT_EQ(mf_value_data(out[1])[0], 2.0);
+    ASSERT_TRUE(out[2] == nullptr);
+    uint8_t bytes[3];
+    ASSERT_EQ(mf_value_copy(x, MF_UINT8, bytes), MF_OK);
+    ASSERT_EQ(bytes[1], 0);
+    ASSERT_EQ(bytes[2], 255);
+
+    // Strings and function handle variables
+    mf_value* s = mf_value_string("abc");
+    ASSERT_EQ(mf_set(e, "s", s), MF_OK);
+    ASSERT_EQ(mf_eval(e, "f = @(v) v * 2; n = numel(s);"), MF_OK);
+    mf_value* two[1];
+    ASSERT_EQ(mf_call(e, "f", &x, 1, two, 1), MF_OK);
+    ASSERT_EQ(mf_value_data(two[0])[2], 600.0);
+    mf_value* n = mf_get(e, "n");
+    ASSERT_EQ(mf_value_data(n)[0], 3.0);
+    ASSERT_EQ(std::string(mf_value_text(s)), std::string("abc"));
+
+    // Errors stay on the engine and do not cross the C boundary
+    ASSERT_EQ(mf_eval(e, "error('boom')"), MF_ERROR);
+    ASSERT_EQ(std::string(mf_last_error(e)), std::string("boom"));
+    ASSERT_TRUE(mf_get(e, "nope") == nullptr);
+    ASSERT_EQ(mf_call(e, "no_such_function", &x, 1, out, 1), MF_ERROR);
+    ASSERT_EQ(mf_eval(e, "y = 1;"), MF_OK);
+    ASSERT_EQ(std::string(mf_last_error(e)), std::string(""));
+
+    for (mf_value* v : {a, x, out[0], out[1], s, two[0], n}) mf_value_free(v);
+    mf_engine_destroy(e);
+}
+
+TEST(capi_borrowed_buffers_are_not_copied_or_modified) {
+    static int released = 0;
+    std::vector<double> buf = {1, 2, 3, 4, 5, 6};
+    mf_engine* e = mf_engine_create();
+    mf_value* b = mf_value_borrow(2, 3, buf.data(), [](void* ctx) { *static_cast<int*>(ctx) += 1; }, &released);
+    ASSERT_TRUE(mf_value_data(b) == buf.data());
+    ASSERT_EQ(mf_set(e, "b", b), MF_OK);
+    mf_value_free(b);
+    ASSERT_EQ(released, 0); // the workspace still refers to it
+    ASSERT_EQ(mf_eval(e, "t = sum(b(:)); b(1) = 100; u = b(1);"), MF_OK);
+    mf_value* t = mf_get(e, "t");
+    mf_value* u = mf_get(e, "u");
+    ASSERT_EQ(mf_value_data(t)[0], 21.0);
+    ASSERT_EQ(mf_value_data(u)[0], 100.0);
+    ASSERT_EQ(buf[0], 1.0); // MatFree wrote to its own copy
+    ASSERT_EQ(released, 1);
+    mf_value_free(t);
+    mf_value_free(u);
+    mf_engine_destroy(e);
+}
+#endif
+
+#ifdef MATFREE_TEST_PLUGIN
+TEST(interp_native_plugin_lazy_load_and_call) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_plugin_test";
+    std::filesystem::create_directories(dir);
+    auto plugin = dir / "mfx_demo.mfx";
+    std::filesystem::copy_file(MATFREE_TEST_PLUGIN, plugin, std::filesystem::copy_options::overwrite_existing);
+    auto interp = createTestInterp();
+    interp.addPath(dir.string());
+    interp.executeString("[y, n] = mfx_demo([1 2; 3 4], 3);"
+                         "h = @mfx_demo; z = h(5, 2);"
+                         "c = mfx_demo_loads();"
+                         "try mfx_demo('x', 1); msg = ''; catch err; msg = err.message; end");
+    auto env = interp.globalEnv();
+    const Matrix& y = env->get("y")->matrix();
+    ASSERT_EQ(y.rows(), 2u);
+    ASSERT_EQ(y(1, 0), 9.0);
+    ASSERT_EQ(env->get("n")->scalarDouble(), 4.0);
+    ASSERT_EQ(env->get("z")->scalarDouble(), 10.0);
+    ASSERT_EQ(env->get("c")->scalarDouble(), 2.0);
+    ASSERT_EQ(env->get("msg")->string(), std::string("mfx_demo: expected a matrix and a scalar"));
+}
+
+TEST(interp_native_plugin_reloads_after_clear_mex) {
+    auto dir = std::filesystem::temp_directory_path() / "matfree_plugin_reload_test";
+    std::filesystem::create_directories(dir);
+    auto plugin = dir / "mfx_demo.mfx";
+    std::filesystem::remove(plugin);
+    std::filesystem::copy_file(MATFREE_TEST_PLUGIN, plugin);
+    auto interp = createTestInterp();
+    interp.addPath(dir.string());
+    interp.executeString("mfx_demo(1, 1); mfx_demo(1, 1); before = mfx_demo_loads();");
+    // Unchanged: clear('mex') binds the same loaded copy again
+    interp.executeString("clear('mex'); mfx_demo(1, 1); same = mfx_demo_loads();");
+
+    // A rebuilt plugin (new file, newer time) is loaded afresh
+    auto stamp = std::filesystem::last_write_time(plugin);
+    std::filesystem::remove(plugin);
+    std::filesystem::copy_file(MATFREE_TEST_PLUGIN, plugin);
+    std::filesystem::last_write_time(plugin, stamp + std::chrono::seconds(5));
+    interp.executeString("still = mfx_demo_loads(); clear('mex'); mfx_demo(1, 1); after = mfx_demo_loads();");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("before")->scalarDouble(), 2.0);
+    ASSERT_EQ(env->get("same")->scalarDouble(), 3.0);
+    ASSERT_EQ(env->get("still")->scalarDouble(), 3.0);
+    ASSERT_EQ(env->get("after")->scalarDouble(), 1.0);
+}
+#endif
+
+#ifdef MATFREE_TEST_FFI_LIB
+TEST(interp_calllib_converts_arguments_and_returns_outputs) {
+    auto header = std::filesystem::temp_directory_path() / "matfree_ffi_demo.h";
+    {
+        std::ofstream out(header);
+        out << "#pragma once\n#include <stddef.h>\n/* demo */\n#ifdef __cplusplus\nextern \"C\" {\n#endif\n"
+               "double ffi_dot(const double* x, const double* y, int n);\n"
+               "void ffi_scale(double *x, int n, double k);\n"
+               "unsigned int ffi_sum_u8(const unsigned char* x, size_t n);\n"
+               "double ffi_mix(int a, float b, double c, long long d, short e, unsigned int f);\n"
+               "unsigned int ffi_wrap(int x); // unsigned result\n"
+               "void ffi_fill_i16(short* out, int n);\n"
+               "const char* ffi_name(void);\n"
+               "void ffi_callback(void (*cb)(int));\n"
+               "#ifdef __cplusplus\n}\n#endif\n";
+    }
+    auto interp = createTestInterp();
+    interp.executeString("loadlibrary('" + std::string(MATFREE_TEST_FFI_LIB) + "', '" + header.string() +
+                         "', 'alias', 'demo');"
+                         "d = calllib('demo', 'ffi_dot', [1 2 3], [4 5 6], 3);"
+                         "x = [1 2; 3 4]; y = calllib('demo', 'ffi_scale', x, 4, 0.5);"
+                         "s = calllib('demo', 'ffi_sum_u8', [250, 10, 300], 3);"
+                         "m = calllib('demo', 'ffi_mix', 1, 0.5, 0.25, 2^40, -2, 3);"
+                         "w = calllib('demo', 'ffi_wrap', -1);"
+                         "f = calllib('demo', 'ffi_fill_i16', zeros(1, 3), 3);"
+                         "nm = calllib('demo', 'ffi_name');"
+                         "fns = libfunctions('demo'); loaded = libisloaded('demo');"
+                         "try calllib('demo', 'ffi_callback', 1); msg = ''; catch err; msg = err.message; end;"
+                         "unloadlibrary('demo'); gone = libisloaded('demo');");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("d")->scalarDouble(), 32.0);
+    const Matrix& y = env->get("y")->matrix();
+    ASSERT_EQ(y(1, 1), 2.0);
+    ASSERT_EQ(env->get("x")->matrix()(1, 1), 4.0); // the argument is untouched
+    ASSERT_EQ(env->get("s")->scalarDouble(), 515.0); // 300 saturates to 255
+    ASSERT_EQ(env->get("m")->scalarDouble(), 1 + 0.5 + 0.25 + 1099511627776.0 - 2 + 3);
+    ASSERT_EQ(env->get("w")->scalarDouble(), 4294967295.0);
+    const Matrix& f = env->get("f")->matrix();
+    ASSERT_EQ(f(0, 2), -3000.0);
+    ASSERT_EQ(env->get("nm")->string(), std::string("ffi_demo"));
+    ASSERT_EQ(env->get("fns")->cellArray().data.size(), 7u);
+    ASSERT_TRUE(env->get("loaded")->isLogical() && env->get("loaded")->scalarDouble() == 1.0);
+    ASSERT_TRUE(env->get("msg")->string().find("function pointer") != std::string::npos);
+    ASSERT_EQ(env->get("gone")->scalarDouble(), 0.0);
+}
+
+TEST(interp_calllib_strings_and_prototype_text) {
+    auto interp = createTestInterp();
+    interp.executeString("loadlibrary('" + std::string(MATFREE_TEST_FFI_LIB) +
+                         "', 'size_t ffi_strlen(const char* s); void ffi_upper(char *s); int ffi_missing(int);');"
+                         "n = calllib('ffi_demo', 'ffi_strlen', 'hello');"
+                         "s = 'mixed Case'; u = calllib('ffi_demo', 'ffi_upper', s);"
+                         "fns = libfunctions('ffi_demo');"
+                         "try calllib('ffi_demo', 'ffi_strlen'); msg = ''; catch err; msg = err.message; end");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("n")->scalarDouble(), 5.0);
+    ASSERT_EQ(env->get("u")->string(), std::string("MIXED CASE"));
+    ASSERT_EQ(env->get("s")->string(), std::string("mixed Case"));
+    ASSERT_EQ(env->get("fns")->cellArray().data.size(), 2u); // ffi_missing is not exported
+    ASSERT_EQ(env->get("msg")->string(), std::string("calllib: 'ffi_strlen' needs 1 argument(s), got 0"));
+}
+#endif
+
+TEST(interp_profile_counts_functions_and_lines) {
+    auto interp = createTestInterp();
+    interp.executeString("function y = sq(x)\n"
+                         "y = x^2;\n"
+                         "end\n"
+                         "profile('on');\n"
+                         "s = 0;\n"
+                         "for k = 1:5\n"
+                         "    s = s + sq(k);\n"
+                         "end\n"
+                         "profile('off');\n"
+                         "s = sq(1);\n" // not recorded
+                         "p = profile('info');",
+                         "prof.m");
+    auto table = interp.globalEnv()->get("p")->structVal().fields.at("FunctionTable")->cellArray();
+    ASSERT_EQ(table.data.size(), 2u);
+    const FunctionStats* sq = nullptr;
+    const FunctionStats* script = nullptr;
+    for (auto* f : interp.profiler().functions()) (f->name == "sq" ? sq : script) = f;
+    ASSERT_TRUE(sq && script);
+    ASSERT_EQ(script->name, std::string("prof.m"));
+    ASSERT_EQ(sq->calls, 5u);
+    ASSERT_EQ(sq->lines.at(2).calls, 5u);
+    ASSERT_EQ(script->lines.at(7).calls, 5u); // s = s + sq(k)
+    ASSERT_EQ(script->lines.at(6).calls, 1u); // the for loop
+    ASSERT_EQ(script->lines.count(10), 0u);
+    // Line times include calls but not nested statements
+    ASSERT_TRUE(script->lines.at(7).time >= sq->totalTime);
+    ASSERT_TRUE(script->lines.at(6).time + script->lines.at(7).time <= script->totalTime + 1e-9);
+    ASSERT_NEAR(script->selfTime(), script->totalTime - sq->totalTime, 1e-9);
+    auto entry = table.data[0]->structVal().fields;
+    ASSERT_EQ(entry.at("ExecutedLines")->matrix().cols(), 3u);
+}
+
+TEST(interp_profile_reports_and_toc_output) {
+    auto interp = createTestInterp();
+    std::string out = captureOutput(interp,
+                                    "function r = inner(n)\nr = sum(1:n);\nend\n"
+                                    "profile('on'); inner(10); inner(20); profile('viewer');"
+                                    "j = profile('json'); st = profile('status');"
+                                    "tic; e = toc; t = tic; e2 = toc(t);");
+    ASSERT_TRUE(out.find("Function") != std::string::npos);
+    ASSERT_TRUE(out.find("inner") != std::string::npos);
+    ASSERT_TRUE(out.find("Elapsed time") == std::string::npos); // toc assigned: not printed
+    auto env = interp.globalEnv();
+    std::string json = env->get("j")->string();
+    ASSERT_TRUE(json.find("{\"name\": \"inner\", \"calls\": 2,") != std::string::npos);
+    ASSERT_TRUE(json.find("{\"line\": 2, \"calls\": 2, \"time\": ") != std::string::npos);
+    ASSERT_EQ(env->get("st")->string(), std::string("off"));
+    ASSERT_TRUE(env->get("e2")->scalarDouble() >= 0 && env->get("e2")->scalarDouble() < 60);
+    out = captureOutput(interp, "toc");
+    ASSERT_TRUE(out.find("Elapsed time is") == 0);
+}
+
+#ifndef _WIN32
+TEST(interp_sampling_profiler_folds_stacks_by_line) {
+    auto interp = createTestInterp();
+    interp.executeString("function s = work(n)\n"
+                         "s = 0;\n"
+                         "for i = 1:n\n"
+                         "    s = s + sum(sort(rand(1, 20000)));\n"
+                         "end\n"
+                         "end\n"
+                         "profile('sample', 2000);\n"
+                         "t = tic; total = 0;\n"
+                         "while toc(t) < 0.3\n"
+                         "    total = total + work(5);\n"
+                         "end\n"
+                         "profile('off');\n"
+                         "folded = profile('flamegraph');",
+                         "samp.m");
+    std::string folded = interp.globalEnv()->get("folded")->string();
+    // Time in sort/rand shows under the line of work() that called them
+    ASSERT_TRUE(folded.find("samp.m:10;work:4 ") != std::string::npos);
+    size_t samples = 0;
+    std::istringstream lines(folded);
+    for (std::string line; std::getline(lines, line);) samples += std::stoul(line.substr(line.rfind(' ') + 1));
+    ASSERT_EQ(samples, interp.sampler().samples());
+    ASSERT_TRUE(samples > 10);
+    ASSERT_EQ(interp.sampler().dropped(), 0u);
+}
+
+TEST(interp_sampling_profiler_chrome_trace_and_single_sampler) {
+    auto interp = createTestInterp();
+    interp.executeString("profile('sample');"
+                         "t = tic; x = 0;"
+                         "while toc(t) < 0.1, x = x + numel(unique(rand(1, 5000))); end;"
+                         "st = profile('status'); profile('off');"
+                         "trace = profile('trace');");
+    auto env = interp.globalEnv();
+    ASSERT_EQ(env->get("st")->string(), std::string("on"));
+    std::string trace = env->get("trace")->string();
+    ASSERT_TRUE(trace.find("\"traceEvents\": [") != std::string::npos);
+    size_t begins = 0, ends = 0;
+    for (size_t p = 0; (p = trace.find("\"ph\": \"", p)) != std::string::npos; p += 7) {
+        begins += trace[p + 7] == 'B';
+        ends += trace[p + 7] == 'E';
+    }
+    ASSERT_TRUE(begins > 0);
+    ASSERT_EQ(begins, ends);
+    ASSERT_TRUE(trace.find("\"name\": \"<input>:1\"") != std::string::npos);
+
+    // The timer signal is per process: one sampler at a time
+    auto other = createTestInterp();
+    interp.executeString("profile('sample', 100);");
+    other.executeString("try profile('sample'); msg = ''; catch err; msg = err.message; end");
+    interp.executeString("profile('off');");
+    ASSERT_EQ(other.globalEnv()->get("msg")->string(), std::string("profile: another interpreter is already sampling"));
+}
+#endif
+
+TEST(interp_var_std_omitnan_with_and_without_weight) {
+    auto interp = createTestInterp();
+    interp.executeString("a = var([1 2 NaN 4], 0, 2, 'omitnan');"
+                         "b = std([1 2 NaN 4], 0, 'omitnan');"
+                         "c = var([1 2 NaN 4], 'omitnan');"
+                         "d = var([1 2 NaN 4]);"
+                         "e = std([1 NaN; 3 5; 5 7], 1, 'omitnan');"
+                         "f = var([1 2; NaN 4; 3 NaN], 0, 2, 'omitnan');");
+    auto env = interp.globalEnv();
+    ASSERT_NEAR(env->get("a")->scalarDouble(), 7.0 / 3.0, 1e-12);
+    ASSERT_NEAR(env->get("b")->scalarDouble(), std::sqrt(7.0 / 3.0), 1e-12);
+    ASSERT_NEAR(env->get("c")->scalarDouble(), 7.0 / 3.0, 1e-12);
+    ASSERT_TRUE(std::isnan(env->get("d")->scalarDouble()));
+    const Matrix& e = env->get("e")->matrix();
+    ASSERT_NEAR(e(0, 0), std::sqrt(8.0 / 3.0), 1e-12);
+    ASSERT_NEAR(e(0, 1), 1.0, 1e-12);
+    const Matrix& f = env->get("f")->matrix();
+    ASSERT_NEAR(f(0, 0), 0.5, 1e-12);
+    ASSERT_EQ(f(1, 0), 0.0);
+    ASSERT_EQ(f(2, 0), 0.0);
+}
+
+TEST(interp_var_std_accept_logical_input) {
+    auto interp = createTestInterp();
+    interp.executeString("v = var([true false true false]); s = std([1 2 3] > 1, 1);");
+    auto env = interp.globalEnv();
+    ASSERT_NEAR(env->get("v")->scalarDouble(), 1.0 / 3.0, 1e-12);
+    ASSERT_NEAR(env->get("s")->scalarDouble(), std::sqrt(2.0 / 9.0), 1e-12);
+}
+
 // ============================================================================
 // Main
 // ============================================================================